@@ -0,0 +1,536 @@
+/*
+    Copyright (C) 2019 William Hart
+
+    This file is part of FLINT.
+
+    FLINT is free software: you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.  See <http://www.gnu.org/licenses/>.
+*/
+
+/*
+   Benchmark driver: runs the kernels registered in kernels.c over their
+   parameter sweeps and writes the timings as JSON or CSV, optionally
+   comparing them with a previous run. Run with --help for the options.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "flint.h"
+#include "profiler.h"
+#include "bench.h"
+
+#ifndef FLINT_GIT_REV
+#define FLINT_GIT_REV "unknown"
+#endif
+
+/* a sample is at least this many cycles of repeated calls */
+#define BENCH_MIN_CYCLES 2e7
+
+#define BENCH_MAX_REPS (WORD(1) << 24)
+
+#define BENCH_MAX_THREADS 16
+
+#define BENCH_NAME_LEN 64
+
+typedef struct
+{
+    char kernel[BENCH_NAME_LEN];
+    slong len;
+    slong bits;
+    slong threads;
+    slong reps;
+    slong samples;
+    double min;
+    double median;
+    double max;
+    ulong hwm;
+} bench_result_struct;
+
+typedef struct
+{
+    bench_result_struct * entries;
+    slong num;
+    slong alloc;
+} bench_table_struct;
+
+static const slong bench_no_values[] = { 0 };
+
+static void usage(const char * prog)
+{
+    flint_printf("usage: %s [options]\n\n", prog);
+    flint_printf("   -l, --list            list the kernels and exit\n");
+    flint_printf("   -k, --kernel a,b,...  only run kernels whose names "
+                 "contain one of the given strings\n");
+    flint_printf("   -f, --format json|csv output format (default json)\n");
+    flint_printf("   -o, --output file     write results to file "
+                 "(default stdout)\n");
+    flint_printf("   -t, --threads 1,2,... thread counts for threaded "
+                 "kernels (default 1)\n");
+    flint_printf("   -s, --samples n       samples per point (default 5)\n");
+    flint_printf("   -c, --compare file    compare medians with a previous "
+                 "run, in either format\n");
+    flint_printf("   -r, --threshold pct   slowdown flagged as a regression "
+                 "(default 10)\n\n");
+    flint_printf("Times are in cycles per call. hwm_kb is the peak resident "
+                 "size of the process\nwhile running a point, where the "
+                 "system lets it be reset (Linux), otherwise\nthe peak so "
+                 "far. The exit status is 1 if a regression was found.\n");
+}
+
+static void table_push(bench_table_struct * t, const bench_result_struct * r)
+{
+    if (t->num == t->alloc)
+    {
+        t->alloc = FLINT_MAX(16, 2*t->alloc);
+        t->entries = (bench_result_struct *) flint_realloc(t->entries,
+                                       t->alloc*sizeof(bench_result_struct));
+    }
+
+    t->entries[t->num++] = *r;
+}
+
+static const bench_result_struct * table_find(const bench_table_struct * t,
+                                               const bench_result_struct * r)
+{
+    slong i;
+
+    for (i = 0; i < t->num; i++)
+    {
+        const bench_result_struct * e = t->entries + i;
+
+        if (strcmp(e->kernel, r->kernel) == 0 && e->len == r->len &&
+                              e->bits == r->bits && e->threads == r->threads)
+            return e;
+    }
+
+    return NULL;
+}
+
+/* split a comma separated list of positive integers, returning the count */
+static slong parse_list(slong * res, slong max, const char * str)
+{
+    slong num = 0;
+
+    while (*str != '\0' && num < max)
+    {
+        char * end;
+        slong v = strtol(str, &end, 10);
+
+        if (end == str || v <= 0)
+            return 0;
+
+        res[num++] = v;
+        str = (*end == ',') ? end + 1 : end;
+    }
+
+    return num;
+}
+
+static int name_matches(const char * name, const char * filter)
+{
+    char buf[BENCH_NAME_LEN];
+    const char * s = filter;
+
+    if (filter == NULL)
+        return 1;
+
+    while (*s != '\0')
+    {
+        size_t n = strcspn(s, ",");
+
+        if (n > 0 && n < BENCH_NAME_LEN)
+        {
+            memcpy(buf, s, n);
+            buf[n] = '\0';
+            if (strstr(name, buf) != NULL)
+                return 1;
+        }
+
+        s += n;
+        if (*s == ',')
+            s++;
+    }
+
+    return 0;
+}
+
+/*
+   Reads the value for key from a JSON record written by write_result, which
+   puts each result on a line of its own.
+*/
+static int json_field(char * res, size_t size, const char * line,
+                                                             const char * key)
+{
+    char pat[BENCH_NAME_LEN + 4];
+    const char * p;
+    size_t n;
+
+    sprintf(pat, "\"%s\":", key);
+    p = strstr(line, pat);
+    if (p == NULL)
+        return 0;
+
+    p += strlen(pat);
+    while (*p == ' ' || *p == '"')
+        p++;
+
+    n = strcspn(p, "\",}");
+    if (n >= size)
+        return 0;
+
+    memcpy(res, p, n);
+    res[n] = '\0';
+    return 1;
+}
+
+static int parse_json_line(bench_result_struct * r, const char * line)
+{
+    char buf[BENCH_NAME_LEN];
+
+    if (!json_field(r->kernel, BENCH_NAME_LEN, line, "kernel"))
+        return 0;
+
+    if (!json_field(buf, sizeof(buf), line, "len")) return 0;
+    r->len = strtol(buf, NULL, 10);
+    if (!json_field(buf, sizeof(buf), line, "bits")) return 0;
+    r->bits = strtol(buf, NULL, 10);
+    if (!json_field(buf, sizeof(buf), line, "threads")) return 0;
+    r->threads = strtol(buf, NULL, 10);
+    if (!json_field(buf, sizeof(buf), line, "median_cycles")) return 0;
+    r->median = strtod(buf, NULL);
+
+    return 1;
+}
+
+static int parse_csv_line(bench_result_struct * r, const char * line)
+{
+    const char * comma = strchr(line, ',');
+    size_t n;
+    double min, max;
+    ulong reps, samples;
+    slong len, bits, threads;
+
+    if (comma == NULL || strncmp(line, "kernel,", 7) == 0)
+        return 0;
+
+    n = comma - line;
+    if (n >= BENCH_NAME_LEN)
+        return 0;
+
+    memcpy(r->kernel, line, n);
+    r->kernel[n] = '\0';
+
+    if (flint_sscanf(comma + 1, "%wd,%wd,%wd,%wu,%wu", &len, &bits, &threads,
+                                                    &reps, &samples) != 5)
+        return 0;
+
+    /* skip the five integer fields */
+    for (n = 0; n < 5 && comma != NULL; n++)
+        comma = strchr(comma + 1, ',');
+
+    if (comma == NULL ||
+        sscanf(comma, ",%lf,%lf,%lf", &min, &r->median, &max) != 3)
+        return 0;
+
+    r->len = len;
+    r->bits = bits;
+    r->threads = threads;
+
+    return 1;
+}
+
+static void load_baseline(bench_table_struct * t, const char * filename)
+{
+    FILE * file = fopen(filename, "r");
+    char line[1024];
+
+    if (file == NULL)
+    {
+        flint_printf("Exception (bench). Cannot open %s.\n", filename);
+        flint_abort();
+    }
+
+    while (fgets(line, sizeof(line), file) != NULL)
+    {
+        bench_result_struct r;
+
+        memset(&r, 0, sizeof(r));
+
+        if (parse_json_line(&r, line) || parse_csv_line(&r, line))
+            table_push(t, &r);
+    }
+
+    fclose(file);
+}
+
+static void reset_hwm(void)
+{
+#if defined(__linux__)
+    /* writing 5 resets the peak resident set size, where supported */
+    FILE * file = fopen("/proc/self/clear_refs", "w");
+
+    if (file != NULL)
+    {
+        fputs("5", file);
+        fclose(file);
+    }
+#endif
+}
+
+static ulong read_hwm(void)
+{
+#if defined(__linux__)
+    meminfo_t meminfo;
+
+    memset(meminfo, 0, sizeof(meminfo_t));
+    get_memory_usage(meminfo);
+
+    return meminfo->hwm;
+#else
+    return 0;
+#endif
+}
+
+static int cmp_double(const void * a, const void * b)
+{
+    double x = *((const double *) a), y = *((const double *) b);
+
+    return (x > y) - (x < y);
+}
+
+static void run_point(bench_result_struct * r, const bench_kernel_struct * k,
+                   const bench_param_t param, slong samples, flint_rand_t state)
+{
+    double * times, t0, t;
+    void * data;
+    slong i, reps;
+
+    flint_set_num_threads(param->threads);
+
+    reset_hwm();
+    data = k->init(param, state);
+
+    /* warm up, then find how many calls make up a sample */
+    k->run(data);
+    for (reps = 1; reps < BENCH_MAX_REPS; reps *= 2)
+    {
+        t0 = get_cycle_counter();
+        for (i = 0; i < reps; i++)
+            k->run(data);
+        t = get_cycle_counter() - t0;
+
+        if (t >= BENCH_MIN_CYCLES)
+            break;
+    }
+
+    times = (double *) flint_malloc(samples*sizeof(double));
+
+    for (i = 0; i < samples; i++)
+    {
+        slong j;
+
+        t0 = get_cycle_counter();
+        for (j = 0; j < reps; j++)
+            k->run(data);
+        times[i] = (get_cycle_counter() - t0)/reps;
+    }
+
+    k->clear(data);
+
+    qsort(times, samples, sizeof(double), cmp_double);
+
+    strncpy(r->kernel, k->name, BENCH_NAME_LEN - 1);
+    r->kernel[BENCH_NAME_LEN - 1] = '\0';
+    r->len = param->len;
+    r->bits = param->bits;
+    r->threads = param->threads;
+    r->reps = reps;
+    r->samples = samples;
+    r->min = times[0];
+    r->max = times[samples - 1];
+    r->median = (samples % 2) ? times[samples/2] :
+                                 (times[samples/2 - 1] + times[samples/2])/2;
+    r->hwm = read_hwm();
+
+    flint_free(times);
+    flint_set_num_threads(1);
+}
+
+static void write_header(FILE * out, int json)
+{
+    if (json)
+    {
+        flint_fprintf(out, "{\n\"flint_version\": \"%s\",\n", FLINT_VERSION);
+        flint_fprintf(out, "\"revision\": \"%s\",\n", FLINT_GIT_REV);
+        flint_fprintf(out, "\"results\": [\n");
+    }
+    else
+    {
+        flint_fprintf(out, "kernel,len,bits,threads,reps,samples,"
+                       "min_cycles,median_cycles,max_cycles,hwm_kb,revision\n");
+    }
+}
+
+static void write_result(FILE * out, int json, const bench_result_struct * r,
+                                                                    int first)
+{
+    if (json)
+    {
+        flint_fprintf(out, "%s{\"kernel\": \"%s\", \"len\": %wd, "
+            "\"bits\": %wd, \"threads\": %wd, \"reps\": %wd, "
+            "\"samples\": %wd, ", first ? "" : ",\n", r->kernel, r->len,
+            r->bits, r->threads, r->reps, r->samples);
+        flint_fprintf(out, "\"min_cycles\": %.0f, \"median_cycles\": %.0f, "
+            "\"max_cycles\": %.0f, \"hwm_kb\": %wu}", r->min, r->median,
+            r->max, r->hwm);
+    }
+    else
+    {
+        flint_fprintf(out, "%s,%wd,%wd,%wd,%wd,%wd,%.0f,%.0f,%.0f,%wu,%s\n",
+            r->kernel, r->len, r->bits, r->threads, r->reps, r->samples,
+            r->min, r->median, r->max, r->hwm, FLINT_GIT_REV);
+    }
+
+    fflush(out);
+}
+
+static void write_footer(FILE * out, int json)
+{
+    if (json)
+        flint_fprintf(out, "\n]\n}\n");
+}
+
+int main(int argc, char * argv[])
+{
+    const char * filter = NULL, * outname = NULL, * basename = NULL;
+    slong threads[BENCH_MAX_THREADS] = { 1 };
+    slong num_threads = 1, samples = 5;
+    double threshold = 10.0;
+    int json = 1, list = 0, first = 1;
+    slong i, j, l, b, regressions = 0;
+    bench_table_struct baseline = { NULL, 0, 0 };
+    FILE * out = stdout;
+    FLINT_TEST_INIT(state);
+
+    for (i = 1; i < argc; i++)
+    {
+        const char * opt = argv[i];
+        const char * val = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+        if (!strcmp(opt, "-l") || !strcmp(opt, "--list"))
+        {
+            list = 1;
+            continue;
+        }
+
+        if (!strcmp(opt, "-h") || !strcmp(opt, "--help") || val == NULL)
+        {
+            usage(argv[0]);
+            return strcmp(opt, "-h") && strcmp(opt, "--help");
+        }
+
+        i++;
+
+        if (!strcmp(opt, "-k") || !strcmp(opt, "--kernel"))
+            filter = val;
+        else if (!strcmp(opt, "-f") || !strcmp(opt, "--format"))
+            json = strcmp(val, "csv") != 0;
+        else if (!strcmp(opt, "-o") || !strcmp(opt, "--output"))
+            outname = val;
+        else if (!strcmp(opt, "-t") || !strcmp(opt, "--threads"))
+            num_threads = parse_list(threads, BENCH_MAX_THREADS, val);
+        else if (!strcmp(opt, "-s") || !strcmp(opt, "--samples"))
+            samples = strtol(val, NULL, 10);
+        else if (!strcmp(opt, "-c") || !strcmp(opt, "--compare"))
+            basename = val;
+        else if (!strcmp(opt, "-r") || !strcmp(opt, "--threshold"))
+            threshold = strtod(val, NULL);
+        else
+            num_threads = 0;
+
+        if (num_threads == 0 || samples <= 0)
+        {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (list)
+    {
+        for (i = 0; i < bench_num_kernels; i++)
+            flint_printf("%s%s\n", bench_kernels[i].name,
+                               bench_kernels[i].threaded ? " (threaded)" : "");
+        return 0;
+    }
+
+    if (basename != NULL)
+        load_baseline(&baseline, basename);
+
+    if (outname != NULL && (out = fopen(outname, "w")) == NULL)
+    {
+        flint_printf("Exception (bench). Cannot open %s.\n", outname);
+        flint_abort();
+    }
+
+    write_header(out, json);
+
+    for (i = 0; i < bench_num_kernels; i++)
+    {
+        const bench_kernel_struct * k = bench_kernels + i;
+        const slong * lens = k->lens ? k->lens : bench_no_values;
+        const slong * bits = k->bits ? k->bits : bench_no_values;
+
+        if (!name_matches(k->name, filter))
+            continue;
+
+        l = 0;
+        do {
+            b = 0;
+            do {
+                for (j = 0; j < (k->threaded ? num_threads : 1); j++)
+                {
+                    bench_result_struct r;
+                    const bench_result_struct * old;
+                    bench_param_t param;
+
+                    param->len = lens[l];
+                    param->bits = bits[b];
+                    param->threads = k->threaded ? threads[j] : 1;
+
+                    run_point(&r, k, param, samples, state);
+                    write_result(out, json, &r, first);
+                    first = 0;
+
+                    old = table_find(&baseline, &r);
+                    if (old != NULL &&
+                            r.median > old->median*(1.0 + threshold/100.0))
+                    {
+                        fprintf(stderr, "REGRESSION %s len=%ld bits=%ld "
+                            "threads=%ld: %.0f -> %.0f cycles (%+.1f%%)\n",
+                            r.kernel, (long) r.len, (long) r.bits,
+                            (long) r.threads, old->median, r.median,
+                            100.0*(r.median/old->median - 1.0));
+                        regressions++;
+                    }
+                }
+            } while (bits[b] != 0 && bits[++b] != 0);
+        } while (lens[l] != 0 && lens[++l] != 0);
+    }
+
+    write_footer(out, json);
+
+    if (out != stdout)
+        fclose(out);
+
+    if (basename != NULL)
+        fprintf(stderr, "%ld regression(s) against %s\n",
+                                                  (long) regressions, basename);
+
+    flint_free(baseline.entries);
+    FLINT_TEST_CLEANUP(state);
+
+    return regressions != 0;
+}
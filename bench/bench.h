@@ -0,0 +1,49 @@
+/*
+    Copyright (C) 2019 William Hart
+
+    This file is part of FLINT.
+
+    FLINT is free software: you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.  See <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef FLINT_BENCH_H
+#define FLINT_BENCH_H
+
+#include "flint.h"
+
+/* one point of a parameter sweep; unused parameters are zero */
+typedef struct
+{
+    slong len;
+    slong bits;
+    slong threads;
+} bench_param_struct;
+
+typedef bench_param_struct bench_param_t[1];
+
+/*
+   A named kernel. The driver calls init once for each point of the sweep
+   over lens x bits (x thread counts if the kernel is threaded), then run
+   repeatedly, then clear. Each of lens and bits is a zero terminated list
+   of values, or NULL if the kernel does not take that parameter. Calling
+   run more than once on the same data must be valid.
+*/
+typedef struct
+{
+    const char * name;
+    const slong * lens;
+    const slong * bits;
+    int threaded;
+    void * (* init)(const bench_param_t param, flint_rand_t state);
+    void (* run)(void * data);
+    void (* clear)(void * data);
+} bench_kernel_struct;
+
+extern const bench_kernel_struct bench_kernels[];
+
+extern const slong bench_num_kernels;
+
+#endif
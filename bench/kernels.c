@@ -0,0 +1,506 @@
+/*
+    Copyright (C) 2019 William Hart
+
+    This file is part of FLINT.
+
+    FLINT is free software: you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.  See <http://www.gnu.org/licenses/>.
+*/
+
+/*
+   The kernels run by the benchmark driver. To add one, write its init, run
+   and clear functions and add an entry to bench_kernels at the bottom.
+   Names should stay stable between releases so that results can be
+   compared.
+*/
+
+#include <gmp.h>
+#include "flint.h"
+#include "ulong_extras.h"
+#include "fmpz.h"
+#include "fmpz_vec.h"
+#include "fmpz_factor.h"
+#include "fmpz_poly.h"
+#include "fmpz_mat.h"
+#include "fmpz_lll.h"
+#include "fmpz_mpoly.h"
+#include "nmod_poly.h"
+#include "nmod_poly_factor.h"
+#include "nmod_mat.h"
+#include "fft.h"
+#include "qsieve.h"
+#include "bench.h"
+
+#define NUM_WORDS 100
+
+/******************************************************************************
+
+    ulong_extras
+
+******************************************************************************/
+
+typedef struct
+{
+    mp_limb_t n[NUM_WORDS];
+} words_struct;
+
+static void * words_init(const bench_param_t p, flint_rand_t state)
+{
+    words_struct * d = flint_malloc(sizeof(words_struct));
+    slong i;
+
+    for (i = 0; i < NUM_WORDS; i++)
+        d->n[i] = n_randbits(state, p->bits) | 1;
+
+    return d;
+}
+
+static void n_factor_run(void * data)
+{
+    words_struct * d = (words_struct *) data;
+    n_factor_t fac;
+    slong i;
+
+    for (i = 0; i < NUM_WORDS; i++)
+    {
+        n_factor_init(&fac);
+        n_factor(&fac, d->n[i], 0);
+    }
+}
+
+static void n_is_prime_run(void * data)
+{
+    words_struct * d = (words_struct *) data;
+    slong i;
+
+    for (i = 0; i < NUM_WORDS; i++)
+        n_is_prime(d->n[i]);
+}
+
+/******************************************************************************
+
+    fmpz
+
+******************************************************************************/
+
+typedef struct
+{
+    fmpz_t a, b, c;
+} fmpz3_struct;
+
+static void * fmpz3_init(const bench_param_t p, flint_rand_t state)
+{
+    fmpz3_struct * d = flint_malloc(sizeof(fmpz3_struct));
+
+    fmpz_init(d->a);
+    fmpz_init(d->b);
+    fmpz_init(d->c);
+    fmpz_randbits(d->a, state, p->bits);
+    fmpz_randbits(d->b, state, p->bits);
+
+    return d;
+}
+
+static void fmpz3_clear(void * data)
+{
+    fmpz3_struct * d = (fmpz3_struct *) data;
+
+    fmpz_clear(d->a);
+    fmpz_clear(d->b);
+    fmpz_clear(d->c);
+    flint_free(d);
+}
+
+static void fmpz_mul_run(void * data)
+{
+    fmpz3_struct * d = (fmpz3_struct *) data;
+
+    fmpz_mul(d->c, d->a, d->b);
+}
+
+static void fmpz_gcd_run(void * data)
+{
+    fmpz3_struct * d = (fmpz3_struct *) data;
+
+    fmpz_gcd(d->c, d->a, d->b);
+}
+
+/* a semiprime with factors of about half the bits */
+static void * semiprime_init(const bench_param_t p, flint_rand_t state)
+{
+    fmpz3_struct * d = flint_malloc(sizeof(fmpz3_struct));
+
+    fmpz_init(d->a);
+    fmpz_init(d->b);
+    fmpz_init(d->c);
+    fmpz_randprime(d->a, state, p->bits/2, 0);
+    fmpz_randprime(d->b, state, p->bits - p->bits/2, 0);
+    fmpz_mul(d->c, d->a, d->b);
+
+    return d;
+}
+
+static void qsieve_factor_run(void * data)
+{
+    fmpz3_struct * d = (fmpz3_struct *) data;
+    fmpz_factor_t fac;
+
+    fmpz_factor_init(fac);
+    qsieve_factor(fac, d->c);
+    fmpz_factor_clear(fac);
+}
+
+/******************************************************************************
+
+    fft
+
+******************************************************************************/
+
+typedef struct
+{
+    mp_ptr a, b, r;
+    slong n;
+} mpn3_struct;
+
+static void * mpn3_init(const bench_param_t p, flint_rand_t state)
+{
+    mpn3_struct * d = flint_malloc(sizeof(mpn3_struct));
+    slong i;
+
+    d->n = p->len;
+    d->a = flint_malloc(d->n*sizeof(mp_limb_t));
+    d->b = flint_malloc(d->n*sizeof(mp_limb_t));
+    d->r = flint_malloc(2*d->n*sizeof(mp_limb_t));
+
+    for (i = 0; i < d->n; i++)
+    {
+        d->a[i] = n_randlimb(state);
+        d->b[i] = n_randlimb(state);
+    }
+
+    return d;
+}
+
+static void mpn3_clear(void * data)
+{
+    mpn3_struct * d = (mpn3_struct *) data;
+
+    flint_free(d->a);
+    flint_free(d->b);
+    flint_free(d->r);
+    flint_free(d);
+}
+
+static void fft_mul_run(void * data)
+{
+    mpn3_struct * d = (mpn3_struct *) data;
+
+    flint_mpn_mul_fft_main(d->r, d->a, d->n, d->b, d->n);
+}
+
+/******************************************************************************
+
+    polynomials
+
+******************************************************************************/
+
+typedef struct
+{
+    nmod_poly_t a, b, c;
+} nmod_poly3_struct;
+
+static void * nmod_poly3_init(const bench_param_t p, flint_rand_t state)
+{
+    nmod_poly3_struct * d = flint_malloc(sizeof(nmod_poly3_struct));
+    mp_limb_t n = n_randprime(state, p->bits, 0);
+
+    nmod_poly_init(d->a, n);
+    nmod_poly_init(d->b, n);
+    nmod_poly_init(d->c, n);
+    nmod_poly_randtest(d->a, state, p->len);
+    nmod_poly_randtest(d->b, state, p->len);
+
+    return d;
+}
+
+static void nmod_poly3_clear(void * data)
+{
+    nmod_poly3_struct * d = (nmod_poly3_struct *) data;
+
+    nmod_poly_clear(d->a);
+    nmod_poly_clear(d->b);
+    nmod_poly_clear(d->c);
+    flint_free(d);
+}
+
+static void nmod_poly_mul_run(void * data)
+{
+    nmod_poly3_struct * d = (nmod_poly3_struct *) data;
+
+    nmod_poly_mul(d->c, d->a, d->b);
+}
+
+static void nmod_poly_factor_run(void * data)
+{
+    nmod_poly3_struct * d = (nmod_poly3_struct *) data;
+    nmod_poly_factor_t fac;
+
+    nmod_poly_factor_init(fac);
+    nmod_poly_factor(fac, d->a);
+    nmod_poly_factor_clear(fac);
+}
+
+typedef struct
+{
+    fmpz_poly_t a, b, c;
+    fmpz_t t;
+} fmpz_poly3_struct;
+
+/* a dense polynomial of the given length with coefficients of the given size */
+static void fmpz_poly_randbits(fmpz_poly_t f, flint_rand_t state,
+                                                      slong len, slong bits)
+{
+    slong i;
+
+    fmpz_poly_fit_length(f, len);
+    for (i = 0; i < len; i++)
+        fmpz_randbits(f->coeffs + i, state, bits);
+    _fmpz_poly_set_length(f, len);
+    _fmpz_poly_normalise(f);
+}
+
+static void * fmpz_poly3_init(const bench_param_t p, flint_rand_t state)
+{
+    fmpz_poly3_struct * d = flint_malloc(sizeof(fmpz_poly3_struct));
+
+    fmpz_poly_init(d->a);
+    fmpz_poly_init(d->b);
+    fmpz_poly_init(d->c);
+    fmpz_init(d->t);
+    fmpz_poly_randbits(d->a, state, p->len, p->bits);
+    fmpz_poly_randbits(d->b, state, p->len, p->bits);
+    fmpz_randbits(d->t, state, p->bits);
+
+    return d;
+}
+
+static void fmpz_poly3_clear(void * data)
+{
+    fmpz_poly3_struct * d = (fmpz_poly3_struct *) data;
+
+    fmpz_poly_clear(d->a);
+    fmpz_poly_clear(d->b);
+    fmpz_poly_clear(d->c);
+    fmpz_clear(d->t);
+    flint_free(d);
+}
+
+static void fmpz_poly_mul_run(void * data)
+{
+    fmpz_poly3_struct * d = (fmpz_poly3_struct *) data;
+
+    fmpz_poly_mul(d->c, d->a, d->b);
+}
+
+static void fmpz_poly_taylor_shift_run(void * data)
+{
+    fmpz_poly3_struct * d = (fmpz_poly3_struct *) data;
+
+    fmpz_poly_taylor_shift_multi_mod(d->c, d->a, d->t);
+}
+
+typedef struct
+{
+    fmpz_mpoly_ctx_t ctx;
+    fmpz_mpoly_t a, b, c;
+} fmpz_mpoly3_struct;
+
+static void * fmpz_mpoly3_init(const bench_param_t p, flint_rand_t state)
+{
+    fmpz_mpoly3_struct * d = flint_malloc(sizeof(fmpz_mpoly3_struct));
+
+    fmpz_mpoly_ctx_init(d->ctx, 4, ORD_LEX);
+    fmpz_mpoly_init(d->a, d->ctx);
+    fmpz_mpoly_init(d->b, d->ctx);
+    fmpz_mpoly_init(d->c, d->ctx);
+    fmpz_mpoly_randtest_bits(d->a, state, p->len, p->bits, 16, d->ctx);
+    fmpz_mpoly_randtest_bits(d->b, state, p->len, p->bits, 16, d->ctx);
+
+    return d;
+}
+
+static void fmpz_mpoly3_clear(void * data)
+{
+    fmpz_mpoly3_struct * d = (fmpz_mpoly3_struct *) data;
+
+    fmpz_mpoly_clear(d->a, d->ctx);
+    fmpz_mpoly_clear(d->b, d->ctx);
+    fmpz_mpoly_clear(d->c, d->ctx);
+    fmpz_mpoly_ctx_clear(d->ctx);
+    flint_free(d);
+}
+
+static void fmpz_mpoly_mul_heap_run(void * data)
+{
+    fmpz_mpoly3_struct * d = (fmpz_mpoly3_struct *) data;
+
+    fmpz_mpoly_mul_heap_threaded(d->c, d->a, d->b, d->ctx);
+}
+
+/******************************************************************************
+
+    matrices
+
+******************************************************************************/
+
+typedef struct
+{
+    nmod_mat_t a, b, c;
+} nmod_mat3_struct;
+
+static void * nmod_mat3_init(const bench_param_t p, flint_rand_t state)
+{
+    nmod_mat3_struct * d = flint_malloc(sizeof(nmod_mat3_struct));
+    mp_limb_t n = n_randprime(state, p->bits, 0);
+
+    nmod_mat_init(d->a, p->len, p->len, n);
+    nmod_mat_init(d->b, p->len, p->len, n);
+    nmod_mat_init(d->c, p->len, p->len, n);
+    nmod_mat_randfull(d->a, state);
+    nmod_mat_randfull(d->b, state);
+
+    return d;
+}
+
+static void nmod_mat3_clear(void * data)
+{
+    nmod_mat3_struct * d = (nmod_mat3_struct *) data;
+
+    nmod_mat_clear(d->a);
+    nmod_mat_clear(d->b);
+    nmod_mat_clear(d->c);
+    flint_free(d);
+}
+
+static void nmod_mat_mul_run(void * data)
+{
+    nmod_mat3_struct * d = (nmod_mat3_struct *) data;
+
+    nmod_mat_mul(d->c, d->a, d->b);
+}
+
+typedef struct
+{
+    fmpz_mat_t a, b, c;
+    fmpz_lll_t fl;
+} fmpz_mat3_struct;
+
+static void * fmpz_mat3_init(const bench_param_t p, flint_rand_t state)
+{
+    fmpz_mat3_struct * d = flint_malloc(sizeof(fmpz_mat3_struct));
+
+    fmpz_mat_init(d->a, p->len, p->len);
+    fmpz_mat_init(d->b, p->len, p->len);
+    fmpz_mat_init(d->c, p->len, p->len);
+    fmpz_mat_randbits(d->a, state, p->bits);
+    fmpz_mat_randbits(d->b, state, p->bits);
+
+    return d;
+}
+
+/* an integer relations lattice, reduced afresh from b on every run */
+static void * lll_init(const bench_param_t p, flint_rand_t state)
+{
+    fmpz_mat3_struct * d = flint_malloc(sizeof(fmpz_mat3_struct));
+
+    fmpz_mat_init(d->a, p->len, p->len + 1);
+    fmpz_mat_init(d->b, p->len, p->len + 1);
+    fmpz_mat_init(d->c, 0, 0);
+    fmpz_mat_randintrel(d->b, state, p->bits);
+    fmpz_lll_context_init_default(d->fl);
+
+    return d;
+}
+
+static void fmpz_mat3_clear(void * data)
+{
+    fmpz_mat3_struct * d = (fmpz_mat3_struct *) data;
+
+    fmpz_mat_clear(d->a);
+    fmpz_mat_clear(d->b);
+    fmpz_mat_clear(d->c);
+    flint_free(d);
+}
+
+static void fmpz_mat_mul_run(void * data)
+{
+    fmpz_mat3_struct * d = (fmpz_mat3_struct *) data;
+
+    fmpz_mat_mul(d->c, d->a, d->b);
+}
+
+static void fmpz_lll_run(void * data)
+{
+    fmpz_mat3_struct * d = (fmpz_mat3_struct *) data;
+
+    fmpz_mat_set(d->a, d->b);
+    fmpz_lll(d->a, NULL, d->fl);
+}
+
+/******************************************************************************
+
+    Registry
+
+******************************************************************************/
+
+static const slong word_bits[] = { 32, 48, 64, 0 };
+static const slong int_bits[] = { 64, 256, 1024, 16384, 262144, 0 };
+static const slong qsieve_bits[] = { 80, 100, 120, 0 };
+static const slong fft_limbs[] = { 4096, 32768, 262144, 0 };
+static const slong nmod_bits[] = { 20, 64, 0 };
+static const slong poly_lens[] = { 16, 256, 4096, 65536, 0 };
+static const slong fmpz_poly_lens[] = { 16, 256, 4096, 0 };
+static const slong fmpz_poly_bits[] = { 64, 1024, 0 };
+static const slong factor_lens[] = { 32, 128, 0 };
+static const slong shift_lens[] = { 100, 500, 0 };
+static const slong shift_bits[] = { 64, 0 };
+static const slong mpoly_lens[] = { 100, 1000, 0 };
+static const slong mpoly_bits[] = { 64, 0 };
+static const slong mat_dims[] = { 32, 128, 512, 0 };
+static const slong fmpz_mat_dims[] = { 16, 64, 256, 0 };
+static const slong fmpz_mat_bits[] = { 20, 200, 0 };
+static const slong lll_dims[] = { 10, 20, 40, 0 };
+static const slong lll_bits[] = { 100, 0 };
+
+const bench_kernel_struct bench_kernels[] =
+{
+    { "n_factor", NULL, word_bits, 0, words_init, n_factor_run, flint_free },
+    { "n_is_prime", NULL, word_bits, 0,
+                                     words_init, n_is_prime_run, flint_free },
+    { "fmpz_mul", NULL, int_bits, 0, fmpz3_init, fmpz_mul_run, fmpz3_clear },
+    { "fmpz_gcd", NULL, int_bits, 0, fmpz3_init, fmpz_gcd_run, fmpz3_clear },
+    { "qsieve_factor", NULL, qsieve_bits, 0,
+                            semiprime_init, qsieve_factor_run, fmpz3_clear },
+    { "fft_mul", fft_limbs, NULL, 0, mpn3_init, fft_mul_run, mpn3_clear },
+    { "nmod_poly_mul", poly_lens, nmod_bits, 0,
+                        nmod_poly3_init, nmod_poly_mul_run, nmod_poly3_clear },
+    { "nmod_poly_factor", factor_lens, nmod_bits, 0,
+                     nmod_poly3_init, nmod_poly_factor_run, nmod_poly3_clear },
+    { "fmpz_poly_mul", fmpz_poly_lens, fmpz_poly_bits, 0,
+                        fmpz_poly3_init, fmpz_poly_mul_run, fmpz_poly3_clear },
+    { "fmpz_poly_taylor_shift", shift_lens, shift_bits, 1,
+               fmpz_poly3_init, fmpz_poly_taylor_shift_run, fmpz_poly3_clear },
+    { "fmpz_mpoly_mul_heap", mpoly_lens, mpoly_bits, 1,
+                fmpz_mpoly3_init, fmpz_mpoly_mul_heap_run, fmpz_mpoly3_clear },
+    { "nmod_mat_mul", mat_dims, nmod_bits, 0,
+                           nmod_mat3_init, nmod_mat_mul_run, nmod_mat3_clear },
+    { "fmpz_mat_mul", fmpz_mat_dims, fmpz_mat_bits, 0,
+                           fmpz_mat3_init, fmpz_mat_mul_run, fmpz_mat3_clear },
+    { "fmpz_lll", lll_dims, lll_bits, 0,
+                                     lll_init, fmpz_lll_run, fmpz_mat3_clear }
+};
+
+const slong bench_num_kernels =
+                         sizeof(bench_kernels)/sizeof(bench_kernel_struct);
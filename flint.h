@@ -100,6 +100,25 @@ FLINT_DLL void __flint_set_memory_functions(void *(*alloc_func) (size_t),
      void *(*calloc_func) (size_t, size_t), void *(*realloc_func) (void *, size_t),
                                                               void (*free_func) (void *));
 
+/* arena allocator, installed with __flint_set_memory_functions */
+typedef struct
+{
+    size_t in_use;
+    size_t high_water;
+    ulong num_chunks;
+    ulong num_allocs;
+    ulong num_large;
+} flint_arena_stats_struct;
+
+typedef flint_arena_stats_struct flint_arena_stats_t[1];
+
+FLINT_DLL void * flint_arena_malloc(size_t size);
+FLINT_DLL void * flint_arena_calloc(size_t num, size_t size);
+FLINT_DLL void * flint_arena_realloc(void * ptr, size_t size);
+FLINT_DLL void flint_arena_free(void * ptr);
+FLINT_DLL void flint_arena_get_stats(flint_arena_stats_t stats);
+FLINT_DLL void flint_arena_reset(void);
+
 FLINT_DLL void flint_abort(void);
 FLINT_DLL void flint_set_abort(void (*func)(void));
   /* flint_abort is calling abort by default
@@ -171,6 +190,89 @@ FLINT_DLL int flint_get_num_threads(void);
 FLINT_DLL void flint_set_num_threads(int num_threads);
 FLINT_DLL void flint_parallel_cleanup(void);
 
+/* algorithm cutoffs, which may be loaded at runtime, see tuning.c */
+typedef enum
+{
+    FLINT_CUTOFF_NMOD_POLY_MUL_KS2,
+    FLINT_CUTOFF_NMOD_POLY_MUL_KS4,
+    FLINT_CUTOFF_NMOD_MAT_MUL_STRASSEN,
+    FLINT_CUTOFF_FMPZ_MAT_MUL_SMALL,
+    FLINT_CUTOFF_FMPZ_MAT_MUL_CLASSICAL,
+    FLINT_CUTOFF_FMPZ_MAT_MUL_MULTI_MOD_DIM,
+    FLINT_CUTOFF_FMPZ_MAT_MUL_MULTI_MOD_BITS,
+    FLINT_CUTOFF_FFT_MULMOD_2EXPP1,
+    FLINT_CUTOFF_QSIEVE_DLP_BITS,
+    FLINT_CUTOFF_QSIEVE_LANCZOS_COLS,
+    FLINT_CUTOFF_QSIEVE_STORE_WORDS,
+    FLINT_CUTOFF_ECM_STAGE_II_FFT,
+    FLINT_CUTOFF_PRIMES_TABLE_MIN,
+    FLINT_NUM_CUTOFFS
+} flint_cutoff_t;
+
+FLINT_DLL extern slong flint_cutoff_tab[FLINT_NUM_CUTOFFS];
+FLINT_DLL extern int flint_cutoffs_initialised;
+
+FLINT_DLL void _flint_cutoffs_init(void);
+
+static __inline__
+slong flint_get_cutoff(flint_cutoff_t c)
+{
+    if (!flint_cutoffs_initialised)
+        _flint_cutoffs_init();
+
+    return flint_cutoff_tab[c];
+}
+
+#define FLINT_CUTOFF(name) flint_get_cutoff(FLINT_CUTOFF_ ## name)
+
+FLINT_DLL void flint_set_cutoff(flint_cutoff_t c, slong value);
+FLINT_DLL slong flint_get_default_cutoff(flint_cutoff_t c);
+FLINT_DLL const char * flint_cutoff_name(flint_cutoff_t c);
+FLINT_DLL void flint_reset_cutoffs(void);
+FLINT_DLL int flint_load_cutoffs(const char * filename);
+FLINT_DLL int flint_save_cutoffs(const char * filename);
+
+/* tracing of the algorithms chosen by dispatch functions, see trace.c */
+typedef enum
+{
+    FLINT_TRACE_FMPZ_MAT_MUL,
+    FLINT_TRACE_FMPZ_POLY_MUL,
+    FLINT_TRACE_NMOD_MAT_MUL,
+    FLINT_TRACE_NMOD_POLY_MUL,
+    FLINT_TRACE_NUM_DISPATCHERS
+} flint_trace_t;
+
+typedef void (* flint_trace_func_t)(flint_trace_t d, const char * alg,
+                                     slong size, ulong cycles, void * data);
+
+FLINT_DLL ulong flint_trace_clock(void);
+FLINT_DLL void flint_trace_record(flint_trace_t d, const char * alg,
+                                                     slong size, ulong cycles);
+FLINT_DLL ulong flint_trace_calls(flint_trace_t d, const char * alg,
+                                                              ulong * cycles);
+FLINT_DLL const char * flint_trace_name(flint_trace_t d);
+FLINT_DLL void flint_trace_set_callback(flint_trace_func_t func, void * data);
+FLINT_DLL void flint_trace_reset(void);
+FLINT_DLL void flint_trace_dump(FILE * file);
+
+/*
+   Makes the call to the algorithm alg chosen by dispatcher d, recording
+   the size of the operands and the time taken if FLINT was configured
+   with --enable-trace.
+*/
+#if FLINT_TRACE
+#define FLINT_TRACE_CALL(d, alg, size, call)                            \
+    do {                                                                \
+        ulong __trace_start = flint_trace_clock();                      \
+        call;                                                           \
+        flint_trace_record(FLINT_TRACE_ ## d, alg, size,                \
+                                 flint_trace_clock() - __trace_start);  \
+    } while (0)
+#else
+#define FLINT_TRACE_CALL(d, alg, size, call) \
+    do { call; } while (0)
+#endif
+
 FLINT_DLL int flint_test_multiplier(void);
 
 typedef struct
@@ -56,15 +56,30 @@ typedef struct
 
 typedef fmpz_preinvn_struct fmpz_preinvn_t[1];
 
-typedef struct
+typedef struct fmpz_block_header_s
 {
-   int count;
+   void * address; /* must come first */
+   ulong check;
+   void * mem;
+   slong count;
 #if HAVE_PTHREAD
    pthread_t thread;
 #endif
-   void * address;
+   __mpz_struct * free;
+   struct fmpz_block_header_s * prev;
+   struct fmpz_block_header_s * next;
 } fmpz_block_header_s;
 
+typedef struct
+{
+   ulong hits;
+   ulong misses;
+   ulong remote_frees;
+   ulong retained_bytes;
+} fmpz_cache_stats_struct;
+
+typedef fmpz_cache_stats_struct fmpz_cache_stats_t[1];
+
 /* maximum positive value a small coefficient can have */
 #define COEFF_MAX ((WORD(1) << (FLINT_BITS - 2)) - WORD(1))
 
@@ -81,6 +96,14 @@ FLINT_DLL void _fmpz_cleanup_mpz_content(void);
 
 FLINT_DLL void _fmpz_cleanup(void);
 
+FLINT_DLL void fmpz_cache_set_limit(ulong limit);
+
+FLINT_DLL ulong fmpz_cache_get_limit(void);
+
+FLINT_DLL void fmpz_cache_get_stats(fmpz_cache_stats_t stats);
+
+FLINT_DLL void fmpz_cache_reset_stats(void);
+
 FLINT_DLL __mpz_struct * _fmpz_promote(fmpz_t f);
 
 FLINT_DLL __mpz_struct * _fmpz_promote_val(fmpz_t f);
@@ -371,6 +394,19 @@ FLINT_DLL size_t fmpz_sizeinbase(const fmpz_t f, int b);
 
 FLINT_DLL char * fmpz_get_str(char * str, int b, const fmpz_t f);
 
+/* divide and conquer radix conversion, see fmpz/get_str.c */
+
+#define FMPZ_STR_LEAF_LIMBS 64
+#define FMPZ_STR_DC_LIMBS 2000
+
+FLINT_DLL slong _fmpz_radix_leaf(int b);
+
+FLINT_DLL const fmpz * _fmpz_radix_powers(int b, slong num);
+
+FLINT_DLL void _fmpz_radix_powers_clear(const fmpz * pows, int b, slong num);
+
+FLINT_DLL int _fmpz_set_str_digits(fmpz_t f, const char * s, slong n, int b);
+
 FMPZ_INLINE
 void fmpz_swap(fmpz_t f, fmpz_t g)
 {
@@ -382,7 +418,16 @@ void fmpz_swap(fmpz_t f, fmpz_t g)
     }
 }
 
-FLINT_DLL int fmpz_cmp(const fmpz_t f, const fmpz_t g);
+FLINT_DLL int _fmpz_cmp_general(const fmpz_t f, const fmpz_t g);
+
+FMPZ_INLINE
+int fmpz_cmp(const fmpz_t f, const fmpz_t g)
+{
+    if (!COEFF_IS_MPZ(*f) && !COEFF_IS_MPZ(*g))  /* both are small */
+        return (*f < *g ? -1 : *f > *g);
+    else
+        return _fmpz_cmp_general(f, g);
+}
 
 FLINT_DLL int fmpz_cmp_ui(const fmpz_t f, ulong g);
 
@@ -443,15 +488,51 @@ fmpz_neg(fmpz_t f1, const fmpz_t f2)
 
 FLINT_DLL void fmpz_abs(fmpz_t f1, const fmpz_t f2);
 
-FLINT_DLL void fmpz_add(fmpz_t f, const fmpz_t g, const fmpz_t h);
+FLINT_DLL void _fmpz_add_general(fmpz_t f, const fmpz_t g, const fmpz_t h);
+
+FMPZ_INLINE
+void fmpz_add(fmpz_t f, const fmpz_t g, const fmpz_t h)
+{
+    if (!COEFF_IS_MPZ(*g) && !COEFF_IS_MPZ(*h))  /* both are small */
+        fmpz_set_si(f, *g + *h);
+    else
+        _fmpz_add_general(f, g, h);
+}
+
+FLINT_DLL void _fmpz_sub_general(fmpz_t f, const fmpz_t g, const fmpz_t h);
 
-FLINT_DLL void fmpz_sub(fmpz_t f, const fmpz_t g, const fmpz_t h);
+FMPZ_INLINE
+void fmpz_sub(fmpz_t f, const fmpz_t g, const fmpz_t h)
+{
+    if (!COEFF_IS_MPZ(*g) && !COEFF_IS_MPZ(*h))  /* both are small */
+        fmpz_set_si(f, *g - *h);
+    else
+        _fmpz_sub_general(f, g, h);
+}
 
 FLINT_DLL void fmpz_mul_ui(fmpz_t f, const fmpz_t g, ulong x);
 
 FLINT_DLL void fmpz_mul_si(fmpz_t f, const fmpz_t g, slong x);
 
-FLINT_DLL void fmpz_mul(fmpz_t f, const fmpz_t g, const fmpz_t h);
+FLINT_DLL void _fmpz_mul_general(fmpz_t f, const fmpz_t g, const fmpz_t h);
+
+FMPZ_INLINE
+void fmpz_mul(fmpz_t f, const fmpz_t g, const fmpz_t h)
+{
+    if (!COEFF_IS_MPZ(*g) && !COEFF_IS_MPZ(*h))  /* both are small */
+    {
+        mp_limb_t hi, lo;
+
+        smul_ppmm(hi, lo, *g, *h);
+
+        if (hi == FLINT_SIGN_EXT(lo))  /* product fits in a slong */
+            fmpz_set_si(f, lo);
+        else
+            fmpz_set_signed_uiui(f, hi, lo);
+    }
+    else
+        _fmpz_mul_general(f, g, h);
+}
 
 FLINT_DLL void fmpz_mul_2exp(fmpz_t f, const fmpz_t g, ulong exp);
 
@@ -463,7 +544,27 @@ FLINT_DLL void fmpz_addmul_ui(fmpz_t f, const fmpz_t g, ulong x);
 
 FLINT_DLL void fmpz_submul_ui(fmpz_t f, const fmpz_t g, ulong x);
 
-FLINT_DLL void fmpz_addmul(fmpz_t f, const fmpz_t g, const fmpz_t h);
+FLINT_DLL void _fmpz_addmul_general(fmpz_t f, const fmpz_t g, const fmpz_t h);
+
+FMPZ_INLINE
+void fmpz_addmul(fmpz_t f, const fmpz_t g, const fmpz_t h)
+{
+    if (!COEFF_IS_MPZ(*f) && !COEFF_IS_MPZ(*g) && !COEFF_IS_MPZ(*h))
+    {
+        mp_limb_t hi, lo;
+
+        /* |g*h| < 2^(2*FLINT_BITS - 4), so adding f cannot overflow */
+        smul_ppmm(hi, lo, *g, *h);
+        add_ssaaaa(hi, lo, hi, lo, FLINT_SIGN_EXT(*f), *f);
+
+        if (hi == FLINT_SIGN_EXT(lo))  /* result fits in a slong */
+            fmpz_set_si(f, lo);
+        else
+            fmpz_set_signed_uiui(f, hi, lo);
+    }
+    else
+        _fmpz_addmul_general(f, g, h);
+}
 
 FLINT_DLL void fmpz_submul(fmpz_t f, const fmpz_t g, const fmpz_t h);
 
@@ -755,6 +856,12 @@ FLINT_DLL int fmpz_is_strong_probabprime(const fmpz_t n, const fmpz_t a);
 
 FLINT_DLL int fmpz_is_probabprime(const fmpz_t p);
 
+FLINT_DLL slong _fmpz_is_probabprime_vec(ulong * res, const fmpz * n,
+                                                                  slong len);
+
+FLINT_DLL slong fmpz_is_probabprime_vec(ulong * res, const fmpz * n,
+                                                                  slong len);
+
 FLINT_DLL int fmpz_is_prime_pseudosquare(const fmpz_t n);
 
 FLINT_DLL void _fmpz_nm1_trial_factors(const fmpz_t n, mp_ptr pm1, 
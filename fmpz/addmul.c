@@ -14,7 +14,7 @@
 #include "ulong_extras.h"
 #include "fmpz.h"
 
-void fmpz_addmul(fmpz_t f, const fmpz_t g, const fmpz_t h)
+void _fmpz_addmul_general(fmpz_t f, const fmpz_t g, const fmpz_t h)
 {
     fmpz c1, c2;
     __mpz_struct * mpz_ptr;
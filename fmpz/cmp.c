@@ -15,7 +15,7 @@
 #include "fmpz.h"
 
 int
-fmpz_cmp(const fmpz_t f, const fmpz_t g)
+_fmpz_cmp_general(const fmpz_t f, const fmpz_t g)
 {
     int sign;
 
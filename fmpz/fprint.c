@@ -1,5 +1,6 @@
 /*
     Copyright (C) 2010 Sebastian Pancratz
+    Copyright (C) 2019 William Hart
 
     This file is part of FLINT.
 
@@ -10,15 +11,25 @@
 */
 
 #include <stdio.h>
+#include <string.h>
 #include <gmp.h>
 
 #include "fmpz.h"
 
 int fmpz_fprint(FILE * file, const fmpz_t x)
 {
-	if (!COEFF_IS_MPZ(*x))
+    if (!COEFF_IS_MPZ(*x))
         return flint_fprintf(file, "%wd", *x);
-	else 
+    else if (flint_get_num_threads() == 1 ||
+                                    fmpz_size(x) < 2*FMPZ_STR_DC_LIMBS)
         return (int) mpz_out_str(file, 10, COEFF_TO_PTR(*x));
+    else
+    {
+        char * s = fmpz_get_str(NULL, 10, x);
+        int r = (fputs(s, file) < 0) ? 0 : (int) strlen(s);
+
+        flint_free(s);
+        return r;
+    }
 }
 
@@ -1,6 +1,7 @@
 /*
     Copyright (C) 2009 William Hart
     Copyright (C) 2010 Sebastian Pancratz
+    Copyright (C) 2019 William Hart
 
     This file is part of FLINT.
 
@@ -11,21 +12,75 @@
 */
 
 #include <stdio.h>
+#include <ctype.h>
 #include <gmp.h>
 #include "flint.h"
 #include "fmpz.h"
 
+/*
+   The digits are collected from the stream and converted directly, without
+   an intermediate mpz, so that long inputs use the divide and conquer
+   conversion of fmpz_set_str.
+*/
 int 
 fmpz_fread(FILE * file, fmpz_t f)
 {
-    mpz_t t;
-    size_t r;
+    char * s;
+    slong n = 0, alloc = 64;
+    int c, neg = 0;
 
-    mpz_init(t);
-    r = mpz_inp_str(t, file, 10);
-    fmpz_set_mpz(f, t);
-    mpz_clear(t);
+    do {
+        c = getc(file);
+    } while (c != EOF && isspace(c));
 
-    return (r > 0) ? 1 : 0;
-}
+    if (c == '-')
+    {
+        neg = 1;
+        c = getc(file);
+    }
+
+    s = flint_malloc(alloc);
+
+    while (c != EOF && isdigit(c))
+    {
+        if (n == alloc)
+        {
+            alloc *= 2;
+            s = flint_realloc(s, alloc);
+        }
+
+        s[n++] = c;
+        c = getc(file);
+    }
+
+    /* like mpz_inp_str, a character which is not a digit is consumed
+       if no digits have been read */
+    if (n == 0)
+    {
+        flint_free(s);
+        return 0;
+    }
 
+    if (c != EOF)
+        ungetc(c, file);
+
+    if (n <= (FLINT_BITS == 64 ? 19 : 9))
+    {
+        ulong v = 0;
+        slong i;
+
+        for (i = 0; i < n; i++)
+            v = 10*v + (s[i] - '0');
+
+        fmpz_set_ui(f, v);
+    }
+    else
+        _fmpz_set_str_digits(f, s, n, 10);
+
+    if (neg)
+        fmpz_neg(f, f);
+
+    flint_free(s);
+
+    return 1;
+}
@@ -1,5 +1,6 @@
 /*
     Copyright (C) 2010, 2011 Sebastian Pancratz
+    Copyright (C) 2019 William Hart
 
     This file is part of FLINT.
 
@@ -9,11 +10,154 @@
     (at your option) any later version.  See <http://www.gnu.org/licenses/>.
 */
 
+#include <string.h>
 #include <gmp.h>
 #include "flint.h"
 #include "ulong_extras.h"
+#include "threadpool.h"
 #include "fmpz.h"
 
+static const char _fmpz_digits[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+
+/*
+   Writes the leaf*2^k digits of 0 <= f < b^(leaf*2^k) to s, with leading
+   zeros. The conversion is split in two halves with pows[k - 1] while
+   there are threads to run them on, as GMP's own conversion is faster on
+   a single thread.
+*/
+static void _fmpz_get_str_rec(char * s, const fmpz_t f, slong k,
+                                      const fmpz * pows, slong leaf, int b);
+
+typedef struct
+{
+    char * s;
+    const fmpz * f;
+    slong k;
+    const fmpz * pows;
+    slong leaf;
+    int b;
+    int num_threads;
+} _get_str_arg_t;
+
+static void _fmpz_get_str_worker(void * arg_ptr)
+{
+    _get_str_arg_t * arg = (_get_str_arg_t *) arg_ptr;
+    int num_threads = flint_get_num_threads();
+
+    flint_set_num_threads(arg->num_threads);
+    _fmpz_get_str_rec(arg->s, arg->f, arg->k, arg->pows, arg->leaf, arg->b);
+    flint_set_num_threads(num_threads);
+}
+
+static void _fmpz_get_str_rec(char * s, const fmpz_t f, slong k,
+                                       const fmpz * pows, slong leaf, int b)
+{
+    slong n = leaf << k;
+
+    if (fmpz_is_zero(f))
+    {
+        memset(s, '0', n);
+    }
+    else if (k == 0 || flint_get_num_threads() == 1 ||
+                           fmpz_size(pows + k - 1) < FMPZ_STR_DC_LIMBS)
+    {
+        slong i, m, len = fmpz_size(f);
+        mp_ptr t = flint_malloc(len * sizeof(mp_limb_t));
+        unsigned char * u = flint_malloc(n + 1);
+
+        /* mpn_get_str overwrites its input */
+        fmpz_get_ui_array(t, len, f);
+        m = mpn_get_str(u, b, t, len);
+
+        memset(s, '0', n - m);
+        for (i = 0; i < m; i++)
+            s[n - m + i] = _fmpz_digits[u[i]];
+
+        flint_free(t);
+        flint_free(u);
+    }
+    else
+    {
+        _get_str_arg_t args[2];
+        fmpz_t q, r;
+
+        fmpz_init(q);
+        fmpz_init(r);
+
+        fmpz_tdiv_qr(q, r, f, pows + k - 1);
+
+        args[0].s = s;
+        args[0].f = q;
+        args[1].s = s + n/2;
+        args[1].f = r;
+        args[0].k = args[1].k = k - 1;
+        args[0].pows = args[1].pows = pows;
+        args[0].leaf = args[1].leaf = leaf;
+        args[0].b = args[1].b = b;
+        args[0].num_threads = (flint_get_num_threads() + 1)/2;
+        args[1].num_threads = flint_get_num_threads()/2;
+
+        threadpool_parallel_do(_fmpz_get_str_worker, args,
+                                             2, sizeof(_get_str_arg_t));
+
+        fmpz_clear(q);
+        fmpz_clear(r);
+    }
+}
+
+/*
+   Converts |f| padded to leaf*2^k digits, where b^(leaf*2^k) > |f|, and
+   removes the leading zeros. The top halves of the padding cost little
+   as their quotients are zero.
+*/
+static char * _fmpz_get_str_dc(char * str, int b, const fmpz_t f)
+{
+    const fmpz * pows;
+    slong k, leaf, n, start, len, digits;
+    char * s;
+    fmpz_t a;
+
+    leaf = _fmpz_radix_leaf(b);
+    digits = fmpz_sizeinbase(f, b);
+
+    /* fmpz_sizeinbase may overestimate, but never underestimates */
+    for (k = 0; (leaf << k) < digits; k++) ;
+
+    pows = _fmpz_radix_powers(b, k);
+
+    fmpz_init(a);
+    fmpz_abs(a, f);
+
+    n = leaf << k;
+    s = flint_malloc(n + 2);
+    _fmpz_get_str_rec(s + 1, a, k, pows, leaf, b);
+
+    for (start = 1; start < n && s[start] == '0'; start++) ;
+
+    if (fmpz_sgn(f) < 0)
+        s[--start] = '-';
+
+    len = n + 1 - start;
+
+    if (str == NULL)
+    {
+        memmove(s, s + start, len);
+        str = flint_realloc(s, len + 1);
+    }
+    else
+    {
+        memcpy(str, s + start, len);
+        flint_free(s);
+    }
+
+    str[len] = '\0';
+
+    _fmpz_radix_powers_clear(pows, b, k);
+    fmpz_clear(a);
+
+    return str;
+}
+
 char * fmpz_get_str(char * str, int b, const fmpz_t f)
 {
     if (!COEFF_IS_MPZ(*f))
@@ -28,6 +172,11 @@ char * fmpz_get_str(char * str, int b, const fmpz_t f)
         str = mpz_get_str(str, b, z);
         mpz_clear(z);
     }
+    else if (b >= 2 && b <= 36 && flint_get_num_threads() > 1 &&
+                               fmpz_size(f) >= 2*FMPZ_STR_DC_LIMBS)
+    {
+        str = _fmpz_get_str_dc(str, b, f);
+    }
     else
     {
         if (!str) {
@@ -38,4 +187,3 @@ char * fmpz_get_str(char * str, int b, const fmpz_t f)
 
     return str;
 }
-
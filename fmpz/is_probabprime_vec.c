@@ -0,0 +1,216 @@
+/*
+    Copyright (C) 2019 William Hart
+
+    This file is part of FLINT.
+
+    FLINT is free software: you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.  See <http://www.gnu.org/licenses/>.
+*/
+
+#include <gmp.h>
+#include "flint.h"
+#include "ulong_extras.h"
+#include "fmpz.h"
+#include "threadpool.h"
+
+/*
+   The odd primes of flint_primes_small are packed into groups whose
+   product fits in a limb. A multi-limb candidate is reduced once modulo
+   each product with mpn_mod_1 and the residue is checked against the
+   primes of the group by multiplying by their inverses modulo
+   2^FLINT_BITS. Word-size entries are collected and handed to
+   _n_is_prime_vec in batches.
+*/
+
+#define SMALL_BATCH (4*FLINT_BITS)
+
+typedef struct
+{
+    ulong prod[FLINT_NUM_PRIMES_SMALL];
+    slong start[FLINT_NUM_PRIMES_SMALL + 1]; /* primes of group g */
+    slong num_groups;
+    ulong inv[FLINT_NUM_PRIMES_SMALL];
+    ulong lim[FLINT_NUM_PRIMES_SMALL];
+} _fmpz_trial_struct;
+
+static void
+_fmpz_trial_init(_fmpz_trial_struct * T)
+{
+    slong i, j;
+    ulong p;
+
+    T->num_groups = 0;
+    T->start[0] = 1;
+    T->prod[0] = 1;
+
+    for (i = 1; i < FLINT_NUM_PRIMES_SMALL; i++)
+    {
+        p = flint_primes_small[i];
+
+        if (T->prod[T->num_groups] > UWORD_MAX/p)
+        {
+            T->num_groups++;
+            T->start[T->num_groups] = i;
+            T->prod[T->num_groups] = 1;
+        }
+
+        T->prod[T->num_groups] *= p;
+
+        /* Newton iteration for p^-1 mod 2^FLINT_BITS */
+        T->inv[i] = p;
+        for (j = 0; j < 5; j++)
+            T->inv[i] *= 2 - p*T->inv[i];
+
+        T->lim[i] = UWORD_MAX/p;
+    }
+
+    T->num_groups++;
+    T->start[T->num_groups] = FLINT_NUM_PRIMES_SMALL;
+}
+
+/* whether the odd multi-limb d has no prime factor in flint_primes_small */
+static int
+_fmpz_trial_coprime(mp_srcptr d, mp_size_t size, const _fmpz_trial_struct * T)
+{
+    slong g, i;
+    ulong r;
+
+    for (g = 0; g < T->num_groups; g++)
+    {
+        r = mpn_mod_1(d, size, T->prod[g]);
+
+        for (i = T->start[g]; i < T->start[g + 1]; i++)
+            if (r*T->inv[i] <= T->lim[i])
+                return 0;
+    }
+
+    return 1;
+}
+
+/* hands the word-size entries small[j] of index idx[j] to _n_is_prime_vec */
+static void
+_fmpz_is_probabprime_vec_small(ulong * res, const ulong * small,
+                                                 const slong * idx, slong num)
+{
+    ulong mask[SMALL_BATCH/FLINT_BITS];
+    slong j;
+
+    _n_is_prime_vec(mask, small, num);
+
+    for (j = 0; j < num; j++)
+        if ((mask[j/FLINT_BITS] >> (j % FLINT_BITS)) & 1)
+            res[idx[j]/FLINT_BITS] |= UWORD(1) << (idx[j] % FLINT_BITS);
+}
+
+slong
+_fmpz_is_probabprime_vec(ulong * res, const fmpz * n, slong len)
+{
+    _fmpz_trial_struct * T;
+    ulong small[SMALL_BATCH];
+    slong idx[SMALL_BATCH];
+    slong i, num_small, limbs;
+    fmpz c;
+
+    limbs = (len + FLINT_BITS - 1)/FLINT_BITS;
+    flint_mpn_zero(res, limbs);
+
+    T = flint_malloc(sizeof(_fmpz_trial_struct));
+    _fmpz_trial_init(T);
+
+    num_small = 0;
+
+    for (i = 0; i < len; i++)
+    {
+        c = n[i];
+
+        if (!COEFF_IS_MPZ(c))
+        {
+            if (c <= 1)
+                continue;
+
+            small[num_small] = c;
+            idx[num_small] = i;
+            num_small++;
+
+            if (num_small == SMALL_BATCH)
+            {
+                _fmpz_is_probabprime_vec_small(res, small, idx, num_small);
+                num_small = 0;
+            }
+        }
+        else
+        {
+            __mpz_struct * z = COEFF_TO_PTR(c);
+
+            if (z->_mp_size <= 0 || (z->_mp_d[0] & 1) == 0)
+                continue;
+
+            if (_fmpz_trial_coprime(z->_mp_d, z->_mp_size, T)
+                    && fmpz_is_probabprime(n + i))
+                res[i/FLINT_BITS] |= UWORD(1) << (i % FLINT_BITS);
+        }
+    }
+
+    if (num_small != 0)
+        _fmpz_is_probabprime_vec_small(res, small, idx, num_small);
+
+    flint_free(T);
+
+    return (limbs == 0) ? 0 : mpn_popcount(res, limbs);
+}
+
+typedef struct
+{
+    ulong * res;
+    const fmpz * n;
+    slong len;
+    slong num;
+} _fmpz_is_probabprime_vec_arg_t;
+
+static void
+_fmpz_is_probabprime_vec_worker(void * arg_ptr)
+{
+    _fmpz_is_probabprime_vec_arg_t * arg =
+                                   (_fmpz_is_probabprime_vec_arg_t *) arg_ptr;
+
+    arg->num = _fmpz_is_probabprime_vec(arg->res, arg->n, arg->len);
+}
+
+slong
+fmpz_is_probabprime_vec(ulong * res, const fmpz * n, slong len)
+{
+    _fmpz_is_probabprime_vec_arg_t * args;
+    slong i, num_threads, block, num;
+
+    /* blocks are whole limbs of res, so that threads write disjoint limbs */
+    num_threads = flint_get_num_threads();
+    num_threads = FLINT_MIN(num_threads, len/FLINT_BITS);
+
+    if (num_threads <= 1)
+        return _fmpz_is_probabprime_vec(res, n, len);
+
+    block = (len + num_threads - 1)/num_threads;
+    block = ((block + FLINT_BITS - 1)/FLINT_BITS)*FLINT_BITS;
+
+    args = flint_malloc(num_threads*sizeof(_fmpz_is_probabprime_vec_arg_t));
+
+    for (i = 0; i < num_threads; i++)
+    {
+        args[i].res = res + (i*block)/FLINT_BITS;
+        args[i].n = n + i*block;
+        args[i].len = FLINT_MAX(0, FLINT_MIN(block, len - i*block));
+    }
+
+    threadpool_parallel_do(_fmpz_is_probabprime_vec_worker, args, num_threads,
+                                      sizeof(_fmpz_is_probabprime_vec_arg_t));
+
+    num = 0;
+    for (i = 0; i < num_threads; i++)
+        num += args[i].num;
+
+    flint_free(args);
+
+    return num;
+}
@@ -34,6 +34,9 @@ ulong mpz_num = 0;
 ulong mpz_alloc = 0;
 ulong mpz_free_num = 0;
 ulong mpz_free_alloc = 0;
+ulong mpz_free_limit = 16384;
+ulong mpz_hits = 0;
+ulong mpz_misses = 0;
 
 #if FLINT_REENTRANT
 void fmpz_lock_init()
@@ -52,9 +55,13 @@ __mpz_struct * _fmpz_new_mpz(void)
 #endif
 
     if (mpz_free_num != 0)
+    {
         z = mpz_free_arr[--mpz_free_num];
+        mpz_hits++;
+    }
     else
     {
+        mpz_misses++;
         z = flint_malloc(sizeof(__mpz_struct));
 
         if (mpz_num == mpz_alloc) /* store pointer to prevent gc cleanup */
@@ -85,6 +92,16 @@ void _fmpz_clear_mpz(fmpz f)
     pthread_mutex_lock(&fmpz_lock);
 #endif
 
+    if (mpz_free_num >= mpz_free_limit)
+    {
+        mpz_clear(ptr);
+        flint_free(ptr);
+#if FLINT_REENTRANT
+        pthread_mutex_unlock(&fmpz_lock);
+#endif
+        return;
+    }
+
     if (mpz_free_num == mpz_free_alloc)
     {
         mpz_free_alloc = FLINT_MAX(64, mpz_free_alloc * 2);
@@ -127,6 +144,68 @@ void _fmpz_cleanup(void)
 #endif
 }
 
+void fmpz_cache_set_limit(ulong limit)
+{
+#if FLINT_REENTRANT
+    pthread_once(&fmpz_initialised, fmpz_lock_init);
+    pthread_mutex_lock(&fmpz_lock);
+#endif
+
+    mpz_free_limit = limit;
+
+    while (mpz_free_num > mpz_free_limit)
+    {
+        mpz_free_num--;
+        mpz_clear(mpz_free_arr[mpz_free_num]);
+        flint_free(mpz_free_arr[mpz_free_num]);
+    }
+
+#if FLINT_REENTRANT
+    pthread_mutex_unlock(&fmpz_lock);
+#endif
+}
+
+ulong fmpz_cache_get_limit(void)
+{
+    return mpz_free_limit;
+}
+
+void fmpz_cache_get_stats(fmpz_cache_stats_t stats)
+{
+    ulong i;
+
+#if FLINT_REENTRANT
+    pthread_once(&fmpz_initialised, fmpz_lock_init);
+    pthread_mutex_lock(&fmpz_lock);
+#endif
+
+    stats->hits = mpz_hits;
+    stats->misses = mpz_misses;
+    stats->remote_frees = 0;
+    stats->retained_bytes = 0;
+    for (i = 0; i < mpz_free_num; i++)
+        stats->retained_bytes += sizeof(__mpz_struct)
+                               + mpz_free_arr[i]->_mp_alloc*sizeof(mp_limb_t);
+
+#if FLINT_REENTRANT
+    pthread_mutex_unlock(&fmpz_lock);
+#endif
+}
+
+void fmpz_cache_reset_stats(void)
+{
+#if FLINT_REENTRANT
+    pthread_once(&fmpz_initialised, fmpz_lock_init);
+    pthread_mutex_lock(&fmpz_lock);
+#endif
+
+    mpz_hits = mpz_misses = 0;
+
+#if FLINT_REENTRANT
+    pthread_mutex_unlock(&fmpz_lock);
+#endif
+}
+
 __mpz_struct * _fmpz_promote(fmpz_t f)
 {
     if (!COEFF_IS_MPZ(*f)) /* f is small so promote it first */
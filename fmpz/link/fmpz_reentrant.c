@@ -35,6 +35,28 @@ void _fmpz_cleanup(void)
 {
 }
 
+/* nothing is cached, so there is nothing to limit or count */
+void fmpz_cache_set_limit(ulong limit)
+{
+}
+
+ulong fmpz_cache_get_limit(void)
+{
+    return 0;
+}
+
+void fmpz_cache_get_stats(fmpz_cache_stats_t stats)
+{
+    stats->hits = 0;
+    stats->misses = 0;
+    stats->remote_frees = 0;
+    stats->retained_bytes = 0;
+}
+
+void fmpz_cache_reset_stats(void)
+{
+}
+
 __mpz_struct * _fmpz_promote(fmpz_t f)
 {
     if (!COEFF_IS_MPZ(*f))  /* f is small so promote it first */
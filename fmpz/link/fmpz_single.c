@@ -18,6 +18,7 @@
 #endif
 
 #include <stdlib.h>
+#include <string.h>
 
 #include <gmp.h>
 #include "flint.h"
@@ -28,18 +29,83 @@
 
 #define PAGES_PER_BLOCK 16
 
-/* The number of new mpz's allocated at a time */
-#define MPZ_BLOCK 64
+/* The number of mpz's moved between a thread and the depot at a time */
+#define MPZ_MAGAZINE 64
 
-FLINT_TLS_PREFIX __mpz_struct ** mpz_free_arr = NULL;
-FLINT_TLS_PREFIX ulong mpz_free_num = 0;
-FLINT_TLS_PREFIX ulong mpz_free_alloc = 0;
-#pragma omp threadprivate(mpz_free_arr, mpz_free_num, mpz_free_alloc)
+/* The default number of mpz's the depot may hold */
+#define MPZ_DEPOT_LIMIT 16384
+
+#if FLINT_FMPZ_INLINE
+/*
+   Each struct is followed by its own limbs, together filling a cache line.
+   The limbs only move to the heap if the value outgrows them, and move back
+   when the mpz is returned to the cache if they grew too large to keep.
+*/
+#define MPZ_SLOT_SIZE 64
+#define MPZ_INLINE_LIMBS \
+    ((slong) ((MPZ_SLOT_SIZE - sizeof(__mpz_struct))/sizeof(mp_limb_t)))
+#define MPZ_INLINE_PTR(z) ((mp_ptr) ((z) + 1))
+#else
+#define MPZ_SLOT_SIZE sizeof(__mpz_struct)
+#endif
+
+/* stored in each page, with the address of the block header */
+#define MPZ_BLOCK_MAGIC (UWORD_MAX/255*0xa5)
+
+/*
+   Free mpz's are cached in two magazines per thread. When both are empty a
+   thread takes a full magazine from the global depot, and when both are full
+   it puts one in the depot. Beyond the depot limit, magazines are cleared
+   and their structs returned to the blocks they were carved from, a whole
+   magazine at a time. A block is freed once all its structs are back.
+*/
+typedef struct _fmpz_magazine_s
+{
+    struct _fmpz_magazine_s * next;
+    slong num;
+    slong fresh; /* arr[0], ..., arr[fresh - 1] have never been used */
+    __mpz_struct * arr[MPZ_MAGAZINE];
+} _fmpz_magazine_s;
+
+FLINT_TLS_PREFIX _fmpz_magazine_s * mpz_loaded = NULL;
+FLINT_TLS_PREFIX _fmpz_magazine_s * mpz_prev = NULL;
+FLINT_TLS_PREFIX ulong mpz_hits = 0;
+FLINT_TLS_PREFIX ulong mpz_misses = 0;
+FLINT_TLS_PREFIX ulong mpz_remote_frees = 0;
+FLINT_TLS_PREFIX slong mpz_retained = 0;
+#pragma omp threadprivate(mpz_loaded, mpz_prev, mpz_hits, mpz_misses)
+#pragma omp threadprivate(mpz_remote_frees, mpz_retained)
+
+/* everything below is protected by the depot lock */
+static _fmpz_magazine_s * mpz_depot = NULL;
+static ulong mpz_depot_num = 0;
+static ulong mpz_depot_limit = MPZ_DEPOT_LIMIT;
+static fmpz_block_header_s * mpz_blocks = NULL; /* blocks with free structs */
+static ulong mpz_total_hits = 0;
+static ulong mpz_total_misses = 0;
+static ulong mpz_total_remote_frees = 0;
+static slong mpz_total_retained = 0;
+
+#if HAVE_PTHREAD
+static pthread_mutex_t mpz_depot_lock = PTHREAD_MUTEX_INITIALIZER;
+#define DEPOT_LOCK pthread_mutex_lock(&mpz_depot_lock)
+#define DEPOT_UNLOCK pthread_mutex_unlock(&mpz_depot_lock)
+#else
+#define DEPOT_LOCK
+#define DEPOT_UNLOCK
+#endif
 
 static slong flint_page_size;
 static slong flint_mpz_structs_per_block;
 static slong flint_page_mask;
 
+#if FLINT_FMPZ_INLINE
+/* the GMP memory functions we hand on to */
+static void * (* mpz_gmp_alloc_func)(size_t) = NULL;
+static void * (* mpz_gmp_realloc_func)(void *, size_t, size_t) = NULL;
+static void (* mpz_gmp_free_func)(void *, size_t) = NULL;
+#endif
+
 slong flint_get_page_size()
 {
 #if defined(__unix__)
@@ -60,128 +126,520 @@ void * flint_align_ptr(void * ptr, slong size)
     return (void *)((mask & (slong) ptr) + size);
 }
 
-__mpz_struct * _fmpz_new_mpz(void)
+#if FLINT_FMPZ_INLINE
+#define MPZ_BYTES(z) (MPZ_SLOT_SIZE + ((z)->_mp_d == MPZ_INLINE_PTR(z) ? \
+                                       0 : (z)->_mp_alloc*sizeof(mp_limb_t)))
+#else
+#define MPZ_BYTES(z) (sizeof(__mpz_struct) + (z)->_mp_alloc*sizeof(mp_limb_t))
+#endif
+
+/* free structs in a block are linked through their first word */
+#define MPZ_NEXT(z) (*((__mpz_struct **) (z)))
+
+static fmpz_block_header_s * _fmpz_block_header(__mpz_struct * ptr)
+{
+    fmpz_block_header_s * page = (fmpz_block_header_s *)
+                                               ((slong) ptr & flint_page_mask);
+
+    return (fmpz_block_header_s *) page->address;
+}
+
+static void _fmpz_flush_counts(void)
 {
-    if (mpz_free_num == 0) /* allocate more mpz's */
+    mpz_total_hits += mpz_hits;
+    mpz_total_misses += mpz_misses;
+    mpz_total_remote_frees += mpz_remote_frees;
+    mpz_total_retained += mpz_retained;
+    mpz_hits = mpz_misses = mpz_remote_frees = 0;
+    mpz_retained = 0;
+}
+
+static void _fmpz_block_link(fmpz_block_header_s * h)
+{
+    h->prev = NULL;
+    h->next = mpz_blocks;
+    if (mpz_blocks != NULL)
+        mpz_blocks->prev = h;
+    mpz_blocks = h;
+}
+
+static void _fmpz_block_unlink(fmpz_block_header_s * h)
+{
+    if (h->prev != NULL)
+        h->prev->next = h->next;
+    else
+        mpz_blocks = h->next;
+    if (h->next != NULL)
+        h->next->prev = h->prev;
+}
+
+#if FLINT_FMPZ_INLINE
+
+/*
+   Whether ptr is the limb array of a struct in one of our blocks. Any other
+   pointer GMP hands us lies in a live allocation, so the start of its page
+   is mapped and can be read. Our pages start with the address of their
+   block and a check word derived from it, which are wiped before a block is
+   freed, and the limbs of a slot are at a fixed offset from its start.
+*/
+static int _fmpz_is_inline(void * ptr)
+{
+    fmpz_block_header_s * page;
+    slong offset;
+
+    if (flint_page_mask == 0)
+        return 0;
+
+    page = (fmpz_block_header_s *) ((slong) ptr & flint_page_mask);
+
+    if (page->check != ((ulong) page->address ^ MPZ_BLOCK_MAGIC))
+        return 0;
+
+    offset = (char *) ptr - (char *) page;
+
+    return offset % MPZ_SLOT_SIZE == sizeof(__mpz_struct);
+}
+
+static void * _fmpz_inline_realloc(void * ptr, size_t old_size, size_t new_size)
+{
+    void * new_ptr;
+
+    if (!_fmpz_is_inline(ptr))
+        return mpz_gmp_realloc_func(ptr, old_size, new_size);
+
+    if (new_size <= MPZ_INLINE_LIMBS*sizeof(mp_limb_t))
+        return ptr;
+
+    new_ptr = mpz_gmp_alloc_func(new_size);
+    memcpy(new_ptr, ptr, FLINT_MIN(old_size, new_size));
+
+    return new_ptr;
+}
+
+static void _fmpz_inline_free(void * ptr, size_t size)
+{
+    if (!_fmpz_is_inline(ptr))
+        mpz_gmp_free_func(ptr, size);
+}
+
+/* stop the pages of a block being recognised, before it is freed */
+static void _fmpz_inline_wipe(fmpz_block_header_s * h)
+{
+    slong i;
+
+    for (i = 0; i < PAGES_PER_BLOCK; i++)
+        ((fmpz_block_header_s *) ((char *) h + i*flint_page_size))->check = 0;
+}
+
+static void _fmpz_inline_install(void)
+{
+    if (mpz_gmp_free_func == NULL)
     {
-        void * aligned_ptr, * ptr;
+        mp_get_memory_functions(&mpz_gmp_alloc_func, &mpz_gmp_realloc_func,
+                                                           &mpz_gmp_free_func);
+        mp_set_memory_functions(mpz_gmp_alloc_func, _fmpz_inline_realloc,
+                                                           _fmpz_inline_free);
+    }
+}
 
-        slong i, j, num, block_size, skip;
+#endif
+
+static void _fmpz_new_block(void)
+{
+    void * ptr;
+    fmpz_block_header_s * header;
+    slong i, j, num, skip, block_size;
 
+    if (flint_page_size == 0)
+    {
         flint_page_size = flint_get_page_size();
-        block_size = PAGES_PER_BLOCK*flint_page_size;
         flint_page_mask = ~(flint_page_size - 1);
+    }
 
-        /* get new block */
-        ptr = flint_malloc(block_size + flint_page_size);
+    block_size = PAGES_PER_BLOCK*flint_page_size;
 
-        /* align to page boundary */
-        aligned_ptr = flint_align_ptr(ptr, flint_page_size);
+    /* get new block and align to page boundary */
+    ptr = flint_malloc(block_size + flint_page_size);
+    header = (fmpz_block_header_s *) flint_align_ptr(ptr, flint_page_size);
 
-        /* set free count to zero and determine if this is the main thread */
-        ((fmpz_block_header_s *) ptr)->count = 0;
+    header->mem = ptr;
+    header->count = 0;
+    header->free = NULL;
 #if HAVE_PTHREAD
-        ((fmpz_block_header_s *) ptr)->thread = pthread_self();
+    header->thread = pthread_self();
+#endif
+
+    /* total number of slots per page */
+    num = flint_page_size/MPZ_SLOT_SIZE;
+
+    for (i = 0; i < PAGES_PER_BLOCK; i++)
+    {
+        char * page_ptr = (char *) header + i*flint_page_size;
+
+        /*
+           the first page holds the block header, the others its address and
+           check word, which are the first fields of the header
+        */
+        ((fmpz_block_header_s *) page_ptr)->address = header;
+        ((fmpz_block_header_s *) page_ptr)->check =
+                                           (ulong) header ^ MPZ_BLOCK_MAGIC;
+
+        if (i == 0)
+            skip = (sizeof(fmpz_block_header_s) - 1)/MPZ_SLOT_SIZE + 1;
+        else
+            skip = (2*sizeof(void *) - 1)/MPZ_SLOT_SIZE + 1;
+
+        for (j = num - 1; j >= skip; j--)
+        {
+            __mpz_struct * z = (__mpz_struct *) (page_ptr + j*MPZ_SLOT_SIZE);
+
+            MPZ_NEXT(z) = header->free;
+            header->free = z;
+            header->count++;
+        }
+    }
+
+    flint_mpz_structs_per_block = header->count;
+    mpz_total_retained += header->count*MPZ_SLOT_SIZE;
+
+    _fmpz_block_link(header);
+#if FLINT_FMPZ_INLINE
+    _fmpz_inline_install();
 #endif
-        /* how many __mpz_structs worth are dedicated to header, per page */
-        skip = (sizeof(fmpz_block_header_s) - 1)/sizeof(__mpz_struct) + 1;
+}
+
+/* take n uninitialised structs from the blocks, with the depot lock held */
+static void _fmpz_take_structs(__mpz_struct ** arr, slong n)
+{
+    slong i = 0;
 
-        /* total number of number of __mpz_structs worth per page */
-        num = flint_page_size/sizeof(__mpz_struct);
+    while (i < n)
+    {
+        fmpz_block_header_s * h;
+
+        if (mpz_blocks == NULL)
+            _fmpz_new_block();
 
-        flint_mpz_structs_per_block = PAGES_PER_BLOCK*(num - skip);
+        h = mpz_blocks;
 
-        for (i = 0; i < PAGES_PER_BLOCK; i++)
+        while (i < n && h->free != NULL)
         {
-            __mpz_struct * page_ptr = (__mpz_struct *)((slong) aligned_ptr + i*flint_page_size);
-
-            /* set pointer in each page to start of entire block */
-            ((fmpz_block_header_s *) page_ptr)->address = ptr;
-
-            for (j = skip; j < num; j++)
-            {
-                mpz_init2(page_ptr + j, 2*FLINT_BITS);
-
-                /*
-                   Cannot be lifted from loop due to possibility of
-                   gc calling _fmpz_clear_mpz during call to mpz_init_2
-                */
-                if (mpz_free_num >= mpz_free_alloc)
-                {
-                    mpz_free_alloc = FLINT_MAX(mpz_free_num + 1, mpz_free_alloc * 2);
-                    mpz_free_arr = flint_realloc(mpz_free_arr, mpz_free_alloc * sizeof(__mpz_struct *));
-                }
-
-                mpz_free_arr[mpz_free_num++] = page_ptr + j;
-            }
+            arr[i++] = h->free;
+            h->free = MPZ_NEXT(h->free);
+            h->count--;
         }
+
+        if (h->count == 0)
+            _fmpz_block_unlink(h);
     }
 
-    return mpz_free_arr[--mpz_free_num];
+    mpz_total_retained -= n*MPZ_SLOT_SIZE;
 }
 
-void _fmpz_clear_mpz(fmpz f)
+/* return n cleared structs to their blocks, with the depot lock held */
+static void _fmpz_return_structs(__mpz_struct ** arr, slong n)
 {
-    __mpz_struct * ptr = COEFF_TO_PTR(f);
+    slong i;
+
+    mpz_total_retained += n*MPZ_SLOT_SIZE;
 
-    /* check free count for block is zero, else this mpz came from a thread */
-    fmpz_block_header_s * header_ptr = (fmpz_block_header_s *)((slong) ptr & flint_page_mask);
+    for (i = 0; i < n; i++)
+    {
+        fmpz_block_header_s * h = _fmpz_block_header(arr[i]);
 
-    header_ptr = (fmpz_block_header_s *) header_ptr->address;
+        if (h->count == 0)
+            _fmpz_block_link(h);
 
-    /* clean up if this is left over from another thread */
-#if HAVE_PTHREAD
-    if (header_ptr->count != 0 || !pthread_equal(header_ptr->thread, pthread_self()))
+        MPZ_NEXT(arr[i]) = h->free;
+        h->free = arr[i];
+
+        if (++h->count == flint_mpz_structs_per_block)
+        {
+            _fmpz_block_unlink(h);
+#if FLINT_FMPZ_INLINE
+            _fmpz_inline_wipe(h);
+#endif
+            mpz_total_retained -= h->count*MPZ_SLOT_SIZE;
+            flint_free(h->mem);
+        }
+    }
+}
+
+static void _fmpz_slot_init(__mpz_struct * z)
+{
+#if FLINT_FMPZ_INLINE
+    z->_mp_alloc = MPZ_INLINE_LIMBS;
+    z->_mp_size = 0;
+    z->_mp_d = MPZ_INLINE_PTR(z);
 #else
-    if (header_ptr->count != 0)
+    mpz_init2(z, 2*FLINT_BITS);
 #endif
+}
+
+static void _fmpz_slot_clear(__mpz_struct * z)
+{
+#if FLINT_FMPZ_INLINE
+    if (z->_mp_d != MPZ_INLINE_PTR(z))
+        mpz_clear(z);
+#else
+    mpz_clear(z);
+#endif
+}
+
+static _fmpz_magazine_s * _fmpz_magazine_new(void)
+{
+    _fmpz_magazine_s * m;
+
+    m = (_fmpz_magazine_s *) flint_malloc(sizeof(_fmpz_magazine_s));
+    m->next = NULL;
+    m->num = 0;
+    m->fresh = 0;
+
+    return m;
+}
+
+/* clear the contents of m and give the structs back to their blocks */
+static void _fmpz_magazine_release(_fmpz_magazine_s * m)
+{
+    slong i;
+
+    for (i = 0; i < m->num; i++)
     {
-        mpz_clear(ptr);
+        mpz_retained -= MPZ_BYTES(m->arr[i]);
+        _fmpz_slot_clear(m->arr[i]);
+    }
+
+    DEPOT_LOCK;
+    _fmpz_flush_counts();
+    _fmpz_return_structs(m->arr, m->num);
+    DEPOT_UNLOCK;
+
+    m->num = 0;
+    m->fresh = 0;
+}
+
+/* make sure the loaded magazine is not empty */
+static void _fmpz_reload(void)
+{
+    _fmpz_magazine_s * m;
+    slong i;
 
-        if (++header_ptr->count == flint_mpz_structs_per_block)
-            flint_free(header_ptr);
-    } else
+    if (mpz_prev != NULL && mpz_prev->num != 0)
     {
-        if (ptr->_mp_alloc > FLINT_MPZ_MAX_CACHE_LIMBS)
-            mpz_realloc2(ptr, 2*FLINT_BITS);
+        m = mpz_loaded;
+        mpz_loaded = mpz_prev;
+        mpz_prev = m;
+        return;
+    }
 
-        if (mpz_free_num == mpz_free_alloc)
-        {
-            mpz_free_alloc = FLINT_MAX(64, mpz_free_alloc * 2);
-            mpz_free_arr = flint_realloc(mpz_free_arr, mpz_free_alloc * sizeof(__mpz_struct *));
-        }
+    DEPOT_LOCK;
+
+    if (mpz_depot != NULL)
+    {
+        m = mpz_depot;
+        mpz_depot = m->next;
+        mpz_depot_num--;
+        _fmpz_flush_counts();
+        DEPOT_UNLOCK;
 
-        mpz_free_arr[mpz_free_num++] = ptr;
+        if (mpz_loaded != NULL)
+            flint_free(mpz_loaded);
+        mpz_loaded = m;
+
+        return;
+    }
+
+    if (mpz_loaded == NULL)
+        mpz_loaded = _fmpz_magazine_new();
+
+    _fmpz_take_structs(mpz_loaded->arr, MPZ_MAGAZINE);
+    _fmpz_flush_counts();
+
+    DEPOT_UNLOCK;
+
+    for (i = 0; i < MPZ_MAGAZINE; i++)
+    {
+        _fmpz_slot_init(mpz_loaded->arr[i]);
+        mpz_retained += MPZ_BYTES(mpz_loaded->arr[i]);
     }
+
+    mpz_loaded->num = MPZ_MAGAZINE;
+    mpz_loaded->fresh = MPZ_MAGAZINE;
 }
 
-void _fmpz_cleanup_mpz_content(void)
+/* make sure the loaded magazine is not full */
+static void _fmpz_unload(void)
+{
+    _fmpz_magazine_s * m;
+
+    if (mpz_loaded == NULL)
+    {
+        mpz_loaded = _fmpz_magazine_new();
+        return;
+    }
+
+    if (mpz_prev == NULL)
+        mpz_prev = _fmpz_magazine_new();
+
+    if (mpz_prev->num == 0)
+    {
+        m = mpz_loaded;
+        mpz_loaded = mpz_prev;
+        mpz_prev = m;
+        return;
+    }
+
+    m = mpz_prev;
+    mpz_prev = mpz_loaded;
+    mpz_loaded = _fmpz_magazine_new();
+
+    DEPOT_LOCK;
+
+    _fmpz_flush_counts();
+
+    if ((mpz_depot_num + 1)*MPZ_MAGAZINE <= mpz_depot_limit)
+    {
+        m->next = mpz_depot;
+        mpz_depot = m;
+        mpz_depot_num++;
+        DEPOT_UNLOCK;
+        return;
+    }
+
+    DEPOT_UNLOCK;
+
+    _fmpz_magazine_release(m);
+    flint_free(m);
+}
+
+__mpz_struct * _fmpz_new_mpz(void)
+{
+    __mpz_struct * z;
+
+    if (mpz_loaded == NULL || mpz_loaded->num == 0)
+        _fmpz_reload();
+
+    z = mpz_loaded->arr[--mpz_loaded->num];
+
+    if (mpz_loaded->num < mpz_loaded->fresh)
+    {
+        mpz_loaded->fresh = mpz_loaded->num;
+        mpz_misses++;
+    }
+    else
+        mpz_hits++;
+
+    mpz_retained -= MPZ_BYTES(z);
+
+    return z;
+}
+
+void _fmpz_clear_mpz(fmpz f)
 {
-    ulong i;
+    __mpz_struct * ptr = COEFF_TO_PTR(f);
+
+#if HAVE_PTHREAD
+    if (!pthread_equal(_fmpz_block_header(ptr)->thread, pthread_self()))
+        mpz_remote_frees++;
+#endif
 
-    for (i = 0; i < mpz_free_num; i++)
+    if (ptr->_mp_alloc > FLINT_MPZ_MAX_CACHE_LIMBS)
     {
-       fmpz_block_header_s * ptr;
+#if FLINT_FMPZ_INLINE
+        _fmpz_slot_clear(ptr);
+        _fmpz_slot_init(ptr);
+#else
+        mpz_realloc2(ptr, 2*FLINT_BITS);
+#endif
+    }
+
+    if (mpz_loaded == NULL || mpz_loaded->num == MPZ_MAGAZINE)
+        _fmpz_unload();
 
-       mpz_clear(mpz_free_arr[i]);
+    mpz_loaded->arr[mpz_loaded->num++] = ptr;
+    mpz_retained += MPZ_BYTES(ptr);
+}
 
-       /* update count of cleared mpz's for block */
-       ptr = (fmpz_block_header_s *)((slong) mpz_free_arr[i] & ~(flint_page_size - 1));
+/* empty the depot down to the given number of magazines */
+static void _fmpz_depot_trim(ulong num)
+{
+    _fmpz_magazine_s * m, * list = NULL;
 
-       ptr = (fmpz_block_header_s *) ptr->address;
+    DEPOT_LOCK;
+    while (mpz_depot_num > num)
+    {
+        m = mpz_depot;
+        mpz_depot = m->next;
+        mpz_depot_num--;
+        m->next = list;
+        list = m;
+    }
+    DEPOT_UNLOCK;
 
-       if (++ptr->count == flint_mpz_structs_per_block)
-          flint_free(ptr);
+    while (list != NULL)
+    {
+        m = list;
+        list = m->next;
+        _fmpz_magazine_release(m);
+        flint_free(m);
     }
+}
+
+void _fmpz_cleanup_mpz_content(void)
+{
+    if (mpz_loaded != NULL)
+        _fmpz_magazine_release(mpz_loaded);
 
-    mpz_free_num = mpz_free_alloc = 0;
+    if (mpz_prev != NULL)
+        _fmpz_magazine_release(mpz_prev);
 }
 
 void _fmpz_cleanup(void)
 {
     _fmpz_cleanup_mpz_content();
-    flint_free(mpz_free_arr);
-    mpz_free_arr = NULL;
+
+    flint_free(mpz_loaded);
+    flint_free(mpz_prev);
+    mpz_loaded = mpz_prev = NULL;
+
+    _fmpz_depot_trim(0);
+
+    DEPOT_LOCK;
+    _fmpz_flush_counts();
+    DEPOT_UNLOCK;
+}
+
+void fmpz_cache_set_limit(ulong limit)
+{
+    DEPOT_LOCK;
+    mpz_depot_limit = limit;
+    DEPOT_UNLOCK;
+
+    _fmpz_depot_trim(limit/MPZ_MAGAZINE);
+}
+
+ulong fmpz_cache_get_limit(void)
+{
+    return mpz_depot_limit;
+}
+
+void fmpz_cache_get_stats(fmpz_cache_stats_t stats)
+{
+    DEPOT_LOCK;
+    _fmpz_flush_counts();
+    stats->hits = mpz_total_hits;
+    stats->misses = mpz_total_misses;
+    stats->remote_frees = mpz_total_remote_frees;
+    stats->retained_bytes = FLINT_MAX(mpz_total_retained, 0);
+    DEPOT_UNLOCK;
+}
+
+void fmpz_cache_reset_stats(void)
+{
+    DEPOT_LOCK;
+    _fmpz_flush_counts();
+    mpz_total_hits = mpz_total_misses = mpz_total_remote_frees = 0;
+    DEPOT_UNLOCK;
 }
 
 __mpz_struct * _fmpz_promote(fmpz_t f)
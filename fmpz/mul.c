@@ -15,7 +15,7 @@
 #include "fmpz.h"
 
 void
-fmpz_mul(fmpz_t f, const fmpz_t g, const fmpz_t h)
+_fmpz_mul_general(fmpz_t f, const fmpz_t g, const fmpz_t h)
 {
     fmpz c1, c2;
     __mpz_struct *mpz_ptr;
@@ -16,9 +16,6 @@
 
 int fmpz_print(const fmpz_t x)
 {
-	if (!COEFF_IS_MPZ(*x)) 
-        return flint_printf("%wd", *x);
-	else 
-        return (int) mpz_out_str(stdout, 10, COEFF_TO_PTR(*x));
+    return fmpz_fprint(stdout, x);
 }
 
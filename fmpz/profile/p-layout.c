@@ -0,0 +1,121 @@
+/*
+    Copyright (C) 2019 William Hart
+
+    This file is part of FLINT.
+
+    FLINT is free software: you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.  See <http://www.gnu.org/licenses/>.
+*/
+
+/*
+   Times operations dominated by allocating and freeing multiprecision
+   fmpz's of a few limbs. Run it once with FLINT configured with
+   --enable-fmpz-inline and once without to compare the two layouts.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <gmp.h>
+#include "flint.h"
+#include "fmpz.h"
+#include "fmpz_vec.h"
+#include "fmpz_poly.h"
+#include "fmpz_mat.h"
+#include "ulong_extras.h"
+#include "profiler.h"
+
+#define VEC_LEN 10000
+#define POLY_LEN 200
+#define MAT_DIM 40
+
+int
+main(void)
+{
+    slong limbs, i, iter;
+    timeit_t t;
+    FLINT_TEST_INIT(state);
+
+#if FLINT_FMPZ_INLINE && !FLINT_REENTRANT
+    flint_printf("layout: mpz struct and limbs in one slot\n\n");
+#else
+    flint_printf("layout: limbs allocated separately\n\n");
+#endif
+
+    for (limbs = 2; limbs <= 8; limbs++)
+    {
+        mp_bitcnt_t bits = limbs*FLINT_BITS - 1;
+        fmpz * u, * v;
+        fmpz_poly_t f, g, h;
+        fmpz_mat_t A, B, C;
+
+        flint_printf("limbs = %wd\n", limbs);
+
+        /* vector arithmetic, with the outputs created and destroyed */
+        u = _fmpz_vec_init(VEC_LEN);
+        _fmpz_vec_randtest(u, state, VEC_LEN, bits);
+
+        timeit_start(t);
+        for (iter = 0; iter < 100; iter++)
+        {
+            v = _fmpz_vec_init(VEC_LEN);
+            for (i = 0; i < VEC_LEN - 1; i++)
+                fmpz_mul(v + i, u + i, u + i + 1);
+            for (i = 0; i < VEC_LEN - 1; i++)
+                fmpz_add(v + i, v + i, u + i);
+            _fmpz_vec_clear(v, VEC_LEN);
+        }
+        timeit_stop(t);
+
+        flint_printf("   vec mul/add:  %wd ms\n", (slong) t->cpu);
+
+        _fmpz_vec_clear(u, VEC_LEN);
+
+        /* classical polynomial multiplication */
+        fmpz_poly_init(f);
+        fmpz_poly_init(g);
+        fmpz_poly_init(h);
+        fmpz_poly_randtest(f, state, POLY_LEN, bits/2);
+        fmpz_poly_randtest(g, state, POLY_LEN, bits/2);
+
+        timeit_start(t);
+        for (iter = 0; iter < 20; iter++)
+        {
+            fmpz_poly_zero(h);
+            fmpz_poly_mul_classical(h, f, g);
+        }
+        timeit_stop(t);
+
+        flint_printf("   poly mul:     %wd ms\n", (slong) t->cpu);
+
+        fmpz_poly_clear(f);
+        fmpz_poly_clear(g);
+        fmpz_poly_clear(h);
+
+        /* classical matrix multiplication */
+        fmpz_mat_init(A, MAT_DIM, MAT_DIM);
+        fmpz_mat_init(B, MAT_DIM, MAT_DIM);
+        fmpz_mat_init(C, MAT_DIM, MAT_DIM);
+        fmpz_mat_randbits(A, state, bits/2);
+        fmpz_mat_randbits(B, state, bits/2);
+
+        timeit_start(t);
+        for (iter = 0; iter < 20; iter++)
+        {
+            fmpz_mat_zero(C);
+            fmpz_mat_mul_classical(C, A, B);
+        }
+        timeit_stop(t);
+
+        flint_printf("   mat mul:      %wd ms\n", (slong) t->cpu);
+
+        fmpz_mat_clear(A);
+        fmpz_mat_clear(B);
+        fmpz_mat_clear(C);
+    }
+
+    flint_randclear(state);
+    flint_cleanup();
+    return 0;
+}
@@ -0,0 +1,161 @@
+/*
+    Copyright (C) 2019 William Hart
+
+    This file is part of FLINT.
+
+    FLINT is free software: you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.  See <http://www.gnu.org/licenses/>.
+*/
+
+/*
+   Compares the inline small cases of fmpz_add, fmpz_sub, fmpz_mul,
+   fmpz_addmul and fmpz_cmp with calling the out-of-line functions directly,
+   then times some classical multiplications built on them.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <gmp.h>
+#include "flint.h"
+#include "fmpz.h"
+#include "fmpz_vec.h"
+#include "fmpz_poly.h"
+#include "fmpz_mat.h"
+#include "ulong_extras.h"
+#include "profiler.h"
+
+#define LEN 1000
+#define REPS 20000
+
+int
+main(void)
+{
+    fmpz * a, * b, * c;
+    fmpz_poly_t f, g, h;
+    fmpz_mat_t A, B, C;
+    slong i, iter, bits;
+    int s;
+    timeit_t t0, t1;
+    FLINT_TEST_INIT(state);
+
+    a = _fmpz_vec_init(LEN);
+    b = _fmpz_vec_init(LEN);
+    c = _fmpz_vec_init(LEN);
+
+    for (bits = 10; bits <= FLINT_BITS - 2; bits += 10)
+    {
+        _fmpz_vec_randtest(a, state, LEN, bits);
+        _fmpz_vec_randtest(b, state, LEN, bits);
+
+        flint_printf("bits = %wd (inline / out of line)\n", bits);
+
+        timeit_start(t0);
+        for (iter = 0; iter < REPS; iter++)
+            for (i = 0; i < LEN; i++)
+                fmpz_add(c + i, a + i, b + i);
+        timeit_stop(t0);
+        timeit_start(t1);
+        for (iter = 0; iter < REPS; iter++)
+            for (i = 0; i < LEN; i++)
+                _fmpz_add_general(c + i, a + i, b + i);
+        timeit_stop(t1);
+        flint_printf("   add:     %wd / %wd ms\n", t0->cpu, t1->cpu);
+
+        timeit_start(t0);
+        for (iter = 0; iter < REPS; iter++)
+            for (i = 0; i < LEN; i++)
+                fmpz_sub(c + i, a + i, b + i);
+        timeit_stop(t0);
+        timeit_start(t1);
+        for (iter = 0; iter < REPS; iter++)
+            for (i = 0; i < LEN; i++)
+                _fmpz_sub_general(c + i, a + i, b + i);
+        timeit_stop(t1);
+        flint_printf("   sub:     %wd / %wd ms\n", t0->cpu, t1->cpu);
+
+        timeit_start(t0);
+        for (iter = 0; iter < REPS; iter++)
+            for (i = 0; i < LEN; i++)
+                fmpz_mul(c + i, a + i, b + i);
+        timeit_stop(t0);
+        timeit_start(t1);
+        for (iter = 0; iter < REPS; iter++)
+            for (i = 0; i < LEN; i++)
+                _fmpz_mul_general(c + i, a + i, b + i);
+        timeit_stop(t1);
+        flint_printf("   mul:     %wd / %wd ms\n", t0->cpu, t1->cpu);
+
+        _fmpz_vec_zero(c, LEN);
+        timeit_start(t0);
+        for (iter = 0; iter < REPS; iter++)
+            for (i = 0; i < LEN; i++)
+                fmpz_addmul(c + i, a + i, b + i);
+        timeit_stop(t0);
+        _fmpz_vec_zero(c, LEN);
+        timeit_start(t1);
+        for (iter = 0; iter < REPS; iter++)
+            for (i = 0; i < LEN; i++)
+                _fmpz_addmul_general(c + i, a + i, b + i);
+        timeit_stop(t1);
+        flint_printf("   addmul:  %wd / %wd ms\n", t0->cpu, t1->cpu);
+
+        s = 0;
+        timeit_start(t0);
+        for (iter = 0; iter < REPS; iter++)
+            for (i = 0; i < LEN; i++)
+                s += fmpz_cmp(a + i, b + i);
+        timeit_stop(t0);
+        timeit_start(t1);
+        for (iter = 0; iter < REPS; iter++)
+            for (i = 0; i < LEN; i++)
+                s -= _fmpz_cmp_general(a + i, b + i);
+        timeit_stop(t1);
+        flint_printf("   cmp:     %wd / %wd ms%s\n", t0->cpu, t1->cpu,
+                                                         s != 0 ? " (!)" : "");
+    }
+
+    _fmpz_vec_clear(a, LEN);
+    _fmpz_vec_clear(b, LEN);
+    _fmpz_vec_clear(c, LEN);
+
+    /* inner loops which are dominated by small arithmetic */
+    fmpz_poly_init(f);
+    fmpz_poly_init(g);
+    fmpz_poly_init(h);
+    fmpz_poly_randtest(f, state, 500, 20);
+    fmpz_poly_randtest(g, state, 500, 20);
+
+    timeit_start(t0);
+    for (iter = 0; iter < 1000; iter++)
+        fmpz_poly_mul_classical(h, f, g);
+    timeit_stop(t0);
+    flint_printf("\nfmpz_poly_mul_classical, length 500, 20 bits: %wd ms\n",
+                                                                     t0->cpu);
+
+    fmpz_poly_clear(f);
+    fmpz_poly_clear(g);
+    fmpz_poly_clear(h);
+
+    fmpz_mat_init(A, 100, 100);
+    fmpz_mat_init(B, 100, 100);
+    fmpz_mat_init(C, 100, 100);
+    fmpz_mat_randbits(A, state, 20);
+    fmpz_mat_randbits(B, state, 20);
+
+    timeit_start(t0);
+    for (iter = 0; iter < 10; iter++)
+        fmpz_mat_mul_classical(C, A, B);
+    timeit_stop(t0);
+    flint_printf("fmpz_mat_mul_classical, 100 x 100, 20 bits: %wd ms\n",
+                                                                     t0->cpu);
+
+    fmpz_mat_clear(A);
+    fmpz_mat_clear(B);
+    fmpz_mat_clear(C);
+
+    flint_randclear(state);
+    flint_cleanup();
+    return 0;
+}
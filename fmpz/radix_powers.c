@@ -0,0 +1,109 @@
+/*
+    Copyright (C) 2019 William Hart
+
+    This file is part of FLINT.
+
+    FLINT is free software: you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.  See <http://www.gnu.org/licenses/>.
+*/
+
+#include <math.h>
+#include <gmp.h>
+#include <pthread.h>
+#include "flint.h"
+#include "fmpz.h"
+#include "fmpz_vec.h"
+
+/*
+   The powers of 10 are kept between calls, as decimal is what the I/O
+   functions use. Entries are only ever appended, so a table handed to
+   other threads stays valid while the owner extends it.
+*/
+
+#if FLINT_REENTRANT && !HAVE_TLS
+static pthread_once_t radix_initialised = PTHREAD_ONCE_INIT;
+pthread_mutex_t radix_lock;
+
+static void _fmpz_radix_powers_init(void)
+{
+    pthread_mutex_init(&radix_lock, NULL);
+}
+#endif
+
+FLINT_TLS_PREFIX fmpz _fmpz_radix_pow10[FLINT_BITS];
+FLINT_TLS_PREFIX slong _fmpz_radix_pow10_num = 0;
+#pragma omp threadprivate(_fmpz_radix_pow10, _fmpz_radix_pow10_num)
+
+static void _fmpz_radix_powers_cleanup(void)
+{
+    slong i;
+
+    for (i = 0; i < _fmpz_radix_pow10_num; i++)
+        fmpz_clear(_fmpz_radix_pow10 + i);
+
+    _fmpz_radix_pow10_num = 0;
+}
+
+slong _fmpz_radix_leaf(int b)
+{
+    return (slong) ((FMPZ_STR_LEAF_LIMBS * FLINT_BITS) * log(2.0)
+                                                          / log((double) b));
+}
+
+static void
+_fmpz_radix_powers_fill(fmpz * pows, slong start, slong num, int b)
+{
+    slong i;
+
+    for (i = start; i < num; i++)
+    {
+        if (i == 0)
+        {
+            fmpz_set_ui(pows, b);
+            fmpz_pow_ui(pows, pows, _fmpz_radix_leaf(b));
+        }
+        else
+            fmpz_mul(pows + i, pows + i - 1, pows + i - 1);
+    }
+}
+
+const fmpz * _fmpz_radix_powers(int b, slong num)
+{
+    fmpz * pows;
+
+    if (b != 10)
+    {
+        pows = _fmpz_vec_init(num);
+        _fmpz_radix_powers_fill(pows, 0, num, b);
+        return pows;
+    }
+
+#if FLINT_REENTRANT && !HAVE_TLS
+    pthread_once(&radix_initialised, _fmpz_radix_powers_init);
+    pthread_mutex_lock(&radix_lock);
+#endif
+
+    if (num > _fmpz_radix_pow10_num)
+    {
+        if (_fmpz_radix_pow10_num == 0)
+            flint_register_cleanup_function(_fmpz_radix_powers_cleanup);
+
+        _fmpz_radix_powers_fill(_fmpz_radix_pow10, _fmpz_radix_pow10_num,
+                                                                     num, b);
+        _fmpz_radix_pow10_num = num;
+    }
+
+#if FLINT_REENTRANT && !HAVE_TLS
+    pthread_mutex_unlock(&radix_lock);
+#endif
+
+    return _fmpz_radix_pow10;
+}
+
+void _fmpz_radix_powers_clear(const fmpz * pows, int b, slong num)
+{
+    if (b != 10)
+        _fmpz_vec_clear((fmpz *) pows, num);
+}
@@ -18,13 +18,5 @@
 int 
 fmpz_read(fmpz_t f)
 {
-    mpz_t t;
-    size_t r;
-
-    mpz_init(t);
-    r = mpz_inp_str(t, stdin, 10);
-    fmpz_set_mpz(f, t);
-    mpz_clear(t);
-
-    return (r > 0) ? 1 : 0;
+    return fmpz_fread(stdin, f);
 }
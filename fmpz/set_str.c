@@ -1,5 +1,6 @@
 /*
     Copyright (C) 2010 Sebastian Pancratz
+    Copyright (C) 2019 William Hart
 
     This file is part of FLINT.
 
@@ -9,20 +10,174 @@
     (at your option) any later version.  See <http://www.gnu.org/licenses/>.
 */
 
+#include <string.h>
 #include <gmp.h>
 #include "flint.h"
 #include "ulong_extras.h"
+#include "threadpool.h"
 #include "fmpz.h"
 
+static int _fmpz_digit_value(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'z')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'Z')
+        return c - 'A' + 10;
+    return 36;
+}
+
+/*
+   Sets f to the value of the n digits at s, which are known to be valid.
+   As for fmpz_get_str, the string is only split while there are threads
+   to convert the halves on.
+*/
+static void _fmpz_set_str_rec(fmpz_t f, const char * s, slong n,
+                                      const fmpz * pows, slong leaf, int b);
+
+typedef struct
+{
+    fmpz * f;
+    const char * s;
+    slong n;
+    const fmpz * pows;
+    slong leaf;
+    int b;
+    int num_threads;
+} _set_str_arg_t;
+
+static void _fmpz_set_str_worker(void * arg_ptr)
+{
+    _set_str_arg_t * arg = (_set_str_arg_t *) arg_ptr;
+    int num_threads = flint_get_num_threads();
+
+    flint_set_num_threads(arg->num_threads);
+    _fmpz_set_str_rec(arg->f, arg->s, arg->n, arg->pows, arg->leaf, arg->b);
+    flint_set_num_threads(num_threads);
+}
+
+static void _fmpz_set_str_rec(fmpz_t f, const char * s, slong n,
+                                       const fmpz * pows, slong leaf, int b)
+{
+    while (n > 0 && *s == '0')
+    {
+        s++;
+        n--;
+    }
+
+    if (n <= leaf || flint_get_num_threads() == 1 ||
+                      n*FLINT_BIT_COUNT(b - 1) < 2*FMPZ_STR_DC_LIMBS*FLINT_BITS)
+    {
+        slong i, len;
+        unsigned char * u;
+        mp_ptr t;
+
+        if (n == 0)
+        {
+            fmpz_zero(f);
+            return;
+        }
+
+        u = flint_malloc(n);
+        t = flint_malloc((n*FLINT_BIT_COUNT(b - 1)/FLINT_BITS + 2)
+                                                         * sizeof(mp_limb_t));
+
+        for (i = 0; i < n; i++)
+            u[i] = _fmpz_digit_value(s[i]);
+
+        len = mpn_set_str(t, u, n, b);
+        fmpz_set_ui_array(f, t, len);
+
+        flint_free(u);
+        flint_free(t);
+    }
+    else
+    {
+        _set_str_arg_t args[2];
+        slong k, m;
+        fmpz_t lo;
+
+        for (k = 0; (leaf << (k + 1)) < n; k++) ;
+        m = leaf << k;
+
+        fmpz_init(lo);
+
+        args[0].f = f;
+        args[0].s = s;
+        args[0].n = n - m;
+        args[1].f = lo;
+        args[1].s = s + n - m;
+        args[1].n = m;
+        args[0].pows = args[1].pows = pows;
+        args[0].leaf = args[1].leaf = leaf;
+        args[0].b = args[1].b = b;
+        args[0].num_threads = (flint_get_num_threads() + 1)/2;
+        args[1].num_threads = flint_get_num_threads()/2;
+
+        threadpool_parallel_do(_fmpz_set_str_worker, args,
+                                             2, sizeof(_set_str_arg_t));
+
+        fmpz_mul(f, f, pows + k);
+        fmpz_add(f, f, lo);
+
+        fmpz_clear(lo);
+    }
+}
+
+int _fmpz_set_str_digits(fmpz_t f, const char * s, slong n, int b)
+{
+    const fmpz * pows;
+    slong i, k, leaf;
+
+    for (i = 0; i < n; i++)
+        if (_fmpz_digit_value(s[i]) >= b)
+            return -1;
+
+    if (n == 0)
+        return -1;
+
+    leaf = _fmpz_radix_leaf(b);
+
+    if (flint_get_num_threads() == 1)
+    {
+        _fmpz_set_str_rec(f, s, n, NULL, leaf, b);
+        return 0;
+    }
+
+    for (k = 0; (leaf << k) < n; k++) ;
+
+    pows = _fmpz_radix_powers(b, k);
+    _fmpz_set_str_rec(f, s, n, pows, leaf, b);
+    _fmpz_radix_powers_clear(pows, b, k);
+
+    return 0;
+}
+
 int fmpz_set_str(fmpz_t f, const char * str, int b)
 {
     int ans;
     mpz_t copy;
 
+    if (b >= 2 && b <= 36)
+    {
+        const char * s = str + (str[0] == '-');
+        slong n = strlen(s);
+
+        /* strings of digits only, as mpz_set_str also skips spaces */
+        if (flint_get_num_threads() > 1 &&
+                n*FLINT_BIT_COUNT(b - 1) >= 2*FMPZ_STR_DC_LIMBS*FLINT_BITS &&
+                _fmpz_set_str_digits(f, s, n, b) == 0)
+        {
+            if (str[0] == '-')
+                fmpz_neg(f, f);
+            return 0;
+        }
+    }
+
     ans = mpz_init_set_str(copy, (char *) str, b);
     if (ans == 0)
         fmpz_set_mpz(f, copy);
     mpz_clear(copy);
     return ans;
 }
-
@@ -0,0 +1,186 @@
+/*
+    Copyright (C) 2019 William Hart
+
+    This file is part of FLINT.
+
+    FLINT is free software: you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.  See <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <gmp.h>
+#include "flint.h"
+#include "fmpz.h"
+#include "fmpz_vec.h"
+#include "ulong_extras.h"
+#include "threadpool.h"
+
+#define NUM 1000
+
+typedef struct
+{
+    fmpz * vec;
+    slong len;
+    ulong seed;
+    int produce;
+} worker_arg_struct;
+
+/* set or check vec[i] = seed*(2^100 + i), clearing it in the latter case */
+void worker(void * varg)
+{
+    worker_arg_struct * arg = (worker_arg_struct *) varg;
+    fmpz_t t;
+    slong i;
+
+    fmpz_init(t);
+
+    for (i = 0; i < arg->len; i++)
+    {
+        fmpz_one(t);
+        fmpz_mul_2exp(t, t, 100);
+        fmpz_add_ui(t, t, i);
+        fmpz_mul_ui(t, t, arg->seed);
+
+        if (arg->produce)
+            fmpz_set(arg->vec + i, t);
+        else
+        {
+            if (!fmpz_equal(arg->vec + i, t))
+            {
+                flint_printf("FAIL:\n");
+                flint_printf("value lost, i = %wd\n", i);
+                abort();
+            }
+
+            fmpz_clear(arg->vec + i);
+        }
+    }
+
+    fmpz_clear(t);
+}
+
+int
+main(void)
+{
+    int i, j;
+    fmpz_cache_stats_t s0, s1;
+    FLINT_TEST_INIT(state);
+
+    flint_printf("cache....");
+    fflush(stdout);
+
+    /*
+       every allocation is counted as a hit or a miss, unless the memory
+       manager is the reentrant one, which caches nothing
+    */
+    for (i = 0; fmpz_cache_get_limit() != 0 &&
+                                      i < 10 * flint_test_multiplier(); i++)
+    {
+        fmpz * vec;
+        slong len = n_randint(state, 5000);
+
+        vec = _fmpz_vec_init(len);
+
+        fmpz_cache_get_stats(s0);
+
+        for (j = 0; j < len; j++)
+            fmpz_set_ui(vec + j, UWORD_MAX);
+
+        fmpz_cache_get_stats(s1);
+
+        if (s1->hits + s1->misses != s0->hits + s0->misses + len)
+        {
+            flint_printf("FAIL:\n");
+            flint_printf("len = %wd, hits = %wu, %wu, misses = %wu, %wu\n",
+                len, s0->hits, s1->hits, s0->misses, s1->misses);
+            abort();
+        }
+
+        _fmpz_vec_clear(vec, len);
+    }
+
+    /* a small limit keeps the cache small */
+    for (i = 0; i < flint_test_multiplier(); i++)
+    {
+        fmpz * vec;
+        slong len = 50000;
+        ulong limit = fmpz_cache_get_limit();
+
+        fmpz_cache_set_limit(n_randint(state, 200));
+
+        vec = _fmpz_vec_init(len);
+        for (j = 0; j < len; j++)
+        {
+            fmpz_set_ui(vec + j, UWORD_MAX);
+            fmpz_mul_2exp(vec + j, vec + j, 200);
+        }
+        _fmpz_vec_clear(vec, len);
+
+        fmpz_cache_get_stats(s0);
+
+        if (s0->retained_bytes > 1000000)
+        {
+            flint_printf("FAIL:\n");
+            flint_printf("%wu bytes retained\n", s0->retained_bytes);
+            abort();
+        }
+
+        fmpz_cache_set_limit(limit);
+
+        if (fmpz_cache_get_limit() != limit)
+        {
+            flint_printf("FAIL:\n");
+            flint_printf("limit not restored\n");
+            abort();
+        }
+    }
+
+    /* integers passed between threads */
+    for (i = 0; i < 10 * flint_test_multiplier(); i++)
+    {
+        slong k, num = n_randint(state, 8) + 1;
+        worker_arg_struct * args;
+
+        flint_set_num_threads(n_randint(state, 4) + 1);
+
+        if (n_randint(state, 2))
+            fmpz_cache_set_limit(n_randint(state, 1000));
+
+        args = flint_malloc(num*sizeof(worker_arg_struct));
+
+        for (k = 0; k < num; k++)
+        {
+            args[k].len = n_randint(state, NUM);
+            args[k].vec = _fmpz_vec_init(args[k].len);
+            args[k].seed = n_randint(state, 1000) + 1;
+            args[k].produce = 1;
+        }
+
+        /* produce on some threads */
+        threadpool_parallel_do(worker, args, num, sizeof(worker_arg_struct));
+
+        /* consume on others, with the workers shifted along */
+        for (k = 0; k < num; k++)
+            args[k].produce = 0;
+        threadpool_parallel_do(worker, args + 1, num - 1,
+                                                   sizeof(worker_arg_struct));
+        worker(args + 0);
+
+        for (k = 0; k < num; k++)
+            flint_free(args[k].vec);
+
+        flint_free(args);
+
+        fmpz_cache_set_limit(16384);
+    }
+
+    threadpool_global_clear();
+
+    FLINT_TEST_CLEANUP(state);
+
+    flint_printf("PASS\n");
+    return 0;
+}
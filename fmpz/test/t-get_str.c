@@ -69,6 +69,52 @@ main(void)
         mpz_clear(b);
     }
 
+    /* large values, using the divide and conquer conversion */
+    for (i = 0; i < 20 * flint_test_multiplier(); i++)
+    {
+        fmpz_t a;
+        mpz_t b;
+        int base;
+        char *str1, *str2;
+
+        fmpz_init(a);
+        mpz_init(b);
+        fmpz_randtest(a, state, n_randint(state, 1000000) + 1);
+        if (n_randint(state, 4) == 0)
+        {
+            fmpz_set_ui(a, 10);
+            fmpz_pow_ui(a, a, n_randint(state, 300000));
+            fmpz_sub_ui(a, a, n_randint(state, 2));
+        }
+        base = (n_randint(state, 2) == 0) ? 10 : n_randint(state, 35) + 2;
+
+        flint_set_num_threads(n_randint(state, 3) + 1);
+
+        fmpz_get_mpz(b, a);
+
+        str2 = mpz_get_str(NULL, base, b);
+        if (n_randint(state, 2))
+            str1 = fmpz_get_str(NULL, base, a);
+        else
+            str1 = fmpz_get_str(flint_malloc(fmpz_sizeinbase(a, base) + 2),
+                                                                  base, a);
+
+        if (strcmp(str1, str2) != 0)
+        {
+            flint_printf("FAIL (large):\n");
+            flint_printf("bits = %wd, base = %d\n", fmpz_bits(a), base);
+            abort();
+        }
+
+        flint_free(str1);
+        flint_free(str2);
+
+        fmpz_clear(a);
+        mpz_clear(b);
+    }
+
+    flint_set_num_threads(1);
+
     FLINT_TEST_CLEANUP(state);
     
     flint_printf("PASS\n");
@@ -0,0 +1,110 @@
+/*
+    Copyright (C) 2019 William Hart
+
+    This file is part of FLINT.
+
+    FLINT is free software: you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.  See <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <gmp.h>
+#include "flint.h"
+#include "ulong_extras.h"
+#include "fmpz.h"
+#include "fmpz_vec.h"
+#include "threadpool.h"
+
+int main(void)
+{
+    slong i, j, len, num, count;
+    fmpz * n;
+    fmpz_t t;
+    ulong * res;
+    FLINT_TEST_INIT(state);
+
+    flint_printf("is_probabprime_vec....");
+    fflush(stdout);
+
+    fmpz_init(t);
+
+    for (i = 0; i < 50 * flint_test_multiplier(); i++)
+    {
+        flint_set_num_threads(n_randint(state, 4) + 1);
+
+        len = n_randint(state, 2) ? n_randint(state, 100) :
+                                    n_randint(state, 1000);
+
+        n = _fmpz_vec_init(len);
+        res = flint_malloc(((len + FLINT_BITS - 1)/FLINT_BITS + 1)*sizeof(ulong));
+
+        for (j = 0; j < len; j++)
+        {
+            switch (n_randint(state, 5))
+            {
+                case 0:
+                    fmpz_randtest(n + j, state, 20);
+                    break;
+                case 1:
+                    fmpz_randtest(n + j, state, 200);
+                    break;
+                case 2:
+                    fmpz_randprime(n + j, state, n_randint(state, 200) + 2, 0);
+                    break;
+                case 3:
+                    /* a large prime times a small one */
+                    fmpz_randprime(n + j, state, n_randint(state, 100) + 2, 0);
+                    fmpz_mul_ui(n + j, n + j, n_nth_prime(n_randint(state, 200) + 1));
+                    break;
+                default:
+                    fmpz_randprime(n + j, state, n_randint(state, 100) + 2, 0);
+                    fmpz_randprime(t, state, n_randint(state, 100) + 2, 0);
+                    fmpz_mul(n + j, n + j, t);
+            }
+        }
+
+        res[(len + FLINT_BITS - 1)/FLINT_BITS] = UWORD(12345);
+
+        if (n_randint(state, 2))
+            num = fmpz_is_probabprime_vec(res, n, len);
+        else
+            num = _fmpz_is_probabprime_vec(res, n, len);
+
+        count = 0;
+        for (j = 0; j < len; j++)
+        {
+            int bit = (res[j/FLINT_BITS] >> (j % FLINT_BITS)) & 1;
+
+            if (bit != fmpz_is_probabprime(n + j))
+            {
+                flint_printf("FAIL:\n");
+                fmpz_print(n + j);
+                flint_printf("\nbit = %d\n", bit);
+                abort();
+            }
+
+            count += bit;
+        }
+
+        if (count != num || res[(len + FLINT_BITS - 1)/FLINT_BITS] != 12345)
+        {
+            flint_printf("FAIL (count):\n");
+            flint_printf("count = %wd, num = %wd\n", count, num);
+            abort();
+        }
+
+        _fmpz_vec_clear(n, len);
+        flint_free(res);
+    }
+
+    fmpz_clear(t);
+
+    FLINT_TEST_CLEANUP(state);
+    threadpool_global_clear();
+
+    flint_printf("PASS\n");
+    return 0;
+}
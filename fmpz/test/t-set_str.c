@@ -0,0 +1,97 @@
+/*
+    Copyright (C) 2019 William Hart
+
+    This file is part of FLINT.
+
+    FLINT is free software: you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.  See <http://www.gnu.org/licenses/>.
+*/
+
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <gmp.h>
+#include "flint.h"
+#include "ulong_extras.h"
+#include "fmpz.h"
+
+int
+main(void)
+{
+    int i;
+    FLINT_TEST_INIT(state);
+
+    flint_printf("set_str....");
+    fflush(stdout);
+
+    for (i = 0; i < 1000 * flint_test_multiplier(); i++)
+    {
+        fmpz_t a, b;
+        mpz_t c;
+        int base, ans;
+        char * str;
+
+        fmpz_init(a);
+        fmpz_init(b);
+        mpz_init(c);
+
+        if (i % 50 == 0)
+            fmpz_randtest(a, state, n_randint(state, 1000000) + 1);
+        else
+            fmpz_randtest(a, state, 200);
+
+        base = (n_randint(state, 2) == 0) ? 10 : n_randint(state, 35) + 2;
+
+        flint_set_num_threads(n_randint(state, 3) + 1);
+
+        fmpz_get_mpz(c, a);
+        str = mpz_get_str(NULL, base, c);
+
+        /* upper case digits are allowed */
+        if (n_randint(state, 2))
+        {
+            slong j;
+
+            for (j = 0; str[j] != '\0'; j++)
+                if (str[j] >= 'a' && str[j] <= 'z')
+                    str[j] += 'A' - 'a';
+        }
+
+        ans = fmpz_set_str(b, str, base);
+
+        if (ans != 0 || !fmpz_equal(a, b))
+        {
+            flint_printf("FAIL:\n");
+            flint_printf("bits = %wd, base = %d, ans = %d\n",
+                                                   fmpz_bits(a), base, ans);
+            abort();
+        }
+
+        /* an invalid digit at the end */
+        if (strlen(str) > 1)
+        {
+            str[strlen(str) - 1] = (base == 36) ? '!' : 'z';
+
+            if (fmpz_set_str(b, str, base) != -1)
+            {
+                flint_printf("FAIL (invalid digit):\n");
+                flint_printf("bits = %wd, base = %d\n", fmpz_bits(a), base);
+                abort();
+            }
+        }
+
+        flint_free(str);
+        fmpz_clear(a);
+        fmpz_clear(b);
+        mpz_clear(c);
+    }
+
+    flint_set_num_threads(1);
+
+    FLINT_TEST_CLEANUP(state);
+
+    flint_printf("PASS\n");
+    return 0;
+}
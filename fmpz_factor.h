@@ -36,6 +36,45 @@ typedef struct
 
 typedef fmpz_factor_struct fmpz_factor_t[1];
 
+/* methods which may be used in a factoring strategy */
+#define FMPZ_FACTOR_METHOD_NONE          0
+#define FMPZ_FACTOR_METHOD_TRIAL         1
+#define FMPZ_FACTOR_METHOD_POLLARD_BRENT 2
+#define FMPZ_FACTOR_METHOD_PP1           3
+#define FMPZ_FACTOR_METHOD_ECM           4
+#define FMPZ_FACTOR_METHOD_QSIEVE        5
+#define FMPZ_FACTOR_METHOD_N_FACTOR      6 /* reported for one word numbers */
+
+typedef struct
+{
+    int method;
+    mp_bitcnt_t min_bits; /* only applied to cofactors of this size */
+    ulong B1;
+    ulong B2;
+    ulong count;
+} fmpz_factor_step_struct;
+
+typedef struct
+{
+    fmpz_factor_step_struct * steps;
+    slong num;
+    slong alloc;
+} fmpz_factor_strategy_struct;
+
+typedef fmpz_factor_strategy_struct fmpz_factor_strategy_t[1];
+
+typedef struct
+{
+    ulong start;    /* wall clock in milliseconds at initialisation */
+    ulong max_time; /* in milliseconds, 0 for no limit */
+    ulong max_ops;  /* 0 for no limit */
+    /* ops and stop are accessed atomically, as ECM threads share them */
+    ulong ops;      /* operations charged so far */
+    int stop;       /* set once the effort is exhausted or cancelled */
+} fmpz_factor_effort_struct;
+
+typedef fmpz_factor_effort_struct fmpz_factor_effort_t[1];
+
 /* Utility functions *********************************************************/
 
 FLINT_DLL void fmpz_factor_init(fmpz_factor_t factor);
@@ -57,6 +96,38 @@ FLINT_DLL void _fmpz_factor_set_length(fmpz_factor_t factor, slong newlen);
 FLINT_DLL void _fmpz_factor_concat(fmpz_factor_t factor1,
                                              fmpz_factor_t factor2, ulong exp);
 
+/* Factoring strategies ******************************************************/
+
+FLINT_DLL void fmpz_factor_strategy_init(fmpz_factor_strategy_t strategy);
+
+FLINT_DLL void fmpz_factor_strategy_clear(fmpz_factor_strategy_t strategy);
+
+FLINT_DLL void fmpz_factor_strategy_add_step(fmpz_factor_strategy_t strategy,
+                   int method, mp_bitcnt_t min_bits, ulong B1, ulong B2,
+                                                                ulong count);
+
+FLINT_DLL void fmpz_factor_strategy_set_default(
+                                             fmpz_factor_strategy_t strategy);
+
+/* Effort bounds *************************************************************/
+
+FLINT_DLL ulong _fmpz_factor_effort_clock(void);
+
+FLINT_DLL void fmpz_factor_effort_init(fmpz_factor_effort_t effort,
+                                                      ulong ms, ulong ops);
+
+FLINT_DLL void fmpz_factor_effort_charge(fmpz_factor_effort_struct * effort,
+                                                                  ulong ops);
+
+FLINT_DLL int fmpz_factor_effort_exhausted(
+                                       fmpz_factor_effort_struct * effort);
+
+FMPZ_FACTOR_INLINE
+void fmpz_factor_effort_cancel(fmpz_factor_effort_t effort)
+{
+    __atomic_store_n(&effort->stop, 1, __ATOMIC_RELEASE);
+}
+
 /* Factoring *****************************************************************/
 
 FLINT_DLL void _fmpz_factor_extend_factor_ui(fmpz_factor_t factor, mp_limb_t n);
@@ -68,6 +139,17 @@ FLINT_DLL void fmpz_factor(fmpz_factor_t factor, const fmpz_t n);
 
 FLINT_DLL void fmpz_factor_no_trial(fmpz_factor_t factor, const fmpz_t n);
 
+FLINT_DLL int _fmpz_factor_no_trial_strategy(fmpz_factor_t factor,
+             int * method, fmpz_t cofactor, const fmpz_t n,
+             const fmpz_factor_strategy_t strategy,
+             fmpz_factor_effort_struct * effort);
+
+FLINT_DLL int fmpz_factor_no_trial_strategy(fmpz_factor_t factor,
+        int * method, const fmpz_t n, const fmpz_factor_strategy_t strategy);
+
+FLINT_DLL int fmpz_factor_partial(fmpz_factor_t factor, fmpz_t cofactor,
+                             const fmpz_t n, fmpz_factor_effort_t effort);
+
 FLINT_DLL void fmpz_factor_si(fmpz_factor_t factor, slong n);
 
 FLINT_DLL int fmpz_factor_pp1(fmpz_t factor, const fmpz_t n, 
@@ -86,6 +168,15 @@ FLINT_DLL int fmpz_factor_pollard_brent_single(fmpz_t p_factor, fmpz_t n_in,
                                                fmpz_t yi, fmpz_t ai, 
                                                mp_limb_t max_iters);
 
+FLINT_DLL int _flint_mpn_factor_pollard_brent_single(mp_ptr factor,
+                    mp_ptr n, mp_ptr ninv, mp_ptr a, mp_ptr y,
+                    mp_limb_t n_size, mp_limb_t normbits, mp_limb_t max_iters,
+                    fmpz_factor_effort_struct * effort);
+
+FLINT_DLL int _fmpz_factor_pollard_brent(fmpz_t factor, flint_rand_t state,
+                                 fmpz_t n, mp_limb_t max_tries,
+                      mp_limb_t max_iters, fmpz_factor_effort_struct * effort);
+
 FLINT_DLL int fmpz_factor_pollard_brent(fmpz_t factor, flint_rand_t state,
                                         fmpz_t n, mp_limb_t max_tries, 
                                         mp_limb_t max_iters);
@@ -120,6 +211,10 @@ typedef struct ecm_s {
 
     unsigned char **prime_table;
 
+    fmpz_factor_effort_struct * effort; /* checked by the stages, or NULL */
+    int * found; /* set atomically once another curve found a factor,
+                    or NULL */
+
     mp_limb_t n_size;
     mp_limb_t normbits;
 
@@ -152,6 +247,15 @@ FLINT_DLL void fmpz_factor_ecm_mul_montgomery_ladder(mp_ptr x, mp_ptr z,
 FLINT_DLL int fmpz_factor_ecm_select_curve(mp_ptr f, mp_ptr sig, mp_ptr n,
                                            ecm_t ecm_inf);
 
+/* whether the stages should give up on the current curve */
+FMPZ_FACTOR_INLINE
+int _fmpz_factor_ecm_stop(ecm_t ecm_inf)
+{
+    return (ecm_inf->found != NULL &&
+                      __atomic_load_n(ecm_inf->found, __ATOMIC_ACQUIRE)) ||
+           fmpz_factor_effort_exhausted(ecm_inf->effort);
+}
+
 FLINT_DLL int fmpz_factor_ecm_stage_I(mp_ptr f, const mp_limb_t *prime_array,
                                       mp_limb_t num, mp_limb_t B1, mp_ptr n, 
                                       ecm_t ecm_inf);
@@ -159,6 +263,13 @@ FLINT_DLL int fmpz_factor_ecm_stage_I(mp_ptr f, const mp_limb_t *prime_array,
 FLINT_DLL int fmpz_factor_ecm_stage_II(mp_ptr f, mp_limb_t B1, mp_limb_t B2,
                                        mp_limb_t P, mp_ptr n, ecm_t ecm_inf);
 
+FLINT_DLL int fmpz_factor_ecm_stage_II_fft(mp_ptr f, mp_limb_t B1,
+                      mp_limb_t B2, mp_limb_t P, mp_ptr n, ecm_t ecm_inf);
+
+FLINT_DLL int _fmpz_factor_ecm(fmpz_t f, mp_limb_t curves, mp_limb_t B1,
+                     mp_limb_t B2, flint_rand_t state, const fmpz_t n_in,
+                                        fmpz_factor_effort_struct * effort);
+
 FLINT_DLL int fmpz_factor_ecm(fmpz_t f, mp_limb_t curves, mp_limb_t B1,
                         mp_limb_t B2, flint_rand_t state, const fmpz_t n_in);
 
@@ -16,6 +16,7 @@
 #include "flint.h"
 #include "fmpz.h"
 #include "mpn_extras.h"
+#include "threadpool.h"
 
 static
 ulong n_ecm_primorial[] =
@@ -43,13 +44,196 @@ ulong n_ecm_primorial[] =
 #define num_n_ecm_primorials 9
 #endif
 
+/*
+   Tries one curve with a random sigma, returning as fmpz_factor_ecm. If a
+   factor is found, it is set in fac, shifted by the normalisation, with
+   *size limbs.
+*/
+static int
+_fmpz_factor_ecm_curve(mp_ptr fac, mp_size_t * size, flint_rand_t state,
+               fmpz_t sig, mp_ptr mpsig, const fmpz_t nm8,
+               const mp_limb_t * prime_array, mp_limb_t num, mp_limb_t B1,
+               mp_limb_t B2, mp_limb_t P, int fft, mp_ptr n, ecm_t ecm_inf)
+{
+    __mpz_struct * mpz_ptr;
+    mp_limb_t cy;
+    int ret;
+
+    fmpz_randm(sig, state, nm8);
+    fmpz_add_ui(sig, sig, 7);
+
+    mpn_zero(mpsig, ecm_inf->n_size);
+
+    if ((!COEFF_IS_MPZ(*sig)))
+    {
+        mpsig[0] = fmpz_get_ui(sig);
+        cy = mpn_lshift(mpsig, mpsig, 1, ecm_inf->normbits);
+        if (cy)
+            mpsig[1] = cy;
+    }
+    else
+    {
+        mpz_ptr = COEFF_TO_PTR(*sig);
+
+        cy = mpn_lshift(mpsig, mpz_ptr->_mp_d, mpz_ptr->_mp_size, ecm_inf->normbits);
+        if (cy)
+            mpsig[mpz_ptr->_mp_size] = cy;
+    }
+
+    /************************ SELECT CURVE ************************/
+
+    ret = fmpz_factor_ecm_select_curve(fac, mpsig, n, ecm_inf);
+
+    if (ret == -1) /* no inverse, try another curve */
+        return 0;
+
+    if (ret)
+    {
+        /* Found factor while selecting curve,
+           very very lucky :) */
+        *size = ret;
+        return -1;
+    }
+
+    /************************** STAGE I ***************************/
+
+    ret = fmpz_factor_ecm_stage_I(fac, prime_array, num, B1, n, ecm_inf);
+
+    if (ret)
+    {
+        /* Found factor after stage I */
+        *size = ret;
+        return 1;
+    }
+
+    /* stage I may have given up on the curve */
+    if (_fmpz_factor_ecm_stop(ecm_inf))
+        return 0;
+
+    /************************** STAGE II ***************************/
+
+    if (fft)
+        ret = fmpz_factor_ecm_stage_II_fft(fac, B1, B2, P, n, ecm_inf);
+    else
+        ret = fmpz_factor_ecm_stage_II(fac, B1, B2, P, n, ecm_inf);
+
+    if (ret)
+    {
+        /* Found factor after stage II */
+        *size = ret;
+        return 2;
+    }
+
+    return 0;
+}
+
+typedef struct
+{
+    pthread_mutex_t mutex;
+    int found; /* set with the mutex held, polled atomically by the stages */
+    const mp_limb_t * prime_array;
+    mp_limb_t num, B1, B2, P;
+    int fft;
+    mp_ptr n;
+    const fmpz * nm8;
+    const ecm_s * ecm_inf;
+    fmpz_factor_effort_struct * effort; /* charged atomically */
+    mp_limb_t cost;
+} _ecm_shared_t;
+
+typedef struct
+{
+    _ecm_shared_t * shared;
+    mp_limb_t curves;
+    ulong seed1, seed2;
+    mp_ptr fac;
+    mp_size_t size;
+    int ret;
+} _ecm_worker_arg_t;
+
+/*
+   Each worker runs its share of the curves with its own random state. The
+   first worker to find a factor records it and the others give up on
+   their current curve, as they do once the effort is exhausted.
+*/
+static void
+_fmpz_factor_ecm_worker(void * arg_ptr)
+{
+    _ecm_worker_arg_t * arg = (_ecm_worker_arg_t *) arg_ptr;
+    _ecm_shared_t * shared = arg->shared;
+    mp_limb_t n_size = shared->ecm_inf->n_size;
+    mp_limb_t j;
+    mp_size_t size;
+    mp_ptr fac, mpsig;
+    flint_rand_t state;
+    ecm_t ecm_inf;
+    fmpz_t sig;
+    int ret;
+
+    fmpz_factor_ecm_init(ecm_inf, n_size);
+    ecm_inf->normbits = shared->ecm_inf->normbits;
+    mpn_copyi(ecm_inf->ninv, shared->ecm_inf->ninv, n_size);
+    mpn_copyi(ecm_inf->one, shared->ecm_inf->one, n_size);
+    /* the stage II tables are only read */
+    ecm_inf->GCD_table = shared->ecm_inf->GCD_table;
+    ecm_inf->prime_table = shared->ecm_inf->prime_table;
+    ecm_inf->effort = shared->effort;
+    ecm_inf->found = &shared->found;
+
+    flint_randinit(state);
+    flint_randseed(state, arg->seed1, arg->seed2);
+    _flint_rand_init_gmp(state);
+    gmp_randseed_ui(state->gmp_state, arg->seed1);
+
+    fmpz_init(sig);
+    fac = flint_malloc(2*(n_size + 1)*sizeof(mp_limb_t));
+    mpsig = fac + n_size + 1;
+
+    arg->ret = 0;
+
+    for (j = 0; j < arg->curves; j++)
+    {
+        if (_fmpz_factor_ecm_stop(ecm_inf))
+            break;
+
+        ret = _fmpz_factor_ecm_curve(fac, &size, state, sig, mpsig,
+                 shared->nm8, shared->prime_array, shared->num, shared->B1,
+                    shared->B2, shared->P, shared->fft, shared->n, ecm_inf);
+
+        fmpz_factor_effort_charge(shared->effort, shared->cost);
+
+        if (ret)
+        {
+            pthread_mutex_lock(&shared->mutex);
+            if (!shared->found)
+            {
+                __atomic_store_n(&shared->found, 1, __ATOMIC_RELEASE);
+                mpn_copyi(arg->fac, fac, size);
+                arg->size = size;
+                arg->ret = ret;
+            }
+            pthread_mutex_unlock(&shared->mutex);
+
+            break;
+        }
+    }
+
+    flint_free(fac);
+    fmpz_clear(sig);
+    flint_randclear(state);
+    fmpz_factor_ecm_clear(ecm_inf);
+}
+
 int
-fmpz_factor_ecm(fmpz_t f, mp_limb_t curves, mp_limb_t B1, mp_limb_t B2,
-                flint_rand_t state, const fmpz_t n_in)
+_fmpz_factor_ecm(fmpz_t f, mp_limb_t curves, mp_limb_t B1, mp_limb_t B2,
+                flint_rand_t state, const fmpz_t n_in,
+                fmpz_factor_effort_struct * effort)
 {
     fmpz_t sig, nm8;
-    mp_limb_t P, num, maxD, mmin, mmax, mdiff, prod, maxj, n_size, cy;
-    int i, j, ret;
+    mp_limb_t P, num, maxD, mmin, mmax, mdiff, prod, maxj, n_size, cost;
+    mp_size_t size;
+    slong num_threads;
+    int i, j, ret, fft;
     ecm_t ecm_inf;
     __mpz_struct *fac, *mpz_ptr;
     mp_ptr n, mpsig;
@@ -59,13 +243,6 @@ fmpz_factor_ecm(fmpz_t f, mp_limb_t curves, mp_limb_t B1, mp_limb_t B2,
     const mp_limb_t *prime_array;
     n_size = fmpz_size(n_in);
 
-    fmpz_factor_ecm_init(ecm_inf, n_size);
-
-    TMP_START;
-
-    n     = TMP_ALLOC(n_size * sizeof(mp_limb_t));
-    mpsig = TMP_ALLOC(n_size * sizeof(mp_limb_t));
-
     if (n_size == 1)
     {
         ret = n_factor_ecm(&P, curves, B1, B2, state, fmpz_get_ui(n_in));
@@ -73,19 +250,23 @@ fmpz_factor_ecm(fmpz_t f, mp_limb_t curves, mp_limb_t B1, mp_limb_t B2,
         return ret;
     }
 
-    if ((!COEFF_IS_MPZ(* n_in)))
-    {
-        count_leading_zeros(ecm_inf->normbits, fmpz_get_ui(n_in));
-        n[0] = fmpz_get_ui(n_in);
-        n[0] <<= ecm_inf->normbits;
-    }
-    else
-    {
-        mpz_ptr = COEFF_TO_PTR(* n_in);
-        count_leading_zeros(ecm_inf->normbits, mpz_ptr->_mp_d[n_size - 1]);
-        mpn_lshift(n, mpz_ptr->_mp_d, n_size, ecm_inf->normbits);
-    }
+    fmpz_factor_ecm_init(ecm_inf, n_size);
+    ecm_inf->effort = effort;
+
+    /*
+       multiplications per curve: stage I has about 1.44*B1 ladder steps of
+       about ten multiplications, stage II less than one per ten integers
+    */
+    cost = 14*B1 + (B2 - B1)/10;
 
+    TMP_START;
+
+    n     = TMP_ALLOC(n_size * sizeof(mp_limb_t));
+    mpsig = TMP_ALLOC((n_size + 1) * sizeof(mp_limb_t));
+
+    mpz_ptr = COEFF_TO_PTR(* n_in);
+    count_leading_zeros(ecm_inf->normbits, mpz_ptr->_mp_d[n_size - 1]);
+    mpn_lshift(n, mpz_ptr->_mp_d, n_size, ecm_inf->normbits);
     flint_mpn_preinvn(ecm_inf->ninv, n, n_size);
     ecm_inf->one[0] = UWORD(1) << ecm_inf->normbits;
 
@@ -106,15 +287,31 @@ fmpz_factor_ecm(fmpz_t f, mp_limb_t curves, mp_limb_t B1, mp_limb_t B2,
 
     /************************ STAGE II PRECOMPUTATIONS ***********************/
 
-    maxD = n_sqrt(B2);
+    fft = (B2 >= (mp_limb_t) FLINT_CUTOFF(ECM_STAGE_II_FFT) && B1 >= 3);
 
     /* Selecting primorial */
 
-    j = 1;
-    while ((j < num_n_ecm_primorials) && (n_ecm_primorial[j] < maxD))
-        j += 1;
+    if (fft)
+    {
+        /* balance the phi(P)/2 baby steps with the (B2 - B1)/P giant steps */
+        j = 1;
+        while (j + 1 < num_n_ecm_primorials && n_ecm_primorial[j + 1] <= B1
+            && n_ecm_primorial[j + 1]*(n_euler_phi(n_ecm_primorial[j + 1])/2)
+                                                                 <= B2 - B1)
+            j += 1;
+
+        P = n_ecm_primorial[j];
+    }
+    else
+    {
+        maxD = n_sqrt(B2);
 
-    P = n_ecm_primorial[j - 1]; 
+        j = 1;
+        while ((j < num_n_ecm_primorials) && (n_ecm_primorial[j] < maxD))
+            j += 1;
+
+        P = n_ecm_primorial[j - 1]; 
+    }
     
     mmin = (B1 + (P/2)) / P;
     mmax = ((B2 - P/2) + P - 1)/P;      /* ceil */
@@ -126,131 +323,133 @@ fmpz_factor_ecm(fmpz_t f, mp_limb_t curves, mp_limb_t B1, mp_limb_t B2,
     maxj = (P + 1)/2; 
     mdiff = mmax - mmin + 1;
 
-    /* compute GCD_table */
-
-    ecm_inf->GCD_table = flint_malloc(maxj + 1);
-
-    for (j = 1; j <= maxj; j += 2)
+    if (fft)
     {
-        if ((j%2) && n_gcd(j, P) == 1)
-            ecm_inf->GCD_table[j] = 1;  
-        else
-            ecm_inf->GCD_table[j] = 0;
-    }  
-
-    /* compute prime table */
-
-    ecm_inf->prime_table = flint_malloc(mdiff * sizeof(unsigned char*));
+        /* the polynomial stage II does not use the tables */
+        ecm_inf->GCD_table = NULL;
+        ecm_inf->prime_table = NULL;
+        mdiff = 0;
+    }
+    else
+    {
+        /* compute GCD_table */
 
-    for (i = 0; i < mdiff; i++)
-        ecm_inf->prime_table[i] = flint_malloc((maxj + 1) * sizeof(unsigned char));
+        ecm_inf->GCD_table = flint_malloc(maxj + 1);
 
-    for (i = 0; i < mdiff; i++)
-    {
         for (j = 1; j <= maxj; j += 2)
         {
-            ecm_inf->prime_table[i][j] = 0;
+            if ((j%2) && n_gcd(j, P) == 1)
+                ecm_inf->GCD_table[j] = 1;  
+            else
+                ecm_inf->GCD_table[j] = 0;
+        }  
 
-            /* if (i + mmin)*D + j
-               is prime, mark 1. Can be possibly prime
-               only if gcd(j, D) = 1 */
+        /* compute prime table */
 
-            if (ecm_inf->GCD_table[j] == 1)
-            {
-                prod = (i + mmin)*P + j;
-                if (n_is_prime(prod))
-                    ecm_inf->prime_table[i][j] = 1;
+        ecm_inf->prime_table = flint_malloc(mdiff * sizeof(unsigned char*));
+
+        for (i = 0; i < mdiff; i++)
+            ecm_inf->prime_table[i] = flint_malloc((maxj + 1) * sizeof(unsigned char));
 
-                prod = (i + mmin)*P - j;
-                if (n_is_prime(prod))
-                    ecm_inf->prime_table[i][j] = 1;
+        for (i = 0; i < mdiff; i++)
+        {
+            for (j = 1; j <= maxj; j += 2)
+            {
+                ecm_inf->prime_table[i][j] = 0;
+
+                /* if (i + mmin)*D + j
+                   is prime, mark 1. Can be possibly prime
+                   only if gcd(j, D) = 1 */
+
+                if (ecm_inf->GCD_table[j] == 1)
+                {
+                    prod = (i + mmin)*P + j;
+                    if (n_is_prime(prod))
+                        ecm_inf->prime_table[i][j] = 1;
+
+                    prod = (i + mmin)*P - j;
+                    if (n_is_prime(prod))
+                        ecm_inf->prime_table[i][j] = 1;
+                }
             }
         }
     }
 
-
     /****************************** TRY "CURVES" *****************************/
 
-    for (j = 0; j < curves; j++)
-    {
-        fmpz_randm(sig, state, nm8);
-        fmpz_add_ui(sig, sig, 7);
+    num_threads = FLINT_MIN(flint_get_num_threads(), curves);
 
-        if ((!COEFF_IS_MPZ(*sig)))
+    if (num_threads > 1)
+    {
+        _ecm_shared_t shared;
+        _ecm_worker_arg_t * args;
+
+        pthread_mutex_init(&shared.mutex, NULL);
+        shared.found = 0;
+        shared.prime_array = prime_array;
+        shared.num = num;
+        shared.B1 = B1;
+        shared.B2 = B2;
+        shared.P = P;
+        shared.fft = fft;
+        shared.n = n;
+        shared.nm8 = nm8;
+        shared.ecm_inf = ecm_inf;
+        shared.effort = effort;
+        shared.cost = cost;
+
+        args = flint_malloc(num_threads*sizeof(_ecm_worker_arg_t));
+
+        for (i = 0; i < num_threads; i++)
         {
-            mpsig[0] = fmpz_get_ui(sig);
-            cy = mpn_lshift(mpsig, mpsig, 1, ecm_inf->normbits);
-            if (cy)
-                mpsig[1] = cy;
+            args[i].shared = &shared;
+            args[i].curves = curves/num_threads + (i < curves % num_threads);
+            args[i].seed1 = n_randlimb(state);
+            args[i].seed2 = n_randlimb(state);
+            args[i].fac = fac->_mp_d;
         }
-        else
-        {
-            mpz_ptr = COEFF_TO_PTR(*sig);
 
-            cy = mpn_lshift(mpsig, mpz_ptr->_mp_d, mpz_ptr->_mp_size, ecm_inf->normbits);
-            if (cy)
-                mpsig[mpz_ptr->_mp_size] = cy;
+        threadpool_parallel_do(_fmpz_factor_ecm_worker, args,
+                                       num_threads, sizeof(_ecm_worker_arg_t));
 
-        }
-
-        /************************ SELECT CURVE ************************/
-
-        ret = fmpz_factor_ecm_select_curve(fac->_mp_d, mpsig, n, ecm_inf);
-
-        if (ret)
+        ret = 0;
+        for (i = 0; i < num_threads; i++)
         {
-            /* Found factor while selecting curve,
-               very very lucky :) */
-
-            mpn_rshift(fac->_mp_d, fac->_mp_d, ret, ecm_inf->normbits);
-            MPN_NORM(fac->_mp_d, ret);
-
-            fac->_mp_size = ret;
-            _fmpz_demote_val(f);    
-
-            ret = -1;
-            goto cleanup;
+            if (args[i].ret)
+            {
+                ret = args[i].ret;
+                size = args[i].size;
+            }
         }
 
-        if (ret != -1)
+        flint_free(args);
+        pthread_mutex_destroy(&shared.mutex);
+    }
+    else
+    {
+        for (j = 0; j < curves; j++)
         {
+            if (fmpz_factor_effort_exhausted(effort))
+                break;
 
-            /************************** STAGE I ***************************/
+            ret = _fmpz_factor_ecm_curve(fac->_mp_d, &size, state, sig, mpsig,
+                     nm8, prime_array, num, B1, B2, P, fft, n, ecm_inf);
 
-            ret = fmpz_factor_ecm_stage_I(fac->_mp_d, prime_array, num, B1, n, ecm_inf);
+            fmpz_factor_effort_charge(effort, cost);
 
             if (ret)
-            {
-                /* Found factor after stage I */
-                mpn_rshift(fac->_mp_d, fac->_mp_d, ret, ecm_inf->normbits);
-                MPN_NORM(fac->_mp_d, ret);
-
-                fac->_mp_size = ret;
-                _fmpz_demote_val(f);    
-
-                ret = 1;
-                goto cleanup;
-            }  
-            /************************** STAGE II ***************************/
-
-            ret = fmpz_factor_ecm_stage_II(fac->_mp_d, B1, B2, P, n, ecm_inf);
-
-            if (ret)
-            {
-                /* Found factor after stage I */
-                mpn_rshift(fac->_mp_d, fac->_mp_d, ret, ecm_inf->normbits);
-                MPN_NORM(fac->_mp_d, ret);
-                fac->_mp_size = ret;
-                _fmpz_demote_val(f);  
-
-                ret = 2;
-                goto cleanup;
-            }
+                break;
         }
     }
 
-    cleanup:
+    if (ret)
+    {
+        mpn_rshift(fac->_mp_d, fac->_mp_d, size, ecm_inf->normbits);
+        MPN_NORM(fac->_mp_d, size);
 
+        fac->_mp_size = size;
+        _fmpz_demote_val(f);
+    }
 
     flint_free(ecm_inf->GCD_table);
     for (i = 0; i < mdiff; i++)
@@ -263,3 +462,10 @@ fmpz_factor_ecm(fmpz_t f, mp_limb_t curves, mp_limb_t B1, mp_limb_t B2,
 
     return ret;
 }
+
+int
+fmpz_factor_ecm(fmpz_t f, mp_limb_t curves, mp_limb_t B1, mp_limb_t B2,
+                flint_rand_t state, const fmpz_t n_in)
+{
+    return _fmpz_factor_ecm(f, curves, B1, B2, state, n_in, NULL);
+}
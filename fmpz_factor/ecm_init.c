@@ -42,4 +42,6 @@ fmpz_factor_ecm_init(ecm_t ecm_inf, mp_limb_t sz)
     mpn_zero(ecm_inf->one, sz);
 
     ecm_inf->n_size = sz;
+    ecm_inf->effort = NULL;
+    ecm_inf->found = NULL;
 }
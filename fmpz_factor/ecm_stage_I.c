@@ -26,6 +26,10 @@ fmpz_factor_ecm_stage_I(mp_ptr f, const mp_limb_t *prime_array, mp_limb_t num,
 
     for (i = 0; i < num; i++)
     {
+        /* give up on the curve if the effort is used up or a factor found */
+        if ((i & 63) == 0 && _fmpz_factor_ecm_stop(ecm_inf))
+            return 0;
+
         p = n_flog(B1, prime_array[i]);
         times = prime_array[i];
 
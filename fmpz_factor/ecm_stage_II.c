@@ -100,6 +100,10 @@ fmpz_factor_ecm_stage_II(mp_ptr f, mp_limb_t B1, mp_limb_t B2, mp_limb_t P,
 
     for (i = mmin; i <= mmax; i ++)
     {
+        /* stop early, but still check the primes covered so far */
+        if (_fmpz_factor_ecm_stop(ecm_inf))
+            break;
+
         for (j = 1; j <= maxj; j += 2)
         {
             if (ecm_inf->prime_table[i - mmin][j] == 1)
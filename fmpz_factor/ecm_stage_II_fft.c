@@ -0,0 +1,237 @@
+/*
+    Copyright (C) 2019 William Hart
+
+    This file is part of FLINT.
+
+    FLINT is free software: you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.  See <http://www.gnu.org/licenses/>.
+*/
+
+#include <gmp.h>
+#include "flint.h"
+#include "ulong_extras.h"
+#include "fmpz.h"
+#include "fmpz_vec.h"
+#include "fmpz_mod_poly.h"
+#include "mpn_extras.h"
+
+/* Implementation of the stage II of ECM using polynomial evaluation */
+
+/* r = the residue held by the normalised x */
+static void
+_fmpz_set_ecm(fmpz_t r, mp_srcptr x, mp_ptr t, ecm_t ecm_inf)
+{
+    if (ecm_inf->normbits)
+        mpn_rshift(t, x, ecm_inf->n_size, ecm_inf->normbits);
+    else
+        mpn_copyi(t, x, ecm_inf->n_size);
+
+    fmpz_set_ui_array(r, t, ecm_inf->n_size);
+}
+
+/*
+   Sets xs[i] to xs[i]/zs[i] modulo N using a single inversion. If one of
+   the zs[i] is not invertible, g is set to the gcd of their product with
+   N and 0 is returned.
+*/
+static int
+_fmpz_ecm_normalise(fmpz * xs, const fmpz * zs, slong len, fmpz * c,
+                                                 fmpz_t g, const fmpz_t N)
+{
+    fmpz_t inv, t;
+    slong i;
+    int ok;
+
+    fmpz_init(inv);
+    fmpz_init(t);
+
+    fmpz_set(c + 0, zs + 0);
+    for (i = 1; i < len; i++)
+    {
+        fmpz_mul(c + i, c + i - 1, zs + i);
+        fmpz_mod(c + i, c + i, N);
+    }
+
+    ok = fmpz_invmod(inv, c + len - 1, N);
+
+    if (!ok)
+        fmpz_gcd(g, c + len - 1, N);
+    else
+    {
+        for (i = len - 1; i > 0; i--)
+        {
+            fmpz_mul(t, inv, c + i - 1);    /* 1/zs[i] */
+            fmpz_mul(inv, inv, zs + i);
+            fmpz_mod(inv, inv, N);
+            fmpz_mul(xs + i, xs + i, t);
+            fmpz_mod(xs + i, xs + i, N);
+        }
+
+        fmpz_mul(xs + 0, xs + 0, inv);
+        fmpz_mod(xs + 0, xs + 0, N);
+    }
+
+    fmpz_clear(inv);
+    fmpz_clear(t);
+
+    return ok;
+}
+
+int
+fmpz_factor_ecm_stage_II_fft(mp_ptr f, mp_limb_t B1, mp_limb_t B2,
+                                     mp_limb_t P, mp_ptr n, ecm_t ecm_inf)
+{
+    mp_ptr Qx, Qz, Rx, Rz, Sx, Sz, a, b, t, Q0x2, Q0z2, arrx, arrz;
+    mp_limb_t mmin, mmax, maxj, m;
+    mp_size_t n_size = ecm_inf->n_size, sz;
+    slong i, j, k, len;
+    fmpz * xs, * zs, * c, * F, * ys;
+    fmpz_t N, g, d;
+    int ret = 0;
+
+    mmin = (B1 + (P/2)) / P;
+    mmax = ((B2 - P/2) + P - 1)/P;      /* ceil */
+    maxj = (P + 1)/2;
+
+    /* the baby steps are the j < P/2 coprime to P */
+    k = n_euler_phi(P)/2;
+
+    Qx   = flint_malloc(11 * n_size * sizeof(mp_limb_t));
+    Qz   = Qx + n_size;
+    Rx   = Qz + n_size;
+    Rz   = Rx + n_size;
+    Sx   = Rz + n_size;
+    Sz   = Sx + n_size;
+    Q0x2 = Sz + n_size;
+    Q0z2 = Q0x2 + n_size;
+    a    = Q0z2 + n_size;
+    b    = a + n_size;
+    t    = b + n_size;
+    arrx = flint_malloc(((maxj >> 1) + 1) * n_size * sizeof(mp_limb_t));
+    arrz = flint_malloc(((maxj >> 1) + 1) * n_size * sizeof(mp_limb_t));
+
+    fmpz_init(N);
+    fmpz_init(g);
+    fmpz_init(d);
+    xs = _fmpz_vec_init(k);
+    zs = _fmpz_vec_init(k);
+    c  = _fmpz_vec_init(k);
+    ys = _fmpz_vec_init(k);
+    F  = _fmpz_vec_init(k + 1);
+
+    _fmpz_set_ecm(N, n, t, ecm_inf);
+
+    /* arr[j/2] = j*Q0 for odd j, as for the baby-step giant-step version */
+    mpn_copyi(arrx, ecm_inf->x, n_size);
+    mpn_copyi(arrz, ecm_inf->z, n_size);
+
+    fmpz_factor_ecm_double(Q0x2, Q0z2, arrx, arrz, n, ecm_inf);
+
+    fmpz_factor_ecm_add(arrx + n_size, arrz + n_size,
+                         Q0x2, Q0z2, arrx, arrz, arrx, arrz, n, ecm_inf);
+
+    for (j = 2; j <= (slong) (maxj >> 1); j++)
+    {
+        fmpz_factor_ecm_add(arrx + j * n_size, arrz + j * n_size,
+                            arrx + (j - 1) * n_size, arrz + (j - 1) * n_size,
+                            Q0x2, Q0z2,
+                            arrx + (j - 2) * n_size, arrz + (j - 2) * n_size,
+                            n, ecm_inf);
+    }
+
+    for (j = 1, i = 0; j <= (slong) maxj; j += 2)
+    {
+        if (n_gcd(j, P) == 1)
+        {
+            _fmpz_set_ecm(xs + i, arrx + (j >> 1) * n_size, t, ecm_inf);
+            _fmpz_set_ecm(zs + i, arrz + (j >> 1) * n_size, t, ecm_inf);
+            i++;
+        }
+    }
+
+    /* F(X) = prod (X - x(jQ0)) */
+    if (!_fmpz_ecm_normalise(xs, zs, k, c, d, N))
+        goto found;
+
+    _fmpz_mod_poly_product_roots_fmpz_vec(F, xs, k, N);
+
+    /* Q = P*Q0, R = mmin*Q, S = (mmin + 1)*Q */
+    fmpz_factor_ecm_mul_montgomery_ladder(Qx, Qz, ecm_inf->x, ecm_inf->z,
+                                           P, n, ecm_inf);
+    fmpz_factor_ecm_mul_montgomery_ladder(Rx, Rz, Qx, Qz, mmin, n, ecm_inf);
+    fmpz_factor_ecm_mul_montgomery_ladder(Sx, Sz, Qx, Qz, mmin + 1,
+                                                                n, ecm_inf);
+
+    /*
+       F(x(mQ)) vanishes modulo p if m*P*Q0 = +-j*Q0 modulo p for one of
+       the baby steps j, evaluate F at k giant steps at a time
+    */
+    fmpz_one(g);
+
+    for (m = mmin; m <= mmax; m += len)
+    {
+        /* stop early, but still check the giant steps covered so far */
+        if (_fmpz_factor_ecm_stop(ecm_inf))
+            break;
+
+        len = FLINT_MIN(k, (slong) (mmax - m + 1));
+
+        for (i = 0; i < len; i++)
+        {
+            _fmpz_set_ecm(xs + i, Rx, t, ecm_inf);
+            _fmpz_set_ecm(zs + i, Rz, t, ecm_inf);
+
+            /* S + Q has difference S - Q = R */
+            fmpz_factor_ecm_add(a, b, Sx, Sz, Qx, Qz, Rx, Rz, n, ecm_inf);
+
+            mpn_copyi(Rx, Sx, n_size);
+            mpn_copyi(Rz, Sz, n_size);
+            mpn_copyi(Sx, a, n_size);
+            mpn_copyi(Sz, b, n_size);
+        }
+
+        if (!_fmpz_ecm_normalise(xs, zs, len, c, d, N))
+            goto found;
+
+        _fmpz_mod_poly_evaluate_fmpz_vec_fast(ys, F, k + 1, xs, len, N);
+
+        for (i = 0; i < len; i++)
+        {
+            fmpz_mul(g, g, ys + i);
+            fmpz_mod(g, g, N);
+        }
+    }
+
+    fmpz_gcd(d, g, N);
+
+found:
+
+    if (!fmpz_is_one(d) && !fmpz_equal(d, N) && !fmpz_is_zero(d))
+    {
+        /* return the factor normalised, as the other stages do */
+        fmpz_get_ui_array(f, n_size, d);
+        if (ecm_inf->normbits)
+            mpn_lshift(f, f, n_size, ecm_inf->normbits);
+
+        sz = n_size;
+        MPN_NORM(f, sz);
+        ret = sz;
+    }
+
+    fmpz_clear(N);
+    fmpz_clear(g);
+    fmpz_clear(d);
+    _fmpz_vec_clear(xs, k);
+    _fmpz_vec_clear(zs, k);
+    _fmpz_vec_clear(c, k);
+    _fmpz_vec_clear(ys, k);
+    _fmpz_vec_clear(F, k + 1);
+
+    flint_free(Qx);
+    flint_free(arrx);
+    flint_free(arrz);
+
+    return ret;
+}
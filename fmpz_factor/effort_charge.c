@@ -0,0 +1,32 @@
+/*
+    Copyright (C) 2019 William Hart
+
+    This file is part of FLINT.
+
+    FLINT is free software: you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.  See <http://www.gnu.org/licenses/>.
+*/
+
+#include <gmp.h>
+#include "flint.h"
+#include "fmpz.h"
+
+void
+fmpz_factor_effort_charge(fmpz_factor_effort_struct * effort, ulong ops)
+{
+    ulong old, new;
+
+    if (effort == NULL)
+        return;
+
+    old = __atomic_load_n(&effort->ops, __ATOMIC_RELAXED);
+
+    /* saturating add, retried if another thread charged in between */
+    do
+    {
+        new = (old > UWORD_MAX - ops) ? UWORD_MAX : old + ops;
+    } while (!__atomic_compare_exchange_n(&effort->ops, &old, new, 1,
+                                         __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+}
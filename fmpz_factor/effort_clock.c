@@ -0,0 +1,30 @@
+/*
+    Copyright (C) 2019 William Hart
+
+    This file is part of FLINT.
+
+    FLINT is free software: you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.  See <http://www.gnu.org/licenses/>.
+*/
+
+#if defined(_MSC_VER)
+#include "gettimeofday.h"
+#else
+#include <sys/time.h>
+#endif
+#include <gmp.h>
+#include "flint.h"
+#include "fmpz.h"
+
+/* wall clock in milliseconds, differences are taken modulo the word size */
+ulong
+_fmpz_factor_effort_clock(void)
+{
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+
+    return (ulong) tv.tv_sec * 1000 + (ulong) tv.tv_usec / 1000;
+}
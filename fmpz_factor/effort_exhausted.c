@@ -0,0 +1,35 @@
+/*
+    Copyright (C) 2019 William Hart
+
+    This file is part of FLINT.
+
+    FLINT is free software: you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.  See <http://www.gnu.org/licenses/>.
+*/
+
+#include <gmp.h>
+#include "flint.h"
+#include "fmpz.h"
+
+int
+fmpz_factor_effort_exhausted(fmpz_factor_effort_struct * effort)
+{
+    if (effort == NULL)
+        return 0;
+
+    if (__atomic_load_n(&effort->stop, __ATOMIC_ACQUIRE))
+        return 1;
+
+    if ((effort->max_ops != 0 && __atomic_load_n(&effort->ops,
+                                   __ATOMIC_RELAXED) >= effort->max_ops) ||
+        (effort->max_time != 0 && _fmpz_factor_effort_clock()
+                                     - effort->start >= effort->max_time))
+    {
+        __atomic_store_n(&effort->stop, 1, __ATOMIC_RELEASE);
+        return 1;
+    }
+
+    return 0;
+}
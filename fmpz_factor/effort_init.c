@@ -0,0 +1,24 @@
+/*
+    Copyright (C) 2019 William Hart
+
+    This file is part of FLINT.
+
+    FLINT is free software: you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.  See <http://www.gnu.org/licenses/>.
+*/
+
+#include <gmp.h>
+#include "flint.h"
+#include "fmpz.h"
+
+void
+fmpz_factor_effort_init(fmpz_factor_effort_t effort, ulong ms, ulong ops)
+{
+    effort->start = _fmpz_factor_effort_clock();
+    effort->max_time = ms;
+    effort->max_ops = ops;
+    effort->ops = 0;
+    effort->stop = 0;
+}
@@ -13,58 +13,16 @@
 #include "flint.h"
 #include "fmpz.h"
 #include "fmpz_vec.h"
-#include "mpn_extras.h"
-#include "ulong_extras.h"
-#include "qsieve.h"
 
 void
 fmpz_factor_no_trial(fmpz_factor_t factor, const fmpz_t n)
 {
-   int exp, i;
+   fmpz_factor_strategy_t strategy;
 
-   if (fmpz_is_prime(n))
-      _fmpz_factor_append(factor, n, 1);
-   else
-   {
-      fmpz_t root;
+   fmpz_factor_strategy_init(strategy);
+   fmpz_factor_strategy_set_default(strategy);
 
-      fmpz_init(root);
+   fmpz_factor_no_trial_strategy(factor, NULL, n, strategy);
 
-      exp = fmpz_is_perfect_power(root, n);
-
-      if (exp != 0)
-      {
-         fmpz_factor_t fac;
-
-         fmpz_factor_init(fac);
-
-         fmpz_factor_no_trial(fac, root);
-
-         _fmpz_factor_concat(factor, fac, exp);
-
-         fmpz_factor_clear(fac);
-      } else
-      {
-         fmpz_factor_t fac, fac2;
-
-         fmpz_factor_init(fac);
-
-         /* insert call to ecm here */
-
-         qsieve_factor(fac, n);
-
-         for (i = 0; i < fac->num; i++)
-         {
-            fmpz_factor_init(fac2);
-
-            fmpz_factor_no_trial(fac2, fac->p + i);
-
-            _fmpz_factor_concat(factor, fac2, fac->exp[i]);
- 
-            fmpz_factor_clear(fac2);
-         }
-
-         fmpz_factor_clear(fac);
-      }
-   }
+   fmpz_factor_strategy_clear(strategy);
 }
@@ -0,0 +1,281 @@
+/*
+    Copyright (C) 2019 William Hart
+
+    This file is part of FLINT.
+
+    FLINT is free software: you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.  See <http://www.gnu.org/licenses/>.
+*/
+
+#include <gmp.h>
+#include "flint.h"
+#include "fmpz.h"
+#include "fmpz_vec.h"
+#include "mpn_extras.h"
+#include "ulong_extras.h"
+#include "qsieve.h"
+
+static void
+_fmpz_factor_append_method(fmpz_factor_t factor, int * method,
+                                        const fmpz_t p, ulong exp, int found)
+{
+    if (method != NULL)
+        method[factor->num] = found;
+
+    _fmpz_factor_append(factor, p, exp);
+}
+
+/* n is odd and does not fit in a word */
+static int
+_fmpz_factor_trial_step(fmpz_t f, const fmpz_t n, ulong num_primes)
+{
+    __mpz_struct * z = COEFF_TO_PTR(*n);
+    slong found;
+
+    if (num_primes < 2)
+        return 0;
+
+    found = flint_mpn_factor_trial(z->_mp_d, z->_mp_size, 1, num_primes);
+
+    if (found)
+        fmpz_set_ui(f, n_primes_arr_readonly(found + 1)[found]);
+
+    return found != 0;
+}
+
+/*
+   Appends the factorisation of n^exp to factor, using the steps of the
+   strategy from start onwards. Factors which are not split any further
+   are reported as found by the given method. Returns 0 if a composite
+   factor had to be appended, or multiplied into cofactor if that is not
+   NULL. The remaining steps are skipped once the effort is exhausted.
+*/
+static int
+_fmpz_factor_strategy(fmpz_factor_t factor, int * method, fmpz_t cofactor,
+                  fmpz_t n, ulong exp, const fmpz_factor_strategy_t strategy,
+                  slong start, int found_by, flint_rand_t state,
+                  fmpz_factor_effort_struct * effort)
+{
+    fmpz_factor_step_struct * step;
+    mp_bitcnt_t bits;
+    fmpz_t f, g;
+    slong i, j;
+    int e, found, ret = 0;
+
+    if (fmpz_is_one(n))
+        return 1;
+
+    if (fmpz_is_prime(n))
+    {
+        _fmpz_factor_append_method(factor, method, n, exp, found_by);
+        return 1;
+    }
+
+    fmpz_init(f);
+    fmpz_init(g);
+
+    e = fmpz_is_perfect_power(f, n);
+
+    if (e != 0)
+    {
+        ret = _fmpz_factor_strategy(factor, method, cofactor, f, exp*e,
+                                strategy, start, found_by, state, effort);
+        goto cleanup;
+    }
+
+    if (fmpz_abs_fits_ui(n))
+    {
+        n_factor_t fac;
+
+        n_factor_init(&fac);
+        n_factor(&fac, fmpz_get_ui(n), 0);
+
+        for (i = 0; i < fac.num; i++)
+        {
+            fmpz_set_ui(f, fac.p[i]);
+            _fmpz_factor_append_method(factor, method, f, exp*fac.exp[i],
+                                                FMPZ_FACTOR_METHOD_N_FACTOR);
+        }
+
+        ret = 1;
+        goto cleanup;
+    }
+
+    if (fmpz_is_even(n))
+    {
+        fmpz_set_ui(f, 2);
+        i = start;
+        found = FMPZ_FACTOR_METHOD_TRIAL;
+        goto split;
+    }
+
+    bits = fmpz_bits(n);
+
+    for (i = start; i < strategy->num; i++)
+    {
+        step = strategy->steps + i;
+        found = step->method;
+
+        if (fmpz_factor_effort_exhausted(effort))
+            break;
+
+        if (bits < step->min_bits)
+            continue;
+
+        switch (step->method)
+        {
+            case FMPZ_FACTOR_METHOD_TRIAL:
+                if (_fmpz_factor_trial_step(f, n, step->B1))
+                    goto split;
+                break;
+
+            case FMPZ_FACTOR_METHOD_POLLARD_BRENT:
+                if (_fmpz_factor_pollard_brent(f, state, n,
+                                         step->count, step->B1, effort))
+                    goto split;
+                break;
+
+            case FMPZ_FACTOR_METHOD_PP1:
+                for (j = 0; j < (slong) step->count &&
+                                !fmpz_factor_effort_exhausted(effort); j++)
+                {
+                    if (fmpz_factor_pp1(f, n, step->B1, step->B2,
+                                                   n_randint(state, 1000) + 3))
+                        goto split;
+                }
+                break;
+
+            case FMPZ_FACTOR_METHOD_ECM:
+                if (_fmpz_factor_ecm(f, step->count, step->B1, step->B2,
+                                                           state, n, effort))
+                    goto split;
+                break;
+
+            case FMPZ_FACTOR_METHOD_QSIEVE:
+            {
+                fmpz_factor_t fac;
+
+                fmpz_factor_init(fac);
+
+                qsieve_factor_effort(fac, n, effort);
+
+                if (fac->num > 1 || (fac->num == 1 && fac->exp[0] > 1))
+                {
+                    ret = 1;
+
+                    for (j = 0; j < fac->num; j++)
+                        ret &= _fmpz_factor_strategy(factor, method,
+                              cofactor, fac->p + j, exp*fac->exp[j],
+                              strategy, i, FMPZ_FACTOR_METHOD_QSIEVE,
+                                                              state, effort);
+
+                    fmpz_factor_clear(fac);
+                    goto cleanup;
+                }
+
+                fmpz_factor_clear(fac);
+                break;
+            }
+
+            default:
+                flint_printf("Exception (fmpz_factor_no_trial_strategy). "
+                             "Unknown method.\n");
+                flint_abort();
+        }
+    }
+
+    /* nothing in the strategy split n */
+    if (cofactor != NULL)
+    {
+        fmpz_pow_ui(f, n, exp);
+        fmpz_mul(cofactor, cofactor, f);
+    }
+    else
+        _fmpz_factor_append_method(factor, method, n, exp,
+                                                    FMPZ_FACTOR_METHOD_NONE);
+    goto cleanup;
+
+split:
+
+    /* the methods may return trivial factors */
+    if (fmpz_cmp_ui(f, 1) <= 0 || fmpz_cmp(f, n) >= 0)
+    {
+        /* retry with the remaining steps */
+        ret = _fmpz_factor_strategy(factor, method, cofactor, n, exp,
+                                  strategy, i + 1, found_by, state, effort);
+        goto cleanup;
+    }
+
+    fmpz_divexact(g, n, f);
+
+    ret = _fmpz_factor_strategy(factor, method, cofactor, f, exp,
+                                        strategy, i, found, state, effort);
+    ret &= _fmpz_factor_strategy(factor, method, cofactor, g, exp,
+                                        strategy, i, found, state, effort);
+
+cleanup:
+
+    fmpz_clear(f);
+    fmpz_clear(g);
+
+    return ret;
+}
+
+int
+_fmpz_factor_no_trial_strategy(fmpz_factor_t factor, int * method,
+              fmpz_t cofactor, const fmpz_t n,
+              const fmpz_factor_strategy_t strategy,
+              fmpz_factor_effort_struct * effort)
+{
+    slong i, j, k, start = factor->num;
+    flint_rand_t state;
+    fmpz_t m;
+    int ret;
+
+    fmpz_init_set(m, n);
+    flint_randinit(state);
+
+    if (cofactor != NULL)
+        fmpz_one(cofactor);
+
+    ret = _fmpz_factor_strategy(factor, method, cofactor, m, 1, strategy,
+                                0, FMPZ_FACTOR_METHOD_NONE, state, effort);
+
+    flint_randclear(state);
+    fmpz_clear(m);
+
+    /* a prime may have been split off more than one cofactor */
+    for (i = k = start; i < factor->num; i++)
+    {
+        for (j = start; j < k; j++)
+        {
+            if (fmpz_equal(factor->p + j, factor->p + i))
+                break;
+        }
+
+        if (j < k)
+            factor->exp[j] += factor->exp[i];
+        else
+        {
+            fmpz_swap(factor->p + k, factor->p + i);
+            factor->exp[k] = factor->exp[i];
+            if (method != NULL)
+                method[k] = method[i];
+            k++;
+        }
+    }
+
+    _fmpz_factor_set_length(factor, k);
+
+    return ret;
+}
+
+int
+fmpz_factor_no_trial_strategy(fmpz_factor_t factor, int * method,
+                  const fmpz_t n, const fmpz_factor_strategy_t strategy)
+{
+    return _fmpz_factor_no_trial_strategy(factor, method, NULL, n,
+                                                           strategy, NULL);
+}
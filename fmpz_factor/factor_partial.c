@@ -0,0 +1,61 @@
+/*
+    Copyright (C) 2019 William Hart
+
+    This file is part of FLINT.
+
+    FLINT is free software: you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.  See <http://www.gnu.org/licenses/>.
+*/
+
+#include <gmp.h>
+#include "flint.h"
+#include "fmpz.h"
+
+int
+fmpz_factor_partial(fmpz_factor_t factor, fmpz_t cofactor, const fmpz_t n,
+                                                 fmpz_factor_effort_t effort)
+{
+    fmpz_factor_strategy_t strategy, def;
+    fmpz_factor_step_struct * step;
+    fmpz_t m;
+    slong i;
+    int ret;
+
+    _fmpz_factor_set_length(factor, 0);
+    factor->sign = fmpz_sgn(n);
+
+    if (fmpz_is_zero(n))
+    {
+        fmpz_one(cofactor);
+        return 1;
+    }
+
+    fmpz_init(m);
+    fmpz_abs(m, n);
+
+    /* trial division, as fmpz_factor does first, then the default steps */
+    fmpz_factor_strategy_init(strategy);
+    fmpz_factor_strategy_init(def);
+    fmpz_factor_strategy_set_default(def);
+
+    fmpz_factor_strategy_add_step(strategy,
+                                    FMPZ_FACTOR_METHOD_TRIAL, 0, 1000, 0, 0);
+
+    for (i = 0; i < def->num; i++)
+    {
+        step = def->steps + i;
+        fmpz_factor_strategy_add_step(strategy, step->method,
+                         step->min_bits, step->B1, step->B2, step->count);
+    }
+
+    ret = _fmpz_factor_no_trial_strategy(factor, NULL, cofactor, m,
+                                                          strategy, effort);
+
+    fmpz_factor_strategy_clear(def);
+    fmpz_factor_strategy_clear(strategy);
+    fmpz_clear(m);
+
+    return ret;
+}
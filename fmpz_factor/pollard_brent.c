@@ -21,14 +21,15 @@
 #include "mpn_extras.h"
 
 int
-fmpz_factor_pollard_brent(fmpz_t p_factor, flint_rand_t state, fmpz_t n_in, 
-                          mp_limb_t max_tries, mp_limb_t max_iters)
+_fmpz_factor_pollard_brent(fmpz_t p_factor, flint_rand_t state, fmpz_t n_in,
+                          mp_limb_t max_tries, mp_limb_t max_iters,
+                          fmpz_factor_effort_struct * effort)
 {
     fmpz_t fa, fy, maxa, maxy;
     mp_ptr a, y, n, ninv, temp;
     mp_limb_t n_size, normbits, ans, val, size, cy;
     __mpz_struct *fac, *mpz_ptr;
-    int ret;
+    int ret = 0;
 
     TMP_INIT;
 
@@ -76,7 +77,7 @@ fmpz_factor_pollard_brent(fmpz_t p_factor, flint_rand_t state, fmpz_t n_in,
     mpz_realloc2(fac, n_size * FLINT_BITS);
     fac->_mp_size = n_size;
 
-    while (max_tries--)
+    while (max_tries-- && !fmpz_factor_effort_exhausted(effort))
     {
         fmpz_randm(fa, state, maxa);  
         fmpz_add_ui(fa, fa, 1);
@@ -130,7 +131,8 @@ fmpz_factor_pollard_brent(fmpz_t p_factor, flint_rand_t state, fmpz_t n_in,
             mpn_copyi(a, temp, n_size);
         }
 
-        ret = flint_mpn_factor_pollard_brent_single(fac->_mp_d, n, ninv, a, y, n_size, normbits, max_iters);
+        ret = _flint_mpn_factor_pollard_brent_single(fac->_mp_d, n, ninv,
+                               a, y, n_size, normbits, max_iters, effort);
 
         if (ret)
         {
@@ -148,3 +150,11 @@ fmpz_factor_pollard_brent(fmpz_t p_factor, flint_rand_t state, fmpz_t n_in,
     
     return ret;    
 }
+
+int
+fmpz_factor_pollard_brent(fmpz_t p_factor, flint_rand_t state, fmpz_t n_in,
+                          mp_limb_t max_tries, mp_limb_t max_iters)
+{
+    return _fmpz_factor_pollard_brent(p_factor, state, n_in, max_tries,
+                                                          max_iters, NULL);
+}
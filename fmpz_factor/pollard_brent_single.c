@@ -41,8 +41,9 @@ flint_mpn_sqr_and_add_a(mp_ptr y, mp_ptr a, mp_ptr n, mp_limb_t n_size, mp_ptr n
 }
 
 int
-flint_mpn_factor_pollard_brent_single(mp_ptr factor, mp_ptr n, mp_ptr ninv, mp_ptr a, mp_ptr y,
-                     mp_limb_t n_size, mp_limb_t normbits, mp_limb_t max_iters)
+_flint_mpn_factor_pollard_brent_single(mp_ptr factor, mp_ptr n, mp_ptr ninv,
+                     mp_ptr a, mp_ptr y, mp_limb_t n_size, mp_limb_t normbits,
+                     mp_limb_t max_iters, fmpz_factor_effort_struct * effort)
 {     
     /* n_size >= 2, one limb fmpz_t's are passed on to 
        n_factor_pollard_brent in outer funtion      */
@@ -106,6 +107,15 @@ flint_mpn_factor_pollard_brent_single(mp_ptr factor, mp_ptr n, mp_ptr ninv, mp_p
 
             k += m;
             j = ((gcdlimbs == 1) && (factor[0] == one_shift_norm));   /* gcd == 1 */
+
+            /* about two multiplications per iteration */
+            fmpz_factor_effort_charge(effort, 2*minval);
+
+            if (j && fmpz_factor_effort_exhausted(effort))
+            {
+                ret = 0;
+                goto cleanup;
+            }
         } while ((k < iter) && j); 
 
         if (iter > max_iters)   /* max iterations crossed */
@@ -159,11 +169,21 @@ flint_mpn_factor_pollard_brent_single(mp_ptr factor, mp_ptr n, mp_ptr ninv, mp_p
             mpn_rshift(factor, factor, gcdlimbs, normbits);  
     }
 
+cleanup:
+
     TMP_END;
     
     return ret;
 }
 
+int
+flint_mpn_factor_pollard_brent_single(mp_ptr factor, mp_ptr n, mp_ptr ninv, mp_ptr a, mp_ptr y,
+                     mp_limb_t n_size, mp_limb_t normbits, mp_limb_t max_iters)
+{
+    return _flint_mpn_factor_pollard_brent_single(factor, n, ninv, a, y,
+                                        n_size, normbits, max_iters, NULL);
+}
+
 int
 fmpz_factor_pollard_brent_single(fmpz_t p_factor, fmpz_t n_in, fmpz_t yi, 
                                  fmpz_t ai, mp_limb_t max_iters)
@@ -0,0 +1,52 @@
+/*
+    Copyright (C) 2019 William Hart
+
+    This file is part of FLINT.
+
+    FLINT is free software: you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.  See <http://www.gnu.org/licenses/>.
+*/
+
+#include <gmp.h>
+#include "flint.h"
+#include "fmpz.h"
+
+void
+fmpz_factor_strategy_add_step(fmpz_factor_strategy_t strategy, int method,
+                       mp_bitcnt_t min_bits, ulong B1, ulong B2, ulong count)
+{
+    fmpz_factor_step_struct * step;
+
+    if (method < FMPZ_FACTOR_METHOD_TRIAL || method > FMPZ_FACTOR_METHOD_QSIEVE)
+    {
+        flint_printf("Exception (fmpz_factor_strategy_add_step). "
+                     "Unknown method.\n");
+        flint_abort();
+    }
+
+    if (method == FMPZ_FACTOR_METHOD_ECM && B2 < B1)
+    {
+        flint_printf("Exception (fmpz_factor_strategy_add_step). "
+                     "B1 > B2 encountered.\n");
+        flint_abort();
+    }
+
+    if (strategy->num == strategy->alloc)
+    {
+        strategy->alloc = FLINT_MAX(8, 2*strategy->alloc);
+        strategy->steps = flint_realloc(strategy->steps,
+                          strategy->alloc*sizeof(fmpz_factor_step_struct));
+    }
+
+    step = strategy->steps + strategy->num;
+
+    step->method   = method;
+    step->min_bits = min_bits;
+    step->B1       = B1;
+    step->B2       = B2;
+    step->count    = count;
+
+    strategy->num++;
+}
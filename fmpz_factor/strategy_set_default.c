@@ -0,0 +1,57 @@
+/*
+    Copyright (C) 2019 William Hart
+
+    This file is part of FLINT.
+
+    FLINT is free software: you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.  See <http://www.gnu.org/licenses/>.
+*/
+
+#include <gmp.h>
+#include "flint.h"
+#include "fmpz.h"
+
+/*
+   The steps are ordered by increasing cost. Pollard-Brent and p + 1 catch
+   the factors just beyond trial division cheaply. The ECM levels follow
+   the usual tables for finding factors of 15, 20, 25, 30 and 35 digits,
+   but each level only starts once the cofactor is large enough that its
+   curves cost no more than about a quarter of the time qsieve would take
+   on the cofactor, so that numbers without a small factor do not pay much
+   for the attempt. The curve counts are cumulative, a level that is split
+   over two steps runs more curves for larger cofactors.
+*/
+void
+fmpz_factor_strategy_set_default(fmpz_factor_strategy_t strategy)
+{
+    strategy->num = 0;
+
+    fmpz_factor_strategy_add_step(strategy,
+                        FMPZ_FACTOR_METHOD_POLLARD_BRENT, 64, 4096, 0, 1);
+    fmpz_factor_strategy_add_step(strategy,
+                        FMPZ_FACTOR_METHOD_POLLARD_BRENT, 140, 32768, 0, 1);
+    fmpz_factor_strategy_add_step(strategy,
+                        FMPZ_FACTOR_METHOD_PP1, 140, 10000, 100, 1);
+    fmpz_factor_strategy_add_step(strategy,
+                        FMPZ_FACTOR_METHOD_PP1, 200, 50000, 300, 1);
+
+    fmpz_factor_strategy_add_step(strategy,
+                        FMPZ_FACTOR_METHOD_ECM, 170, 2000, 200000, 10);
+    fmpz_factor_strategy_add_step(strategy,
+                        FMPZ_FACTOR_METHOD_ECM, 190, 2000, 200000, 15);
+    fmpz_factor_strategy_add_step(strategy,
+                        FMPZ_FACTOR_METHOD_ECM, 200, 11000, 1100000, 10);
+    fmpz_factor_strategy_add_step(strategy,
+                        FMPZ_FACTOR_METHOD_ECM, 220, 11000, 1100000, 80);
+    fmpz_factor_strategy_add_step(strategy,
+                        FMPZ_FACTOR_METHOD_ECM, 250, 50000, 5000000, 300);
+    fmpz_factor_strategy_add_step(strategy,
+                        FMPZ_FACTOR_METHOD_ECM, 290, 250000, 25000000, 700);
+    fmpz_factor_strategy_add_step(strategy,
+                        FMPZ_FACTOR_METHOD_ECM, 330, 1000000, 25000000, 1800);
+
+    fmpz_factor_strategy_add_step(strategy,
+                        FMPZ_FACTOR_METHOD_QSIEVE, 0, 0, 0, 0);
+}
@@ -41,6 +41,8 @@ int main(void)
 
             fmpz_mul(primeprod, prime1, prime2);
 
+            flint_set_num_threads(n_randint(state, 4) + 1);
+
             k = fmpz_factor_ecm(fac, i << 2, 2000, 50000, state, primeprod);
 
             if (k == 0)
@@ -49,7 +51,7 @@ int main(void)
             {
                 fmpz_mod(modval, primeprod, fac);
                 k = fmpz_cmp_ui(modval, 0);
-                if (k != 0)
+                if (k != 0 || fmpz_is_one(fac) || fmpz_equal(fac, primeprod))
                 {
                     printf("FAIL : Wrong factor calculated\n");
                     printf("n : ");
@@ -68,6 +70,53 @@ int main(void)
         abort();
     }
 
+    /* polynomial stage II */
+    flint_set_cutoff(FLINT_CUTOFF_ECM_STAGE_II_FFT, 0);
+    fails = 0;
+
+    for (i = 35; i <= 50; i += 5)
+    {
+        for (j = 0; j < flint_test_multiplier(); j++)
+        {
+            fmpz_set_ui(prime1, n_randprime(state, i, 1));
+            fmpz_set_ui(prime2, n_randprime(state, i, 1));
+
+            fmpz_mul(primeprod, prime1, prime2);
+
+            flint_set_num_threads(n_randint(state, 4) + 1);
+
+            k = fmpz_factor_ecm(fac, i << 2, 2000, 50000, state, primeprod);
+
+            if (k == 0)
+                fails += 1;
+            else
+            {
+                fmpz_mod(modval, primeprod, fac);
+                k = fmpz_cmp_ui(modval, 0);
+                if (k != 0 || fmpz_is_one(fac) || fmpz_equal(fac, primeprod))
+                {
+                    printf("FAIL : Wrong factor calculated (fft)\n");
+                    printf("n : ");
+                    fmpz_print(primeprod);
+                    printf(" factor calculated : ");
+                    fmpz_print(fac);
+                    abort();
+                }
+            }
+        }
+    }
+
+    if (fails > flint_test_multiplier())
+    {
+        printf("FAIL : ECM failed too many times (fft, %d times)\n", fails);
+        abort();
+    }
+
+    flint_set_cutoff(FLINT_CUTOFF_ECM_STAGE_II_FFT,
+                flint_get_default_cutoff(FLINT_CUTOFF_ECM_STAGE_II_FFT));
+
+    flint_set_num_threads(1);
+
     fmpz_clear(prime1);
     fmpz_clear(prime2);
     fmpz_clear(primeprod);
@@ -0,0 +1,260 @@
+/*
+    Copyright (C) 2019 William Hart
+
+    This file is part of FLINT.
+
+    FLINT is free software: you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.  See <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <gmp.h>
+#include "flint.h"
+#include "fmpz.h"
+#include "ulong_extras.h"
+
+void randprime(fmpz_t p, flint_rand_t state, slong bits)
+{
+    fmpz_randbits(p, state, bits);
+
+    if (fmpz_sgn(p) < 0)
+       fmpz_neg(p, p);
+
+    if (fmpz_is_even(p))
+       fmpz_add_ui(p, p, 1);
+
+    while (!fmpz_is_probabprime(p))
+       fmpz_add_ui(p, p, 2);
+}
+
+/* check that the new entries of fac multiply to n and are distinct */
+void check_factors(const fmpz_factor_t fac, const fmpz_t n, int complete,
+                                                            const char * s)
+{
+    slong i, j;
+    fmpz_t m, t;
+
+    fmpz_init(m);
+    fmpz_init(t);
+
+    fmpz_one(m);
+    for (i = 0; i < fac->num; i++)
+    {
+        fmpz_pow_ui(t, fac->p + i, fac->exp[i]);
+        fmpz_mul(m, m, t);
+
+        for (j = 0; j < i; j++)
+        {
+            if (fmpz_equal(fac->p + i, fac->p + j))
+            {
+                flint_printf("FAIL (%s):\n", s);
+                flint_printf("repeated factor\n");
+                fmpz_print(n); flint_printf("\n");
+                abort();
+            }
+        }
+
+        if (complete && !fmpz_is_probabprime(fac->p + i))
+        {
+            flint_printf("FAIL (%s):\n", s);
+            flint_printf("composite factor\n");
+            fmpz_print(n); flint_printf("\n");
+            abort();
+        }
+    }
+
+    if (!fmpz_equal(m, n))
+    {
+        flint_printf("FAIL (%s):\n", s);
+        flint_printf("factors do not multiply to n\n");
+        fmpz_print(n); flint_printf("\n");
+        abort();
+    }
+
+    fmpz_clear(m);
+    fmpz_clear(t);
+}
+
+int main(void)
+{
+    slong i, j;
+    fmpz_t n, x, y;
+    fmpz_factor_t fac;
+    fmpz_factor_strategy_t S;
+    int method[400];
+    FLINT_TEST_INIT(state);
+
+    fmpz_init(n);
+    fmpz_init(x);
+    fmpz_init(y);
+
+    flint_printf("factor_no_trial_strategy....");
+    fflush(stdout);
+
+    /* trial division only */
+    fmpz_factor_strategy_init(S);
+    fmpz_factor_strategy_add_step(S, FMPZ_FACTOR_METHOD_TRIAL, 0, 1000, 0, 0);
+
+    for (i = 0; i < 100; i++)
+    {
+        randprime(n, state, 100);
+
+        for (j = n_randint(state, 5); j >= 0; j--)
+        {
+            fmpz_set_ui(x, n_nth_prime(n_randint(state, 999) + 1));
+            fmpz_pow_ui(x, x, n_randint(state, 3) + 1);
+            fmpz_mul(n, n, x);
+        }
+
+        fmpz_factor_init(fac);
+
+        if (!fmpz_factor_no_trial_strategy(fac, method, n, S))
+        {
+            flint_printf("FAIL (trial):\n");
+            fmpz_print(n); flint_printf("\n");
+            abort();
+        }
+
+        check_factors(fac, n, 1, "trial");
+
+        for (j = 0; j < fac->num; j++)
+        {
+            if (method[j] != FMPZ_FACTOR_METHOD_TRIAL &&
+                                        method[j] != FMPZ_FACTOR_METHOD_N_FACTOR)
+            {
+                flint_printf("FAIL (trial):\n");
+                flint_printf("method[%wd] = %d\n", j, method[j]);
+                abort();
+            }
+        }
+
+        fmpz_factor_clear(fac);
+    }
+
+    fmpz_factor_strategy_clear(S);
+
+    /* a medium factor and a large cofactor, ECM only */
+    fmpz_factor_strategy_init(S);
+    fmpz_factor_strategy_add_step(S, FMPZ_FACTOR_METHOD_ECM,
+                                                     0, 2000, 200000, 200);
+
+    for (i = 0; i < 5; i++)
+    {
+        randprime(x, state, n_randint(state, 10) + 30);
+        randprime(y, state, n_randint(state, 200) + 200);
+        fmpz_mul(n, x, y);
+
+        fmpz_factor_init(fac);
+
+        if (!fmpz_factor_no_trial_strategy(fac, method, n, S))
+        {
+            flint_printf("FAIL (ecm):\n");
+            fmpz_print(n); flint_printf("\n");
+            abort();
+        }
+
+        check_factors(fac, n, 1, "ecm");
+
+        if (fac->num != 2 || method[0] != FMPZ_FACTOR_METHOD_ECM ||
+                             method[1] != FMPZ_FACTOR_METHOD_ECM)
+        {
+            flint_printf("FAIL (ecm):\n");
+            flint_printf("%wd factors, method %d\n", fac->num, method[0]);
+            abort();
+        }
+
+        fmpz_factor_clear(fac);
+    }
+
+    fmpz_factor_strategy_clear(S);
+
+    /* a strategy which does not apply leaves the composite */
+    fmpz_factor_strategy_init(S);
+    fmpz_factor_strategy_add_step(S, FMPZ_FACTOR_METHOD_POLLARD_BRENT,
+                                                         1000, 4096, 0, 1);
+
+    for (i = 0; i < 10; i++)
+    {
+        randprime(x, state, 70);
+        do {
+            randprime(y, state, 70);
+        } while (fmpz_equal(x, y));
+        fmpz_mul(n, x, y);
+
+        fmpz_factor_init(fac);
+        _fmpz_factor_append_ui(fac, 3, 1);
+
+        if (fmpz_factor_no_trial_strategy(fac, method, n, S))
+        {
+            flint_printf("FAIL (none):\n");
+            fmpz_print(n); flint_printf("\n");
+            abort();
+        }
+
+        if (fac->num != 2 || !fmpz_equal(fac->p + 1, n) ||
+                             method[1] != FMPZ_FACTOR_METHOD_NONE)
+        {
+            flint_printf("FAIL (none):\n");
+            flint_printf("%wd factors\n", fac->num);
+            abort();
+        }
+
+        fmpz_factor_clear(fac);
+    }
+
+    fmpz_factor_strategy_clear(S);
+
+    /* default strategy, repeated factors */
+    fmpz_factor_strategy_init(S);
+    fmpz_factor_strategy_set_default(S);
+
+    for (i = 0; i < 30; i++)
+    {
+        fmpz_one(n);
+
+        for (j = n_randint(state, 4); j >= 0; j--)
+        {
+            if (j == 0 || n_randint(state, 3) != 0)
+                randprime(x, state, n_randint(state, 50) + 10);
+            fmpz_mul(n, n, x);
+        }
+
+        fmpz_factor_init(fac);
+
+        if (!fmpz_factor_no_trial_strategy(fac, method, n, S))
+        {
+            flint_printf("FAIL (default):\n");
+            fmpz_print(n); flint_printf("\n");
+            abort();
+        }
+
+        check_factors(fac, n, 1, "default");
+
+        for (j = 0; j < fac->num; j++)
+        {
+            if (method[j] < FMPZ_FACTOR_METHOD_NONE ||
+                                     method[j] > FMPZ_FACTOR_METHOD_N_FACTOR)
+            {
+                flint_printf("FAIL (default):\n");
+                flint_printf("method[%wd] = %d\n", j, method[j]);
+                abort();
+            }
+        }
+
+        fmpz_factor_clear(fac);
+    }
+
+    fmpz_factor_strategy_clear(S);
+
+    fmpz_clear(n);
+    fmpz_clear(x);
+    fmpz_clear(y);
+
+    FLINT_TEST_CLEANUP(state);
+
+    flint_printf("PASS\n");
+    return 0;
+}
@@ -0,0 +1,225 @@
+/*
+    Copyright (C) 2019 William Hart
+
+    This file is part of FLINT.
+
+    FLINT is free software: you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.  See <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <gmp.h>
+#include "flint.h"
+#include "fmpz.h"
+#include "ulong_extras.h"
+
+void randprime(fmpz_t p, flint_rand_t state, slong bits)
+{
+    fmpz_randbits(p, state, bits);
+
+    if (fmpz_sgn(p) < 0)
+       fmpz_neg(p, p);
+
+    if (fmpz_is_even(p))
+       fmpz_add_ui(p, p, 1);
+
+    while (!fmpz_is_probabprime(p))
+       fmpz_add_ui(p, p, 2);
+}
+
+/* check that the factors are prime and together with c multiply to n */
+void check_partial(const fmpz_factor_t fac, const fmpz_t c, const fmpz_t n,
+                                                    int ret, const char * s)
+{
+    slong i;
+    fmpz_t m, t;
+
+    fmpz_init(m);
+    fmpz_init(t);
+
+    fmpz_set(m, c);
+    for (i = 0; i < fac->num; i++)
+    {
+        fmpz_pow_ui(t, fac->p + i, fac->exp[i]);
+        fmpz_mul(m, m, t);
+
+        if (!fmpz_is_prime(fac->p + i))
+        {
+            flint_printf("FAIL (%s):\n", s);
+            flint_printf("composite factor\n");
+            fmpz_print(n); flint_printf("\n");
+            abort();
+        }
+    }
+
+    if (fac->sign < 0)
+        fmpz_neg(m, m);
+
+    if (!fmpz_equal(m, n) || fac->sign != fmpz_sgn(n))
+    {
+        flint_printf("FAIL (%s):\n", s);
+        flint_printf("factors do not multiply to n\n");
+        fmpz_print(n); flint_printf("\n");
+        abort();
+    }
+
+    if (ret != fmpz_is_one(c))
+    {
+        flint_printf("FAIL (%s):\n", s);
+        flint_printf("ret = %d, cofactor = ", ret);
+        fmpz_print(c); flint_printf("\n");
+        abort();
+    }
+
+    fmpz_clear(m);
+    fmpz_clear(t);
+}
+
+int main(void)
+{
+    slong i, j;
+    ulong t0;
+    fmpz_t n, c, x, y;
+    fmpz_factor_t fac;
+    fmpz_factor_effort_t effort;
+    int ret;
+    FLINT_TEST_INIT(state);
+
+    fmpz_init(n);
+    fmpz_init(c);
+    fmpz_init(x);
+    fmpz_init(y);
+
+    flint_printf("factor_partial....");
+    fflush(stdout);
+
+    /* no limit, the factorisation is complete */
+    for (i = 0; i < 30; i++)
+    {
+        fmpz_set_si(n, n_randint(state, 2) ? -1 : 1);
+
+        for (j = n_randint(state, 4); j >= 0; j--)
+        {
+            if (j == 0 || n_randint(state, 3) != 0)
+                randprime(x, state, n_randint(state, 60) + 2);
+            fmpz_mul(n, n, x);
+        }
+
+        fmpz_factor_init(fac);
+        fmpz_factor_effort_init(effort, 0, 0);
+
+        ret = fmpz_factor_partial(fac, c, n, effort);
+
+        check_partial(fac, c, n, ret, "complete");
+
+        if (!ret)
+        {
+            flint_printf("FAIL (complete):\n");
+            fmpz_print(n); flint_printf("\n");
+            abort();
+        }
+
+        fmpz_factor_clear(fac);
+    }
+
+    /* zero */
+    fmpz_factor_init(fac);
+    fmpz_factor_effort_init(effort, 0, 0);
+    fmpz_zero(n);
+
+    ret = fmpz_factor_partial(fac, c, n, effort);
+
+    if (!ret || fac->sign != 0 || fac->num != 0 || !fmpz_is_one(c))
+    {
+        flint_printf("FAIL (zero):\n");
+        abort();
+    }
+
+    fmpz_factor_clear(fac);
+
+    /* few operations, small factors are found but two large ones are not */
+    for (i = 0; i < 10; i++)
+    {
+        randprime(x, state, 90);
+        do {
+            randprime(y, state, 90);
+        } while (fmpz_equal(x, y));
+        fmpz_mul(c, x, y);
+
+        fmpz_set_ui(n, n_nth_prime(n_randint(state, 999) + 1));
+        fmpz_mul_ui(n, n, n_randint(state, 1000) + 1);
+        fmpz_mul(n, n, c);
+
+        fmpz_factor_init(fac);
+        fmpz_factor_effort_init(effort, 0, 1000);
+
+        ret = fmpz_factor_partial(fac, c, n, effort);
+
+        check_partial(fac, c, n, ret, "ops");
+
+        if (ret || fac->num == 0 || !fmpz_factor_effort_exhausted(effort))
+        {
+            flint_printf("FAIL (ops):\n");
+            fmpz_print(n); flint_printf("\n");
+            abort();
+        }
+
+        fmpz_factor_clear(fac);
+    }
+
+    /* a time limit stops the sieve well before it finishes */
+    for (i = 0; i < 2; i++)
+    {
+        randprime(x, state, 120);
+        randprime(y, state, 121);
+        fmpz_mul(n, x, y);
+
+        fmpz_factor_init(fac);
+        fmpz_factor_effort_init(effort, 50, 0);
+        t0 = _fmpz_factor_effort_clock();
+
+        ret = fmpz_factor_partial(fac, c, n, effort);
+
+        check_partial(fac, c, n, ret, "time");
+
+        if (ret || !fmpz_equal(c, n) || _fmpz_factor_effort_clock() - t0 > 5000)
+        {
+            flint_printf("FAIL (time):\n");
+            fmpz_print(n); flint_printf("\n");
+            abort();
+        }
+
+        fmpz_factor_clear(fac);
+    }
+
+    /* a cancelled effort only leaves what needs no strategy step */
+    for (i = 0; i < 10; i++)
+    {
+        randprime(x, state, 70);
+        fmpz_mul_2exp(n, x, n_randint(state, 5));
+        fmpz_mul_ui(n, n, n_randint(state, 1000) + 1);
+
+        fmpz_factor_init(fac);
+        fmpz_factor_effort_init(effort, 0, 0);
+        fmpz_factor_effort_cancel(effort);
+
+        ret = fmpz_factor_partial(fac, c, n, effort);
+
+        check_partial(fac, c, n, ret, "cancel");
+
+        fmpz_factor_clear(fac);
+    }
+
+    fmpz_clear(n);
+    fmpz_clear(c);
+    fmpz_clear(x);
+    fmpz_clear(y);
+
+    FLINT_TEST_CLEANUP(state);
+
+    flint_printf("PASS\n");
+    return 0;
+}
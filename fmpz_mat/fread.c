@@ -16,41 +16,41 @@ fmpz_mat_fread(FILE* file, fmpz_mat_t mat)
 {
     slong r, c, i, j;
     int byte_count;
-    mpz_t t;
+    fmpz_t t;
 
     /* first number in file should be row dimension */
-    mpz_init(t);
-    byte_count = mpz_inp_str(t, file, 10);
+    fmpz_init(t);
+    byte_count = fmpz_fread(file, t);
     if (byte_count == 0)
     {
-        mpz_clear(t);
+        fmpz_clear(t);
         return 0;
     }
     
-    if (!mpz_fits_slong_p(t))
+    if (!fmpz_fits_si(t))
     {
         flint_printf("Exception (fmpz_mat_fread). "
                "Number of rows does not fit into a slong.\n");
         flint_abort();
     }
-    r = flint_mpz_get_si(t);
+    r = fmpz_get_si(t);
 
     /* second number in file should be column dimension */
-    byte_count = mpz_inp_str(t, file, 10);
+    byte_count = fmpz_fread(file, t);
     if (byte_count == 0)
     {
-        mpz_clear(t);
+        fmpz_clear(t);
         return 0;
     }
     
-    if (!mpz_fits_slong_p(t))
+    if (!fmpz_fits_si(t))
     {
         flint_printf("Exception (fmpz_mat_fread). "
                "Number of columns does not fit into a slong.\n");
         flint_abort();
     }
-    c = flint_mpz_get_si(t);
-    mpz_clear(t);
+    c = fmpz_get_si(t);
+    fmpz_clear(t);
     
     /* if the input is 0 by 0 then set the dimensions to r and c */
     if (mat->r == 0 && mat->c == 0)
@@ -33,13 +33,16 @@ fmpz_mat_mul(fmpz_mat_t C, const fmpz_mat_t A, const fmpz_mat_t B)
 
     dim = FLINT_MIN(FLINT_MIN(m, n), k);
 
-    if (dim < 12)
+    /* Strassen calls back here for dimensions up to 4 */
+    if (dim < FLINT_MAX(FLINT_CUTOFF(FMPZ_MAT_MUL_SMALL), 5))
     {
         /* The inline version only benefits from large n */
         if (n <= 2)
-            fmpz_mat_mul_classical(C, A, B);
+            FLINT_TRACE_CALL(FMPZ_MAT_MUL, "classical", dim,
+                fmpz_mat_mul_classical(C, A, B));
         else
-            fmpz_mat_mul_classical_inline(C, A, B);
+            FLINT_TRACE_CALL(FMPZ_MAT_MUL, "classical_inline", dim,
+                fmpz_mat_mul_classical_inline(C, A, B));
     }
     else
     {
@@ -55,25 +58,30 @@ fmpz_mat_mul(fmpz_mat_t C, const fmpz_mat_t A, const fmpz_mat_t B)
 
         if (5*(ab + bb) > dim * dim || (bits > FLINT_BITS - 3 && dim < 60))
         {
-            if ((ab + bb) * dim < 17000)
+            if ((ab + bb) * dim < FLINT_CUTOFF(FMPZ_MAT_MUL_CLASSICAL))
             {
-                fmpz_mat_mul_classical_inline(C, A, B);
+                FLINT_TRACE_CALL(FMPZ_MAT_MUL, "classical_inline", dim,
+                    fmpz_mat_mul_classical_inline(C, A, B));
             }
             else
             {
-                if (dim > 75 && (ab + bb) > 650)
+                if (dim > FLINT_CUTOFF(FMPZ_MAT_MUL_MULTI_MOD_DIM) &&
+                    (ab + bb) > FLINT_CUTOFF(FMPZ_MAT_MUL_MULTI_MOD_BITS))
                 {
-                    _fmpz_mat_mul_multi_mod(C, A, B, bits);
+                    FLINT_TRACE_CALL(FMPZ_MAT_MUL, "multi_mod", dim,
+                        _fmpz_mat_mul_multi_mod(C, A, B, bits));
                 }
                 else
                 {
-                    fmpz_mat_mul_strassen(C, A, B);
+                    FLINT_TRACE_CALL(FMPZ_MAT_MUL, "strassen", dim,
+                        fmpz_mat_mul_strassen(C, A, B));
                 }
             }
         }
         else
         {
-            _fmpz_mat_mul_multi_mod(C, A, B, bits);
+            FLINT_TRACE_CALL(FMPZ_MAT_MUL, "multi_mod", dim,
+                _fmpz_mat_mul_multi_mod(C, A, B, bits));
         }
     }
 }
@@ -46,8 +46,8 @@ _fmpz_mod_poly_reduce_matrix_mod_poly (fmpz_mat_t A, const fmpz_mat_t B,
     fmpz_clear(invf);
 }
 
-void *
-_fmpz_mod_poly_precompute_matrix_worker (void * arg_ptr)
+void
+_fmpz_mod_poly_precompute_matrix_worker(void * arg_ptr)
 {
     fmpz_mod_poly_matrix_precompute_arg_t arg =
                            *((fmpz_mod_poly_matrix_precompute_arg_t *) arg_ptr);
@@ -65,8 +65,6 @@ _fmpz_mod_poly_precompute_matrix_worker (void * arg_ptr)
                                      arg.poly1.coeffs, n, arg.poly2.coeffs,
                                      n + 1, arg.poly2inv.coeffs, n + 1,
                                      &arg.poly2.p);
-    flint_cleanup();
-    return NULL;
 }
 
 void
@@ -143,7 +141,7 @@ fmpz_mod_poly_precompute_matrix(fmpz_mat_t A, const fmpz_mod_poly_t poly1,
     _fmpz_vec_clear(ptr, vec_len);
 }
 
-void *
+void
 _fmpz_mod_poly_compose_mod_brent_kung_precomp_preinv_worker(void * arg_ptr)
 {
     fmpz_mod_poly_compose_mod_precomp_preinv_arg_t arg=
@@ -156,14 +154,12 @@ _fmpz_mod_poly_compose_mod_brent_kung_precomp_preinv_worker(void * arg_ptr)
 
     if (arg.poly3.length == 1)
     {
-        flint_cleanup();
-        return NULL;
+        return;
     }
     if (arg.poly1.length == 1)
     {
         fmpz_set(arg.res.coeffs, arg.poly1.coeffs);
-        flint_cleanup();
-        return NULL;
+        return;
     }
 
     if (arg.poly3.length == 2)
@@ -171,8 +167,7 @@ _fmpz_mod_poly_compose_mod_brent_kung_precomp_preinv_worker(void * arg_ptr)
         _fmpz_mod_poly_evaluate_fmpz(arg.res.coeffs, arg.poly1.coeffs,
                                      arg.poly1.length, arg.A.rows[1],
                                      &arg.poly3.p);
-        flint_cleanup();
-        return NULL;
+        return;
     }
 
     m = n_sqrt(n) + 1;
@@ -215,8 +210,6 @@ _fmpz_mod_poly_compose_mod_brent_kung_precomp_preinv_worker(void * arg_ptr)
 
     fmpz_mat_clear(B);
     fmpz_mat_clear(C);
-    flint_cleanup();
-    return NULL;
 }
 
 void
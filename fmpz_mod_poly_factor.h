@@ -124,7 +124,7 @@ FLINT_DLL void fmpz_mod_poly_factor_kaltofen_shoup(fmpz_mod_poly_factor_t res,
 FLINT_DLL void fmpz_mod_poly_factor_berlekamp(fmpz_mod_poly_factor_t factors,
                                      const fmpz_mod_poly_t f);
 
-FLINT_DLL void * _fmpz_mod_poly_interval_poly_worker(void* arg_ptr);
+FLINT_DLL void _fmpz_mod_poly_interval_poly_worker(void* arg_ptr);
 
 #ifdef __cplusplus
 }
@@ -14,7 +14,6 @@
 #define ulong ulongxx/* interferes with system includes */
 
 #include <math.h>
-#include <pthread.h>
 
 #undef ulong
 
@@ -22,9 +21,10 @@
 
 #define ulong mp_limb_t
 
+#include "threadpool.h"
 #include "fmpz_mod_poly.h"
 
-void *
+void
 _fmpz_mod_poly_interval_poly_worker(void* arg_ptr)
 {
     fmpz_mod_poly_interval_poly_arg_t arg =
@@ -60,8 +60,6 @@ _fmpz_mod_poly_interval_poly_worker(void* arg_ptr)
 
     _fmpz_vec_clear(tmp, arg.v.length - 1);
     fmpz_clear(invV);
-    flint_cleanup();
-    return NULL;
 }
 
 void
@@ -75,7 +73,6 @@ fmpz_mod_poly_factor_distinct_deg_threaded(fmpz_mod_poly_factor_t res,
     fmpz_t p;
     fmpz_mat_t * HH;
     double beta;
-    pthread_t *threads;
     fmpz_mod_poly_matrix_precompute_arg_t * args1;
     fmpz_mod_poly_compose_mod_precomp_preinv_arg_t * args2;
     fmpz_mod_poly_interval_poly_arg_t * args3;
@@ -126,7 +123,6 @@ fmpz_mod_poly_factor_distinct_deg_threaded(fmpz_mod_poly_factor_t res,
         fmpz_mod_poly_init(scratch[i], p);
 
     HH      = flint_malloc(sizeof(fmpz_mat_t) * (num_threads + 1));
-    threads = flint_malloc(sizeof(pthread_t) * num_threads);
     args1   = flint_malloc(num_threads *
                            sizeof(fmpz_mod_poly_matrix_precompute_arg_t));
     args2   = flint_malloc(num_threads *
@@ -247,12 +243,10 @@ fmpz_mod_poly_factor_distinct_deg_threaded(fmpz_mod_poly_factor_t res,
                 args1[i].poly1    = *scratch[i];
                 args1[i].poly2    = *v;
                 args1[i].poly2inv = *vinv;
-
-                pthread_create(&threads[i], NULL,
-                            _fmpz_mod_poly_precompute_matrix_worker, &args1[i]);
             }
-            for (i = 1; i < c1; i++)
-                pthread_join(threads[i], NULL);
+
+            threadpool_parallel_do(_fmpz_mod_poly_precompute_matrix_worker,
+                                          args1 + 1, c1 - 1, sizeof(args1[0]));
 
             fmpz_mod_poly_rem(tmp, H[num_threads - 1], v);
             for (i = 0; i < c1; i++)
@@ -264,15 +258,14 @@ fmpz_mod_poly_factor_distinct_deg_threaded(fmpz_mod_poly_factor_t res,
                 args2[i].poly1    = *tmp;
                 args2[i].poly3    = *v;
                 args2[i].poly3inv = *vinv;
-
-                pthread_create(&threads[i], NULL,
-        _fmpz_mod_poly_compose_mod_brent_kung_precomp_preinv_worker, &args2[i]);
             }
+
+            threadpool_parallel_do(
+                    _fmpz_mod_poly_compose_mod_brent_kung_precomp_preinv_worker,
+                                                  args2, c1, sizeof(args2[0]));
+
             for (i = 0; i < c1; i++)
-            {
-                pthread_join(threads[i], NULL);
                 _fmpz_mod_poly_normalise(H[num_threads + i]);
-            }
 
             for (i = 0; i < c1; i++)
             {
@@ -285,16 +278,13 @@ fmpz_mod_poly_factor_distinct_deg_threaded(fmpz_mod_poly_factor_t res,
                 args3[i].res  = *I[num_threads + i];
                 args3[i].v    = *v;
                 args3[i].vinv = *vinv;
-
-                pthread_create(&threads[i], NULL,
-                               _fmpz_mod_poly_interval_poly_worker, &args3[i]);
             }
 
+            threadpool_parallel_do(_fmpz_mod_poly_interval_poly_worker,
+                                                  args3, c1, sizeof(args3[0]));
+
             for (i = 0; i < c1; i++)
-            {
-                pthread_join(threads[i], NULL);
                 _fmpz_mod_poly_normalise(I[num_threads + i]);
-            }
 
             fmpz_mod_poly_set_ui(II, UWORD(1));
 
@@ -351,15 +341,14 @@ fmpz_mod_poly_factor_distinct_deg_threaded(fmpz_mod_poly_factor_t res,
                 args2[i].poly1    = *tmp;
                 args2[i].poly3    = *v;
                 args2[i].poly3inv = *vinv;
-
-                pthread_create(&threads[i], NULL,
-        _fmpz_mod_poly_compose_mod_brent_kung_precomp_preinv_worker, &args2[i]);
             }
+
+            threadpool_parallel_do(
+                    _fmpz_mod_poly_compose_mod_brent_kung_precomp_preinv_worker,
+                                                  args2, c2, sizeof(args2[0]));
+
             for (i = 0; i < c2; i++)
-            {
-                pthread_join(threads[i], NULL);
                 _fmpz_mod_poly_normalise(H[j * num_threads + i]);
-            }
 
             for (i = 0; i < c2; i++)
             {
@@ -373,16 +362,13 @@ fmpz_mod_poly_factor_distinct_deg_threaded(fmpz_mod_poly_factor_t res,
                 args3[i].res  = *I[j * num_threads + i];
                 args3[i].v    = *v;
                 args3[i].vinv = *vinv;
-
-                pthread_create(&threads[i], NULL,
-                               _fmpz_mod_poly_interval_poly_worker, &args3[i]);
             }
 
+            threadpool_parallel_do(_fmpz_mod_poly_interval_poly_worker,
+                                                  args3, c2, sizeof(args3[0]));
+
             for (i = 0; i < c2; i++)
-            {
-                pthread_join(threads[i], NULL);
                 _fmpz_mod_poly_normalise(I[j * num_threads + i]);
-            }
 
             fmpz_mod_poly_set_ui(II, UWORD(1));
 
@@ -475,5 +461,4 @@ fmpz_mod_poly_factor_distinct_deg_threaded(fmpz_mod_poly_factor_t res,
     flint_free(args1);
     flint_free(args2);
     flint_free(args3);
-    flint_free(threads);
 }
@@ -10,8 +10,8 @@
 */
 
 #include <stdlib.h>
-#include <pthread.h>
 
+#include "threadpool.h"
 #include "fmpz_mpoly.h"
 
 /* improve locality */
@@ -68,7 +68,7 @@ mul_array_threaded_arg_t;
     LEX
 ******************/
 
-void * _fmpz_mpoly_mul_array_threaded_worker_LEX(void * arg_ptr)
+void _fmpz_mpoly_mul_array_threaded_worker_LEX(void * arg_ptr)
 {
     slong i, j, Pi;
     mul_array_threaded_arg_t * arg = (mul_array_threaded_arg_t *) arg_ptr;
@@ -201,13 +201,7 @@ void * _fmpz_mpoly_mul_array_threaded_worker_LEX(void * arg_ptr)
         pthread_mutex_unlock(&base->mutex);
     }
 
-    if (arg->idx > 0)
-    {
-        flint_cleanup();
-    }
-
     TMP_END;
-    return NULL;
 }
 
 
@@ -220,7 +214,6 @@ void _fmpz_mpoly_mul_array_chunked_threaded_LEX(fmpz_mpoly_t P,
     slong * Asum, * Amax, * Bsum, * Bmax;
     slong * Amain, * Bmain;
     ulong * Apexp, * Bpexp;
-    pthread_t * threads;
     mul_array_threaded_arg_t * args;
     mul_array_threaded_base_t * base;
     mul_array_threaded_chunk_t * Pchunks;
@@ -322,26 +315,14 @@ void _fmpz_mpoly_mul_array_chunked_threaded_LEX(fmpz_mpoly_t P,
 
     args    = (mul_array_threaded_arg_t *) TMP_ALLOC(
                             sizeof(mul_array_threaded_arg_t) * base->nthreads);
-    threads = (pthread_t *) TMP_ALLOC(sizeof(pthread_t) * base->nthreads);
-
     pthread_mutex_init(&base->mutex, NULL);
     for (i = base->nthreads - 1; i >= 0; i--)
     {
         args[i].idx = i;
         args[i].basep = base;
-        if (i > 0)
-        {
-            pthread_create(&threads[i], NULL,
-                          _fmpz_mpoly_mul_array_threaded_worker_LEX, &args[i]);
-        } else
-        {
-            _fmpz_mpoly_mul_array_threaded_worker_LEX(&args[i]);
-        }
-    }
-    for (i = base->nthreads - 1; i > 0; i--)
-    {
-        pthread_join(threads[i], NULL);
     }
+    threadpool_parallel_do(_fmpz_mpoly_mul_array_threaded_worker_LEX, args,
+                              base->nthreads, sizeof(mul_array_threaded_arg_t));
     pthread_mutex_destroy(&base->mutex);
 
     Plen = 0;
@@ -473,7 +454,7 @@ cleanup:
 *****************************/
 
 
-void * _fmpz_mpoly_mul_array_threaded_worker_DEG(void * arg_ptr)
+void _fmpz_mpoly_mul_array_threaded_worker_DEG(void * arg_ptr)
 {
     slong i, j, Pi;
     mul_array_threaded_arg_t * arg = (mul_array_threaded_arg_t *) arg_ptr;
@@ -617,13 +598,7 @@ void * _fmpz_mpoly_mul_array_threaded_worker_DEG(void * arg_ptr)
         pthread_mutex_unlock(&base->mutex);
     }
 
-    if (arg->idx > 0)
-    {
-        flint_cleanup();
-    }
-
     TMP_END;
-    return NULL;
 }
 
 
@@ -638,7 +613,6 @@ void _fmpz_mpoly_mul_array_chunked_threaded_DEG(fmpz_mpoly_t P,
     slong * Amain, * Bmain;
     ulong * Apexp, * Bpexp;
 
-    pthread_t * threads;
     mul_array_threaded_arg_t * args;
     mul_array_threaded_base_t * base;
     mul_array_threaded_chunk_t * Pchunks;
@@ -743,26 +717,14 @@ void _fmpz_mpoly_mul_array_chunked_threaded_DEG(fmpz_mpoly_t P,
 
     args    = (mul_array_threaded_arg_t *) TMP_ALLOC(sizeof(
                                    mul_array_threaded_arg_t) * base->nthreads);
-    threads = (pthread_t *) TMP_ALLOC(sizeof(pthread_t) * base->nthreads);
-
     pthread_mutex_init(&base->mutex, NULL);
     for (i = base->nthreads - 1; i >= 0; i--)
     {
         args[i].idx = i;
         args[i].basep = base;
-        if (i > 0)
-        {
-            pthread_create(&threads[i], NULL,
-                          _fmpz_mpoly_mul_array_threaded_worker_DEG, &args[i]);
-        } else
-        {
-            _fmpz_mpoly_mul_array_threaded_worker_DEG(&args[i]);
-        }
-    }
-    for (i = base->nthreads - 1; i > 0; i--)
-    {
-        pthread_join(threads[i], NULL);
     }
+    threadpool_parallel_do(_fmpz_mpoly_mul_array_threaded_worker_DEG, args,
+                              base->nthreads, sizeof(mul_array_threaded_arg_t));
     pthread_mutex_destroy(&base->mutex);
 
     Plen = 0;
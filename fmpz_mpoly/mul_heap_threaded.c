@@ -11,8 +11,8 @@
 
 #include <gmp.h>
 #include <stdlib.h>
-#include <pthread.h>
 
+#include "threadpool.h"
 #include "fmpz_mpoly.h"
 
 
@@ -552,7 +552,7 @@ mul_heap_threaded_arg_t;
       yy = tt; \
    } while (0)
 
-void * _fmpz_mpoly_mul_heap_threaded_worker(void * arg_ptr)
+void _fmpz_mpoly_mul_heap_threaded_worker(void * arg_ptr)
 {
     mul_heap_threaded_arg_t * arg = (mul_heap_threaded_arg_t *) arg_ptr;
 
@@ -651,11 +651,6 @@ void * _fmpz_mpoly_mul_heap_threaded_worker(void * arg_ptr)
     flint_free(t2);
     flint_free(t1);
     flint_free(exp);
-    if (arg->idx + 1 < base->nthreads)
-    {
-        flint_cleanup();
-    }
-    return NULL;
 }
 
 
@@ -666,7 +661,6 @@ slong _fmpz_mpoly_mul_heap_threaded(fmpz ** poly1, ulong ** exp1, slong * alloc,
                               mp_bitcnt_t bits, slong N, const ulong * cmpmask)
 {
     slong i, j, k, ndivs2;
-    pthread_t * threads;
     mul_heap_threaded_arg_t * args;
     mul_heap_threaded_base_t * base;
     mul_heap_threaded_div_t * divs;
@@ -690,7 +684,6 @@ slong _fmpz_mpoly_mul_heap_threaded(fmpz ** poly1, ulong ** exp1, slong * alloc,
     ndivs2 = base->ndivs*base->ndivs;
 
     divs    = flint_malloc(sizeof(mul_heap_threaded_div_t) * base->ndivs);
-    threads = flint_malloc(sizeof(pthread_t) * base->nthreads);
     args    = flint_malloc(sizeof(mul_heap_threaded_arg_t) * base->nthreads);
 
     /* allocate space and set the boundary for each division */
@@ -731,21 +724,9 @@ slong _fmpz_mpoly_mul_heap_threaded(fmpz ** poly1, ulong ** exp1, slong * alloc,
         args[i].idx = i;
         args[i].basep = base;
         args[i].divp = divs;
-        if (i + 1 < base->nthreads)
-        {
-            pthread_create(&threads[i], NULL, _fmpz_mpoly_mul_heap_threaded_worker, &args[i]);
-        } else
-        {
-            _fmpz_mpoly_mul_heap_threaded_worker(&args[i]);
-        }
-    }
-    for (i = base->nthreads-1; i >= 0; i--)
-    {
-        if (i + 1 < base->nthreads)
-        {
-            pthread_join(threads[i], NULL);
-        }
     }
+    threadpool_parallel_do(_fmpz_mpoly_mul_heap_threaded_worker, args,
+                                base->nthreads, sizeof(mul_heap_threaded_arg_t));
     pthread_mutex_destroy(&base->mutex);
 
     /* concatenate the outputs */ 
@@ -779,7 +760,6 @@ slong _fmpz_mpoly_mul_heap_threaded(fmpz ** poly1, ulong ** exp1, slong * alloc,
     }
 
     flint_free(args);
-    flint_free(threads);
     flint_free(divs);
     flint_free(base);
 
@@ -19,22 +19,22 @@ int fmpz_poly_fread(FILE * file, fmpz_poly_t poly)
 {
     int r;
     slong i, len;
-    mpz_t t;
+    fmpz_t t;
 
-    mpz_init(t);
-    r = mpz_inp_str(t, file, 10);
+    fmpz_init(t);
+    r = fmpz_fread(file, t);
     if (r == 0)
     {
-        mpz_clear(t);
+        fmpz_clear(t);
         return 0;
     }
-    if (!mpz_fits_slong_p(t))
+    if (!fmpz_fits_si(t))
     {
         flint_printf("Exception (fmpz_poly_fread). Length does not fit into a slong.\n");
         flint_abort();
     }
-    len = flint_mpz_get_si(t);
-    mpz_clear(t);
+    len = fmpz_get_si(t);
+    fmpz_clear(t);
 
     fmpz_poly_fit_length(poly, len);
 
@@ -10,9 +10,9 @@
 */
 
 #include <math.h>
-#include <pthread.h>
 #include <gmp.h>
 #include "flint.h"
+#include "threadpool.h"
 #include "fmpz.h"
 #include "fmpz_poly.h"
 #include "nmod_poly.h"
@@ -30,15 +30,16 @@ worker_t;
 void _fmpz_poly_taylor_shift_dc(fmpz * poly,
     const fmpz_t c, slong len, slong num_total_threads);
 
-static void *
+static void
 _fmpz_poly_taylor_shift_dc_worker(void * arg_ptr)
 {
     worker_t * data = (worker_t *) arg_ptr;
+    int num_threads = flint_get_num_threads();
+
     flint_set_num_threads(data->num_threads);
     _fmpz_poly_taylor_shift_dc(data->poly, data->c, data->len,
                                data->num_total_threads);
-    flint_cleanup();
-    return NULL;
+    flint_set_num_threads(num_threads);
 }
 
 void
@@ -85,7 +86,6 @@ _fmpz_poly_taylor_shift_dc(fmpz * poly, const fmpz_t c, slong len,
     }
     else
     {
-        pthread_t threads[2];
         worker_t args[2];
 
         args[0].poly = poly;
@@ -104,13 +104,8 @@ _fmpz_poly_taylor_shift_dc(fmpz * poly, const fmpz_t c, slong len,
         args[1].num_threads = args[0].num_threads;
         args[1].num_total_threads = args[0].num_total_threads;
 
-        pthread_create(&threads[0], NULL,
-            _fmpz_poly_taylor_shift_dc_worker, &args[0]);
-        pthread_create(&threads[1], NULL,
-            _fmpz_poly_taylor_shift_dc_worker, &args[1]);
-
-        pthread_join(threads[0], NULL);
-        pthread_join(threads[1], NULL);
+        threadpool_parallel_do(_fmpz_poly_taylor_shift_dc_worker, args,
+                                                          2, sizeof(worker_t));
     }
 
     tmp = _fmpz_vec_init(len1 + 1);
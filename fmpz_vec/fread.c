@@ -20,38 +20,38 @@ int _fmpz_vec_fread(FILE * file, fmpz ** vec, slong * len)
 {
     int alloc, r;
     slong i;
-    mpz_t t;
+    fmpz_t t;
 
     alloc = (*vec == NULL);
 
-    mpz_init(t);
-    r = mpz_inp_str(t, file, 10);
+    fmpz_init(t);
+    r = fmpz_fread(file, t);
     if (r == 0)
     {
         if (alloc)
             *len = 0;
-        mpz_clear(t);
+        fmpz_clear(t);
         return 0;
     }
-    if (!mpz_fits_slong_p(t))
+    if (!fmpz_fits_si(t))
     {
         flint_printf("Exception (_fmpz_vec_fread). Length does not fit into a slong.\n");
         flint_abort();
     }
     if (alloc)
     {
-        *len = flint_mpz_get_si(t);
+        *len = fmpz_get_si(t);
         *vec = _fmpz_vec_init(*len);
     }
     else
     {
-        if (*len != flint_mpz_get_si(t))
+        if (*len != fmpz_get_si(t))
         {
-            mpz_clear(t);
+            fmpz_clear(t);
             return 0;
         }
     }
-    mpz_clear(t);
+    fmpz_clear(t);
 
     for (i = 0; i < *len; i++)
     {
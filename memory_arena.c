@@ -0,0 +1,439 @@
+/*
+    Copyright (C) 2019 William Hart
+
+    This file is part of FLINT.
+
+    FLINT is free software: you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.  See <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "flint.h"
+
+/*
+    Each thread owns a list of chunks from which blocks are handed out with
+    a bump pointer. Every block is preceded by a header giving the chunk it
+    lives in (NULL for blocks obtained from malloc) and its size.
+
+    Freeing the topmost block of the current chunk moves the bump pointer
+    back down, so that temporaries allocated and freed in stack order are
+    recycled immediately. Other blocks are simply counted off, and a chunk
+    is reset once all of its blocks have been freed.
+
+    Blocks freed by a thread other than the owner are counted in a separate
+    field protected by a global mutex. The owner only reads it when it runs
+    out of room, and a chunk whose owner has called flint_cleanup is freed
+    by whichever thread releases its last block.
+*/
+
+#define FLINT_ARENA_CHUNK_SIZE (WORD(1) << 20)
+
+/* larger blocks go straight to malloc */
+#define FLINT_ARENA_MAX_BLOCK (FLINT_ARENA_CHUNK_SIZE/4)
+
+struct _flint_arena_struct;
+
+typedef struct _flint_arena_chunk_struct
+{
+    struct _flint_arena_struct * owner; /* NULL once orphaned */
+    char * base;
+    size_t top;
+    slong live;         /* blocks not freed by the owner */
+    slong remote;       /* blocks freed by other threads */
+    size_t remote_bytes;
+    struct _flint_arena_chunk_struct * next;
+} _flint_arena_chunk_struct;
+
+typedef struct _flint_arena_struct
+{
+    _flint_arena_chunk_struct * current;
+    _flint_arena_chunk_struct * chunks; /* all chunks except current */
+    size_t in_use;
+    size_t high_water;
+    ulong num_chunks;
+    ulong num_allocs;
+    ulong num_large;
+} _flint_arena_struct;
+
+/* two words, which keeps the blocks suitably aligned */
+typedef struct
+{
+    _flint_arena_chunk_struct * chunk;
+    size_t size;
+} _flint_arena_header_struct;
+
+#define HDR_SIZE sizeof(_flint_arena_header_struct)
+
+#define HDR(ptr) ((_flint_arena_header_struct *) (ptr) - 1)
+
+FLINT_TLS_PREFIX _flint_arena_struct _flint_arena =
+                                                  {NULL, NULL, 0, 0, 0, 0, 0};
+
+static pthread_mutex_t _flint_arena_remote_lock = PTHREAD_MUTEX_INITIALIZER;
+
+#if !HAVE_TLS
+/* without thread local storage all threads share a single arena */
+static pthread_mutex_t _flint_arena_lock = PTHREAD_MUTEX_INITIALIZER;
+#define ARENA_LOCK pthread_mutex_lock(&_flint_arena_lock)
+#define ARENA_UNLOCK pthread_mutex_unlock(&_flint_arena_lock)
+#else
+#define ARENA_LOCK
+#define ARENA_UNLOCK
+#endif
+
+static _flint_arena_chunk_struct * _flint_arena_chunk_new(void)
+{
+    _flint_arena_chunk_struct * c;
+
+    c = (_flint_arena_chunk_struct *)
+                        malloc(sizeof(_flint_arena_chunk_struct));
+    if (c == NULL)
+        return NULL;
+
+    c->base = (char *) malloc(FLINT_ARENA_CHUNK_SIZE);
+    if (c->base == NULL)
+    {
+        free(c);
+        return NULL;
+    }
+
+    c->owner = &_flint_arena;
+    c->top = 0;
+    c->live = 0;
+    c->remote = 0;
+    c->remote_bytes = 0;
+    c->next = NULL;
+
+    _flint_arena.num_chunks++;
+
+    return c;
+}
+
+static void _flint_arena_chunk_free(_flint_arena_chunk_struct * c)
+{
+    free(c->base);
+    free(c);
+}
+
+/*
+    Collect the remote frees of all our chunks and make a chunk with room for
+    size bytes the current one.
+*/
+static int _flint_arena_refill(size_t size)
+{
+    _flint_arena_struct * A = &_flint_arena;
+    _flint_arena_chunk_struct * c, ** prev, * found = NULL;
+
+    if (A->current != NULL)
+    {
+        A->current->next = A->chunks;
+        A->chunks = A->current;
+        A->current = NULL;
+    }
+
+    pthread_mutex_lock(&_flint_arena_remote_lock);
+
+    for (c = A->chunks; c != NULL; c = c->next)
+    {
+        A->in_use -= c->remote_bytes;
+        c->remote_bytes = 0;
+
+        if (c->remote != 0 && c->live == c->remote)
+        {
+            c->live = 0;
+            c->remote = 0;
+        }
+
+        if (c->live == 0)
+            c->top = 0;
+    }
+
+    pthread_mutex_unlock(&_flint_arena_remote_lock);
+
+    for (prev = &A->chunks; *prev != NULL; prev = &(*prev)->next)
+    {
+        if ((*prev)->top + size <= FLINT_ARENA_CHUNK_SIZE)
+        {
+            found = *prev;
+            *prev = found->next;
+            break;
+        }
+    }
+
+    if (found == NULL)
+        found = _flint_arena_chunk_new();
+
+    if (found == NULL)
+        return 0;
+
+    found->next = NULL;
+    A->current = found;
+
+    return 1;
+}
+
+static void * _flint_arena_alloc(size_t size)
+{
+    _flint_arena_struct * A = &_flint_arena;
+    _flint_arena_header_struct * h;
+    _flint_arena_chunk_struct * c;
+
+    /* round up to a whole number of headers */
+    size = ((size + HDR_SIZE - 1)/HDR_SIZE + 1)*HDR_SIZE;
+
+    if (size > FLINT_ARENA_MAX_BLOCK)
+    {
+        h = (_flint_arena_header_struct *) malloc(size);
+        if (h == NULL)
+            return NULL;
+        h->chunk = NULL;
+        h->size = size;
+        A->num_large++;
+        return h + 1;
+    }
+
+    c = A->current;
+    if (c == NULL || c->top + size > FLINT_ARENA_CHUNK_SIZE)
+    {
+        if (!_flint_arena_refill(size))
+            return NULL;
+        c = A->current;
+    }
+
+    h = (_flint_arena_header_struct *) (c->base + c->top);
+    h->chunk = c;
+    h->size = size;
+
+    c->top += size;
+    c->live++;
+
+    A->num_allocs++;
+    A->in_use += size;
+    if (A->in_use > A->high_water)
+        A->high_water = A->in_use;
+
+    return h + 1;
+}
+
+static void _flint_arena_release(void * ptr)
+{
+    _flint_arena_struct * A = &_flint_arena;
+    _flint_arena_header_struct * h = HDR(ptr);
+    _flint_arena_chunk_struct * c = h->chunk;
+
+    if (c == NULL)
+    {
+        free(h);
+        return;
+    }
+
+    if (c->owner == A)
+    {
+        A->in_use -= h->size;
+        c->live--;
+
+        if (c == A->current)
+        {
+            if (c->live == 0)
+                c->top = 0;
+            else if ((char *) h + h->size == c->base + c->top)
+                c->top -= h->size;
+        }
+    }
+    else
+    {
+        int orphaned;
+
+        pthread_mutex_lock(&_flint_arena_remote_lock);
+        c->remote++;
+        c->remote_bytes += h->size;
+        orphaned = (c->owner == NULL && c->remote == c->live);
+        pthread_mutex_unlock(&_flint_arena_remote_lock);
+
+        if (orphaned)
+            _flint_arena_chunk_free(c);
+    }
+}
+
+void * flint_arena_malloc(size_t size)
+{
+    void * ptr;
+
+    ARENA_LOCK;
+    ptr = _flint_arena_alloc(size);
+    ARENA_UNLOCK;
+
+    return ptr;
+}
+
+void * flint_arena_calloc(size_t num, size_t size)
+{
+    void * ptr;
+
+    ARENA_LOCK;
+    ptr = _flint_arena_alloc(num*size);
+    ARENA_UNLOCK;
+
+    if (ptr != NULL)
+        memset(ptr, 0, num*size);
+
+    return ptr;
+}
+
+void * flint_arena_realloc(void * ptr, size_t size)
+{
+    _flint_arena_struct * A = &_flint_arena;
+    _flint_arena_header_struct * h;
+    _flint_arena_chunk_struct * c;
+    size_t old_size, new_size;
+    void * ptr2;
+
+    if (ptr == NULL)
+        return flint_arena_malloc(size);
+
+    h = HDR(ptr);
+    c = h->chunk;
+    old_size = h->size;
+    new_size = ((size + HDR_SIZE - 1)/HDR_SIZE + 1)*HDR_SIZE;
+
+    ARENA_LOCK;
+
+    if (c == NULL && new_size > FLINT_ARENA_MAX_BLOCK)
+    {
+        h = (_flint_arena_header_struct *) realloc(h, new_size);
+        if (h != NULL)
+            h->size = new_size;
+        ARENA_UNLOCK;
+        return h == NULL ? NULL : h + 1;
+    }
+
+    /* the topmost block of the current chunk can grow or shrink in place */
+    if (c != NULL && c == A->current &&
+        (char *) h + old_size == c->base + c->top &&
+        c->top - old_size + new_size <= FLINT_ARENA_CHUNK_SIZE)
+    {
+        c->top = c->top - old_size + new_size;
+        h->size = new_size;
+        A->in_use = A->in_use - old_size + new_size;
+        if (A->in_use > A->high_water)
+            A->high_water = A->in_use;
+        ARENA_UNLOCK;
+        return ptr;
+    }
+
+    /* any other block can shrink in place */
+    if (c != NULL && new_size <= old_size)
+    {
+        ARENA_UNLOCK;
+        return ptr;
+    }
+
+    ptr2 = _flint_arena_alloc(size);
+    if (ptr2 != NULL)
+    {
+        memcpy(ptr2, ptr, FLINT_MIN(old_size - HDR_SIZE, size));
+        _flint_arena_release(ptr);
+    }
+
+    ARENA_UNLOCK;
+
+    return ptr2;
+}
+
+void flint_arena_free(void * ptr)
+{
+    if (ptr == NULL)
+        return;
+
+    ARENA_LOCK;
+    _flint_arena_release(ptr);
+    ARENA_UNLOCK;
+}
+
+void flint_arena_get_stats(flint_arena_stats_t stats)
+{
+    _flint_arena_struct * A = &_flint_arena;
+
+    ARENA_LOCK;
+    stats->in_use = A->in_use;
+    stats->high_water = A->high_water;
+    stats->num_chunks = A->num_chunks;
+    stats->num_allocs = A->num_allocs;
+    stats->num_large = A->num_large;
+    ARENA_UNLOCK;
+}
+
+/*
+    Release the chunks of the calling thread which no longer hold any live
+    blocks and reset the statistics. If orphan is set, chunks which are still
+    in use are handed over to whichever thread frees their last block.
+*/
+static void _flint_arena_trim(int orphan)
+{
+    _flint_arena_struct * A = &_flint_arena;
+    _flint_arena_chunk_struct * c, * next, * keep = NULL;
+
+    if (A->current != NULL)
+    {
+        A->current->next = A->chunks;
+        A->chunks = A->current;
+        A->current = NULL;
+    }
+
+    pthread_mutex_lock(&_flint_arena_remote_lock);
+
+    for (c = A->chunks; c != NULL; c = next)
+    {
+        next = c->next;
+
+        A->in_use -= c->remote_bytes;
+        c->remote_bytes = 0;
+
+        if (c->live == c->remote)
+        {
+            _flint_arena_chunk_free(c);
+            A->num_chunks--;
+        }
+        else if (orphan)
+        {
+            c->owner = NULL;
+            A->num_chunks--;
+        }
+        else
+        {
+            c->next = keep;
+            keep = c;
+        }
+    }
+
+    pthread_mutex_unlock(&_flint_arena_remote_lock);
+
+    A->chunks = keep;
+    A->high_water = A->in_use;
+    A->num_allocs = 0;
+    A->num_large = 0;
+}
+
+void flint_arena_reset(void)
+{
+    ARENA_LOCK;
+    _flint_arena_trim(0);
+    ARENA_UNLOCK;
+}
+
+void _flint_arena_cleanup(void)
+{
+    ARENA_LOCK;
+#if HAVE_TLS
+    _flint_arena_trim(1);
+    _flint_arena.in_use = 0;
+    _flint_arena.high_water = 0;
+#else
+    _flint_arena_trim(0);
+#endif
+    ARENA_UNLOCK;
+}
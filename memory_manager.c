@@ -193,6 +193,7 @@ void flint_register_cleanup_function(flint_cleanup_function_t cleanup_function)
 }
 
 void _fmpz_cleanup();
+void _flint_arena_cleanup(void);
 
 void flint_cleanup()
 {
@@ -211,7 +212,8 @@ void flint_cleanup()
 
     mpfr_free_cache();
     _fmpz_cleanup();
-    
+    _flint_arena_cleanup();
+
 #if FLINT_REENTRANT && !HAVE_TLS
     pthread_mutex_unlock(&register_lock);
 #endif
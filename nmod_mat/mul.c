@@ -18,20 +18,23 @@
 void
 nmod_mat_mul(nmod_mat_t C, const nmod_mat_t A, const nmod_mat_t B)
 {
-    slong m, k, n;
+    slong m, k, n, cutoff;
 
     m = A->r;
     k = A->c;
     n = B->c;
 
-    if (m < NMOD_MAT_MUL_STRASSEN_CUTOFF ||
-        n < NMOD_MAT_MUL_STRASSEN_CUTOFF ||
-        k < NMOD_MAT_MUL_STRASSEN_CUTOFF)
+    /* Strassen calls back here for dimensions up to 4 */
+    cutoff = FLINT_MAX(NMOD_MAT_MUL_STRASSEN_CUTOFF, 5);
+
+    if (m < cutoff || n < cutoff || k < cutoff)
     {
-        nmod_mat_mul_classical(C, A, B);
+        FLINT_TRACE_CALL(NMOD_MAT_MUL, "classical",
+            FLINT_MIN(FLINT_MIN(m, n), k), nmod_mat_mul_classical(C, A, B));
     }
     else
     {
-        nmod_mat_mul_strassen(C, A, B);
+        FLINT_TRACE_CALL(NMOD_MAT_MUL, "strassen",
+            FLINT_MIN(FLINT_MIN(m, n), k), nmod_mat_mul_strassen(C, A, B));
     }
 }
@@ -628,6 +628,15 @@ FLINT_DLL void nmod_poly_powmod_ui_binexp_preinv(nmod_poly_t res,
                            const nmod_poly_t poly, ulong e,
                            const nmod_poly_t f, const nmod_poly_t finv);
 
+FLINT_DLL void _nmod_poly_powmod_ui_binexp_preinv_mont(mp_ptr res,
+                                    mp_srcptr poly, ulong e, mp_srcptr f,
+                                    slong lenf, mp_srcptr finv,
+                                    slong lenfinv, nmod_t mod);
+
+FLINT_DLL void nmod_poly_powmod_ui_binexp_preinv_mont(nmod_poly_t res,
+                           const nmod_poly_t poly, ulong e,
+                           const nmod_poly_t f, const nmod_poly_t finv);
+
 FLINT_DLL void _nmod_poly_powmod_x_ui_preinv (mp_ptr res, ulong e, mp_srcptr f, slong lenf,
                                mp_srcptr finv, slong lenfinv, nmod_t mod);
 
@@ -940,7 +949,7 @@ FLINT_DLL void _nmod_poly_reduce_matrix_mod_poly (nmod_mat_t A, const nmod_mat_t
 FLINT_DLL void _nmod_poly_precompute_matrix (nmod_mat_t A, mp_srcptr poly1, mp_srcptr poly2,
                slong len2, mp_srcptr poly2inv, slong len2inv, nmod_t mod);
 
-FLINT_DLL void * _nmod_poly_precompute_matrix_worker (void * arg_ptr);
+FLINT_DLL void _nmod_poly_precompute_matrix_worker(void * arg_ptr);
 
 FLINT_DLL void nmod_poly_precompute_matrix (nmod_mat_t A, const nmod_poly_t poly1,
                           const nmod_poly_t poly2, const nmod_poly_t poly2inv);
@@ -950,7 +959,7 @@ FLINT_DLL void _nmod_poly_compose_mod_brent_kung_precomp_preinv(mp_ptr res, mp_s
                             slong len3, mp_srcptr poly3inv, slong len3inv,
                             nmod_t mod);
 
-FLINT_DLL void * _nmod_poly_compose_mod_brent_kung_precomp_preinv_worker(void * arg_ptr);
+FLINT_DLL void _nmod_poly_compose_mod_brent_kung_precomp_preinv_worker(void * arg_ptr);
 
 FLINT_DLL void nmod_poly_compose_mod_brent_kung_precomp_preinv(nmod_poly_t res,
                     const nmod_poly_t poly1, const nmod_mat_t A,
@@ -20,23 +20,30 @@ void _nmod_poly_mul(mp_ptr res, mp_srcptr poly1, slong len1,
 {
     slong bits, bits2;
 
+    bits = FLINT_BITS - (slong) mod.norm;
+
     if (len1 + len2 <= 6 || len2 <= 2)
     {
-        _nmod_poly_mul_classical(res, poly1, len1, poly2, len2, mod);
+        FLINT_TRACE_CALL(NMOD_POLY_MUL, "classical", bits * len2,
+            _nmod_poly_mul_classical(res, poly1, len1, poly2, len2, mod));
         return;
     }
 
-    bits = FLINT_BITS - (slong) mod.norm;
     bits2 = FLINT_BIT_COUNT(len1);
 
+    /* traced sizes are bits*len2, the units of the KS2 and KS4 cutoffs */
     if (2 * bits + bits2 <= FLINT_BITS && len1 + len2 < 16)
-        _nmod_poly_mul_classical(res, poly1, len1, poly2, len2, mod);
-    else if (bits * len2 > 2000)
-        _nmod_poly_mul_KS4(res, poly1, len1, poly2, len2, mod);
-    else if (bits * len2 > 200)
-        _nmod_poly_mul_KS2(res, poly1, len1, poly2, len2, mod);
+        FLINT_TRACE_CALL(NMOD_POLY_MUL, "classical", bits * len2,
+            _nmod_poly_mul_classical(res, poly1, len1, poly2, len2, mod));
+    else if (bits * len2 > FLINT_CUTOFF(NMOD_POLY_MUL_KS4))
+        FLINT_TRACE_CALL(NMOD_POLY_MUL, "KS4", bits * len2,
+            _nmod_poly_mul_KS4(res, poly1, len1, poly2, len2, mod));
+    else if (bits * len2 > FLINT_CUTOFF(NMOD_POLY_MUL_KS2))
+        FLINT_TRACE_CALL(NMOD_POLY_MUL, "KS2", bits * len2,
+            _nmod_poly_mul_KS2(res, poly1, len1, poly2, len2, mod));
     else
-        _nmod_poly_mul_KS(res, poly1, len1, poly2, len2, 0, mod);
+        FLINT_TRACE_CALL(NMOD_POLY_MUL, "KS", bits * len2,
+            _nmod_poly_mul_KS(res, poly1, len1, poly2, len2, 0, mod));
 }
 
 void nmod_poly_mul(nmod_poly_t res, const nmod_poly_t poly1, const nmod_poly_t poly2)
@@ -0,0 +1,189 @@
+/*
+    Copyright (C) 2019 William Hart
+
+    This file is part of FLINT.
+
+    FLINT is free software: you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.  See <http://www.gnu.org/licenses/>.
+*/
+
+#undef ulong
+#define ulong ulongxx/* interferes with system includes */
+
+#include <stdlib.h>
+
+#undef ulong
+
+#include <gmp.h>
+
+#define ulong mp_limb_t
+
+#include "flint.h"
+#include "nmod_vec.h"
+#include "nmod_poly.h"
+#include "ulong_extras.h"
+
+/*
+   The coefficients are kept in Montgomery form aR mod n. Division with
+   remainder by f is linear, so it maps Montgomery forms to Montgomery
+   forms and is done as usual. Products are classical, each coefficient
+   being a Montgomery dot product, which beats _nmod_poly_mul for short
+   polynomials and moduli of more than half a limb. Otherwise we call
+   _nmod_poly_powmod_ui_binexp_preinv.
+*/
+
+#define MONT_MUL_CUTOFF 16
+
+/*
+   (T, 2*len - 1) = (A, len)*(B, len)/R, with Brev the reverse of B. When
+   A == B the symmetric terms of the square are only summed once.
+*/
+static void
+_nmod_poly_mul_mont(mp_ptr T, mp_srcptr A, mp_srcptr B, mp_srcptr Brev,
+                                  slong len, nmod_mont_t mont, nmod_t mod)
+{
+    slong k, lo, hi, m;
+    mp_limb_t s;
+
+    for (k = 0; k < 2*len - 1; k++)
+    {
+        lo = FLINT_MAX(0, k - len + 1);
+        hi = FLINT_MIN(k, len - 1);
+
+        if (A == B)
+        {
+            m = (hi - lo + 1)/2;
+            s = _nmod_vec_dot_mont(A + lo, Brev + len - 1 - k + lo, m, mont);
+            s = nmod_add(s, s, mod);
+
+            if ((k & 1) == 0)
+                s = nmod_add(s, nmod_mont_mul(A[k/2], A[k/2], mont), mod);
+
+            T[k] = s;
+        }
+        else
+            T[k] = _nmod_vec_dot_mont(A + lo, Brev + len - 1 - k + lo,
+                                                          hi - lo + 1, mont);
+    }
+}
+
+void
+_nmod_poly_powmod_ui_binexp_preinv_mont(mp_ptr res, mp_srcptr poly,
+                                    ulong e, mp_srcptr f, slong lenf,
+                                    mp_srcptr finv, slong lenfinv, nmod_t mod)
+{
+    nmod_mont_t mont;
+    mp_ptr T, Q, P, Prev, Rrev;
+    slong i, lenT, lenQ, len = lenf - 1;
+    int j;
+
+    if (lenf - 1 > MONT_MUL_CUTOFF || mod.norm >= FLINT_BITS / 2)
+    {
+        _nmod_poly_powmod_ui_binexp_preinv(res, poly, e, f, lenf,
+                                                      finv, lenfinv, mod);
+        return;
+    }
+
+    nmod_mont_init(&mont, mod.n);
+
+    if (lenf == 2)
+    {
+        res[0] = nmod_mont_from(nmod_mont_pow_ui(
+                         nmod_mont_to(poly[0], mont), e, mont), mont);
+        return;
+    }
+
+    lenT = 2 * lenf - 3;
+    lenQ = FLINT_MAX(lenT - lenf + 1, 1);
+
+    T = _nmod_vec_init(lenT + lenQ + 3*len);
+    Q = T + lenT;
+    P = Q + lenQ;
+    Prev = P + len;
+    Rrev = Prev + len;
+
+    _nmod_vec_to_mont(P, poly, len, mont);
+    for (i = 0; i < len; i++)
+        Prev[i] = P[len - 1 - i];
+
+    _nmod_vec_set(res, P, len);
+
+    for (j = ((int) FLINT_BIT_COUNT(e) - 2); j >= 0; j--)
+    {
+        for (i = 0; i < len; i++)
+            Rrev[i] = res[len - 1 - i];
+
+        _nmod_poly_mul_mont(T, res, res, Rrev, len, mont, mod);
+        _nmod_poly_divrem_newton_n_preinv(Q, res, T, lenT, f,
+                                          lenf, finv, lenfinv, mod);
+
+        if (e & (UWORD(1) << j))
+        {
+            _nmod_poly_mul_mont(T, res, P, Prev, len, mont, mod);
+            _nmod_poly_divrem_newton_n_preinv(Q, res, T, lenT, f,
+                                              lenf, finv, lenfinv, mod);
+        }
+    }
+
+    _nmod_vec_from_mont(res, res, len, mont);
+
+    _nmod_vec_clear(T);
+}
+
+void
+nmod_poly_powmod_ui_binexp_preinv_mont(nmod_poly_t res,
+                           const nmod_poly_t poly, ulong e,
+                           const nmod_poly_t f, const nmod_poly_t finv)
+{
+    mp_ptr p;
+    slong len = poly->length;
+    slong lenf = f->length;
+    slong trunc = lenf - 1;
+    int pcopy = 0;
+
+    if (lenf == 0)
+    {
+        flint_printf("Exception (nmod_poly_powmod_ui_binexp_preinv_mont). Divide by zero.\n");
+        flint_abort();
+    }
+
+    if ((poly->mod.n & 1) == 0 || len >= lenf || e <= 2
+                               || lenf == 1 || len == 0)
+    {
+        nmod_poly_powmod_ui_binexp_preinv(res, poly, e, f, finv);
+        return;
+    }
+
+    if (len < trunc)
+    {
+        p = _nmod_vec_init(trunc);
+        flint_mpn_copyi(p, poly->coeffs, len);
+        flint_mpn_zero(p + len, trunc - len);
+        pcopy = 1;
+    } else
+        p = poly->coeffs;
+
+    if ((res == poly && !pcopy) || (res == f) || (res == finv))
+    {
+        nmod_poly_t t;
+        nmod_poly_init2(t, poly->mod.n, trunc);
+        _nmod_poly_powmod_ui_binexp_preinv_mont(t->coeffs,
+            p, e, f->coeffs, lenf, finv->coeffs, finv->length, poly->mod);
+        nmod_poly_swap(res, t);
+        nmod_poly_clear(t);
+    }
+    else
+    {
+        nmod_poly_fit_length(res, trunc);
+        _nmod_poly_powmod_ui_binexp_preinv_mont(res->coeffs,
+            p, e, f->coeffs, lenf, finv->coeffs, finv->length, poly->mod);
+    }
+
+    if (pcopy)
+        _nmod_vec_clear(p);
+
+    res->length = trunc;
+    _nmod_poly_normalise(res);
+}
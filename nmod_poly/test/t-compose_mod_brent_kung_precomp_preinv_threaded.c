@@ -19,11 +19,11 @@
 #undef ulong
 
 #include <gmp.h>
-#include <pthread.h>
 
 #define ulong mp_limb_t
 
 #include "flint.h"
+#include "threadpool.h"
 #include "nmod_poly.h"
 #include "ulong_extras.h"
 
@@ -44,13 +44,11 @@ main(void)
         mp_limb_t m = n_randtest_prime(state, 0);
         slong j, num_threads;
         nmod_poly_matrix_precompute_arg_t * args1;
-        pthread_t *threads;
 
         flint_set_num_threads(1 + n_randint(state, 3));
 
         num_threads = flint_get_num_threads();
 
-        threads = flint_malloc(sizeof(pthread_t) * num_threads);
         tmp = flint_malloc(sizeof(nmod_poly_t) * num_threads);
 
         nmod_poly_init(a, m);
@@ -93,12 +91,10 @@ main(void)
             args1[j].poly1    = *tmp[j];
             args1[j].poly2    = *c;
             args1[j].poly2inv = *cinv;
-
-            pthread_create(&threads[j], NULL,
-                           _nmod_poly_precompute_matrix_worker, &args1[j]);
         }
-        for (j = 0; j < num_threads; j++)
-            pthread_join(threads[j], NULL);
+
+        threadpool_parallel_do(_nmod_poly_precompute_matrix_worker,
+                               args1, num_threads, sizeof(args1[0]));
 
         for (j = 0; j < num_threads; j++)
         {
@@ -127,7 +123,6 @@ main(void)
         flint_free(C);
         flint_free(tmp);
         flint_free(args1);
-        flint_free(threads);
     }
 
 #if HAVE_PTHREAD && (HAVE_TLS || FLINT_REENTRANT)
@@ -140,13 +135,11 @@ main(void)
         mp_limb_t m = n_randtest_prime(state, 0);
         slong j, num_threads;
         nmod_poly_compose_mod_precomp_preinv_arg_t * args1;
-        pthread_t *threads;
 
         flint_set_num_threads(1 + n_randint(state, 3));
 
         num_threads = flint_get_num_threads();
 
-        threads = flint_malloc(sizeof(pthread_t) * num_threads);
         res = flint_malloc(sizeof(nmod_poly_t) * num_threads);
 
         nmod_poly_init(a, m);
@@ -186,15 +179,13 @@ main(void)
             args1[j].poly1    = *a;
             args1[j].poly3    = *c;
             args1[j].poly3inv = *cinv;
-
-            pthread_create(&threads[j], NULL,
-                           _nmod_poly_compose_mod_brent_kung_precomp_preinv_worker, &args1[j]);
         }
+
+        threadpool_parallel_do(_nmod_poly_compose_mod_brent_kung_precomp_preinv_worker,
+                               args1, num_threads, sizeof(args1[0]));
+
         for (j = 0; j < num_threads; j++)
-        {
-            pthread_join(threads[j], NULL);
             _nmod_poly_normalise(res[j]);
-        }
 
         for (j = 0; j < num_threads; j++)
         {
@@ -220,7 +211,6 @@ main(void)
             nmod_poly_clear(res[j]);
         flint_free(res);
         flint_free(args1);
-        flint_free(threads);
     }
 
     FLINT_TEST_CLEANUP(state);
@@ -0,0 +1,131 @@
+/*
+    Copyright (C) 2019 William Hart
+
+    This file is part of FLINT.
+
+    FLINT is free software: you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.  See <http://www.gnu.org/licenses/>.
+*/
+
+#undef ulong
+#define ulong ulongxx/* interferes with system includes */
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#undef ulong
+
+#include <gmp.h>
+
+#define ulong mp_limb_t
+
+#include "flint.h"
+#include "nmod_vec.h"
+#include "nmod_poly.h"
+#include "ulong_extras.h"
+
+int
+main(void)
+{
+    int i, result;
+    FLINT_TEST_INIT(state);
+
+    flint_printf("powmod_ui_binexp_preinv_mont....");
+    fflush(stdout);
+
+    /* Aliasing of res and a */
+    for (i = 0; i < 50 * flint_test_multiplier(); i++)
+    {
+        nmod_poly_t a, res1, f, finv;
+        mp_limb_t n;
+        ulong exp;
+
+        n = n_randtest_prime(state, 0);
+        exp = n_randlimb(state) % 32;
+
+        nmod_poly_init(a, n);
+        nmod_poly_init(f, n);
+        nmod_poly_init(finv, n);
+        nmod_poly_init(res1, n);
+
+        nmod_poly_randtest(a, state, n_randint(state, 30));
+        do {
+            nmod_poly_randtest(f, state, n_randint(state, 30));
+        } while (nmod_poly_is_zero(f));
+
+        nmod_poly_reverse(finv, f, f->length);
+        nmod_poly_inv_series(finv, finv, f->length);
+
+        nmod_poly_powmod_ui_binexp_preinv_mont(res1, a, exp, f, finv);
+        nmod_poly_powmod_ui_binexp_preinv_mont(a, a, exp, f, finv);
+
+        result = (nmod_poly_equal(res1, a));
+        if (!result)
+        {
+            flint_printf("FAIL (aliasing):\n");
+            flint_printf("exp: %wu\n\n", exp);
+            flint_printf("a:\n"); nmod_poly_print(a), flint_printf("\n\n");
+            flint_printf("f:\n"); nmod_poly_print(f), flint_printf("\n\n");
+            flint_printf("res1:\n"); nmod_poly_print(res1), flint_printf("\n\n");
+            abort();
+        }
+
+        nmod_poly_clear(a);
+        nmod_poly_clear(f);
+        nmod_poly_clear(finv);
+        nmod_poly_clear(res1);
+    }
+
+    /* Compare with nmod_poly_powmod_ui_binexp_preinv */
+    for (i = 0; i < 500 * flint_test_multiplier(); i++)
+    {
+        nmod_poly_t a, res1, res2, f, finv;
+        mp_limb_t n;
+        ulong exp;
+
+        n = n_randtest_prime(state, 0);
+        exp = n_randtest(state);
+
+        nmod_poly_init(a, n);
+        nmod_poly_init(f, n);
+        nmod_poly_init(finv, n);
+        nmod_poly_init(res1, n);
+        nmod_poly_init(res2, n);
+
+        do {
+            nmod_poly_randtest(f, state, n_randint(state, 30));
+        } while (nmod_poly_is_zero(f));
+        nmod_poly_randtest(a, state, n_randint(state, f->length + 1));
+
+        nmod_poly_reverse(finv, f, f->length);
+        nmod_poly_inv_series(finv, finv, f->length);
+
+        nmod_poly_powmod_ui_binexp_preinv(res1, a, exp, f, finv);
+        nmod_poly_powmod_ui_binexp_preinv_mont(res2, a, exp, f, finv);
+
+        result = (nmod_poly_equal(res1, res2));
+        if (!result)
+        {
+            flint_printf("FAIL:\n");
+            flint_printf("exp: %wu\n\n", exp);
+            flint_printf("a:\n"); nmod_poly_print(a), flint_printf("\n\n");
+            flint_printf("f:\n"); nmod_poly_print(f), flint_printf("\n\n");
+            flint_printf("res1:\n"); nmod_poly_print(res1), flint_printf("\n\n");
+            flint_printf("res2:\n"); nmod_poly_print(res2), flint_printf("\n\n");
+            abort();
+        }
+
+        nmod_poly_clear(a);
+        nmod_poly_clear(f);
+        nmod_poly_clear(finv);
+        nmod_poly_clear(res1);
+        nmod_poly_clear(res2);
+    }
+
+    FLINT_TEST_CLEANUP(state);
+
+    flint_printf("PASS\n");
+    return 0;
+}
@@ -129,7 +129,7 @@ FLINT_DLL mp_limb_t nmod_poly_factor_with_kaltofen_shoup(nmod_poly_factor_t resu
 FLINT_DLL mp_limb_t nmod_poly_factor(nmod_poly_factor_t result,
     const nmod_poly_t input);
 
-FLINT_DLL void * _nmod_poly_interval_poly_worker(void* arg_ptr);
+FLINT_DLL void _nmod_poly_interval_poly_worker(void* arg_ptr);
 
 #ifdef __cplusplus
     }
@@ -14,7 +14,6 @@
 
 #include <stdlib.h>
 #include <stdio.h>
-#include <pthread.h>
 
 #undef ulong
 
@@ -23,6 +22,7 @@
 #define ulong mp_limb_t
 
 #include "flint.h"
+#include "threadpool.h"
 #include "nmod_poly.h"
 #include "ulong_extras.h"
 
@@ -43,14 +43,12 @@ main(void)
         mp_limb_t modulus;
         slong j, num_threads, l;
         nmod_poly_interval_poly_arg_t * args1;
-        pthread_t *threads;
 
         flint_set_num_threads(1 + n_randint(state, 3));
 
         num_threads = flint_get_num_threads();
 
         l = n_randint(state, 20) + 1;
-        threads = flint_malloc(sizeof(pthread_t) * num_threads);
         e = flint_malloc(sizeof(nmod_poly_struct) * num_threads);
         tmp = flint_malloc(sizeof(nmod_poly_struct) * l);
         args1 = flint_malloc(num_threads *
@@ -102,11 +100,11 @@ main(void)
             args1[j].v = *c;
             args1[j].vinv = *cinv;
             args1[j].m = l;
-
-            pthread_create(&threads[j], NULL, _nmod_poly_interval_poly_worker, &args1[j]);
         }
-        for (j = 0; j < num_threads; j++)
-            pthread_join(threads[j], NULL);
+
+        threadpool_parallel_do(_nmod_poly_interval_poly_worker,
+                               args1, num_threads, sizeof(args1[0]));
+
         for (j = 0; j < num_threads; j++)
             _nmod_poly_normalise(e[j]);
 
@@ -135,7 +133,6 @@ main(void)
         flint_free(e);
         flint_free(tmp);
         flint_free(args1);
-        flint_free(threads);
     }
 
     FLINT_TEST_CLEANUP(state);
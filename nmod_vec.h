@@ -253,6 +253,133 @@ FLINT_DLL void _nmod_vec_scalar_mul_nmod_shoup(mp_ptr res, mp_srcptr vec,
 FLINT_DLL void _nmod_vec_scalar_addmul_nmod(mp_ptr res, mp_srcptr vec, 
                             slong len, mp_limb_t c, nmod_t mod);
 
+/* Montgomery arithmetic for odd moduli ************************************/
+
+typedef struct
+{
+   mp_limb_t n;
+   mp_limb_t ninv; /* n^-1 mod 2^FLINT_BITS */
+   mp_limb_t one;  /* 2^FLINT_BITS mod n */
+   mp_limb_t r2;   /* 2^(2*FLINT_BITS) mod n */
+} nmod_mont_t;
+
+NMOD_VEC_INLINE
+void nmod_mont_init(nmod_mont_t * mod, mp_limb_t n)
+{
+   mp_limb_t ninv;
+   int i;
+
+   mod->n = n;
+
+   /* Newton iteration, each step doubles the number of correct bits */
+   mod->ninv = n;
+   for (i = 0; i < 5; i++)
+      mod->ninv *= 2 - n*mod->ninv;
+
+   ninv = n_preinvert_limb(n);
+   mod->one = n_mod2_preinv(-n, n, ninv);
+   mod->r2 = n_mulmod2_preinv(mod->one, mod->one, n, ninv);
+}
+
+/* (a_hi, a_lo)/2^FLINT_BITS mod n, assuming a_hi < n */
+#define NMOD_MONT_REDC(r, a_hi, a_lo, mod) \
+   do { \
+      mp_limb_t q0xx, q1xx; \
+      umul_ppmm(q1xx, q0xx, (a_lo)*(mod).ninv, (mod).n); \
+      (r) = (a_hi) - q1xx; \
+      if ((a_hi) < q1xx) \
+         (r) += (mod).n; \
+   } while (0)
+
+NMOD_VEC_INLINE
+mp_limb_t nmod_mont_mul(mp_limb_t a, mp_limb_t b, nmod_mont_t mod)
+{
+   mp_limb_t p_hi, p_lo, r;
+
+   umul_ppmm(p_hi, p_lo, a, b);
+   NMOD_MONT_REDC(r, p_hi, p_lo, mod);
+
+   return r;
+}
+
+NMOD_VEC_INLINE
+mp_limb_t nmod_mont_to(mp_limb_t a, nmod_mont_t mod)
+{
+   return nmod_mont_mul(a, mod.r2, mod);
+}
+
+NMOD_VEC_INLINE
+mp_limb_t nmod_mont_from(mp_limb_t a, nmod_mont_t mod)
+{
+   mp_limb_t r;
+
+   NMOD_MONT_REDC(r, UWORD(0), a, mod);
+
+   return r;
+}
+
+FLINT_DLL mp_limb_t nmod_mont_pow_ui(mp_limb_t a, ulong e, nmod_mont_t mod);
+
+FLINT_DLL void _nmod_vec_to_mont(mp_ptr res, mp_srcptr vec,
+                                             slong len, nmod_mont_t mod);
+
+FLINT_DLL void _nmod_vec_from_mont(mp_ptr res, mp_srcptr vec,
+                                             slong len, nmod_mont_t mod);
+
+FLINT_DLL void _nmod_vec_scalar_mul_mont(mp_ptr res, mp_srcptr vec,
+                               slong len, mp_limb_t c, nmod_mont_t mod);
+
+FLINT_DLL mp_limb_t _nmod_vec_dot_mont(mp_srcptr vec1, mp_srcptr vec2,
+                                             slong len, nmod_mont_t mod);
+
+/* SIMD kernels for small moduli, see nmod_vec/simd.c */
+
+#if FLINT_BITS == 64 && defined(__x86_64__) && defined(__GNUC__) \
+    && (__GNUC__ >= 5 || defined(__clang__))
+#define NMOD_VEC_HAVE_SIMD 1
+#else
+#define NMOD_VEC_HAVE_SIMD 0
+#endif
+
+#define NMOD_VEC_SIMD_NONE 0
+#define NMOD_VEC_SIMD_AVX2 1
+#define NMOD_VEC_SIMD_AVX512 2
+
+#define NMOD_VEC_SIMD_MAX_BITS 50
+#define NMOD_VEC_SIMD_MIN_LEN 16
+
+#if NMOD_VEC_HAVE_SIMD
+#define NMOD_VEC_SIMD_USE(len, mod)                                  \
+    ((len) >= NMOD_VEC_SIMD_MIN_LEN &&                               \
+     (mod).n < (UWORD(1) << NMOD_VEC_SIMD_MAX_BITS) &&               \
+     nmod_vec_simd_level() != NMOD_VEC_SIMD_NONE)
+#else
+#define NMOD_VEC_SIMD_USE(len, mod) 0
+#endif
+
+FLINT_DLL extern int _nmod_vec_simd_level;
+
+FLINT_DLL int nmod_vec_simd_level(void);
+
+FLINT_DLL int nmod_vec_simd_max_level(void);
+
+FLINT_DLL void nmod_vec_simd_set_level(int level);
+
+FLINT_DLL void _nmod_vec_add_simd(mp_ptr res, mp_srcptr vec1,
+                        mp_srcptr vec2, slong len, nmod_t mod);
+
+FLINT_DLL void _nmod_vec_sub_simd(mp_ptr res, mp_srcptr vec1,
+                        mp_srcptr vec2, slong len, nmod_t mod);
+
+FLINT_DLL void _nmod_vec_scalar_mul_nmod_simd(mp_ptr res, mp_srcptr vec,
+                            slong len, mp_limb_t c, nmod_t mod);
+
+FLINT_DLL void _nmod_vec_scalar_addmul_nmod_simd(mp_ptr res, mp_srcptr vec,
+                            slong len, mp_limb_t c, nmod_t mod);
+
+FLINT_DLL mp_limb_t _nmod_vec_dot_simd(mp_srcptr vec1, mp_srcptr vec2,
+                                                    slong len, nmod_t mod);
+
 FLINT_DLL int _nmod_vec_dot_bound_limbs(slong len, nmod_t mod);
 
 
@@ -20,6 +20,12 @@ void _nmod_vec_add(mp_ptr res, mp_srcptr vec1,
 {
     slong i;
 
+    if (NMOD_VEC_SIMD_USE(len, mod))
+    {
+        _nmod_vec_add_simd(res, vec1, vec2, len, mod);
+        return;
+    }
+
     if (mod.norm)
     {
         for (i = 0 ; i < len; i++)
@@ -20,6 +20,10 @@ _nmod_vec_dot(mp_srcptr vec1, mp_srcptr vec2, slong len, nmod_t mod, int nlimbs)
 {
     mp_limb_t res;
     slong i;
+
+    if (mod.n > UWORD(0x100000000) && NMOD_VEC_SIMD_USE(len, mod))
+        return _nmod_vec_dot_simd(vec1, vec2, len, mod);
+
     NMOD_VEC_DOT(res, i, len, vec1[i], vec2[i], mod, nlimbs);
     return res;
 }
@@ -0,0 +1,45 @@
+/*
+    Copyright (C) 2019 William Hart
+
+    This file is part of FLINT.
+
+    FLINT is free software: you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.  See <http://www.gnu.org/licenses/>.
+*/
+
+#include <gmp.h>
+#include "flint.h"
+#include "ulong_extras.h"
+#include "nmod_vec.h"
+
+/*
+   The low limb of the sum is kept exactly and the high limb modulo n.
+   The high limb of a product of two residues is less than n - 1, so
+   adding it and the carry from the low limb needs one conditional
+   subtraction, and a single reduction is done at the end.
+*/
+mp_limb_t _nmod_vec_dot_mont(mp_srcptr vec1, mp_srcptr vec2,
+                                                 slong len, nmod_mont_t mod)
+{
+    mp_limb_t s0, s1, t0, t1, u, r;
+    slong i;
+
+    s0 = s1 = 0;
+
+    for (i = 0; i < len; i++)
+    {
+        umul_ppmm(t1, t0, vec1[i], vec2[i]);
+
+        s0 += t0;
+        t1 += (s0 < t0);
+
+        u = mod.n - s1;
+        s1 = (t1 >= u) ? t1 - u : s1 + t1;
+    }
+
+    NMOD_MONT_REDC(r, s1, s0, mod);
+
+    return r;
+}
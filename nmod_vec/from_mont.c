@@ -0,0 +1,24 @@
+/*
+    Copyright (C) 2019 William Hart
+
+    This file is part of FLINT.
+
+    FLINT is free software: you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.  See <http://www.gnu.org/licenses/>.
+*/
+
+#include <gmp.h>
+#include "flint.h"
+#include "ulong_extras.h"
+#include "nmod_vec.h"
+
+void _nmod_vec_from_mont(mp_ptr res, mp_srcptr vec, slong len,
+                                                            nmod_mont_t mod)
+{
+    slong i;
+
+    for (i = 0; i < len; i++)
+        NMOD_MONT_REDC(res[i], UWORD(0), vec[i], mod);
+}
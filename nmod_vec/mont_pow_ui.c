@@ -0,0 +1,36 @@
+/*
+    Copyright (C) 2019 William Hart
+
+    This file is part of FLINT.
+
+    FLINT is free software: you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.  See <http://www.gnu.org/licenses/>.
+*/
+
+#include <gmp.h>
+#include "flint.h"
+#include "ulong_extras.h"
+#include "nmod_vec.h"
+
+mp_limb_t nmod_mont_pow_ui(mp_limb_t a, ulong e, nmod_mont_t mod)
+{
+    mp_limb_t x;
+    int i;
+
+    if (e == 0)
+        return mod.one;
+
+    x = a;
+
+    for (i = FLINT_BIT_COUNT(e) - 2; i >= 0; i--)
+    {
+        x = nmod_mont_mul(x, x, mod);
+
+        if (e & (UWORD(1) << i))
+            x = nmod_mont_mul(x, a, mod);
+    }
+
+    return x;
+}
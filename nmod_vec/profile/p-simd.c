@@ -0,0 +1,125 @@
+/*
+    Copyright (C) 2019 William Hart
+
+    This file is part of FLINT.
+
+    FLINT is free software: you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.  See <http://www.gnu.org/licenses/>.
+*/
+
+/*
+   Compares the portable versions of the nmod_vec kernels with the AVX2 and
+   AVX-512 versions supported by this machine, in cycles per entry.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "profiler.h"
+#include "flint.h"
+#include "ulong_extras.h"
+#include "nmod_vec.h"
+
+#define LEN 1000
+
+typedef struct
+{
+    mp_bitcnt_t bits;
+    int type;
+    int level;
+} info_t;
+
+void sample(void * arg, ulong count)
+{
+    info_t * info = (info_t *) arg;
+    mp_limb_t n, c, r = 0;
+    mp_ptr vec1, vec2, res;
+    nmod_t mod;
+    slong i;
+    FLINT_TEST_INIT(state);
+
+    n = n_randbits(state, info->bits);
+    nmod_init(&mod, n);
+    c = n_randint(state, n);
+
+    vec1 = _nmod_vec_init(LEN);
+    vec2 = _nmod_vec_init(LEN);
+    res = _nmod_vec_init(LEN);
+
+    _nmod_vec_randtest(vec1, state, LEN, mod);
+    _nmod_vec_randtest(vec2, state, LEN, mod);
+    _nmod_vec_randtest(res, state, LEN, mod);
+
+    nmod_vec_simd_set_level(info->level);
+
+    prof_start();
+    for (i = 0; i < count; i++)
+    {
+        switch (info->type)
+        {
+        case 0:
+            _nmod_vec_add(res, vec1, vec2, LEN, mod);
+            break;
+        case 1:
+            _nmod_vec_sub(res, vec1, vec2, LEN, mod);
+            break;
+        case 2:
+            _nmod_vec_scalar_mul_nmod(res, vec1, LEN, c, mod);
+            break;
+        case 3:
+            _nmod_vec_scalar_addmul_nmod(res, vec1, LEN, c, mod);
+            break;
+        default:
+            r += _nmod_vec_dot(vec1, vec2, LEN, mod,
+                                    _nmod_vec_dot_bound_limbs(LEN, mod));
+        }
+    }
+    prof_stop();
+
+    if (r == UWORD(1))
+        flint_printf("\r");
+
+    nmod_vec_simd_set_level(nmod_vec_simd_max_level());
+
+    _nmod_vec_clear(vec1);
+    _nmod_vec_clear(vec2);
+    _nmod_vec_clear(res);
+    flint_randclear(state);
+}
+
+int main(void)
+{
+    static const char * names[] = { "add", "sub", "scalar_mul",
+                                    "scalar_addmul", "dot" };
+    static const char * levels[] = { "portable", "avx2", "avx512" };
+    double min, max;
+    info_t info;
+    int type, level;
+
+    flint_printf("cycles per entry, length %d\n", LEN);
+
+    for (info.bits = 10; info.bits <= NMOD_VEC_SIMD_MAX_BITS; info.bits += 10)
+    {
+        flint_printf("bits %wu:\n", info.bits);
+
+        for (type = 0; type < 5; type++)
+        {
+            info.type = type;
+            flint_printf("   %-14s", names[type]);
+
+            for (level = 0; level <= nmod_vec_simd_max_level(); level++)
+            {
+                info.level = level;
+                prof_repeat(&min, &max, sample, (void *) &info);
+                flint_printf(" %s %.2lf", levels[level],
+                           (min/(double)FLINT_CLOCK_SCALE_FACTOR)/LEN);
+            }
+
+            flint_printf("\n");
+        }
+    }
+
+    flint_cleanup();
+    return 0;
+}
@@ -18,6 +18,12 @@
 void _nmod_vec_scalar_addmul_nmod(mp_ptr res, mp_srcptr vec, 
 				             slong len, mp_limb_t c, nmod_t mod)
 {
+    if (NMOD_VEC_SIMD_USE(len, mod))
+    {
+        _nmod_vec_scalar_addmul_nmod_simd(res, vec, len, c, mod);
+        return;
+    }
+
     if (mod.norm >= FLINT_BITS/2) /* addmul will fit in a limb */
     {
         mpn_addmul_1(res, vec, len, c);
@@ -18,6 +18,12 @@
 void _nmod_vec_scalar_mul_nmod(mp_ptr res, mp_srcptr vec, 
                                slong len, mp_limb_t c, nmod_t mod)
 {
+    if (NMOD_VEC_SIMD_USE(len, mod))
+    {
+        _nmod_vec_scalar_mul_nmod_simd(res, vec, len, c, mod);
+        return;
+    }
+
     if (len > 10 && mod.n < UWORD_HALF)
     {
         _nmod_vec_scalar_mul_nmod_shoup(res, vec, len, c, mod);
@@ -0,0 +1,549 @@
+/*
+    Copyright (C) 2019 William Hart
+
+    This file is part of FLINT.
+
+    FLINT is free software: you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.  See <http://www.gnu.org/licenses/>.
+*/
+
+#include <gmp.h>
+#include <stdlib.h>
+#include "flint.h"
+#include "ulong_extras.h"
+#include "nmod_vec.h"
+
+/*
+    AVX2 and AVX-512 versions of the basic vector operations, for moduli
+    n < 2^NMOD_VEC_SIMD_MAX_BITS. The entries are reduced, so sums and
+    differences fit in a signed 64 bit lane.
+
+    Products a*c are reduced with double precision arithmetic. With
+    h = fl(a*c) and l = a*c - h, which the FMA gives exactly, let
+    q = round(h/n). As a*c < 2^100 and n < 2^50, q is the nearest
+    integer to a*c/n or off by one, so h - q*n and then r = h - q*n + l
+    are integers of absolute value less than 2n < 2^53, which the FMA and
+    the addition compute exactly. Adding or subtracting n once gives the
+    reduced value.
+
+    The conversions between 64 bit integers and doubles use the fact that
+    the bits of 2^52 + x, for 0 <= x < 2^52, are those of 2^52 with x in
+    the mantissa.
+
+    The kernels are compiled with target attributes, so the rest of FLINT
+    does not need to be built for these instruction sets, and only run if
+    the CPU supports them.
+*/
+
+#if NMOD_VEC_HAVE_SIMD
+
+#include <immintrin.h>
+
+#define MAGIC_D 4503599627370496.0         /* 2^52 */
+#define MAGIC_I WORD(0x4330000000000000)   /* its bits */
+
+/* generic reduction of a product for the tails */
+#define MULMOD(a, c) n_mulmod2_preinv(a, c, mod.n, mod.ninv)
+
+/******************************************************************************
+
+    AVX2
+
+******************************************************************************/
+
+#define AVX2 __attribute__((target("avx2,fma")))
+
+AVX2 static __inline__
+__m256d avx2_to_double(__m256i x)
+{
+    const __m256i magic_i = _mm256_set1_epi64x(MAGIC_I);
+    const __m256d magic_d = _mm256_set1_pd(MAGIC_D);
+
+    return _mm256_sub_pd(_mm256_castsi256_pd(
+                                   _mm256_or_si256(x, magic_i)), magic_d);
+}
+
+AVX2 static __inline__
+__m256i avx2_to_int(__m256d x)
+{
+    const __m256i magic_i = _mm256_set1_epi64x(MAGIC_I);
+    const __m256d magic_d = _mm256_set1_pd(MAGIC_D);
+
+    return _mm256_xor_si256(_mm256_castpd_si256(
+                                   _mm256_add_pd(x, magic_d)), magic_i);
+}
+
+/* a*c mod n for a, c, n as doubles, with ninv = 1/n */
+AVX2 static __inline__
+__m256d avx2_mulmod(__m256d a, __m256d c, __m256d n, __m256d ninv)
+{
+    __m256d h, l, q, r;
+
+    h = _mm256_mul_pd(a, c);
+    l = _mm256_fmsub_pd(a, c, h);
+    q = _mm256_round_pd(_mm256_mul_pd(h, ninv),
+                                 _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    r = _mm256_add_pd(_mm256_fnmadd_pd(q, n, h), l);
+
+    r = _mm256_add_pd(r, _mm256_and_pd(n,
+                    _mm256_cmp_pd(r, _mm256_setzero_pd(), _CMP_LT_OQ)));
+    r = _mm256_sub_pd(r, _mm256_and_pd(n, _mm256_cmp_pd(r, n, _CMP_GE_OQ)));
+
+    return r;
+}
+
+/* a value congruent to a*c mod n in [0, 2n) */
+AVX2 static __inline__
+__m256d avx2_mulmod_lazy(__m256d a, __m256d c, __m256d n, __m256d ninv)
+{
+    __m256d h, l, q;
+
+    h = _mm256_mul_pd(a, c);
+    l = _mm256_fmsub_pd(a, c, h);
+    q = _mm256_round_pd(_mm256_mul_pd(h, ninv),
+                                 _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+
+    return _mm256_add_pd(_mm256_add_pd(_mm256_fnmadd_pd(q, n, h), l), n);
+}
+
+/* x mod n for -n <= x < n */
+AVX2 static __inline__
+__m256i avx2_reduce_signed(__m256i x, __m256i n)
+{
+    return _mm256_add_epi64(x, _mm256_and_si256(n,
+                           _mm256_cmpgt_epi64(_mm256_setzero_si256(), x)));
+}
+
+AVX2 static
+void _nmod_vec_add_avx2(mp_ptr res, mp_srcptr vec1, mp_srcptr vec2,
+                                                       slong len, nmod_t mod)
+{
+    const __m256i n = _mm256_set1_epi64x(mod.n);
+    __m256i a, b;
+    slong i;
+
+    for (i = 0; i + 4 <= len; i += 4)
+    {
+        a = _mm256_loadu_si256((const __m256i *) (vec1 + i));
+        b = _mm256_loadu_si256((const __m256i *) (vec2 + i));
+        a = _mm256_sub_epi64(_mm256_add_epi64(a, b), n);
+        _mm256_storeu_si256((__m256i *) (res + i), avx2_reduce_signed(a, n));
+    }
+
+    for ( ; i < len; i++)
+        res[i] = _nmod_add(vec1[i], vec2[i], mod);
+}
+
+AVX2 static
+void _nmod_vec_sub_avx2(mp_ptr res, mp_srcptr vec1, mp_srcptr vec2,
+                                                       slong len, nmod_t mod)
+{
+    const __m256i n = _mm256_set1_epi64x(mod.n);
+    __m256i a, b;
+    slong i;
+
+    for (i = 0; i + 4 <= len; i += 4)
+    {
+        a = _mm256_loadu_si256((const __m256i *) (vec1 + i));
+        b = _mm256_loadu_si256((const __m256i *) (vec2 + i));
+        a = _mm256_sub_epi64(a, b);
+        _mm256_storeu_si256((__m256i *) (res + i), avx2_reduce_signed(a, n));
+    }
+
+    for ( ; i < len; i++)
+        res[i] = _nmod_sub(vec1[i], vec2[i], mod);
+}
+
+AVX2 static
+void _nmod_vec_scalar_mul_nmod_avx2(mp_ptr res, mp_srcptr vec,
+                                       slong len, mp_limb_t c, nmod_t mod)
+{
+    const __m256d n = _mm256_set1_pd((double) mod.n);
+    const __m256d ninv = _mm256_set1_pd(1.0 / (double) mod.n);
+    const __m256d cd = _mm256_set1_pd((double) c);
+    __m256d a;
+    slong i;
+
+    for (i = 0; i + 4 <= len; i += 4)
+    {
+        a = avx2_to_double(_mm256_loadu_si256((const __m256i *) (vec + i)));
+        a = avx2_mulmod(a, cd, n, ninv);
+        _mm256_storeu_si256((__m256i *) (res + i), avx2_to_int(a));
+    }
+
+    for ( ; i < len; i++)
+        res[i] = MULMOD(vec[i], c);
+}
+
+AVX2 static
+void _nmod_vec_scalar_addmul_nmod_avx2(mp_ptr res, mp_srcptr vec,
+                                       slong len, mp_limb_t c, nmod_t mod)
+{
+    const __m256d n = _mm256_set1_pd((double) mod.n);
+    const __m256d ninv = _mm256_set1_pd(1.0 / (double) mod.n);
+    const __m256d cd = _mm256_set1_pd((double) c);
+    const __m256i ni = _mm256_set1_epi64x(mod.n);
+    __m256d a;
+    __m256i r;
+    slong i;
+
+    for (i = 0; i + 4 <= len; i += 4)
+    {
+        a = avx2_to_double(_mm256_loadu_si256((const __m256i *) (vec + i)));
+        a = avx2_mulmod(a, cd, n, ninv);
+        r = _mm256_loadu_si256((const __m256i *) (res + i));
+        r = _mm256_sub_epi64(_mm256_add_epi64(r, avx2_to_int(a)), ni);
+        _mm256_storeu_si256((__m256i *) (res + i), avx2_reduce_signed(r, ni));
+    }
+
+    for ( ; i < len; i++)
+        res[i] = _nmod_add(res[i], MULMOD(vec[i], c), mod);
+}
+
+/*
+   The partially reduced products, which are less than 2n < 2^51, are summed
+   in integer lanes, and the lanes are reduced before they can overflow.
+   This only beats the portable version when it needs two limbs for the
+   sum of products of size n^2 > 2^64, so _nmod_vec_dot only calls it for
+   n > 2^32.
+*/
+
+/* sum of the four or eight lanes, mod n */
+static mp_limb_t _nmod_vec_dot_lanes(const mp_limb_t * s,
+                                                   slong lanes, nmod_t mod)
+{
+    mp_limb_t t, res = 0;
+    slong j;
+
+    for (j = 0; j < lanes; j++)
+    {
+        NMOD_RED(t, s[j], mod);
+        res = _nmod_add(res, t, mod);
+    }
+
+    return res;
+}
+
+AVX2 static
+mp_limb_t _nmod_vec_dot_avx2(mp_srcptr vec1, mp_srcptr vec2,
+                                                       slong len, nmod_t mod)
+{
+    const __m256d n = _mm256_set1_pd((double) mod.n);
+    const __m256d ninv = _mm256_set1_pd(1.0 / (double) mod.n);
+    mp_limb_t t[4], res = 0;
+    __m256d a, b;
+    __m256i s;
+    slong i = 0, stop;
+
+    while (i + 4 <= len)
+    {
+        s = _mm256_setzero_si256();
+        stop = FLINT_MIN(len - 3, i + 4*1024);
+
+        for ( ; i < stop; i += 4)
+        {
+            a = avx2_to_double(_mm256_loadu_si256(
+                                        (const __m256i *) (vec1 + i)));
+            b = avx2_to_double(_mm256_loadu_si256(
+                                        (const __m256i *) (vec2 + i)));
+            s = _mm256_add_epi64(s,
+                          avx2_to_int(avx2_mulmod_lazy(a, b, n, ninv)));
+        }
+
+        _mm256_storeu_si256((__m256i *) t, s);
+        res = _nmod_add(res, _nmod_vec_dot_lanes(t, 4, mod), mod);
+    }
+
+    for ( ; i < len; i++)
+        res = _nmod_add(res, MULMOD(vec1[i], vec2[i]), mod);
+
+    return res;
+}
+
+/******************************************************************************
+
+    AVX-512
+
+******************************************************************************/
+
+#define AVX512 __attribute__((target("avx512f")))
+
+AVX512 static __inline__
+__m512d avx512_to_double(__m512i x)
+{
+    const __m512i magic_i = _mm512_set1_epi64(MAGIC_I);
+    const __m512d magic_d = _mm512_set1_pd(MAGIC_D);
+
+    return _mm512_sub_pd(_mm512_castsi512_pd(
+                                   _mm512_or_si512(x, magic_i)), magic_d);
+}
+
+AVX512 static __inline__
+__m512i avx512_to_int(__m512d x)
+{
+    const __m512i magic_i = _mm512_set1_epi64(MAGIC_I);
+    const __m512d magic_d = _mm512_set1_pd(MAGIC_D);
+
+    return _mm512_xor_si512(_mm512_castpd_si512(
+                                   _mm512_add_pd(x, magic_d)), magic_i);
+}
+
+AVX512 static __inline__
+__m512d avx512_mulmod(__m512d a, __m512d c, __m512d n, __m512d ninv)
+{
+    __m512d h, l, q, r;
+
+    h = _mm512_mul_pd(a, c);
+    l = _mm512_fmsub_pd(a, c, h);
+    q = _mm512_roundscale_pd(_mm512_mul_pd(h, ninv),
+                                 _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    r = _mm512_add_pd(_mm512_fnmadd_pd(q, n, h), l);
+
+    r = _mm512_mask_add_pd(r, _mm512_cmp_pd_mask(r, _mm512_setzero_pd(),
+                                                      _CMP_LT_OQ), r, n);
+    r = _mm512_mask_sub_pd(r, _mm512_cmp_pd_mask(r, n, _CMP_GE_OQ), r, n);
+
+    return r;
+}
+
+AVX512 static __inline__
+__m512d avx512_mulmod_lazy(__m512d a, __m512d c, __m512d n, __m512d ninv)
+{
+    __m512d h, l, q;
+
+    h = _mm512_mul_pd(a, c);
+    l = _mm512_fmsub_pd(a, c, h);
+    q = _mm512_roundscale_pd(_mm512_mul_pd(h, ninv),
+                                 _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+
+    return _mm512_add_pd(_mm512_add_pd(_mm512_fnmadd_pd(q, n, h), l), n);
+}
+
+AVX512 static __inline__
+__m512i avx512_reduce_signed(__m512i x, __m512i n)
+{
+    return _mm512_mask_add_epi64(x,
+                 _mm512_cmplt_epi64_mask(x, _mm512_setzero_si512()), x, n);
+}
+
+AVX512 static
+void _nmod_vec_add_avx512(mp_ptr res, mp_srcptr vec1, mp_srcptr vec2,
+                                                       slong len, nmod_t mod)
+{
+    const __m512i n = _mm512_set1_epi64(mod.n);
+    __m512i a, b;
+    slong i;
+
+    for (i = 0; i + 8 <= len; i += 8)
+    {
+        a = _mm512_loadu_si512(vec1 + i);
+        b = _mm512_loadu_si512(vec2 + i);
+        a = _mm512_sub_epi64(_mm512_add_epi64(a, b), n);
+        _mm512_storeu_si512(res + i, avx512_reduce_signed(a, n));
+    }
+
+    for ( ; i < len; i++)
+        res[i] = _nmod_add(vec1[i], vec2[i], mod);
+}
+
+AVX512 static
+void _nmod_vec_sub_avx512(mp_ptr res, mp_srcptr vec1, mp_srcptr vec2,
+                                                       slong len, nmod_t mod)
+{
+    const __m512i n = _mm512_set1_epi64(mod.n);
+    __m512i a, b;
+    slong i;
+
+    for (i = 0; i + 8 <= len; i += 8)
+    {
+        a = _mm512_loadu_si512(vec1 + i);
+        b = _mm512_loadu_si512(vec2 + i);
+        a = _mm512_sub_epi64(a, b);
+        _mm512_storeu_si512(res + i, avx512_reduce_signed(a, n));
+    }
+
+    for ( ; i < len; i++)
+        res[i] = _nmod_sub(vec1[i], vec2[i], mod);
+}
+
+AVX512 static
+void _nmod_vec_scalar_mul_nmod_avx512(mp_ptr res, mp_srcptr vec,
+                                       slong len, mp_limb_t c, nmod_t mod)
+{
+    const __m512d n = _mm512_set1_pd((double) mod.n);
+    const __m512d ninv = _mm512_set1_pd(1.0 / (double) mod.n);
+    const __m512d cd = _mm512_set1_pd((double) c);
+    __m512d a;
+    slong i;
+
+    for (i = 0; i + 8 <= len; i += 8)
+    {
+        a = avx512_to_double(_mm512_loadu_si512(vec + i));
+        a = avx512_mulmod(a, cd, n, ninv);
+        _mm512_storeu_si512(res + i, avx512_to_int(a));
+    }
+
+    for ( ; i < len; i++)
+        res[i] = MULMOD(vec[i], c);
+}
+
+AVX512 static
+void _nmod_vec_scalar_addmul_nmod_avx512(mp_ptr res, mp_srcptr vec,
+                                       slong len, mp_limb_t c, nmod_t mod)
+{
+    const __m512d n = _mm512_set1_pd((double) mod.n);
+    const __m512d ninv = _mm512_set1_pd(1.0 / (double) mod.n);
+    const __m512d cd = _mm512_set1_pd((double) c);
+    const __m512i ni = _mm512_set1_epi64(mod.n);
+    __m512d a;
+    __m512i r;
+    slong i;
+
+    for (i = 0; i + 8 <= len; i += 8)
+    {
+        a = avx512_to_double(_mm512_loadu_si512(vec + i));
+        a = avx512_mulmod(a, cd, n, ninv);
+        r = _mm512_loadu_si512(res + i);
+        r = _mm512_sub_epi64(_mm512_add_epi64(r, avx512_to_int(a)), ni);
+        _mm512_storeu_si512(res + i, avx512_reduce_signed(r, ni));
+    }
+
+    for ( ; i < len; i++)
+        res[i] = _nmod_add(res[i], MULMOD(vec[i], c), mod);
+}
+
+AVX512 static
+mp_limb_t _nmod_vec_dot_avx512(mp_srcptr vec1, mp_srcptr vec2,
+                                                       slong len, nmod_t mod)
+{
+    const __m512d n = _mm512_set1_pd((double) mod.n);
+    const __m512d ninv = _mm512_set1_pd(1.0 / (double) mod.n);
+    mp_limb_t t[8], res = 0;
+    __m512d a, b;
+    __m512i s;
+    slong i = 0, stop;
+
+    while (i + 8 <= len)
+    {
+        s = _mm512_setzero_si512();
+        stop = FLINT_MIN(len - 7, i + 8*1024);
+
+        for ( ; i < stop; i += 8)
+        {
+            a = avx512_to_double(_mm512_loadu_si512(vec1 + i));
+            b = avx512_to_double(_mm512_loadu_si512(vec2 + i));
+            s = _mm512_add_epi64(s,
+                      avx512_to_int(avx512_mulmod_lazy(a, b, n, ninv)));
+        }
+
+        _mm512_storeu_si512(t, s);
+        res = _nmod_add(res, _nmod_vec_dot_lanes(t, 8, mod), mod);
+    }
+
+    for ( ; i < len; i++)
+        res = _nmod_add(res, MULMOD(vec1[i], vec2[i]), mod);
+
+    return res;
+}
+
+/******************************************************************************
+
+    Detection and dispatch
+
+******************************************************************************/
+
+int _nmod_vec_simd_level = -1;
+
+static int _nmod_vec_simd_max = -1;
+
+int nmod_vec_simd_max_level(void)
+{
+    if (_nmod_vec_simd_max < 0)
+    {
+        int level = NMOD_VEC_SIMD_NONE;
+
+        __builtin_cpu_init();
+
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+            level = NMOD_VEC_SIMD_AVX2;
+
+        if (__builtin_cpu_supports("avx512f"))
+            level = NMOD_VEC_SIMD_AVX512;
+
+        _nmod_vec_simd_max = level;
+    }
+
+    return _nmod_vec_simd_max;
+}
+
+void _nmod_vec_add_simd(mp_ptr res, mp_srcptr vec1, mp_srcptr vec2,
+                                                       slong len, nmod_t mod)
+{
+    if (_nmod_vec_simd_level == NMOD_VEC_SIMD_AVX512)
+        _nmod_vec_add_avx512(res, vec1, vec2, len, mod);
+    else
+        _nmod_vec_add_avx2(res, vec1, vec2, len, mod);
+}
+
+void _nmod_vec_sub_simd(mp_ptr res, mp_srcptr vec1, mp_srcptr vec2,
+                                                       slong len, nmod_t mod)
+{
+    if (_nmod_vec_simd_level == NMOD_VEC_SIMD_AVX512)
+        _nmod_vec_sub_avx512(res, vec1, vec2, len, mod);
+    else
+        _nmod_vec_sub_avx2(res, vec1, vec2, len, mod);
+}
+
+void _nmod_vec_scalar_mul_nmod_simd(mp_ptr res, mp_srcptr vec,
+                                       slong len, mp_limb_t c, nmod_t mod)
+{
+    if (_nmod_vec_simd_level == NMOD_VEC_SIMD_AVX512)
+        _nmod_vec_scalar_mul_nmod_avx512(res, vec, len, c, mod);
+    else
+        _nmod_vec_scalar_mul_nmod_avx2(res, vec, len, c, mod);
+}
+
+void _nmod_vec_scalar_addmul_nmod_simd(mp_ptr res, mp_srcptr vec,
+                                       slong len, mp_limb_t c, nmod_t mod)
+{
+    if (_nmod_vec_simd_level == NMOD_VEC_SIMD_AVX512)
+        _nmod_vec_scalar_addmul_nmod_avx512(res, vec, len, c, mod);
+    else
+        _nmod_vec_scalar_addmul_nmod_avx2(res, vec, len, c, mod);
+}
+
+mp_limb_t _nmod_vec_dot_simd(mp_srcptr vec1, mp_srcptr vec2,
+                                                       slong len, nmod_t mod)
+{
+    if (_nmod_vec_simd_level == NMOD_VEC_SIMD_AVX512)
+        return _nmod_vec_dot_avx512(vec1, vec2, len, mod);
+    else
+        return _nmod_vec_dot_avx2(vec1, vec2, len, mod);
+}
+
+#else
+
+int _nmod_vec_simd_level = NMOD_VEC_SIMD_NONE;
+
+int nmod_vec_simd_max_level(void)
+{
+    return NMOD_VEC_SIMD_NONE;
+}
+
+#endif
+
+int nmod_vec_simd_level(void)
+{
+    if (_nmod_vec_simd_level < 0)
+        _nmod_vec_simd_level = nmod_vec_simd_max_level();
+
+    return _nmod_vec_simd_level;
+}
+
+void nmod_vec_simd_set_level(int level)
+{
+    _nmod_vec_simd_level = FLINT_MIN(FLINT_MAX(level, NMOD_VEC_SIMD_NONE),
+                                                  nmod_vec_simd_max_level());
+}
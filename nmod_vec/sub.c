@@ -19,6 +19,13 @@ void _nmod_vec_sub(mp_ptr res, mp_srcptr vec1,
                    mp_srcptr vec2, slong len, nmod_t mod)
 {
     slong i;
+
+    if (NMOD_VEC_SIMD_USE(len, mod))
+    {
+        _nmod_vec_sub_simd(res, vec1, vec2, len, mod);
+        return;
+    }
+
     if (mod.norm)
     {
         for (i = 0 ; i < len; i++)
@@ -0,0 +1,151 @@
+/*
+    Copyright (C) 2019 William Hart
+
+    This file is part of FLINT.
+
+    FLINT is free software: you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.  See <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <gmp.h>
+#include "flint.h"
+#include "nmod_vec.h"
+#include "ulong_extras.h"
+
+int
+main(void)
+{
+    int i;
+    FLINT_TEST_INIT(state);
+
+    flint_printf("mont....");
+    fflush(stdout);
+
+    /* scalar arithmetic */
+    for (i = 0; i < 10000 * flint_test_multiplier(); i++)
+    {
+        nmod_t mod;
+        nmod_mont_t mont;
+        mp_limb_t n, a, b, c, d;
+        ulong e;
+
+        n = n_randtest_not_zero(state) | 1;
+        nmod_init(&mod, n);
+        nmod_mont_init(&mont, n);
+
+        a = n_randint(state, n);
+        b = n_randint(state, n);
+        e = n_randtest(state);
+
+        c = nmod_mont_from(nmod_mont_mul(nmod_mont_to(a, mont),
+                                         nmod_mont_to(b, mont), mont), mont);
+        d = nmod_mont_from(nmod_mont_pow_ui(nmod_mont_to(a, mont), e, mont),
+                                                                      mont);
+
+        if (nmod_mont_from(nmod_mont_to(a, mont), mont) != a
+            || c != nmod_mul(a, b, mod) || d != nmod_pow_ui(a, e, mod)
+            || nmod_mont_from(mont.one, mont) != n_mod2_preinv(1, n, mod.ninv))
+        {
+            flint_printf("FAIL (scalar):\n");
+            flint_printf("n = %wu, a = %wu, b = %wu, e = %wu\n", n, a, b, e);
+            flint_printf("c = %wu, d = %wu\n", c, d);
+            abort();
+        }
+    }
+
+    /* vectors */
+    for (i = 0; i < 1000 * flint_test_multiplier(); i++)
+    {
+        slong len, j;
+        nmod_t mod;
+        nmod_mont_t mont;
+        mp_limb_t n, c, d, r;
+        mp_ptr x, y, xm, ym, z;
+
+        len = n_randint(state, 1000);
+        n = n_randtest_not_zero(state) | 1;
+        nmod_init(&mod, n);
+        nmod_mont_init(&mont, n);
+
+        x = _nmod_vec_init(len);
+        y = _nmod_vec_init(len);
+        xm = _nmod_vec_init(len);
+        ym = _nmod_vec_init(len);
+        z = _nmod_vec_init(len);
+
+        _nmod_vec_randtest(x, state, len, mod);
+        _nmod_vec_randtest(y, state, len, mod);
+        c = n_randint(state, n);
+
+        _nmod_vec_to_mont(xm, x, len, mont);
+        _nmod_vec_to_mont(ym, y, len, mont);
+
+        /* aliased */
+        _nmod_vec_from_mont(z, xm, len, mont);
+        _nmod_vec_from_mont(xm, xm, len, mont);
+
+        if (!_nmod_vec_equal(z, x, len) || !_nmod_vec_equal(xm, x, len))
+        {
+            flint_printf("FAIL (conversion):\n");
+            flint_printf("n = %wu, len = %wd\n", n, len);
+            abort();
+        }
+
+        _nmod_vec_to_mont(xm, xm, len, mont);
+
+        _nmod_vec_scalar_mul_mont(z, xm, len, nmod_mont_to(c, mont), mont);
+        _nmod_vec_from_mont(z, z, len, mont);
+
+        for (j = 0; j < len; j++)
+        {
+            if (z[j] != nmod_mul(x[j], c, mod))
+            {
+                flint_printf("FAIL (scalar_mul):\n");
+                flint_printf("n = %wu, len = %wd, j = %wd\n", n, len, j);
+                abort();
+            }
+        }
+
+        d = _nmod_vec_dot(x, y, len, mod, _nmod_vec_dot_bound_limbs(len, mod));
+        r = nmod_mont_from(_nmod_vec_dot_mont(xm, ym, len, mont), mont);
+
+        if (r != d || _nmod_vec_dot_mont(x, ym, len, mont) != d)
+        {
+            flint_printf("FAIL (dot):\n");
+            flint_printf("n = %wu, len = %wd, d = %wu, r = %wu\n",
+                                                               n, len, d, r);
+            abort();
+        }
+
+        _nmod_vec_clear(x);
+        _nmod_vec_clear(y);
+        _nmod_vec_clear(xm);
+        _nmod_vec_clear(ym);
+        _nmod_vec_clear(z);
+    }
+
+    /* the largest moduli */
+    {
+        nmod_mont_t mont;
+        mp_limb_t n = UWORD_MAX, a = UWORD_MAX - 1, v[3];
+
+        nmod_mont_init(&mont, n);
+        v[0] = v[1] = v[2] = nmod_mont_to(a, mont);
+
+        if (nmod_mont_from(nmod_mont_mul(v[0], v[0], mont), mont) != 1
+            || nmod_mont_from(_nmod_vec_dot_mont(v, v, 3, mont), mont) != 3)
+        {
+            flint_printf("FAIL (largest modulus):\n");
+            abort();
+        }
+    }
+
+    FLINT_TEST_CLEANUP(state);
+
+    flint_printf("PASS\n");
+    return 0;
+}
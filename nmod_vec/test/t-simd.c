@@ -0,0 +1,135 @@
+/*
+    Copyright (C) 2019 William Hart
+
+    This file is part of FLINT.
+
+    FLINT is free software: you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.  See <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <gmp.h>
+#include "flint.h"
+#include "nmod_vec.h"
+#include "ulong_extras.h"
+
+int
+main(void)
+{
+    int i, level, max_level;
+    FLINT_TEST_INIT(state);
+
+    flint_printf("simd....");
+    fflush(stdout);
+
+    max_level = nmod_vec_simd_max_level();
+
+    /* compare each level with the portable code */
+    for (i = 0; i < 1000 * flint_test_multiplier(); i++)
+    {
+        slong len;
+        nmod_t mod;
+        mp_limb_t m, c, d1, d2;
+        mp_ptr x, y, r1, r2;
+        int op;
+
+        len = n_randint(state, 100) + 1;
+
+        switch (n_randint(state, 4))
+        {
+        case 0:
+            m = n_randint(state, 100) + 1;
+            break;
+        case 1:
+            m = (UWORD(1) << NMOD_VEC_SIMD_MAX_BITS) - n_randint(state, 100)
+                                                                         - 1;
+            break;
+        case 2:
+            m = UWORD(0x100000000) + n_randint(state, 100) - 50;
+            break;
+        default:
+            m = n_randtest_bits(state,
+                          n_randint(state, NMOD_VEC_SIMD_MAX_BITS + 10) + 1);
+        }
+
+        nmod_init(&mod, m);
+
+        x = _nmod_vec_init(len);
+        y = _nmod_vec_init(len);
+        r1 = _nmod_vec_init(len);
+        r2 = _nmod_vec_init(len);
+
+        _nmod_vec_randtest(x, state, len, mod);
+        _nmod_vec_randtest(y, state, len, mod);
+        _nmod_vec_randtest(r1, state, len, mod);
+        _nmod_vec_set(r2, r1, len);
+        c = n_randint(state, m);
+
+        if (n_randint(state, 4) == 0)
+        {
+            flint_mpn_store(x, len, m - 1);
+            c = m - 1;
+        }
+
+        op = n_randint(state, 5);
+        d1 = d2 = 0;
+
+        for (level = 0; level <= max_level; level++)
+        {
+            nmod_vec_simd_set_level(level);
+
+            switch (op)
+            {
+            case 0:
+                _nmod_vec_add(level == 0 ? r1 : r2, x, y, len, mod);
+                break;
+            case 1:
+                _nmod_vec_sub(level == 0 ? r1 : r2, x, y, len, mod);
+                break;
+            case 2:
+                _nmod_vec_scalar_mul_nmod(level == 0 ? r1 : r2,
+                                                            x, len, c, mod);
+                break;
+            case 3:
+                _nmod_vec_set(level == 0 ? r1 : r2, y, len);
+                _nmod_vec_scalar_addmul_nmod(level == 0 ? r1 : r2,
+                                                            x, len, c, mod);
+                break;
+            default:
+                *(level == 0 ? &d1 : &d2) = _nmod_vec_dot(x, y, len, mod,
+                                        _nmod_vec_dot_bound_limbs(len, mod));
+            }
+
+            if (level != 0 && (!_nmod_vec_equal(r1, r2, len) || d1 != d2))
+            {
+                flint_printf("FAIL:\n");
+                flint_printf("op = %d, level = %d\n", op, level);
+                flint_printf("m = %wu, len = %wd, c = %wu\n", m, len, c);
+                flint_printf("d1 = %wu, d2 = %wu\n", d1, d2);
+                abort();
+            }
+        }
+
+        _nmod_vec_clear(x);
+        _nmod_vec_clear(y);
+        _nmod_vec_clear(r1);
+        _nmod_vec_clear(r2);
+    }
+
+    nmod_vec_simd_set_level(max_level);
+
+    if (nmod_vec_simd_level() != max_level)
+    {
+        flint_printf("FAIL:\n");
+        flint_printf("level not restored\n");
+        abort();
+    }
+
+    FLINT_TEST_CLEANUP(state);
+
+    flint_printf("PASS\n");
+    return 0;
+}
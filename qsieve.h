@@ -18,16 +18,14 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdint.h>
+#include <pthread.h>
 
 #include "flint.h"
 #include "fmpz.h"
 #include "ulong_extras.h"
 #include "fmpz_vec.h"
 #include "fmpz_factor.h"
-
-#if HAVE_OPENMP
-#include <omp.h> /* must include flint.h first */
-#endif
+#include "threadpool.h"
 
 #ifdef __cplusplus
  extern "C" {
@@ -39,6 +37,21 @@
 
 #define BLOCK_SIZE 65536 /* size of sieving cache block */
 
+#define QS_L1_BLOCK_SIZE 32768 /* size of block sieved with the primes
+                                  below QS_L1_PRIME, fits in L1 */
+
+#define QS_L1_PRIME 4096 /* primes hitting a block often enough to be
+                            sieved over the smaller blocks */
+
+#define QS_BUCKET_SIZE 4096 /* hits of primes above BLOCK_SIZE collected per
+                               sieve block before they are added to it */
+
+/* number of words of a relation in the relation store */
+#define QS_REL_LEN(rel, small_primes) \
+   (5 + (small_primes) + 2*(slong) (rel)[3] + FLINT_ABS((slong) (rel)[4]))
+
+#define QS_CHECKPOINT_INTERVAL 600 /* seconds between checkpoints */
+
 typedef struct prime_t
 {
    mp_limb_t pinv;     /* precomputed inverse */
@@ -65,11 +78,17 @@ typedef struct hash_t   /* entry in hash table */
    mp_limb_t prime;    /* value of prime */
    mp_limb_t next;     /* next prime which have same hash value as 'prime' */
    mp_limb_t count;    /* number of occurrence of 'prime' */
+   mp_limb_t last;     /* one more than the offset in the relation store
+                          of the last partial with 'prime', or 0 */
+   mp_limb_t parent;   /* offset in table of parent of 'prime' in the
+                          union-find forest of the graph of partials */
 } hash_t;
 
 typedef struct relation_t  /* format for relation */
 {
    mp_limb_t lp;          /* large prime, is 1, if relation is full */
+   mp_limb_t lp2;         /* second large prime, is 1 unless the relation
+                             has two large primes, lp < lp2 if it has */
    slong num_factors;     /* number of factors, excluding small factor */
    slong small_primes;   /* number of small factors */
    slong * small;         /* exponent of small factors */
@@ -84,9 +103,16 @@ typedef struct qs_poly_s
    int * soln2;       /* second start position in sieve per prime */
    int * posn1;       /* temp space for sieving */
    int * posn2;       /* temp space for sieving */
+   unsigned int * bucket; /* hits of primes above BLOCK_SIZE, QS_BUCKET_SIZE
+                             per sieve block, as position + (size << 24) */
+   slong * bucket_len;   /* number of hits in each bucket */
    slong * small;     /* exponents of small prime factors in relations */
    fac_t * factor;    /* factors for a relation */
    slong num_factors; /* number of factors found in a relation */
+
+   mp_limb_t * rel_buf; /* relations not yet passed to the relation store */
+   slong rel_len;     /* number of words used in rel_buf */
+   slong rel_alloc;   /* number of words allocated for rel_buf */
 } qs_poly_s;
 
 typedef qs_poly_s qs_poly_t[1];
@@ -161,19 +187,36 @@ typedef struct qs_s
    slong poly_count;         /* keep track of the number of polynomials used */
 #endif
 
+   slong num_threads;        /* number of threads used for sieving */
    qs_poly_s * poly;         /* poly data per thread */
+   slong curr_poly;          /* index of next B value to hand out */
 
    /***************************************************************************
                        RELATION DATA
    ***************************************************************************/
 
-   FILE * siqs;          /* pointer to file for storing relations */
+   mp_limb_t * store;    /* relations in binary form, see store.c */
+   slong store_len;      /* number of words of relations in memory */
+   slong store_alloc;    /* number of words allocated for store */
+   slong store_spilled;  /* number of words of relations in spill file */
+   const char * spill_path; /* file to spill relations to, or NULL */
+   FILE * spill;         /* spill file, NULL until relations are spilled */
+   mp_limb_t full_last;  /* one more than offset of last full relation */
+
+   pthread_mutex_t mutex; /* guards the relation store and the B values */
 
    slong full_relation;  /* number of full relations */
    slong num_cycles;     /* number of possible full relations from partials */
 
-   slong vertices;       /* number of different primes in partials */
-   slong components;     /* equal to 1 */
+   int dlp;              /* nonzero if partials may have two large primes */
+   slong dlp_mult;       /* bound on both large primes of such partials, as
+                            a multiple of the largest factor base prime */
+   slong dlp_bits;       /* bits by which the sieve threshold is lowered
+                            when partials have two large primes */
+
+   slong vertices;       /* number of different primes in partials,
+                            including 1 */
+   slong components;     /* number of connected components of the graph */
    slong edges;          /* total number of partials */
 
    slong table_size;     /* size of table */
@@ -214,86 +257,92 @@ typedef struct qs_s
 typedef qs_s qs_t[1];
 
 /*
-   Tuning parameters { bits, ks_primes, fb_primes, small_primes, sieve_size}
-   for qsieve_factor where:
+   Tuning parameters { bits, ks_primes, fb_primes, small_primes, sieve_size,
+   sieve_bits, dlp_mult, dlp_bits } for qsieve_factor where:
      * bits is the number of bits of n
      * ks_primes is the max number of primes to try in Knuth-Schroeppel function
      * fb_primes is the number of factor base primes to use (including k and 2)
      * small_primes is the number of small primes to not factor with (including k and 2)
      * sieve_size is the size of the sieve to use
      * sieve_bits - sieve_fill
+     * dlp_mult bounds the large primes of partials with two large primes,
+       as a multiple of the largest factor base prime
+     * dlp_bits is the number of bits the sieve threshold is lowered by when
+       partials may have two large primes
+   Two large primes are allowed if n has at least
+   FLINT_CUTOFF(QSIEVE_DLP_BITS) bits.
 */
 
 #if HAVE_OPENMP
 
-static const mp_limb_t qsieve_tune[][6] =
+static const mp_limb_t qsieve_tune[][8] =
 {
-   {10,   50,   100,  5,   2 *  2000,  30}, /* */
-   {20,   50,   120,  6,   2 *  2500,  30}, /* */
-   {30,   50,   150,  6,   2 *  2000,  31}, /* */
-   {40,   50,   150,  8,   2 *  3000,  32}, /* 12 digits */
-   {50,   50,   150,  8,   2 *  3000,  34}, /* 15 digits */
-   {60,   50,   150,  9,   2 *  3500,  36}, /* 18 digits */
-   {70,  100,   200,  9,   2 *  4000,  42}, /* 21 digits */
-   {80,  100,   200,  9,   2 *  6000,  44}, /* 24 digits */
-   {90,  100,   200,  9,   2 *  6000,  50}, /* */
-   {100, 100,   300,  9,   2 *  7000,  54}, /* */
-   {110, 100,   500,  9,   2 *  25000, 62}, /* 31 digits */
-   {120, 100,   800,  9,   2 *  30000, 64}, /* */
-   {130, 100,  1000,  9,   2 *  30000, 64}, /* 41 digits */
-   {140, 100,  1200,  9,   2 *  30000, 66}, /* */
-   {150, 100,  1500, 10,   2 *  32000, 68}, /* 45 digit */
-   {160, 150,  1800, 11,   2 *  32000, 70}, /* */
-   {170, 150,  2000, 12,   2 *  32000, 72}, /* 50 digits */
-   {180, 150,  2500, 12,   2 *  32000, 73}, /* */
-   {190, 150,  2800, 12,   2 *  32000, 76}, /* */
-   {200, 200,  4000, 12,   2 *  32000, 80}, /* 60 digits */
-   {210, 100,  3600, 12,   2 *  32000, 83}, /* */
-   {220, 300,  6000, 15,   2 *  65536, 87}, /* */
-   {230, 350,  8500, 17,   3 *  65536, 90}, /* 70 digits */
-   {240, 400, 10000, 19,   4 *  65536, 93}, /* */
-   {250, 500, 15000, 19,   4 *  65536, 97}, /* 75 digits */
-   {260, 600, 25000, 25,   4 *  65536, 100}, /* 80 digits */
-   {270, 800, 35000, 27,   5 *  65536, 104}  /* */
+   {10,   50,   100,  5,   2 *  2000,  30,  60,  8}, /* */
+   {20,   50,   120,  6,   2 *  2500,  30,  60,  8}, /* */
+   {30,   50,   150,  6,   2 *  2000,  31,  60,  8}, /* */
+   {40,   50,   150,  8,   2 *  3000,  32,  60,  8}, /* 12 digits */
+   {50,   50,   150,  8,   2 *  3000,  34,  60,  8}, /* 15 digits */
+   {60,   50,   150,  9,   2 *  3500,  36,  60,  8}, /* 18 digits */
+   {70,  100,   200,  9,   2 *  4000,  42,  60,  8}, /* 21 digits */
+   {80,  100,   200,  9,   2 *  6000,  44,  60,  8}, /* 24 digits */
+   {90,  100,   200,  9,   2 *  6000,  50,  60,  8}, /* */
+   {100, 100,   300,  9,   2 *  7000,  54,  60,  8}, /* */
+   {110, 100,   500,  9,   2 *  25000, 62,  60,  8}, /* 31 digits */
+   {120, 100,   800,  9,   2 *  30000, 64,  60,  8}, /* */
+   {130, 100,  1000,  9,   2 *  30000, 64,  60,  8}, /* 41 digits */
+   {140, 100,  1200,  9,   2 *  30000, 66,  60,  8}, /* */
+   {150, 100,  1500, 10,   2 *  32000, 68,  60,  8}, /* 45 digit */
+   {160, 150,  1800, 11,   2 *  32000, 70,  80,  8}, /* */
+   {170, 150,  2000, 12,   2 *  32000, 72,  80,  8}, /* 50 digits */
+   {180, 150,  2500, 12,   2 *  32000, 73, 100,  8}, /* */
+   {190, 150,  2800, 12,   2 *  32000, 76, 100,  9}, /* */
+   {200, 200,  4000, 12,   2 *  32000, 80, 120,  9}, /* 60 digits */
+   {210, 100,  3600, 12,   2 *  32000, 83, 120,  9}, /* */
+   {220, 300,  6000, 15,   2 *  65536, 87, 140, 10}, /* */
+   {230, 350,  8500, 17,   3 *  65536, 90, 140, 10}, /* 70 digits */
+   {240, 400, 10000, 19,   4 *  65536, 93, 160, 11}, /* */
+   {250, 500, 15000, 19,   4 *  65536, 97, 160, 11}, /* 75 digits */
+   {260, 600, 25000, 25,   4 *  65536, 100, 200, 12}, /* 80 digits */
+   {270, 800, 35000, 27,   5 *  65536, 104, 200, 13}  /* */
 };
 
 #else /* currently tuned for four threads */
 
-static const mp_limb_t qsieve_tune[][6] =
+static const mp_limb_t qsieve_tune[][8] =
 {
-   {10,   50,   100,  5,   2 *  2000,  30}, /* */
-   {20,   50,   120,  6,   2 *  2500,  30}, /* */
-   {30,   50,   150,  6,   2 *  2000,  31}, /* */
-   {40,   50,   150,  8,   2 *  3000,  32}, /* 12 digits */
-   {50,   50,   150,  8,   2 *  4000,  34}, /* 15 digits */
-   {60,   50,   150,  9,   2 *  5000,  36}, /* 18 digits */
-   {70,  100,   200,  9,   2 *  6000,  42}, /* 21 digits */
-   {80,  100,   200,  9,   2 *  8000,  44}, /* 24 digits */
-   {90,  100,   200,  9,   2 *  9000,  50}, /* */
-   {100, 100,   300,  9,   2 *  10000,  54}, /* */
-   {110, 100,   500,  9,   2 *  30000, 62}, /* 31 digits */
-   {120, 100,   800,  9,   2 *  40000, 64}, /* */
-   {130, 100,  1000,  9,   2 *  50000, 64}, /* 41 digits */
-   {140, 100,  1200,  9,   2 *  65536, 66}, /* */
-   {150, 100,  1500, 10,   2 *  65536, 68}, /* 45 digit */
-   {160, 150,  1800, 11,   3 *  65536, 70}, /* */
-   {170, 150,  2000, 12,   4 *  65536, 72}, /* 50 digits */
-   {180, 150,  2500, 12,   5 *  65536, 73}, /* */
-   {190, 150,  2800, 12,   6 *  65536, 76}, /* */
-   {200, 200,  4000, 12,   6 *  65536, 80}, /* 60 digits */
-   {210, 100,  3600, 12,   7 *  65536, 83}, /* */
-   {220, 300,  6000, 15,   9 *  65536, 87}, /* */
-   {230, 350,  8500, 17,   10 *  65536, 90}, /* 70 digits */
-   {240, 400, 10000, 19,   12 *  65536, 93}, /* */
-   {250, 500, 15000, 19,   14 *  65536, 97}, /* 75 digits */
-   {260, 600, 25000, 25,   15 *  65536, 100}, /* 80 digits */
-   {270, 800, 35000, 27,   16 *  65536, 104}  /* */
+   {10,   50,   100,  5,   2 *  2000,  30,  60,  8}, /* */
+   {20,   50,   120,  6,   2 *  2500,  30,  60,  8}, /* */
+   {30,   50,   150,  6,   2 *  2000,  31,  60,  8}, /* */
+   {40,   50,   150,  8,   2 *  3000,  32,  60,  8}, /* 12 digits */
+   {50,   50,   150,  8,   2 *  4000,  34,  60,  8}, /* 15 digits */
+   {60,   50,   150,  9,   2 *  5000,  36,  60,  8}, /* 18 digits */
+   {70,  100,   200,  9,   2 *  6000,  42,  60,  8}, /* 21 digits */
+   {80,  100,   200,  9,   2 *  8000,  44,  60,  8}, /* 24 digits */
+   {90,  100,   200,  9,   2 *  9000,  50,  60,  8}, /* */
+   {100, 100,   300,  9,   2 *  10000,  54,  60,  8}, /* */
+   {110, 100,   500,  9,   2 *  30000, 62,  60,  8}, /* 31 digits */
+   {120, 100,   800,  9,   2 *  40000, 64,  60,  8}, /* */
+   {130, 100,  1000,  9,   2 *  50000, 64,  60,  8}, /* 41 digits */
+   {140, 100,  1200,  9,   2 *  65536, 66,  60,  8}, /* */
+   {150, 100,  1500, 10,   2 *  65536, 68,  60,  8}, /* 45 digit */
+   {160, 150,  1800, 11,   3 *  65536, 70,  80,  8}, /* */
+   {170, 150,  2000, 12,   4 *  65536, 72,  80,  8}, /* 50 digits */
+   {180, 150,  2500, 12,   5 *  65536, 73, 100,  8}, /* */
+   {190, 150,  2800, 12,   6 *  65536, 76, 100,  9}, /* */
+   {200, 200,  4000, 12,   6 *  65536, 80, 120,  9}, /* 60 digits */
+   {210, 100,  3600, 12,   7 *  65536, 83, 120,  9}, /* */
+   {220, 300,  6000, 15,   9 *  65536, 87, 140, 10}, /* */
+   {230, 350,  8500, 17,   10 *  65536, 90, 140, 10}, /* 70 digits */
+   {240, 400, 10000, 19,   12 *  65536, 93, 160, 11}, /* */
+   {250, 500, 15000, 19,   14 *  65536, 97, 160, 11}, /* 75 digits */
+   {260, 600, 25000, 25,   15 *  65536, 100, 200, 12}, /* 80 digits */
+   {270, 800, 35000, 27,   16 *  65536, 104, 200, 13}  /* */
 };
 
 #endif
 
 /* number of entries in the tuning table */
-#define QS_TUNE_SIZE (sizeof(qsieve_tune)/(6*sizeof(mp_limb_t)))
+#define QS_TUNE_SIZE (sizeof(qsieve_tune)/(8*sizeof(mp_limb_t)))
 
 FLINT_DLL void qsieve_init(qs_t qs_inf, const fmpz_t n);
 
@@ -303,6 +352,24 @@ FLINT_DLL void qsieve_clear(qs_t qs_inf);
 
 FLINT_DLL void qsieve_factor(fmpz_factor_t factors, const fmpz_t n);
 
+FLINT_DLL int qsieve_factor_effort(fmpz_factor_t factors, const fmpz_t n,
+                                              fmpz_factor_effort_t effort);
+
+FLINT_DLL void qsieve_factor_spill(fmpz_factor_t factors,
+                                      const fmpz_t n, const char * path);
+
+FLINT_DLL int qsieve_factor_checkpoint(fmpz_factor_t factors,
+                     const fmpz_t n, const char * path, slong max_polys);
+
+FLINT_DLL int qsieve_factor_resume(fmpz_factor_t factors,
+                                        const char * path, slong max_polys);
+
+int qsieve_save_state(qs_t qs_inf, const char * path);
+
+int qsieve_load_state(qs_t qs_inf, const char * path);
+
+int qsieve_read_state_n(fmpz_t n, const char * path);
+
 prime_t * compute_factor_base(mp_limb_t * small_factor, qs_t qs_inf,
                                                              slong num_primes);
 
@@ -354,13 +421,30 @@ slong qsieve_merge_relations(qs_t qs_inf);
 
 slong qsieve_insert_relation(qs_t qs_inf, fmpz_t Y);
 
-void qsieve_write_to_file(qs_t qs_inf, mp_limb_t prime, fmpz_t Y, qs_poly_t poly);
+void qsieve_store_init(qs_t qs_inf);
+
+void qsieve_store_clear(qs_t qs_inf);
+
+void qsieve_buffer_relation(qs_t qs_inf, mp_limb_t prime,
+                              mp_limb_t prime2, fmpz_t Y, qs_poly_t poly);
+
+void qsieve_store_relations(qs_t qs_inf, mp_limb_t * rels, slong len);
+
+void qsieve_flush_relations(qs_t qs_inf, qs_poly_t poly);
+
+mp_limb_t qsieve_get_relation(relation_t * rel, qs_t qs_inf, mp_limb_t off);
 
 hash_t * qsieve_get_table_entry(qs_t qs_inf, mp_limb_t prime);
 
 void qsieve_add_to_hashtable(qs_t qs_inf, mp_limb_t prime);
 
-relation_t qsieve_parse_relation(qs_t qs_inf, char * str);
+void qsieve_add_edge(qs_t qs_inf, mp_limb_t prime, mp_limb_t prime2);
+
+mp_limb_t qsieve_split_cofactor(mp_limb_t * prime2, qs_t qs_inf,
+                                                           mp_limb_t cofactor);
+
+int qsieve_combine_cycle(relation_t * c, qs_t qs_inf, relation_t ** rels,
+                                                     slong len, slong * exps);
 
 relation_t qsieve_merge_relation(qs_t qs_inf, relation_t  a, relation_t  b);
 
@@ -373,6 +457,8 @@ void qsieve_insert_relation2(qs_t qs_inf, relation_t * rel_list,
 
 int qsieve_process_relation(qs_t qs_inf);
 
+int qsieve_process_relation_dlp(qs_t qs_inf);
+
 static __inline__ void insert_col_entry(la_col_t * col, slong entry)
 {
    if (((col->weight >> 4) << 4) == col->weight) /* need more space */
@@ -694,6 +694,305 @@ void combine_cols(slong ncols,
 	}
 }
 
+/*-----------------------------------------------------------------------*/
+
+/* The products with the matrix and the operations on n x 64 matrices
+   done in each iteration can be shared between several threads. For the
+   product with the matrix the rows are also stored, so that each thread
+   computes the entries of the output for a range of rows or columns,
+   chosen to have about the same number of nonzero entries. */
+
+typedef struct {
+	la_col_t *A;		/* columns of the matrix */
+	slong *row_start;	/* row i has entries row_entries[row_start[i]..] */
+	slong *row_entries;	/* column indices of the entries of each row */
+	slong start;		/* range of rows, columns or words handled */
+	slong stop;
+	uint64_t *x;		/* input */
+	uint64_t *y;		/* second input for mul_64xN_Nx64 */
+	uint64_t *b;		/* output */
+	uint64_t *c;		/* table or scratch space */
+	uint64_t xy[64];	/* output of mul_64xN_Nx64 */
+} la_thread_arg_t;
+
+typedef struct {
+	slong num_threads;
+	slong *row_start;
+	slong *row_entries;
+	slong *row_part;	/* thread i handles rows row_part[i] to
+				   row_part[i + 1] */
+	slong *col_part;	/* and columns col_part[i] to col_part[i + 1] */
+	uint64_t *scratch;	/* 256 x 8 words of scratch per thread */
+	la_thread_arg_t *args;
+} la_threads_t;
+
+/*-------------------------------------------------------------------*/
+static void partition_by_weight(slong *part, slong num_threads,
+				const slong *start, slong n) {
+
+	/* Given a cumulative weight start[0..n] of n items, set
+	   part[0..num_threads] so that each range of items carries
+	   about the same weight. One is added per item, for the
+	   cost of the item itself */
+
+	slong i, j, total = start[n] - start[0] + n;
+
+	part[0] = 0;
+	for (i = 1, j = 0; i < num_threads; i++) {
+		slong target = (total / num_threads) * i;
+
+		while (j < n && start[j] - start[0] + j < target)
+			j++;
+		part[i] = j;
+	}
+	part[num_threads] = n;
+}
+
+/*-------------------------------------------------------------------*/
+static void la_threads_init(la_threads_t *T, slong num_threads,
+			slong vsize, slong ncols, la_col_t *A) {
+
+	slong i, j, nnz;
+	slong *count, *col_start;
+
+	T->num_threads = num_threads;
+
+	/* store the matrix by rows as well */
+
+	count = (slong *)flint_calloc(vsize + 1, sizeof(slong));
+	col_start = (slong *)flint_malloc((ncols + 1) * sizeof(slong));
+
+	for (i = 0, nnz = 0; i < ncols; i++) {
+		col_start[i] = nnz;
+		nnz += A[i].weight;
+		for (j = 0; j < A[i].weight; j++)
+			count[A[i].data[j] + 1]++;
+	}
+	col_start[ncols] = nnz;
+
+	for (i = 0; i < vsize; i++)
+		count[i + 1] += count[i];
+
+	T->row_start = (slong *)flint_malloc((vsize + 1) * sizeof(slong));
+	T->row_entries = (slong *)flint_malloc(FLINT_MAX(nnz, 1) * sizeof(slong));
+	memcpy(T->row_start, count, (vsize + 1) * sizeof(slong));
+
+	for (i = 0; i < ncols; i++) {
+		for (j = 0; j < A[i].weight; j++)
+			T->row_entries[count[A[i].data[j]]++] = i;
+	}
+
+	T->row_part = (slong *)flint_malloc((num_threads + 1) * sizeof(slong));
+	T->col_part = (slong *)flint_malloc((num_threads + 1) * sizeof(slong));
+
+	partition_by_weight(T->row_part, num_threads, T->row_start, vsize);
+	partition_by_weight(T->col_part, num_threads, col_start, ncols);
+
+	T->scratch = (uint64_t *)flint_malloc(num_threads * 256 * 8 * 
+							sizeof(uint64_t));
+	T->args = (la_thread_arg_t *)flint_malloc(num_threads * 
+						sizeof(la_thread_arg_t));
+
+	for (i = 0; i < num_threads; i++) {
+		T->args[i].A = A;
+		T->args[i].row_start = T->row_start;
+		T->args[i].row_entries = T->row_entries;
+	}
+
+	flint_free(count);
+	flint_free(col_start);
+}
+
+/*-------------------------------------------------------------------*/
+static void la_threads_clear(la_threads_t *T) {
+
+	flint_free(T->row_start);
+	flint_free(T->row_entries);
+	flint_free(T->row_part);
+	flint_free(T->col_part);
+	flint_free(T->scratch);
+	flint_free(T->args);
+}
+
+/*-------------------------------------------------------------------*/
+static void la_set_ranges(la_threads_t *T, const slong *part, slong n) {
+
+	/* use the partition part[], or split n evenly if part is NULL */
+
+	slong i;
+
+	for (i = 0; i < T->num_threads; i++) {
+		if (part != NULL) {
+			T->args[i].start = part[i];
+			T->args[i].stop = part[i + 1];
+		} else {
+			T->args[i].start = (n * i) / T->num_threads;
+			T->args[i].stop = (n * (i + 1)) / T->num_threads;
+		}
+	}
+}
+
+/*-------------------------------------------------------------------*/
+static void mul_MxN_Nx64_worker(void *arg_ptr) {
+
+	la_thread_arg_t *arg = (la_thread_arg_t *)arg_ptr;
+	slong i, j;
+
+	for (i = arg->start; i < arg->stop; i++) {
+		uint64_t accum = 0;
+
+		for (j = arg->row_start[i]; j < arg->row_start[i + 1]; j++)
+			accum ^= arg->x[arg->row_entries[j]];
+		arg->b[i] = accum;
+	}
+}
+
+/*-------------------------------------------------------------------*/
+static void mul_trans_MxN_Nx64_worker(void *arg_ptr) {
+
+	la_thread_arg_t *arg = (la_thread_arg_t *)arg_ptr;
+	slong i, j;
+
+	for (i = arg->start; i < arg->stop; i++) {
+		la_col_t *col = arg->A + i;
+		slong *row_entries = col->data;
+		uint64_t accum = 0;
+
+		for (j = 0; j < col->weight; j++)
+			accum ^= arg->x[row_entries[j]];
+		arg->b[i] = accum;
+	}
+}
+
+/*-------------------------------------------------------------------*/
+static void mul_Nx64_64x64_acc_worker(void *arg_ptr) {
+
+	la_thread_arg_t *arg = (la_thread_arg_t *)arg_ptr;
+	uint64_t *c = arg->c;
+	slong i;
+
+	for (i = arg->start; i < arg->stop; i++) {
+		uint64_t word = arg->x[i];
+		arg->b[i] ^=  c[ 0*256 + ((word>> 0) & 0xff) ]
+			    ^ c[ 1*256 + ((word>> 8) & 0xff) ]
+			    ^ c[ 2*256 + ((word>>16) & 0xff) ]
+			    ^ c[ 3*256 + ((word>>24) & 0xff) ]
+			    ^ c[ 4*256 + ((word>>32) & 0xff) ]
+			    ^ c[ 5*256 + ((word>>40) & 0xff) ]
+			    ^ c[ 6*256 + ((word>>48) & 0xff) ]
+			    ^ c[ 7*256 + ((word>>56)       ) ];
+	}
+}
+
+/*-------------------------------------------------------------------*/
+static void mul_64xN_Nx64_worker(void *arg_ptr) {
+
+	la_thread_arg_t *arg = (la_thread_arg_t *)arg_ptr;
+
+	mul_64xN_Nx64(arg->x + arg->start, arg->y + arg->start,
+			arg->c, arg->xy, arg->stop - arg->start);
+}
+
+/*-------------------------------------------------------------------*/
+static void la_mul_MxN_Nx64(la_threads_t *T, slong vsize, 
+		slong dense_rows, slong ncols, la_col_t *A,
+		uint64_t *x, uint64_t *b) {
+
+	slong i;
+
+	if (T == NULL) {
+		mul_MxN_Nx64(vsize, dense_rows, ncols, A, x, b);
+		return;
+	}
+
+	la_set_ranges(T, T->row_part, vsize);
+	for (i = 0; i < T->num_threads; i++) {
+		T->args[i].x = x;
+		T->args[i].b = b;
+	}
+
+	threadpool_parallel_do(mul_MxN_Nx64_worker, T->args,
+				T->num_threads, sizeof(la_thread_arg_t));
+}
+
+/*-------------------------------------------------------------------*/
+static void la_mul_trans_MxN_Nx64(la_threads_t *T, slong dense_rows,
+		slong ncols, la_col_t *A, uint64_t *x, uint64_t *b) {
+
+	slong i;
+
+	if (T == NULL) {
+		mul_trans_MxN_Nx64(dense_rows, ncols, A, x, b);
+		return;
+	}
+
+	la_set_ranges(T, T->col_part, ncols);
+	for (i = 0; i < T->num_threads; i++) {
+		T->args[i].x = x;
+		T->args[i].b = b;
+	}
+
+	threadpool_parallel_do(mul_trans_MxN_Nx64_worker, T->args,
+				T->num_threads, sizeof(la_thread_arg_t));
+}
+
+/*-------------------------------------------------------------------*/
+static void la_mul_Nx64_64x64_acc(la_threads_t *T, uint64_t *v, 
+			uint64_t *x, uint64_t *c, uint64_t *y, slong n) {
+
+	slong i;
+
+	if (T == NULL) {
+		mul_Nx64_64x64_acc(v, x, c, y, n);
+		return;
+	}
+
+	/* the table is shared by all threads */
+
+	precompute_Nx64_64x64(x, c);
+
+	la_set_ranges(T, NULL, n);
+	for (i = 0; i < T->num_threads; i++) {
+		T->args[i].x = v;
+		T->args[i].b = y;
+		T->args[i].c = c;
+	}
+
+	threadpool_parallel_do(mul_Nx64_64x64_acc_worker, T->args,
+				T->num_threads, sizeof(la_thread_arg_t));
+}
+
+/*-------------------------------------------------------------------*/
+static void la_mul_64xN_Nx64(la_threads_t *T, uint64_t *x, uint64_t *y,
+			   uint64_t *c, uint64_t *xy, slong n) {
+
+	slong i, j;
+
+	if (T == NULL) {
+		mul_64xN_Nx64(x, y, c, xy, n);
+		return;
+	}
+
+	/* each thread computes the product of its rows of x and y,
+	   the sum of which is transpose(x) * y */
+
+	la_set_ranges(T, NULL, n);
+	for (i = 0; i < T->num_threads; i++) {
+		T->args[i].x = x;
+		T->args[i].y = y;
+		T->args[i].c = T->scratch + i * 256 * 8;
+	}
+
+	threadpool_parallel_do(mul_64xN_Nx64_worker, T->args,
+				T->num_threads, sizeof(la_thread_arg_t));
+
+	memcpy(xy, T->args[0].xy, 64 * sizeof(uint64_t));
+	for (i = 1; i < T->num_threads; i++) {
+		for (j = 0; j < 64; j++)
+			xy[j] ^= T->args[i].xy[j];
+	}
+}
+
 /*-----------------------------------------------------------------------*/
 uint64_t * block_lanczos(flint_rand_t state, slong nrows, 
 			slong dense_rows, slong ncols, la_col_t *B) {
@@ -714,6 +1013,7 @@ uint64_t * block_lanczos(flint_rand_t state, slong nrows,
 	slong dim0, dim1;
 	uint64_t mask0, mask1;
 	slong vsize;
+	la_threads_t threads, *T = NULL;
 
 	/* allocate all of the size-n variables. Note that because
 	   B has been preprocessed to ignore singleton rows, the
@@ -744,6 +1044,14 @@ uint64_t * block_lanczos(flint_rand_t state, slong nrows,
 	f = (uint64_t *)flint_malloc(64 * sizeof(uint64_t));
 	f2 = (uint64_t *)flint_malloc(64 * sizeof(uint64_t));
 
+	/* share the work between threads for large matrices */
+
+	if (dense_rows == 0 && flint_get_num_threads() > 1 &&
+			ncols >= FLINT_CUTOFF(QSIEVE_LANCZOS_COLS)) {
+		T = &threads;
+		la_threads_init(T, flint_get_num_threads(), vsize, ncols, B);
+	}
+
 	/* The iterations computes v[0], vt_a_v[0],
 	   vt_a2_v[0], s[0] and winv[0]. Subscripts larger
 	   than zero represent past versions of these
@@ -777,8 +1085,8 @@ uint64_t * block_lanczos(flint_rand_t state, slong nrows,
 #endif
 
 	memcpy(x, v[0], vsize * sizeof(uint64_t));
-	mul_MxN_Nx64(vsize, dense_rows, ncols, B, v[0], scratch);
-	mul_trans_MxN_Nx64(dense_rows, ncols, B, scratch, v[0]);
+	la_mul_MxN_Nx64(T, vsize, dense_rows, ncols, B, v[0], scratch);
+	la_mul_trans_MxN_Nx64(T, dense_rows, ncols, B, scratch, v[0]);
 	memcpy(v0, v[0], vsize * sizeof(uint64_t));
 
 	/* perform the iteration */
@@ -790,13 +1098,13 @@ uint64_t * block_lanczos(flint_rand_t state, slong nrows,
 		   version of B, or B'B (apostrophe means 
 		   transpose). Use "A" to refer to B'B  */
 
-		mul_MxN_Nx64(vsize, dense_rows, ncols, B, v[0], scratch);
-		mul_trans_MxN_Nx64(dense_rows, ncols, B, scratch, vnext);
+		la_mul_MxN_Nx64(T, vsize, dense_rows, ncols, B, v[0], scratch);
+		la_mul_trans_MxN_Nx64(T, dense_rows, ncols, B, scratch, vnext);
 
 		/* compute v0'*A*v0 and (A*v0)'(A*v0) */
 
-		mul_64xN_Nx64(v[0], vnext, scratch, vt_a_v[0], n);
-		mul_64xN_Nx64(vnext, vnext, scratch, vt_a2_v[0], n);
+		la_mul_64xN_Nx64(T, v[0], vnext, scratch, vt_a_v[0], n);
+		la_mul_64xN_Nx64(T, vnext, vnext, scratch, vt_a2_v[0], n);
 
 		/* if the former is orthogonal to itself, then
 		   the iteration has finished */
@@ -863,15 +1171,15 @@ uint64_t * block_lanczos(flint_rand_t state, slong nrows,
 		for (i = 0; i < n; i++)
 			vnext[i] = vnext[i] & mask0;
 
-		mul_Nx64_64x64_acc(v[0], d, scratch, vnext, n);
-		mul_Nx64_64x64_acc(v[1], e, scratch, vnext, n);
-		mul_Nx64_64x64_acc(v[2], f, scratch, vnext, n);
+		la_mul_Nx64_64x64_acc(T, v[0], d, scratch, vnext, n);
+		la_mul_Nx64_64x64_acc(T, v[1], e, scratch, vnext, n);
+		la_mul_Nx64_64x64_acc(T, v[2], f, scratch, vnext, n);
 		
 		/* update the computed solution 'x' */
 
-		mul_64xN_Nx64(v[0], v0, scratch, d, n);
+		la_mul_64xN_Nx64(T, v[0], v0, scratch, d, n);
 		mul_64x64_64x64(winv[0], d, d);
-		mul_Nx64_64x64_acc(v[0], d, scratch, x, n);
+		la_mul_Nx64_64x64_acc(T, v[0], d, scratch, x, n);
 
 		/* rotate all the variables */
 
@@ -920,6 +1228,8 @@ uint64_t * block_lanczos(flint_rand_t state, slong nrows,
 	   over again */
 
 	if (dim0 == 0) {
+		if (T != NULL)
+			la_threads_clear(T);
 #if QS_DEBUG
 		flint_printf("linear algebra failed; retrying...\n");
 #endif
@@ -933,14 +1243,14 @@ uint64_t * block_lanczos(flint_rand_t state, slong nrows,
 	/* convert the output of the iteration to an actual
 	   collection of nullspace vectors */
 
-	mul_MxN_Nx64(vsize, dense_rows, ncols, B, x, v[1]);
-	mul_MxN_Nx64(vsize, dense_rows, ncols, B, v[0], v[2]);
+	la_mul_MxN_Nx64(T, vsize, dense_rows, ncols, B, x, v[1]);
+	la_mul_MxN_Nx64(T, vsize, dense_rows, ncols, B, v[0], v[2]);
 
 	combine_cols(ncols, x, v[0], v[1], v[2]);
 
 	/* verify that these really are linear dependencies of B */
 
-	mul_MxN_Nx64(vsize, dense_rows, ncols, B, x, v[0]);
+	la_mul_MxN_Nx64(T, vsize, dense_rows, ncols, B, x, v[0]);
 	
 	for (i = 0; i < ncols; i++) {
 		if (v[0][i] != 0)
@@ -951,6 +1261,9 @@ uint64_t * block_lanczos(flint_rand_t state, slong nrows,
 		flint_abort();
 	}
 	
+	if (T != NULL)
+		la_threads_clear(T);
+
 	flint_free(v[0]);
 	flint_free(v[1]);
 	flint_free(v[2]);
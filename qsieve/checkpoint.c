@@ -0,0 +1,286 @@
+/*
+    Copyright (C) 2019 William Hart
+
+    This file is part of FLINT.
+
+    FLINT is free software: you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.  See <http://www.gnu.org/licenses/>.
+*/
+
+#include "qsieve.h"
+
+/*
+   A checkpoint is a sequence of words:
+
+      QS_CHECKPOINT_MAGIC, version, FLINT_BITS
+      size of n, limbs of n
+      multiplier k, number of factor base primes, s, h, m, q_idx, dlp
+      curr_subset[0..s), A_ind[0..s)
+      number of words of relations, relations as in the relation store
+
+   It is taken after all polynomials for A = q0*A0 have been sieved, where
+   q0 is the factor base prime with index q_idx, so that sieving resumes
+   with the next q0. The links in the relations are rebuilt when they are
+   loaded.
+*/
+
+#define QS_CHECKPOINT_MAGIC UWORD(0x51534350)
+#define QS_CHECKPOINT_VERSION 2
+#define QS_CHECKPOINT_BUF 4096
+
+static int _qs_write(FILE * f, const mp_limb_t * w, slong n)
+{
+    return fwrite(w, sizeof(mp_limb_t), n, f) == (size_t) n;
+}
+
+static int _qs_read(FILE * f, mp_limb_t * w, slong n)
+{
+    return fread(w, sizeof(mp_limb_t), n, f) == (size_t) n;
+}
+
+/* read the header and n, return 0 if f is not a checkpoint */
+static int _qs_read_n(fmpz_t n, FILE * f)
+{
+    mp_limb_t head[4];
+    mp_limb_t * d;
+    int ok;
+
+    if (!_qs_read(f, head, 4) || head[0] != QS_CHECKPOINT_MAGIC ||
+         head[1] != QS_CHECKPOINT_VERSION || head[2] != FLINT_BITS ||
+         head[3] == 0 || head[3] > 1000)
+        return 0;
+
+    d = flint_malloc(head[3]*sizeof(mp_limb_t));
+    ok = _qs_read(f, d, head[3]);
+    if (ok)
+        fmpz_set_ui_array(n, d, head[3]);
+    flint_free(d);
+
+    return ok;
+}
+
+int qsieve_save_state(qs_t qs_inf, const char * path)
+{
+    slong i, s = qs_inf->s, size = fmpz_size(qs_inf->n);
+    mp_limb_t * buf;
+    char * tmp;
+    FILE * f;
+    int ok;
+
+    tmp = flint_malloc(strlen(path) + 5);
+    strcpy(tmp, path);
+    strcat(tmp, ".tmp");
+
+    f = fopen(tmp, "wb");
+    if (f == NULL)
+    {
+        flint_free(tmp);
+        return 0;
+    }
+
+    buf = flint_malloc(FLINT_MAX(QS_CHECKPOINT_BUF, 2*s + size + 4)
+                                                        * sizeof(mp_limb_t));
+
+    buf[0] = QS_CHECKPOINT_MAGIC;
+    buf[1] = QS_CHECKPOINT_VERSION;
+    buf[2] = FLINT_BITS;
+    buf[3] = size;
+    fmpz_get_ui_array(buf + 4, size, qs_inf->n);
+    ok = _qs_write(f, buf, size + 4);
+
+    buf[0] = qs_inf->k;
+    buf[1] = qs_inf->num_primes;
+    buf[2] = s;
+    buf[3] = qs_inf->h;
+    buf[4] = qs_inf->m;
+    buf[5] = qs_inf->q_idx;
+    buf[6] = qs_inf->dlp;
+    ok = ok && _qs_write(f, buf, 7);
+
+    for (i = 0; i < s; i++)
+    {
+        buf[i] = qs_inf->curr_subset[i];
+        buf[s + i] = qs_inf->A_ind[i];
+    }
+    ok = ok && _qs_write(f, buf, 2*s);
+
+    buf[0] = qs_inf->store_spilled + qs_inf->store_len;
+    ok = ok && _qs_write(f, buf, 1);
+
+    /* relations in the spill file, then those in memory */
+    if (ok && qs_inf->store_spilled != 0)
+    {
+        ok = (fseek(qs_inf->spill, 0, SEEK_SET) == 0);
+
+        for (i = 0; ok && i < qs_inf->store_spilled; i += QS_CHECKPOINT_BUF)
+        {
+            slong n = FLINT_MIN(QS_CHECKPOINT_BUF, qs_inf->store_spilled - i);
+            ok = _qs_read(qs_inf->spill, buf, n) && _qs_write(f, buf, n);
+        }
+    }
+
+    ok = ok && _qs_write(f, qs_inf->store, qs_inf->store_len);
+
+    ok = (fclose(f) == 0) && ok;
+
+    /* replace the previous checkpoint only once this one is complete */
+    if (ok && rename(tmp, path) != 0)
+    {
+        remove(path);
+        ok = (rename(tmp, path) == 0);
+    }
+
+    if (!ok)
+        remove(tmp);
+
+    flint_free(buf);
+    flint_free(tmp);
+
+    return ok;
+}
+
+int qsieve_read_state_n(fmpz_t n, const char * path)
+{
+    FILE * f = fopen(path, "rb");
+    int ok;
+
+    if (f == NULL)
+        return 0;
+
+    ok = _qs_read_n(n, f);
+    fclose(f);
+
+    return ok;
+}
+
+int qsieve_load_state(qs_t qs_inf, const char * path)
+{
+    slong i, j, s, num_primes, len, num_words;
+    mp_limb_t head[7];
+    mp_limb_t small_factor;
+    mp_limb_t * buf;
+    FILE * f;
+    fmpz_t n;
+    int ok;
+
+    f = fopen(path, "rb");
+    if (f == NULL)
+        return 0;
+
+    fmpz_init(n);
+    ok = _qs_read_n(n, f) && fmpz_equal(n, qs_inf->n) && _qs_read(f, head, 7)
+       && head[0] == qs_inf->k && (slong) head[1] >= qs_inf->num_primes
+       && head[2] != 0 && head[2] <= 40 && head[5] >= head[1]
+       && head[5] < head[1] + qs_inf->ks_primes
+       && head[6] == (mp_limb_t) qs_inf->dlp;
+    fmpz_clear(n);
+
+    if (!ok)
+    {
+        fclose(f);
+        return 0;
+    }
+
+    num_primes = head[1];
+    s = head[2];
+
+    /* the factor base had been enlarged */
+    if (num_primes > qs_inf->num_primes)
+    {
+        compute_factor_base(&small_factor, qs_inf, num_primes + qs_inf->ks_primes);
+        qs_inf->num_primes = num_primes;
+        qsieve_linalg_re_alloc(qs_inf);
+
+        qs_inf->q_idx = qs_inf->num_primes;
+
+        for (j = qs_inf->small_primes; j < qs_inf->num_primes; j++)
+        {
+            if (qs_inf->factor_base[j].p > BLOCK_SIZE)
+                break;
+        }
+
+        qs_inf->second_prime = j;
+    }
+
+    if (!qsieve_init_A0(qs_inf) || qs_inf->s != s)
+    {
+        fclose(f);
+        return 0;
+    }
+
+    /* room for a relation header beyond a full batch */
+    buf = flint_malloc((FLINT_MAX(QS_CHECKPOINT_BUF, 2*s) + 5)
+                                                        * sizeof(mp_limb_t));
+
+    ok = _qs_read(f, buf, 2*s);
+
+    for (i = 0; ok && i < s; i++)
+        ok = (buf[s + i] < (mp_limb_t) num_primes);
+
+    if (!ok)
+    {
+        flint_free(buf);
+        fclose(f);
+        return 0;
+    }
+
+    /* continue from the A0 and q0 that had been sieved */
+    qs_inf->h = head[3];
+    qs_inf->m = head[4];
+    qs_inf->q_idx = head[5];
+    fmpz_one(qs_inf->A0);
+
+    for (i = 0; i < s; i++)
+    {
+        qs_inf->curr_subset[i] = buf[i];
+        qs_inf->A_ind[i] = buf[s + i];
+        fmpz_mul_ui(qs_inf->A0, qs_inf->A0,
+                                       qs_inf->factor_base[buf[s + i]].p);
+    }
+
+    /*
+       pass the relations to the store in batches of whole relations, a
+       truncated file only loses the relations at its end
+    */
+    if (!_qs_read(f, head, 1))
+        head[0] = 0;
+
+    num_words = head[0];
+    len = 0;
+
+    for (i = 0; i < num_words; )
+    {
+        slong rlen;
+
+        if (!_qs_read(f, buf + len, 5))
+            break;
+
+        rlen = QS_REL_LEN(buf + len, qs_inf->small_primes);
+
+        if (rlen > QS_CHECKPOINT_BUF || rlen <= 5)
+            break;
+
+        if (len + rlen > QS_CHECKPOINT_BUF)
+        {
+            qsieve_store_relations(qs_inf, buf, len);
+            memmove(buf, buf + len, 5*sizeof(mp_limb_t));
+            len = 0;
+        }
+
+        if (!_qs_read(f, buf + len + 5, rlen - 5))
+            break;
+
+        len += rlen;
+        i += rlen;
+    }
+
+    if (len != 0)
+        qsieve_store_relations(qs_inf, buf, len);
+
+    flint_free(buf);
+    fclose(f);
+
+    return 1;
+}
@@ -138,102 +138,171 @@ void qsieve_do_sieving(qs_t qs_inf, unsigned char * sieve, qs_poly_t poly)
 }
 
 /*
-   sieving routine, breaks sieve array into blocks then sieve
-   each block, for whole factor base at once
+   sieve the part of the sieve up to B with the primes with index in
+   [start, stop), continuing from the positions in posn1 and posn2
 */
-
-void qsieve_do_sieving2(qs_t qs_inf, unsigned char * sieve, qs_poly_t poly)
+static void qsieve_sieve_block(unsigned char * sieve, unsigned char * B,
+                  slong start, slong stop, qs_t qs_inf, qs_poly_t poly)
 {
-    slong b, d1, d2, i;
-    slong pind, size;
+    slong d1, d2, pind, size;
     mp_limb_t p;
-    slong num_primes = qs_inf->num_primes;
-    int * soln1 = poly->soln1;
     int * soln2 = poly->soln2;
     int * posn1 = poly->posn1;
     int * posn2 = poly->posn2;
     prime_t * factor_base = qs_inf->factor_base;
 
-    unsigned char * B;
     register unsigned char * Bp;
     register unsigned char * pos;
 
-    memset(sieve, qs_inf->sieve_fill, qs_inf->sieve_size + sizeof(ulong));
-    sieve[qs_inf->sieve_size] = (char) 255;
+    for (pind = start; pind < stop; pind++)
+    {
+        if (soln2[pind] == 0)
+            continue;
+
+        p = factor_base[pind].p;
+        size = factor_base[pind].size;
+        d1 = posn2[pind];
+        d2 = p - d1;
+        Bp = B - 2*d1 - d2;
+        pos = sieve + posn1[pind];
+
+        while (pos < Bp)
+        {
+            (*pos) += size, (*(pos + d1)) += size, pos += p;
+            (*pos) += size, (*(pos + d1)) += size, pos += p;
+        }
+
+        Bp = B - d1;
+
+        while (pos < Bp)
+        {
+            (*pos) += size, 
+            (*(pos + d1)) += size, pos += p;
+        }
+
+        if (pos < B)
+        {
+            (*pos) += size, pos += d1;
+            posn2[pind] = d2;
+        }
+        else { posn2[pind] = d1; }
 
-    for (i = 0; i < num_primes; i++)
+        posn1[pind] = (pos - sieve);
+    }
+}
+
+/*
+   add the hits collected in the buckets to the sieve, block by block
+*/
+static void qsieve_empty_buckets(unsigned char * sieve, qs_poly_t poly,
+                                                              slong num_blocks)
+{
+    slong b, j;
+
+    for (b = 0; b < num_blocks; b++)
     {
-        posn1[i] = soln1[i];
-        posn2[i] = soln2[i] - posn1[i];
+        unsigned int * bucket = poly->bucket + b*QS_BUCKET_SIZE;
+        slong len = poly->bucket_len[b];
+
+        for (j = 0; j < len; j++)
+            sieve[bucket[j] & 0xffffff] += (bucket[j] >> 24);
+
+        poly->bucket_len[b] = 0;
     }
+}
+
+/*
+   sieving routine, breaks sieve array into blocks of BLOCK_SIZE bytes
+
+   primes below QS_L1_PRIME, which hit the sieve most often, are sieved
+   over blocks of QS_L1_BLOCK_SIZE bytes, so that these fit in the L1
+   cache, the other primes less than BLOCK_SIZE once per BLOCK_SIZE
+   bytes, as they hit each block only a few times
 
-    for (b = 1; b <= qs_inf->sieve_size / BLOCK_SIZE; b++)
+   primes above BLOCK_SIZE hit each block at most twice, so rather than
+   visit each of them for every block, their hits are sorted into a
+   bucket per block, which are added to the sieve each time QS_BUCKET_SIZE/2
+   primes have been processed
+*/
+
+void qsieve_do_sieving2(qs_t qs_inf, unsigned char * sieve, qs_poly_t poly)
+{
+    slong b, i, num_blocks, l1_prime, count;
+    slong pind, size;
+    mp_limb_t p;
+    slong num_primes = qs_inf->num_primes;
+    slong sieve_size = qs_inf->sieve_size;
+    int * soln1 = poly->soln1;
+    int * soln2 = poly->soln2;
+    unsigned int * bucket = poly->bucket;
+    slong * bucket_len = poly->bucket_len;
+    prime_t * factor_base = qs_inf->factor_base;
+    unsigned char * B;
+
+    memset(sieve, qs_inf->sieve_fill, sieve_size + sizeof(ulong));
+    sieve[sieve_size] = (char) 255;
+
+    for (i = qs_inf->small_primes; i < qs_inf->second_prime; i++)
     {
-        B = sieve + b * BLOCK_SIZE;
+        poly->posn1[i] = soln1[i];
+        poly->posn2[i] = soln2[i] - soln1[i];
+    }
 
-        for (pind = qs_inf->small_primes; pind < qs_inf->second_prime; pind++)
-        {
-            if (soln2[pind] == 0)
-                continue;
+    for (l1_prime = qs_inf->small_primes; l1_prime < qs_inf->second_prime
+                     && factor_base[l1_prime].p < QS_L1_PRIME; l1_prime++) ;
 
-            p = factor_base[pind].p;
-            size = factor_base[pind].size;
-            d1 = posn2[pind];
-            d2 = p - d1;
-            Bp = B - 2*d1 - d2;
-            pos = sieve + posn1[pind];
+    num_blocks = (sieve_size + QS_L1_BLOCK_SIZE - 1)/QS_L1_BLOCK_SIZE;
 
-            while (pos < Bp)
-            {
-                (*pos) += size, (*(pos + d1)) += size, pos += p;
-                (*pos) += size, (*(pos + d1)) += size, pos += p;
-            }
+    for (b = 1; b <= num_blocks; b++)
+    {
+        B = sieve + FLINT_MIN(b * QS_L1_BLOCK_SIZE, sieve_size);
 
-            Bp = B - d1;
+        qsieve_sieve_block(sieve, B, qs_inf->small_primes, l1_prime,
+                                                                qs_inf, poly);
 
-            while (pos < Bp)
-            {
-                (*pos) += size, 
-                (*(pos + d1)) += size, pos += p;
-            }
+        if (b % (BLOCK_SIZE/QS_L1_BLOCK_SIZE) == 0 || b == num_blocks)
+            qsieve_sieve_block(sieve, B, l1_prime, qs_inf->second_prime,
+                                                                qs_inf, poly);
+    }
 
-            if (pos < B)
-            {
-                (*pos) += size, pos += d1;
-                posn2[pind] = d2;
-            }
-            else { posn2[pind] = d1; }
+    num_blocks = (sieve_size + BLOCK_SIZE - 1)/BLOCK_SIZE;
 
-            posn1[pind] = (pos - sieve);
-        }
+    for (b = 0; b < num_blocks; b++)
+        bucket_len[b] = 0;
 
-        for (pind = qs_inf->second_prime; pind < num_primes; pind++)
-        {
-            p = factor_base[pind].p;
+    count = 0;
 
-            if (soln2[pind] == 0)
-                continue;
+    for (pind = qs_inf->second_prime; pind < num_primes; pind++)
+    {
+        if (soln2[pind] == 0)
+            continue;
 
-            size = factor_base[pind].size;
-            pos = sieve + posn1[pind];
+        /* make sure each bucket has room for two more hits */
+        if (count == QS_BUCKET_SIZE/2)
+        {
+            qsieve_empty_buckets(sieve, poly, num_blocks);
+            count = 0;
+        }
 
-            if (pos < B)
-            {
-                (*pos) += size;
-                pos += posn2[pind];
+        p = factor_base[pind].p;
+        size = factor_base[pind].size;
 
-                if (pos < B)
-                {
-                    (*pos) += size;
-                    pos += p - posn2[pind];
-                }
-                else { posn2[pind] = p - posn2[pind]; }
+        for (i = soln1[pind]; i < sieve_size; i += p)
+        {
+            b = i / BLOCK_SIZE;
+            bucket[b*QS_BUCKET_SIZE + bucket_len[b]++] = i + (size << 24);
+        }
 
-                posn1[pind] = (pos - sieve);
-            }
-            else { posn1[pind] = (pos - sieve); }
+        for (i = soln2[pind]; i < sieve_size; i += p)
+        {
+            b = i / BLOCK_SIZE;
+            bucket[b*QS_BUCKET_SIZE + bucket_len[b]++] = i + (size << 24);
         }
+
+        count++;
     }
+
+    qsieve_empty_buckets(sieve, poly, num_blocks);
 }
 
 /* check position 'i' in sieve array for smoothness */
@@ -241,7 +310,7 @@ void qsieve_do_sieving2(qs_t qs_inf, unsigned char * sieve, qs_poly_t poly)
 slong qsieve_evaluate_candidate(qs_t qs_inf, ulong i, unsigned char * sieve, qs_poly_t poly)
 {
    slong bits, exp, extra_bits;
-   mp_limb_t modp, prime;
+   mp_limb_t modp, prime, prime2;
    slong num_primes = qs_inf->num_primes;
    prime_t * factor_base = qs_inf->factor_base;
    slong * small = poly->small;
@@ -283,6 +352,8 @@ slong qsieve_evaluate_candidate(qs_t qs_inf, ulong i, unsigned char * sieve, qs_
    sieve[i] -= qs_inf->sieve_fill;
    bits = FLINT_ABS(fmpz_bits(res));
    bits -= BITS_ADJUST;
+   if (qs_inf->dlp)
+      bits -= qs_inf->dlp_bits; /* allow for two large primes */
    extra_bits = 0;
 
    if (factor_base[0].p != 1) /* divide out powers of the multiplier */
@@ -398,12 +469,7 @@ slong qsieve_evaluate_candidate(qs_t qs_inf, ulong i, unsigned char * sieve, qs_
 
          poly->num_factors = num_factors;
 
-#pragma omp critical
-         {
-            qsieve_write_to_file(qs_inf, 1, Y, poly);
-         
-            qs_inf->full_relation++;
-         }
+         qsieve_buffer_relation(qs_inf, 1, 1, Y, poly);
          relations++;
 
 #if 0
@@ -440,11 +506,25 @@ slong qsieve_evaluate_candidate(qs_t qs_inf, ulong i, unsigned char * sieve, qs_
           } else
               small[2] = 0;
 
+          prime = 0;
+          prime2 = 1;
+
           if (fmpz_bits(res) <= 30)
           {
               prime = fmpz_get_ui(res);
-              
-              if (prime < 60 * factor_base[qs_inf->num_primes - 1].p && n_gcd(prime, qs_inf->k) == 1)
+
+              if (prime >= (qs_inf->dlp ? qs_inf->dlp_mult : 60)
+                                     * factor_base[qs_inf->num_primes - 1].p)
+                  prime = 0;
+          }
+
+          /* otherwise the cofactor may split into two large primes */
+          if (prime == 0 && qs_inf->dlp && fmpz_abs_fits_ui(res))
+              prime = qsieve_split_cofactor(&prime2, qs_inf, fmpz_get_ui(res));
+
+          if (prime != 0)
+          {
+              if (n_gcd(prime, qs_inf->k) == 1 && n_gcd(prime2, qs_inf->k) == 1)
               {
                   for (k = 0; k < qs_inf->s; k++)  /* commit any outstanding A factor */
                   {
@@ -460,16 +540,8 @@ slong qsieve_evaluate_candidate(qs_t qs_inf, ulong i, unsigned char * sieve, qs_
 
                   poly->num_factors = num_factors;
 
-#pragma omp critical
-                  {
-                     /* store this partial in file */
-
-                     qsieve_write_to_file(qs_inf, prime, Y, poly);
-
-                     qs_inf->edges++;
-
-                     qsieve_add_to_hashtable(qs_inf, prime);
-                  }
+                  /* store this partial */
+                  qsieve_buffer_relation(qs_inf, prime, prime2, Y, poly);
               }
           }
       }
@@ -487,6 +559,73 @@ cleanup:
    return relations;
 }
 
+/*
+   On x86-64 the sieve is scanned 64 bytes at a time with AVX2 if the CPU
+   supports it. The function is compiled with a target attribute, so the
+   rest of FLINT does not need to be built for AVX2.
+*/
+
+#if FLINT_BITS == 64 && defined(__x86_64__) && defined(__GNUC__) \
+    && (__GNUC__ >= 5 || defined(__clang__))
+#define QS_HAVE_AVX2 1
+#else
+#define QS_HAVE_AVX2 0
+#endif
+
+#if QS_HAVE_AVX2
+
+#include <immintrin.h>
+
+static int _qsieve_have_avx2 = -1;
+
+__attribute__((target("avx2")))
+static slong qsieve_evaluate_sieve_avx2(qs_t qs_inf,
+                                     unsigned char * sieve, qs_poly_t poly)
+{
+    slong i, j;
+    slong sieve_size = qs_inf->sieve_size;
+    const __m256i thresh = _mm256_set1_epi8((char) (qs_inf->sieve_bits + 1));
+    slong rels = 0;
+
+    for (i = 0; i + 64 <= sieve_size; i += 64)
+    {
+        __m256i x0, x1, m;
+        uint64_t mask;
+
+        x0 = _mm256_loadu_si256((const __m256i *) (sieve + i));
+        x1 = _mm256_loadu_si256((const __m256i *) (sieve + i + 32));
+
+        /* entries > sieve_bits are those unchanged by a max with bits + 1 */
+        m = _mm256_max_epu8(x0, x1);
+        m = _mm256_cmpeq_epi8(_mm256_max_epu8(m, thresh), m);
+
+        if (_mm256_testz_si256(m, m))
+            continue;
+
+        mask = (uint32_t) _mm256_movemask_epi8(
+                        _mm256_cmpeq_epi8(_mm256_max_epu8(x0, thresh), x0));
+        mask |= ((uint64_t) (uint32_t) _mm256_movemask_epi8(
+                _mm256_cmpeq_epi8(_mm256_max_epu8(x1, thresh), x1))) << 32;
+
+        while (mask != 0)
+        {
+            j = __builtin_ctzll(mask);
+            rels += qsieve_evaluate_candidate(qs_inf, i + j, sieve, poly);
+            mask &= mask - 1;
+        }
+    }
+
+    for ( ; i < sieve_size; i++)
+    {
+        if (sieve[i] > qs_inf->sieve_bits)
+            rels += qsieve_evaluate_candidate(qs_inf, i, sieve, poly);
+    }
+
+    return rels;
+}
+
+#endif
+
 /* scan sieve array for possible candidate for smooth relations */
 
 slong qsieve_evaluate_sieve(qs_t qs_inf, unsigned char * sieve, qs_poly_t poly)
@@ -496,6 +635,17 @@ slong qsieve_evaluate_sieve(qs_t qs_inf, unsigned char * sieve, qs_poly_t poly)
     unsigned char bits = qs_inf->sieve_bits;
     slong rels = 0;
 
+#if QS_HAVE_AVX2
+    if (_qsieve_have_avx2 < 0)
+    {
+        __builtin_cpu_init();
+        _qsieve_have_avx2 = __builtin_cpu_supports("avx2");
+    }
+
+    if (_qsieve_have_avx2)
+        return qsieve_evaluate_sieve_avx2(qs_inf, sieve, poly);
+#endif
+
     while (j < qs_inf->sieve_size / sizeof(ulong))
     {
 #if FLINT64
@@ -525,45 +675,83 @@ slong qsieve_evaluate_sieve(qs_t qs_inf, unsigned char * sieve, qs_poly_t poly)
 
 /* procedure to call polynomial initialization and sieving procedure */
 
-slong qsieve_collect_relations(qs_t qs_inf, unsigned char * sieve)
+typedef struct
 {
-    slong relations = 0, rels, i, j = 0;
+    qs_s * qs_inf;
+    unsigned char * sieve;
+    qs_poly_s * poly;
+    slong rels;
+} _worker_arg_struct;
 
-    qsieve_init_poly_first(qs_inf);
+/*
+   Each thread sieves with its own sieve and poly data. The B values are
+   handed out one at a time, as each is obtained from the previous one by
+   the grey code formula, which is cheap compared to sieving with it.
+*/
+static void qsieve_collect_relations_worker(void * arg_ptr)
+{
+    _worker_arg_struct * arg = (_worker_arg_struct *) arg_ptr;
+    qs_s * qs_inf = arg->qs_inf;
+    unsigned char * sieve = arg->sieve;
+    qs_poly_s * poly = arg->poly;
+    slong j;
 
-#pragma omp parallel for
-    for (i = 0; i < (1 << qs_inf->s); i++)
+    while (1)
     {
-#if HAVE_OPENMP
-        unsigned char * thread_sieve = sieve + (qs_inf->sieve_size + sizeof(ulong) + 64)*omp_get_thread_num();
-        qs_poly_s * thread_poly = qs_inf->poly + omp_get_thread_num();
-#else
-        unsigned char * thread_sieve = sieve;
-        qs_poly_s * thread_poly = qs_inf->poly;
-#endif
+        pthread_mutex_lock(&qs_inf->mutex);
+
+        j = qs_inf->curr_poly;
 
-#pragma omp critical
+        if (j < (WORD(1) << qs_inf->s))
         {
-           if (j == 0)
-              qsieve_poly_copy(thread_poly, qs_inf);
-           else
-           {
-              qsieve_init_poly_next(qs_inf, j);
-              qsieve_poly_copy(thread_poly, qs_inf);
-           }
-           j++;
+            if (j != 0)
+                qsieve_init_poly_next(qs_inf, j);
+            qsieve_poly_copy(poly, qs_inf);
+            qs_inf->curr_poly++;
         }
 
+        pthread_mutex_unlock(&qs_inf->mutex);
+
+        if (j >= (WORD(1) << qs_inf->s))
+            break;
+
         if (qs_inf->sieve_size < 2*BLOCK_SIZE)
-           qsieve_do_sieving(qs_inf, thread_sieve, thread_poly);
+            qsieve_do_sieving(qs_inf, sieve, poly);
         else
-           qsieve_do_sieving2(qs_inf, thread_sieve, thread_poly);
+            qsieve_do_sieving2(qs_inf, sieve, poly);
 
-        rels = qsieve_evaluate_sieve(qs_inf, thread_sieve, thread_poly);
+        arg->rels += qsieve_evaluate_sieve(qs_inf, sieve, poly);
 
-#pragma omp atomic
-        relations += rels;
+        qsieve_flush_relations(qs_inf, poly);
     }
+}
+
+slong qsieve_collect_relations(qs_t qs_inf, unsigned char * sieve)
+{
+    slong i, relations = 0;
+    slong num_threads = qs_inf->num_threads;
+    _worker_arg_struct * args;
+
+    args = flint_malloc(num_threads*sizeof(_worker_arg_struct));
+
+    qsieve_init_poly_first(qs_inf);
+    qs_inf->curr_poly = 0;
+
+    for (i = 0; i < num_threads; i++)
+    {
+        args[i].qs_inf = qs_inf;
+        args[i].sieve = sieve + (qs_inf->sieve_size + sizeof(ulong) + 64)*i;
+        args[i].poly = qs_inf->poly + i;
+        args[i].rels = 0;
+    }
+
+    threadpool_parallel_do(qsieve_collect_relations_worker, args,
+                                      num_threads, sizeof(_worker_arg_struct));
+
+    for (i = 0; i < num_threads; i++)
+        relations += args[i].rels;
+
+    flint_free(args);
 
     return relations;
 }
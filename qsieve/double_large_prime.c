@@ -0,0 +1,442 @@
+/*
+    Copyright (C) 2019 William Hart
+
+    This file is part of FLINT.
+
+    FLINT is free software: you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.  See <http://www.gnu.org/licenses/>.
+*/
+
+#include "qsieve.h"
+
+/*
+   With the double large prime variation a partial may have two large
+   primes. The partials are the edges of a graph whose vertices are the
+   large primes and 1, a partial with a single large prime being an edge
+   to 1. The product of the partials along a cycle of the graph is a full
+   relation times the square of the product of the large primes on it.
+*/
+
+#define QS_SQUFOF_ITERS 2000 /* iterations of SQUFOF per multiplier */
+
+/*
+   if the cofactor of a relation is the product of two distinct primes
+   below the large prime bound, return the smaller and set prime2 to the
+   larger, otherwise return 0
+*/
+
+mp_limb_t qsieve_split_cofactor(mp_limb_t * prime2, qs_t qs_inf,
+                                                            mp_limb_t cofactor)
+{
+    mp_limb_t p, q, pmax, bound;
+
+    pmax = qs_inf->factor_base[qs_inf->num_primes - 1].p;
+    bound = FLINT_MIN(qs_inf->dlp_mult * pmax, UWORD(1) << 30);
+
+    /* a cofactor below pmax^2 has no factor in the factor base, so is prime */
+    if (cofactor / pmax < pmax || cofactor / bound >= bound
+                               || n_is_prime(cofactor))
+        return 0;
+
+    p = n_factor_SQUFOF(cofactor, QS_SQUFOF_ITERS);
+
+    if (p == 0)
+    {
+        flint_rand_t state;
+
+        flint_randinit(state);
+        if (!n_factor_pollard_brent(&p, state, cofactor, 3, 1 << 14))
+            p = 0;
+        flint_randclear(state);
+
+        if (p == 0)
+            return 0;
+    }
+
+    q = cofactor / p;
+
+    if (p > q)
+    {
+        mp_limb_t t = p;
+        p = q;
+        q = t;
+    }
+
+    if (p == q || q >= bound || !n_is_prime(p) || !n_is_prime(q))
+        return 0;
+
+    *prime2 = q;
+
+    return p;
+}
+
+/*
+   set c to the full relation which is the product of the len partials at
+   rels, forming a cycle in the graph of partials. The entries of exps,
+   one for each factor base prime, must be zero and are left zero.
+   Returns 1 on success and 0 if c would have too many factors. If a large
+   prime divides kn it is put in qs_inf->small_factor and -1 is returned.
+   Unless 1 is returned, c is not initialised.
+*/
+
+int qsieve_combine_cycle(relation_t * c, qs_t qs_inf, relation_t ** rels,
+                                                      slong len, slong * exps)
+{
+    slong i, j, k, num = 0;
+    relation_t * r;
+    fmpz_t L;
+
+    c->lp = UWORD(1);
+    c->lp2 = UWORD(1);
+    c->small_primes = qs_inf->small_primes;
+    c->small = flint_calloc(qs_inf->small_primes, sizeof(slong));
+    c->factor = flint_malloc(qs_inf->max_factors*sizeof(fac_t));
+    fmpz_init_set_ui(c->Y, 1);
+    fmpz_init_set_ui(L, 1);
+
+    for (i = 0; i < len; i++)
+    {
+        r = rels[i];
+
+        for (j = 0; j < qs_inf->small_primes; j++)
+            c->small[j] += r->small[j];
+
+        for (j = 0; j < r->num_factors; j++)
+            exps[r->factor[j].ind] += r->factor[j].exp;
+
+        fmpz_mul(c->Y, c->Y, r->Y);
+        fmpz_mod(c->Y, c->Y, qs_inf->kn);
+
+        fmpz_mul_ui(L, L, r->lp);
+        fmpz_mul_ui(L, L, r->lp2);
+    }
+
+    /* collect the factors, clearing exps as we go */
+    for (i = 0; i < len; i++)
+    {
+        r = rels[i];
+
+        for (j = 0; j < r->num_factors; j++)
+        {
+            k = r->factor[j].ind;
+
+            if (exps[k] != 0)
+            {
+                if (num < qs_inf->max_factors)
+                {
+                    c->factor[num].ind = k;
+                    c->factor[num].exp = exps[k];
+                }
+
+                num++;
+                exps[k] = 0;
+            }
+        }
+    }
+
+    c->num_factors = num;
+
+    if (num + qs_inf->small_primes >= qs_inf->max_factors)
+    {
+        num = 0;
+        goto cleanup;
+    }
+
+    /* each large prime occurs twice, so L is a square */
+    fmpz_sqrt(L, L);
+
+    if (fmpz_invmod(L, L, qs_inf->kn) == 0)
+    {
+        for (i = 0; i < len; i++)
+        {
+            if (fmpz_fdiv_ui(qs_inf->kn, rels[i]->lp) == 0)
+                qs_inf->small_factor = rels[i]->lp;
+            else if (fmpz_fdiv_ui(qs_inf->kn, rels[i]->lp2) == 0)
+                qs_inf->small_factor = rels[i]->lp2;
+        }
+
+        num = -1;
+        goto cleanup;
+    }
+
+    fmpz_mul(c->Y, c->Y, L);
+    fmpz_mod(c->Y, c->Y, qs_inf->kn);
+
+    fmpz_clear(L);
+
+    return 1;
+
+cleanup:
+
+    flint_free(c->small);
+    flint_free(c->factor);
+    fmpz_clear(c->Y);
+    fmpz_clear(L);
+
+    return num == -1 ? -1 : 0;
+}
+
+static void _qsieve_relation_clear(relation_t * rel)
+{
+    flint_free(rel->small);
+    flint_free(rel->factor);
+    fmpz_clear(rel->Y);
+}
+
+/* index of prime in the sorted array of vertices */
+
+static slong _qsieve_vertex(const mp_limb_t * verts, slong num, mp_limb_t prime)
+{
+    slong lo = 0, hi = num - 1, mid;
+
+    while (lo < hi)
+    {
+        mid = (lo + hi)/2;
+
+        if (verts[mid] < prime)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return lo;
+}
+
+static int _qsieve_limb_cmp(const void * a, const void * b)
+{
+    mp_limb_t x = *((const mp_limb_t *) a);
+    mp_limb_t y = *((const mp_limb_t *) b);
+
+    return (x > y) - (x < y);
+}
+
+/*
+   process relations from the relation store when partials may have two
+   large primes: find a spanning forest of the graph of partials by
+   breadth first search and combine the partials along the cycle closed
+   by each edge not in it
+*/
+
+int qsieve_process_relation_dlp(qs_t qs_inf)
+{
+    slong i, j, e, u, v, len, num_relations = 0, num_full, num_partials;
+    slong num_verts, num_rels, target;
+    slong rel_size = 50000;
+    mp_limb_t off;
+    hash_t * entry;
+    relation_t * rel_list = flint_malloc(rel_size*sizeof(relation_t));
+    relation_t * rlist, * partials, ** cycle;
+    mp_limb_t * verts;
+    slong * eu, * ev, * adj, * start, * depth, * pedge, * queue, * exps;
+    int done = 0;
+
+    /*
+       the full relations, then the partials whose large primes all occur
+       at least twice, as others are not on a cycle
+    */
+    for (i = 0; i <= qs_inf->vertices; i++)
+    {
+        if (i == 0)
+            off = qs_inf->full_last;
+        else
+        {
+            entry = qs_inf->table + i;
+            off = entry->count >= 2 ? entry->last : 0;
+        }
+
+        while (off != 0)
+        {
+            relation_t * rel;
+
+            if (num_relations == rel_size)
+            {
+                rel_list = flint_realloc(rel_list,
+                                              2*rel_size*sizeof(relation_t));
+                rel_size *= 2;
+            }
+
+            rel = rel_list + num_relations;
+            off = qsieve_get_relation(rel, qs_inf, off - 1);
+
+            if (rel->lp2 != UWORD(1) &&
+                qsieve_get_table_entry(qs_inf, rel->lp2)->count < 2)
+                _qsieve_relation_clear(rel);
+            else
+                num_relations++;
+        }
+    }
+
+    num_relations = qsieve_remove_duplicates(rel_list, num_relations);
+
+    /* the full relations come first */
+    for (num_full = 0; num_full < num_relations
+                        && rel_list[num_full].lp == UWORD(1); num_full++) ;
+
+    partials = rel_list + num_full;
+    num_partials = num_relations - num_full;
+
+    target = qs_inf->num_primes + qs_inf->ks_primes + qs_inf->extra_rels;
+
+    /* full relations are moved to rlist */
+    rlist = flint_malloc((num_full + target)*sizeof(relation_t));
+    for (num_rels = 0; num_rels < num_full; num_rels++)
+        rlist[num_rels] = rel_list[num_rels];
+
+    /* the vertices of the graph, with an edge for each partial */
+    verts = flint_malloc((2*num_partials + 1)*sizeof(mp_limb_t));
+
+    for (i = 0; i < num_partials; i++)
+    {
+        verts[2*i] = partials[i].lp;
+        verts[2*i + 1] = partials[i].lp2;
+    }
+
+    qsort(verts, 2*num_partials, sizeof(mp_limb_t), _qsieve_limb_cmp);
+
+    for (i = 0, num_verts = 0; i < 2*num_partials; i++)
+    {
+        if (num_verts == 0 || verts[i] != verts[num_verts - 1])
+            verts[num_verts++] = verts[i];
+    }
+
+    eu = flint_malloc((2*num_partials + 1)*sizeof(slong));
+    ev = eu + num_partials;
+    adj = flint_malloc((2*num_partials + 1)*sizeof(slong));
+    start = flint_calloc(num_verts + 1, sizeof(slong));
+    depth = flint_malloc((3*num_verts + 1)*sizeof(slong));
+    pedge = depth + num_verts;
+    queue = pedge + num_verts;
+    cycle = flint_malloc((num_verts + 1)*sizeof(relation_t *));
+    exps = flint_calloc(qs_inf->num_primes + qs_inf->ks_primes, sizeof(slong));
+
+    /* adjacency lists, as the partials meeting each vertex */
+    for (i = 0; i < num_partials; i++)
+    {
+        eu[i] = _qsieve_vertex(verts, num_verts, partials[i].lp);
+        ev[i] = _qsieve_vertex(verts, num_verts, partials[i].lp2);
+        start[eu[i] + 1]++;
+        start[ev[i] + 1]++;
+    }
+
+    for (i = 0; i < num_verts; i++)
+        start[i + 1] += start[i];
+
+    for (i = 0; i < num_partials; i++)
+    {
+        adj[start[eu[i]]++] = i;
+        adj[start[ev[i]]++] = i;
+    }
+
+    for (i = num_verts; i > 0; i--)
+        start[i] = start[i - 1];
+    start[0] = 0;
+
+    /* breadth first search, pedge is the edge to the parent of a vertex */
+    for (i = 0; i < num_verts; i++)
+        depth[i] = -1;
+
+    for (i = 0; i < num_verts; i++)
+    {
+        slong head = 0, tail = 0;
+
+        if (depth[i] != -1)
+            continue;
+
+        depth[i] = 0;
+        pedge[i] = -1;
+        queue[tail++] = i;
+
+        while (head < tail)
+        {
+            u = queue[head++];
+
+            for (j = start[u]; j < start[u + 1]; j++)
+            {
+                e = adj[j];
+                v = (eu[e] == u) ? ev[e] : eu[e];
+
+                if (depth[v] == -1)
+                {
+                    depth[v] = depth[u] + 1;
+                    pedge[v] = e;
+                    queue[tail++] = v;
+                }
+            }
+        }
+    }
+
+    /* each edge not in the forest closes a cycle through the forest */
+    for (e = 0; e < num_partials && num_rels < target; e++)
+    {
+        int res;
+
+        u = eu[e];
+        v = ev[e];
+
+        if (pedge[u] == e || pedge[v] == e)
+            continue;
+
+        cycle[0] = partials + e;
+        len = 1;
+
+        while (u != v)
+        {
+            if (depth[u] >= depth[v])
+            {
+                cycle[len++] = partials + pedge[u];
+                u = (eu[pedge[u]] == u) ? ev[pedge[u]] : eu[pedge[u]];
+            }
+            else
+            {
+                cycle[len++] = partials + pedge[v];
+                v = (eu[pedge[v]] == v) ? ev[pedge[v]] : eu[pedge[v]];
+            }
+        }
+
+        res = qsieve_combine_cycle(rlist + num_rels, qs_inf, cycle, len, exps);
+
+        if (res == -1)
+        {
+            done = -1;
+            goto cleanup;
+        }
+
+        num_rels += res;
+    }
+
+    if (num_rels < target)
+    {
+        qs_inf->edges -= 100;
+        done = 0;
+    }
+    else
+    {
+        done = 1;
+        qsort(rlist, (size_t) target, sizeof(relation_t),
+                                                     qsieve_compare_relation);
+        qsieve_insert_relation2(qs_inf, rlist, target);
+    }
+
+cleanup:
+
+    /* full relations are freed with rlist */
+    for (i = 0; i < num_partials; i++)
+        _qsieve_relation_clear(partials + i);
+
+    for (i = 0; i < num_rels; i++)
+        _qsieve_relation_clear(rlist + i);
+
+    flint_free(rel_list);
+    flint_free(rlist);
+    flint_free(verts);
+    flint_free(eu);
+    flint_free(adj);
+    flint_free(start);
+    flint_free(depth);
+    flint_free(cycle);
+    flint_free(exps);
+
+    return done;
+}
@@ -28,9 +28,17 @@ int compare_facs(const void * a, const void * b)
 /*
    Returns a factor of n.
    Assumes n is not prime and not a perfect power.
+
+   Relations are spilled to the file spill if it is not NULL. If ckpt is
+   not NULL the state is saved there every QS_CHECKPOINT_INTERVAL seconds,
+   and sieving continues from it if it holds a checkpoint for n. Returns
+   0 if sieving stopped after max_polys polynomials, with the state saved
+   to ckpt, or because the effort was exhausted, otherwise 1.
 */
 
-void qsieve_factor(fmpz_factor_t factors, const fmpz_t n)
+static int _qsieve_factor(fmpz_factor_t factors, const fmpz_t n,
+                   const char * spill, const char * ckpt, slong max_polys,
+                   fmpz_factor_effort_struct * effort)
 {
     qs_t qs_inf;
     mp_limb_t small_factor, delta;
@@ -43,6 +51,9 @@ void qsieve_factor(fmpz_factor_t factors, const fmpz_t n)
     fmpz_t temp, X, Y;
     slong num_facs;
     fmpz * facs;
+    slong polys = 0;
+    int resumed = 0, result = 1;
+    time_t last_save = time(NULL);
 
     if (fmpz_sgn(n) < 0)
     {
@@ -53,11 +64,15 @@ void qsieve_factor(fmpz_factor_t factors, const fmpz_t n)
 
        factors->sign *= -1;
        
-       qsieve_factor(factors, n2);
+       i = _qsieve_factor(factors, n2, spill, ckpt, max_polys, effort);
 
        fmpz_clear(n2);
-       
-       return;
+
+       /* the sign is set again on resume */
+       if (i == 0)
+          factors->sign *= -1;
+
+       return i;
     }
 
     fmpz_init(temp);
@@ -72,6 +87,7 @@ void qsieve_factor(fmpz_factor_t factors, const fmpz_t n)
 #endif
 
     qsieve_init(qs_inf, n);
+    qs_inf->spill_path = spill;
 
 #if QS_DEBUG
     flint_printf("factoring ");
@@ -114,7 +130,7 @@ void qsieve_factor(fmpz_factor_t factors, const fmpz_t n)
 
         fmpz_clear(temp);
         
-        return;
+        return 1;
     }
 
     /* compute kn */
@@ -160,7 +176,7 @@ void qsieve_factor(fmpz_factor_t factors, const fmpz_t n)
 
         fmpz_clear(temp);
 
-        return;
+        return 1;
     }
 
     fmpz_init(X);
@@ -186,15 +202,10 @@ void qsieve_factor(fmpz_factor_t factors, const fmpz_t n)
     flint_printf("\nPolynomial Initialisation and Sieving\n");
 #endif
 
-#if HAVE_OPENMP
-    /* ensure cache lines don't overlap */
-    sieve = flint_malloc((qs_inf->sieve_size + sizeof(ulong) + 64)*omp_get_max_threads());
-#else
-    sieve = flint_malloc(qs_inf->sieve_size + sizeof(ulong));
-#endif
+    /* one sieve per thread, ensure cache lines don't overlap */
+    sieve = flint_malloc((qs_inf->sieve_size + sizeof(ulong) + 64)*qs_inf->num_threads);
 
     qs_inf->q_idx = qs_inf->num_primes;
-    qs_inf->siqs = fopen("siqs.dat", "w");
 
     for (j = qs_inf->small_primes; j < qs_inf->num_primes; j++)
     {
@@ -208,9 +219,14 @@ void qsieve_factor(fmpz_factor_t factors, const fmpz_t n)
     flint_printf("second prime index = %wd\n", qs_inf->second_prime);
 #endif
 
+    if (ckpt != NULL)
+        resumed = qsieve_load_state(qs_inf, ckpt);
+
     while (1)
     {
-        if (qs_inf->s)
+        if (resumed)
+            ; /* continue with the A0 in the checkpoint */
+        else if (qs_inf->s)
             qsieve_re_init_A0(qs_inf);
         else
         {
@@ -221,14 +237,23 @@ void qsieve_factor(fmpz_factor_t factors, const fmpz_t n)
         do
         {
             qsieve_compute_pre_data(qs_inf);
-            
-            for (j = qs_inf->num_primes; j < qs_inf->num_primes + qs_inf->ks_primes; j++)
+
+            /* after a checkpoint, continue with the next value of q0 */
+            j = resumed ? qs_inf->q_idx + 1 : qs_inf->num_primes;
+            resumed = 0;
+
+            for ( ; j < qs_inf->num_primes + qs_inf->ks_primes; j++)
             {
 #if QS_DEBUG
                 printf("j = %ld, num_primes + ks_primes = %ld\n", j, qs_inf->num_primes + qs_inf->ks_primes);
 #endif
                 qs_inf->q_idx  = j;
                 relation += qsieve_collect_relations(qs_inf, sieve);
+                polys += WORD(1) << qs_inf->s;
+
+                /* sieving 64 bytes costs about a multiplication modulo n */
+                fmpz_factor_effort_charge(effort,
+                           (WORD(1) << qs_inf->s)*(qs_inf->sieve_size/64));
                 
                 qs_inf->num_cycles = qs_inf->edges + qs_inf->components - qs_inf->vertices;
 
@@ -244,9 +269,10 @@ void qsieve_factor(fmpz_factor_t factors, const fmpz_t n)
                 {
                     int ok;
 
-                    fclose(qs_inf->siqs);
-
-                    ok = qsieve_process_relation(qs_inf);
+                    if (qs_inf->dlp)
+                        ok = qsieve_process_relation_dlp(qs_inf);
+                    else
+                        ok = qsieve_process_relation(qs_inf);
 
                     if (ok == -1)
                     {
@@ -364,11 +390,39 @@ void qsieve_factor(fmpz_factor_t factors, const fmpz_t n)
 
                        _fmpz_vec_clear(facs, 100);
 
-                       qs_inf->siqs = fopen("siqs.dat", "w");
                        qs_inf->num_primes = num_primes; /* linear algebra adjusts this */
                        goto more_primes; /* need more primes */
                     }
                 }
+
+                if (ckpt != NULL)
+                {
+                    int stop = (max_polys > 0 && polys >= max_polys);
+
+                    if (stop || difftime(time(NULL), last_save) >= QS_CHECKPOINT_INTERVAL)
+                    {
+                        if (!qsieve_save_state(qs_inf, ckpt))
+                        {
+                            flint_printf("Exception (qsieve_factor). Unable to write "
+                                                              "checkpoint to %s.\n", ckpt);
+                            flint_abort();
+                        }
+
+                        last_save = time(NULL);
+                    }
+
+                    if (stop)
+                    {
+                        result = 0;
+                        goto cleanup;
+                    }
+                }
+
+                if (fmpz_factor_effort_exhausted(effort))
+                {
+                    result = 0;
+                    goto cleanup;
+                }
             }
         } while (qsieve_next_A0(qs_inf));
 
@@ -446,8 +500,53 @@ cleanup:
     qsieve_clear(qs_inf);
     qsieve_linalg_clear(qs_inf);
     qsieve_poly_clear(qs_inf);
-    remove("siqs.dat");
     fmpz_clear(X);
     fmpz_clear(Y);
     fmpz_clear(temp);
+
+    return result;
+}
+
+void qsieve_factor(fmpz_factor_t factors, const fmpz_t n)
+{
+    _qsieve_factor(factors, n, NULL, NULL, 0, NULL);
+}
+
+int qsieve_factor_effort(fmpz_factor_t factors, const fmpz_t n,
+                                               fmpz_factor_effort_t effort)
+{
+    return _qsieve_factor(factors, n, NULL, NULL, 0, effort);
+}
+
+void qsieve_factor_spill(fmpz_factor_t factors,
+                                       const fmpz_t n, const char * path)
+{
+    _qsieve_factor(factors, n, path, NULL, 0, NULL);
+}
+
+int qsieve_factor_checkpoint(fmpz_factor_t factors,
+                        const fmpz_t n, const char * path, slong max_polys)
+{
+    int done = _qsieve_factor(factors, n, NULL, path, max_polys, NULL);
+
+    if (done)
+        remove(path);
+
+    return done;
+}
+
+int qsieve_factor_resume(fmpz_factor_t factors,
+                                         const char * path, slong max_polys)
+{
+    fmpz_t n;
+    int done = -1;
+
+    fmpz_init(n);
+
+    if (qsieve_read_state_n(n, path))
+        done = qsieve_factor_checkpoint(factors, n, path, max_polys);
+
+    fmpz_clear(n);
+
+    return done;
 }
@@ -31,6 +31,12 @@ void qsieve_init(qs_t qs_inf, const fmpz_t n)
     i--;
 
     qs_inf->ks_primes = qsieve_tune[i][1]; /* number of Knuth-Schroeppel primes */
+
+    /* whether to use the double large prime variation */
+    qs_inf->dlp = (qs_inf->bits >= FLINT_CUTOFF(QSIEVE_DLP_BITS));
+    qs_inf->dlp_mult = qsieve_tune[i][6];
+    qs_inf->dlp_bits = qsieve_tune[i][7];
+
     qs_inf->num_primes  = 0;
     qs_inf->num_relations = 0;
     qs_inf->full_relation = 0;
@@ -50,4 +56,10 @@ void qsieve_init(qs_t qs_inf, const fmpz_t n)
     qs_inf->sqrts       = NULL;
 
     qs_inf->s = 0;
+
+    qs_inf->spill_path = NULL;
+
+    /* relations are collected on this many threads */
+    qs_inf->num_threads = flint_get_num_threads();
+    pthread_mutex_init(&qs_inf->mutex, NULL);
 }
@@ -10,7 +10,6 @@
     (at your option) any later version.  See <http://www.gnu.org/licenses/>.
 */
 
-#include <ctype.h>
 #include "qsieve.h"
 
 #define HASH_MULT (2654435761U)       /* hash function, taken from 'msieve' */
@@ -24,6 +23,9 @@ void qsieve_display_relation(qs_t qs_inf, relation_t a)
 
     flint_printf("%wu ", a.lp);
 
+    if (a.lp2 != UWORD(1))
+        flint_printf("%wu ", a.lp2);
+
     for (i = 0; i < qs_inf->small_primes; i++)
         flint_printf("%wd ", a.small[i]);
 
@@ -65,6 +67,7 @@ int qsieve_is_relation(qs_t qs_inf, relation_t a)
     }
 
     fmpz_mul_ui(temp2, temp2, a.lp);
+    fmpz_mul_ui(temp2, temp2, a.lp2);
     fmpz_pow_ui(temp, a.Y, UWORD(2));
     fmpz_mod(temp, temp, qs_inf->kn);
     fmpz_mod(temp2, temp2, qs_inf->kn);
@@ -80,31 +83,6 @@ int qsieve_is_relation(qs_t qs_inf, relation_t a)
     return 1;
 }
 
-/* write partial or full relation to file */
-void qsieve_write_to_file(qs_t qs_inf, mp_limb_t prime, fmpz_t Y, qs_poly_t poly)
-{
-    slong i;
-    char * str = NULL;
-    slong num_factors = poly->num_factors;
-    slong * small = poly->small;
-    fac_t * factor = poly->factor;
-
-    flint_fprintf(qs_inf->siqs, "%X ", prime);  /* write large prime */
-
-    for (i = 0; i < qs_inf->small_primes; i++)   /* write small primes */
-        flint_fprintf(qs_inf->siqs, "%X ", small[i]);
-
-    flint_fprintf(qs_inf->siqs, "%X ", num_factors);  /* write number of factors */
-
-    for (i = 0; i < num_factors; i++)               /* write factor along with exponent */
-        flint_fprintf(qs_inf->siqs, "%wx %X ", factor[i].ind, factor[i].exp);
-
-    str = fmpz_get_str(str, 16, Y);    /* converting value of 'Y'  to hex */
-
-    flint_fprintf(qs_inf->siqs, "%s\n", str);   /* write value of 'Y' */
-    flint_free(str);
-}
-
 /*********************************************************
     main function starts here
 **********************************************************/
@@ -154,7 +132,10 @@ hash_t * qsieve_get_table_entry(qs_t qs_inf, mp_limb_t prime)
         entry->prime = prime;
         entry->next = hash_table[first_offset];
         entry->count = 0;
+        entry->last = 0;
+        entry->parent = qs_inf->vertices;
         hash_table[first_offset] = qs_inf->vertices;
+        qs_inf->components++;
     }
     
     return entry;
@@ -173,59 +154,50 @@ void qsieve_add_to_hashtable(qs_t qs_inf, mp_limb_t prime)
     entry->count++;
 }
 
-/*
-   given a string representing a relation, parse it to
-   obtain relation
-*/
+/* root of the tree containing the entry at offset i of the table */
 
-relation_t qsieve_parse_relation(qs_t qs_inf, char * str)
+static mp_limb_t _qsieve_find_root(hash_t * table, mp_limb_t i)
 {
-    slong i;
-    char * next;
-    relation_t rel;
-
-    rel.lp = UWORD(1);
-    rel.small = flint_malloc(qs_inf->small_primes * sizeof(slong));
-    rel.factor = flint_malloc(qs_inf->max_factors * sizeof(fac_t));
-
-    for (i = 0; i < qs_inf->small_primes; i++)
+    while (table[i].parent != i)
     {
-        while (isspace(*str))
-            str++;
-
-        rel.small[i] = strtoul(str, &next, 16);
-        str = next;
+        table[i].parent = table[table[i].parent].parent; /* path halving */
+        i = table[i].parent;
     }
 
-    while (isspace(*str))
-        str++;
-
-    rel.num_factors = strtoul(str, &next, 16);
-    rel.small_primes = qs_inf->small_primes;
-    str = next;
+    return i;
+}
 
-    for (i = 0; i < rel.num_factors; i++)
-    {
-        while (isspace(*str))
-            str++;
+/*
+   add the edge between 'prime' and 'prime2' (which is 1 unless the partial
+   has two large primes) to the graph of partials, keeping track of its
+   connected components so that the number of independent cycles is
+   edges + components - vertices
+*/
 
-        rel.factor[i].ind = strtoul(str, &next, 16);
-        str = next;
+void qsieve_add_edge(qs_t qs_inf, mp_limb_t prime, mp_limb_t prime2)
+{
+    mp_limb_t i, j;
+    hash_t * entry;
 
-        while (isspace(*str))
-            str++;
+    /* the table may move when an entry is added */
+    entry = qsieve_get_table_entry(qs_inf, prime);
+    entry->count++;
+    i = entry - qs_inf->table;
 
-        rel.factor[i].exp = strtoul(str, &next, 16);
-        str = next;
-    }
+    entry = qsieve_get_table_entry(qs_inf, prime2);
+    entry->count++;
+    j = entry - qs_inf->table;
 
-    while (isspace(*str))
-        str++;
+    i = _qsieve_find_root(qs_inf->table, i);
+    j = _qsieve_find_root(qs_inf->table, j);
 
-    fmpz_init(rel.Y);
-    fmpz_set_str(rel.Y, str, 16);
+    if (i != j)
+    {
+        qs_inf->table[i].parent = j;
+        qs_inf->components--;
+    }
 
-    return rel;
+    qs_inf->edges++;
 }
 
 /*
@@ -240,6 +212,7 @@ relation_t qsieve_merge_relation(qs_t qs_inf, relation_t a, relation_t b)
     fmpz_t temp;
 
     c.lp = UWORD(1);
+    c.lp2 = UWORD(1);
     c.small = flint_malloc(qs_inf->small_primes * sizeof(slong));
     c.factor = flint_malloc(qs_inf->max_factors * sizeof(fac_t));
     fmpz_init(c.Y);
@@ -320,7 +293,7 @@ relation_t qsieve_merge_relation(qs_t qs_inf, relation_t a, relation_t b)
 
 /*
    compare two relations in the following order,
-   large_prime, number of factors, factor, small_prime
+   large_prime, second large prime, number of factors, factor, small_prime
 */
 
 int qsieve_compare_relation(const void * a, const void * b)
@@ -335,6 +308,12 @@ int qsieve_compare_relation(const void * a, const void * b)
     if (r1->lp < r2->lp)
         return -1;
 
+    if (r1->lp2 > r2->lp2)
+        return 1;
+
+    if (r1->lp2 < r2->lp2)
+        return -1;
+
     if (r1->num_factors > r2->num_factors)
         return 1;
 
@@ -460,49 +439,50 @@ void qsieve_insert_relation2(qs_t qs_inf, relation_t * rel_list, slong num_relat
 }
 
 /*
-   process relations from the file
+   process relations from the relation store
 */
 
 int qsieve_process_relation(qs_t qs_inf)
 {
-    char buf[1024];
-    char * str;
-    slong i, j, num_relations = 0, num_relations2, full = 0;
-    mp_limb_t prime;
+    slong i, j, first, num_relations = 0, num_relations2, full = 0;
+    mp_limb_t off;
     hash_t * entry;
-    mp_limb_t * hash_table = qs_inf->hash_table;
     slong rel_size = 50000;
     relation_t * rel_list = (relation_t *) flint_malloc(rel_size * sizeof(relation_t));
-    relation_t * rlist;
+    relation_t * rlist = NULL;
     int done = 0;
-  
-    qs_inf->siqs = fopen("siqs.dat", "r");
 
 #if QS_DEBUG & 64
     printf("Getting relations\n");
 #endif
 
-    while (fgets(buf, sizeof(buf), qs_inf->siqs) != NULL)
+    /*
+       the full relations, then the partials whose large prime occurs at
+       least twice, found by following the links from the hash table
+    */
+    for (i = 0; i <= qs_inf->vertices; i++)
     {
-        prime = strtoul(buf, &str, 16);
-        entry = qsieve_get_table_entry(qs_inf, prime);
-
-        if (num_relations == rel_size)
+        if (i == 0)
+            off = qs_inf->full_last;
+        else
         {
-           rel_list = (relation_t *) flint_realloc(rel_list, 2*rel_size * sizeof(relation_t));
-           rel_size *= 2;
+            entry = qs_inf->table + i;
+            off = entry->count >= 2 ? entry->last : 0;
         }
-        
-        if (prime == 1 || entry->count >= 2)
+
+        while (off != 0)
         {
-            rel_list[num_relations] = qsieve_parse_relation(qs_inf, str);
-            rel_list[num_relations].lp = prime;
+            if (num_relations == rel_size)
+            {
+               rel_list = (relation_t *) flint_realloc(rel_list, 2*rel_size * sizeof(relation_t));
+               rel_size *= 2;
+            }
+
+            off = qsieve_get_relation(rel_list + num_relations, qs_inf, off - 1);
             num_relations++;
         }
     }
 
-    fclose(qs_inf->siqs);
-
 #if QS_DEBUG & 64
     printf("Removing duplicates\n");
 #endif
@@ -514,9 +494,8 @@ int qsieve_process_relation(qs_t qs_inf)
 #endif
 
     rlist = flint_malloc(num_relations * sizeof(relation_t));
-    memset(hash_table, 0, (1 << 25) * sizeof(mp_limb_t));
-    qs_inf->vertices = 0;
 
+    /* full relations are moved to rlist */
     for (i = 0, j = 0; i < num_relations; i++)
     {
         if (rel_list[i].lp == UWORD(1))
@@ -524,27 +503,33 @@ int qsieve_process_relation(qs_t qs_inf)
             rlist[j++] = rel_list[i];
             full++;
         }
+    }
+
+    /*
+       partials are sorted by large prime, merge each with the first with
+       the same large prime
+    */
+    for (i = 0, first = 0; i < num_relations; i++)
+    {
+        if (rel_list[i].lp == UWORD(1))
+            continue;
+
+        if (i == 0 || rel_list[i].lp != rel_list[i - 1].lp)
+            first = i;
         else
         {
-            entry = qsieve_get_table_entry(qs_inf, rel_list[i].lp);
-
-            if (entry->count == 0) entry->count = i;
-            else
+            if (fmpz_fdiv_ui(qs_inf->kn, rel_list[i].lp) == 0)
             {
-                if (fmpz_fdiv_ui(qs_inf->kn, rel_list[i].lp) == 0)
-                {
-                   qs_inf->small_factor = rel_list[i].lp;
-                   
-                   done = -1;
-                   goto cleanup;
-                }
-                rlist[j++] = qsieve_merge_relation(qs_inf, rel_list[i], rel_list[entry->count]);
+               qs_inf->small_factor = rel_list[i].lp;
+
+               done = -1;
+               goto cleanup;
             }
+
+            rlist[j++] = qsieve_merge_relation(qs_inf, rel_list[i], rel_list[first]);
         }
     }
 
-    num_relations = j;
-
 #if QS_DEBUG & 64
     printf("Sorting relations\n");
 #endif
@@ -553,7 +538,6 @@ int qsieve_process_relation(qs_t qs_inf)
     {
        qs_inf->edges -= 100;
        done = 0;
-       qs_inf->siqs = fopen("siqs.dat", "a");
     } else
     {
        done = 1;
@@ -564,14 +548,26 @@ int qsieve_process_relation(qs_t qs_inf)
 
 cleanup:
 
+    /* full relations are freed with rlist */
     for (i = 0; i < num_relations; i++)
     {
-       flint_free(rel_list[i].small);
-       flint_free(rel_list[i].factor);
+       if (rel_list[i].lp != UWORD(1))
+       {
+          flint_free(rel_list[i].small);
+          flint_free(rel_list[i].factor);
+          fmpz_clear(rel_list[i].Y);
+       }
     }
+
+    for (i = 0; i < j; i++)
+    {
+       flint_free(rlist[i].small);
+       flint_free(rlist[i].factor);
+       fmpz_clear(rlist[i].Y);
+    }
+
     flint_free(rel_list);
     flint_free(rlist);
 
     return done;
 }
-
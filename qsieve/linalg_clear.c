@@ -42,6 +42,8 @@ void qsieve_linalg_clear(qs_t qs_inf)
 
     flint_free(qs_inf->prime_count);
 
+    qsieve_store_clear(qs_inf);
+
     qs_inf->relation = NULL;
     qs_inf->matrix = NULL;
     qs_inf->Y_arr = NULL;
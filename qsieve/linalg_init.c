@@ -19,6 +19,10 @@ void qsieve_linalg_init(qs_t qs_inf)
     qs_inf->extra_rels = 64; /* number of opportunities to factor n */
     qs_inf->max_factors = 60; /* maximum number of factors a (merged) relation can have */
 
+    /* relations combined along a cycle of partials have more factors */
+    if (qs_inf->dlp)
+        qs_inf->max_factors = 150;
+
     /* allow as many dups as relations */
     num_primes = qs_inf->num_primes;
     qs_inf->num_primes += qs_inf->ks_primes;
@@ -48,12 +52,14 @@ void qsieve_linalg_init(qs_t qs_inf)
     qs_inf->full_relation = 0;
     qs_inf->edges = 0;
     qs_inf->vertices = 0;
-    qs_inf->components = 1;
+    qs_inf->components = 0;
     qs_inf->num_cycles = 0;
 
     qs_inf->table_size = 10000;
     qs_inf->hash_table = flint_calloc(1 << 25, sizeof(mp_limb_t));
     qs_inf->table = flint_malloc(qs_inf->table_size * sizeof(hash_t));
+
+    qsieve_store_init(qs_inf);
 }
 
 /* re-initialize all the linear algebra parameter */
@@ -78,7 +84,7 @@ void qsieve_linalg_re_init(qs_t qs_inf)
     qs_inf->full_relation = 0;
     qs_inf->edges = 0;
     qs_inf->vertices = 0;
-    qs_inf->components = 1;
+    qs_inf->components = 0;
     qs_inf->num_cycles = 0;
 
     memset(qs_inf->hash_table, 0, (1 << 25) * sizeof(mp_limb_t));
@@ -88,18 +94,7 @@ void qsieve_linalg_re_init(qs_t qs_inf)
 
 void qsieve_linalg_re_alloc(qs_t qs_inf)
 {
-    slong num_primes;
-
-    num_primes = qs_inf->num_primes;
-    qs_inf->num_primes += qs_inf->ks_primes;
-    qs_inf->buffer_size = 2*(qs_inf->num_primes + qs_inf->extra_rels);
-    qs_inf->matrix = flint_realloc(qs_inf->matrix, qs_inf->buffer_size*sizeof(la_col_t));
-    qs_inf->unmerged = qs_inf->matrix + qs_inf->buffer_size;
-    qs_inf->Y_arr = flint_realloc(qs_inf->Y_arr, qs_inf->buffer_size*sizeof(fmpz));
-    qs_inf->curr_rel = qs_inf->relation
-                     = flint_realloc(qs_inf->relation, 2*qs_inf->buffer_size*qs_inf->max_factors*sizeof(slong));
-
-    qs_inf->prime_count = flint_realloc(qs_inf->prime_count, qs_inf->num_primes*sizeof(slong));
-    qs_inf->num_primes = num_primes;
+    /* relations refer to the old factor base, start again */
+    qsieve_linalg_clear(qs_inf);
     qsieve_linalg_init(qs_inf);
 }
@@ -17,6 +17,7 @@ mp_limb_t qsieve_poly_init(qs_t qs_inf)
    ulong num_primes = qs_inf->num_primes;
    ulong s = qs_inf->s;    /* number of prime factors in A coeff */
    mp_limb_t ** A_inv2B;
+   slong num_blocks = (qs_inf->sieve_size + BLOCK_SIZE - 1)/BLOCK_SIZE;
    slong i;
 
    fmpz_init(qs_inf->A);
@@ -37,30 +38,25 @@ mp_limb_t qsieve_poly_init(qs_t qs_inf)
    qs_inf->soln1 = flint_malloc(num_primes * sizeof(mp_limb_t));
    qs_inf->soln2 = flint_malloc(num_primes * sizeof(mp_limb_t));
 
-#if HAVE_OPENMP
-   qs_inf->poly = flint_malloc(omp_get_max_threads() * sizeof(qs_poly_s));
+   /* one set of poly data per sieving thread */
+   qs_inf->poly = flint_malloc(qs_inf->num_threads * sizeof(qs_poly_s));
 
-   for (i = 0; i < omp_get_max_threads(); i++)
+   for (i = 0; i < qs_inf->num_threads; i++)
    {
       fmpz_init(qs_inf->poly[i].B);
       qs_inf->poly[i].posn1 = flint_malloc((num_primes + 16)*sizeof(mp_limb_t));
       qs_inf->poly[i].posn2 = flint_malloc((num_primes + 16)*sizeof(mp_limb_t));
       qs_inf->poly[i].soln1 = flint_malloc((num_primes + 16)*sizeof(mp_limb_t));
       qs_inf->poly[i].soln2 = flint_malloc((num_primes + 16)*sizeof(mp_limb_t));
+      qs_inf->poly[i].bucket = flint_malloc(num_blocks*QS_BUCKET_SIZE*sizeof(unsigned int));
+      qs_inf->poly[i].bucket_len = flint_malloc(num_blocks*sizeof(slong));
       qs_inf->poly[i].small = flint_malloc(qs_inf->small_primes*sizeof(mp_limb_t));
       qs_inf->poly[i].factor = flint_malloc(qs_inf->max_factors*sizeof(fac_t));
 
+      qs_inf->poly[i].rel_buf = NULL;
+      qs_inf->poly[i].rel_len = 0;
+      qs_inf->poly[i].rel_alloc = 0;
    }
-#else
-   qs_inf->poly = flint_malloc(sizeof(qs_poly_s));
-   fmpz_init(qs_inf->poly[0].B);
-   qs_inf->poly[0].posn1 = flint_malloc(num_primes * sizeof(mp_limb_t));
-   qs_inf->poly[0].posn2 = flint_malloc(num_primes * sizeof(mp_limb_t));
-   qs_inf->poly[0].soln1 = flint_malloc(num_primes * sizeof(mp_limb_t));
-   qs_inf->poly[0].soln2 = flint_malloc(num_primes * sizeof(mp_limb_t));
-   qs_inf->poly[0].small = flint_malloc(qs_inf->small_primes*sizeof(mp_limb_t));
-   qs_inf->poly[0].factor = flint_malloc(qs_inf->max_factors*sizeof(fac_t));
-#endif
 
    A_inv2B = qs_inf->A_inv2B;
 
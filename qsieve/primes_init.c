@@ -120,6 +120,11 @@ mp_limb_t qsieve_primes_init(qs_t qs_inf)
     qs_inf->small_primes = qsieve_tune[i][3]; /* number of primes to not sieve with */
     
     bits = qsieve_tune[i][5];
+
+    /* leave room for the cofactors of partials with two large primes */
+    if (qs_inf->dlp)
+       bits -= qs_inf->dlp_bits;
+
     if (bits >= 64)
     {
        qs_inf->sieve_bits = bits;
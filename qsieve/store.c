@@ -0,0 +1,260 @@
+/*
+    Copyright (C) 2019 William Hart
+
+    This file is part of FLINT.
+
+    FLINT is free software: you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.  See <http://www.gnu.org/licenses/>.
+*/
+
+#include "qsieve.h"
+
+/*
+   Relations are stored one after the other as words:
+
+      large prime (1 for a full relation)
+      second large prime (1 unless the relation has two large primes)
+      link, one more than the offset of the previous relation with the
+            same (first) large prime (or the previous full relation), or 0
+      number of factors
+      signed size of Y
+      exponents of the small primes
+      index and exponent of each factor
+      limbs of |Y|
+
+   The offset of a relation counts the words before it, including any
+   already spilled to file. The links, together with the last relation
+   recorded in the hash table entry for each large prime, let the
+   relations with a given large prime be found without a scan.
+*/
+
+void qsieve_store_init(qs_t qs_inf)
+{
+    qs_inf->store = NULL;
+    qs_inf->store_len = 0;
+    qs_inf->store_alloc = 0;
+    qs_inf->store_spilled = 0;
+    qs_inf->spill = NULL;
+    qs_inf->full_last = 0;
+}
+
+void qsieve_store_clear(qs_t qs_inf)
+{
+    flint_free(qs_inf->store);
+
+    if (qs_inf->spill != NULL)
+    {
+        fclose(qs_inf->spill);
+        remove(qs_inf->spill_path);
+    }
+
+    qsieve_store_init(qs_inf);
+}
+
+/* append a partial or full relation to the buffer of the calling thread */
+void qsieve_buffer_relation(qs_t qs_inf, mp_limb_t prime,
+                               mp_limb_t prime2, fmpz_t Y, qs_poly_t poly)
+{
+    slong i, len, size;
+    slong num_factors = poly->num_factors;
+    slong * small = poly->small;
+    fac_t * factor = poly->factor;
+    mp_limb_t * rel;
+
+    size = fmpz_size(Y);
+    len = 5 + qs_inf->small_primes + 2*num_factors + size;
+
+    if (poly->rel_len + len > poly->rel_alloc)
+    {
+        poly->rel_alloc = FLINT_MAX(2*poly->rel_alloc, poly->rel_len + len);
+        poly->rel_buf = flint_realloc(poly->rel_buf,
+                                           poly->rel_alloc*sizeof(mp_limb_t));
+    }
+
+    rel = poly->rel_buf + poly->rel_len;
+
+    rel[0] = prime;
+    rel[1] = prime2;
+    rel[2] = 0;
+    rel[3] = num_factors;
+    rel[4] = fmpz_sgn(Y) < 0 ? -size : size;
+    rel += 5;
+
+    for (i = 0; i < qs_inf->small_primes; i++)
+        rel[i] = small[i];
+    rel += qs_inf->small_primes;
+
+    for (i = 0; i < num_factors; i++)
+    {
+        rel[2*i] = factor[i].ind;
+        rel[2*i + 1] = factor[i].exp;
+    }
+    rel += 2*num_factors;
+
+    if (size != 0)
+    {
+        fmpz_t t;
+        fmpz_init(t);
+        fmpz_abs(t, Y);
+        fmpz_get_ui_array(rel, size, t);
+        fmpz_clear(t);
+    }
+
+    poly->rel_len += len;
+}
+
+/*
+   link the len words of relations at rels into the store and append them,
+   the caller must hold the lock if other threads may be sieving
+*/
+void qsieve_store_relations(qs_t qs_inf, mp_limb_t * rels, slong len)
+{
+    slong k, base;
+    mp_limb_t * rel;
+    hash_t * entry;
+
+    base = qs_inf->store_spilled + qs_inf->store_len;
+
+    /* link each relation in, then update counts of fulls and partials */
+    for (k = 0; k < len; k += QS_REL_LEN(rel, qs_inf->small_primes))
+    {
+        rel = rels + k;
+
+        if (rel[0] == 1)
+        {
+            rel[2] = qs_inf->full_last;
+            qs_inf->full_last = base + k + 1;
+            qs_inf->full_relation++;
+        }
+        else
+        {
+            qsieve_add_edge(qs_inf, rel[0], rel[1]);
+            entry = qsieve_get_table_entry(qs_inf, rel[0]);
+            rel[2] = entry->last;
+            entry->last = base + k + 1;
+        }
+    }
+
+    if (qs_inf->store_len + len > qs_inf->store_alloc)
+    {
+        qs_inf->store_alloc = FLINT_MAX(2*qs_inf->store_alloc,
+                                                    qs_inf->store_len + len);
+        qs_inf->store = flint_realloc(qs_inf->store,
+                                      qs_inf->store_alloc*sizeof(mp_limb_t));
+    }
+
+    memcpy(qs_inf->store + qs_inf->store_len, rels, len*sizeof(mp_limb_t));
+    qs_inf->store_len += len;
+
+    /* move relations in memory to the end of the spill file */
+    if (qs_inf->spill_path != NULL &&
+                   qs_inf->store_len > FLINT_CUTOFF(QSIEVE_STORE_WORDS))
+    {
+        if (qs_inf->spill == NULL)
+            qs_inf->spill = fopen(qs_inf->spill_path, "w+b");
+
+        if (qs_inf->spill == NULL ||
+            fseek(qs_inf->spill, 0, SEEK_END) != 0 ||
+            fwrite(qs_inf->store, sizeof(mp_limb_t), qs_inf->store_len,
+                                   qs_inf->spill) != qs_inf->store_len)
+        {
+            flint_printf("Exception (qsieve_factor). Unable to write "
+                                         "relations to %s.\n", qs_inf->spill_path);
+            flint_abort();
+        }
+
+        qs_inf->store_spilled += qs_inf->store_len;
+        qs_inf->store_len = 0;
+    }
+}
+
+/*
+   pass the relations buffered by a thread to the relation store, taking
+   the lock once for all of them
+*/
+void qsieve_flush_relations(qs_t qs_inf, qs_poly_t poly)
+{
+    if (poly->rel_len == 0)
+        return;
+
+    pthread_mutex_lock(&qs_inf->mutex);
+    qsieve_store_relations(qs_inf, poly->rel_buf, poly->rel_len);
+    pthread_mutex_unlock(&qs_inf->mutex);
+
+    poly->rel_len = 0;
+}
+
+/*
+   set rel to the relation at the given offset in the store and return the
+   link to the previous relation in its chain
+*/
+mp_limb_t qsieve_get_relation(relation_t * rel, qs_t qs_inf, mp_limb_t off)
+{
+    slong i, size, len;
+    const mp_limb_t * r;
+    mp_limb_t * tmp = NULL;
+    mp_limb_t link;
+
+    if (off >= qs_inf->store_spilled)
+        r = qs_inf->store + off - qs_inf->store_spilled;
+    else
+    {
+        mp_limb_t head[5];
+
+        if (fseek(qs_inf->spill, off*sizeof(mp_limb_t), SEEK_SET) != 0 ||
+            fread(head, sizeof(mp_limb_t), 5, qs_inf->spill) != 5)
+            goto read_error;
+
+        len = QS_REL_LEN(head, qs_inf->small_primes);
+        tmp = flint_malloc(len*sizeof(mp_limb_t));
+        memcpy(tmp, head, 5*sizeof(mp_limb_t));
+
+        if (fread(tmp + 5, sizeof(mp_limb_t), len - 5, qs_inf->spill)
+                                                          != (size_t) len - 5)
+            goto read_error;
+
+        r = tmp;
+    }
+
+    link = r[2];
+    size = (slong) r[4];
+
+    rel->lp = r[0];
+    rel->lp2 = r[1];
+    rel->num_factors = r[3];
+    rel->small_primes = qs_inf->small_primes;
+    rel->small = flint_malloc(qs_inf->small_primes*sizeof(slong));
+    rel->factor = flint_malloc(qs_inf->max_factors*sizeof(fac_t));
+    r += 5;
+
+    for (i = 0; i < qs_inf->small_primes; i++)
+        rel->small[i] = r[i];
+    r += qs_inf->small_primes;
+
+    for (i = 0; i < rel->num_factors; i++)
+    {
+        rel->factor[i].ind = r[2*i];
+        rel->factor[i].exp = r[2*i + 1];
+    }
+    r += 2*rel->num_factors;
+
+    fmpz_init(rel->Y);
+    if (size != 0)
+    {
+        fmpz_set_ui_array(rel->Y, r, FLINT_ABS(size));
+        if (size < 0)
+            fmpz_neg(rel->Y, rel->Y);
+    }
+
+    flint_free(tmp);
+
+    return link;
+
+read_error:
+    flint_printf("Exception (qsieve_factor). Unable to read "
+                                     "relations from %s.\n", qs_inf->spill_path);
+    flint_abort();
+    return 0;
+}
@@ -0,0 +1,122 @@
+/*
+    Copyright (C) 2019 William Hart
+
+    This file is part of FLINT.
+
+    FLINT is free software: you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.  See <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <gmp.h>
+#include "flint.h"
+#include "ulong_extras.h"
+#include "qsieve.h"
+
+int main(void)
+{
+    slong i, j, k, l;
+    FLINT_TEST_INIT(state);
+
+    flint_printf("block_lanczos....");
+    fflush(stdout);
+
+    /* use several threads whatever the size */
+    flint_set_cutoff(FLINT_CUTOFF_QSIEVE_LANCZOS_COLS, 0);
+
+    for (i = 0; i < 20 * flint_test_multiplier(); i++)
+    {
+        slong nrows = n_randint(state, 1000) + 100;
+        slong ncols = nrows + 64 + n_randint(state, 100);
+        la_col_t * cols;
+        uint64_t * x, * b;
+        int * used;
+
+        cols = flint_malloc(ncols*sizeof(la_col_t));
+        used = flint_calloc(nrows, sizeof(int));
+
+        for (j = 0; j < ncols; j++)
+        {
+            slong weight = n_randint(state, 20) + 1;
+
+            cols[j].data = flint_malloc(weight*sizeof(slong));
+            cols[j].weight = 0;
+            cols[j].orig = j;
+
+            for (k = 0; k < weight; k++)
+            {
+                slong r = n_randint(state, nrows);
+
+                if (!used[r])
+                {
+                    used[r] = 1;
+                    cols[j].data[cols[j].weight++] = r;
+                }
+            }
+
+            for (k = 0; k < cols[j].weight; k++)
+                used[cols[j].data[k]] = 0;
+
+            if (cols[j].weight == 0)
+            {
+                flint_free(cols[j].data);
+                cols[j].data = NULL;
+            }
+        }
+
+        flint_set_num_threads(n_randint(state, 4) + 1);
+
+        do {
+            x = block_lanczos(state, nrows, 0, ncols, cols);
+        } while (x == NULL);
+
+        /* check the dependencies and that they are not all zero */
+        b = flint_calloc(nrows, sizeof(uint64_t));
+
+        for (j = 0; j < ncols; j++)
+        {
+            for (k = 0; k < cols[j].weight; k++)
+                b[cols[j].data[k]] ^= x[j];
+        }
+
+        for (j = 0; j < nrows; j++)
+        {
+            if (b[j] != 0)
+            {
+                flint_printf("FAIL:\n");
+                flint_printf("row %wd of the product is not zero\n", j);
+                abort();
+            }
+        }
+
+        for (j = l = 0; j < ncols; j++)
+            l |= (x[j] != 0);
+
+        if (!l)
+        {
+            flint_printf("FAIL:\n");
+            flint_printf("no nullspace vectors found\n");
+            abort();
+        }
+
+        for (j = 0; j < ncols; j++)
+            flint_free(cols[j].data);
+        flint_free(cols);
+        flint_free(used);
+        flint_free(x);
+        flint_free(b);
+    }
+
+    flint_set_cutoff(FLINT_CUTOFF_QSIEVE_LANCZOS_COLS,
+                  flint_get_default_cutoff(FLINT_CUTOFF_QSIEVE_LANCZOS_COLS));
+
+    flint_set_num_threads(1);
+
+    FLINT_TEST_CLEANUP(state);
+
+    flint_printf("PASS\n");
+    return 0;
+}
@@ -92,6 +92,8 @@ int main(void)
 
       fmpz_factor_init(factors);
 
+      flint_set_num_threads(n_randint(state, 4) + 1);
+
       qsieve_factor(factors, n);
 
       if (factors->num < 2)
@@ -119,6 +121,8 @@ int main(void)
 
       fmpz_factor_init(factors);
 
+      flint_set_num_threads(n_randint(state, 4) + 1);
+
       qsieve_factor(factors, n);
 
       if (factors->num < 3)
@@ -131,6 +135,118 @@ int main(void)
       fmpz_factor_clear(factors);
    }
 
+   /*
+      Test random n, relations spilled to file. The store is kept small
+      so that the relations really go to the file and are read back. The
+      file is created beforehand, so that it is only removed if relations
+      were written to it.
+   */
+   flint_set_cutoff(FLINT_CUTOFF_QSIEVE_STORE_WORDS, 300);
+
+   for (i = 0; i < 10; i++)
+   {
+      slong j;
+      FILE * f;
+
+      randprime(x, state, 50);
+      do {
+         randprime(y, state, 50);
+      } while (fmpz_equal(x, y));
+
+      fmpz_mul(n, x, y);
+
+      fmpz_factor_init(factors);
+
+      flint_set_num_threads(n_randint(state, 4) + 1);
+
+      f = fopen("qsieve_spill_test.dat", "wb");
+      if (f == NULL)
+      {
+         flint_printf("FAIL:\n");
+         flint_printf("unable to create spill file\n");
+         abort();
+      }
+      fclose(f);
+
+      qsieve_factor_spill(factors, n, "qsieve_spill_test.dat");
+
+      if (factors->num < 2)
+      {
+         flint_printf("FAIL:\n");
+         flint_printf("%ld factors found\n", factors->num);
+         abort();
+      }
+
+      fmpz_one(z);
+      for (j = 0; j < factors->num; j++)
+      {
+         fmpz_pow_ui(x, factors->p + j, factors->exp[j]);
+         fmpz_mul(z, z, x);
+      }
+
+      if (fmpz_cmpabs(z, n) != 0)
+      {
+         flint_printf("FAIL:\n");
+         flint_printf("factors do not multiply to n\n");
+         abort();
+      }
+
+      f = fopen("qsieve_spill_test.dat", "rb");
+      if (f != NULL)
+      {
+         fclose(f);
+         flint_printf("FAIL:\n");
+         flint_printf("relations not spilled or spill file not removed\n");
+         abort();
+      }
+
+      fmpz_factor_clear(factors);
+   }
+
+   flint_set_cutoff(FLINT_CUTOFF_QSIEVE_STORE_WORDS,
+                  flint_get_default_cutoff(FLINT_CUTOFF_QSIEVE_STORE_WORDS));
+
+   /* Test random n, two large primes allowed */
+   flint_set_cutoff(FLINT_CUTOFF_QSIEVE_DLP_BITS, 0);
+
+   for (i = 0; i < 3; i++)
+   {
+      slong j, bits = n_randint(state, 6) + 75;
+
+      randprime(x, state, bits);
+      do {
+         randprime(y, state, bits);
+      } while (fmpz_equal(x, y));
+
+      fmpz_mul(n, x, y);
+
+      fmpz_factor_init(factors);
+
+      flint_set_num_threads(n_randint(state, 4) + 1);
+
+      qsieve_factor(factors, n);
+
+      fmpz_one(z);
+      for (j = 0; j < factors->num; j++)
+      {
+         fmpz_pow_ui(x, factors->p + j, factors->exp[j]);
+         fmpz_mul(z, z, x);
+      }
+
+      if (factors->num < 2 || !fmpz_equal(z, n))
+      {
+         flint_printf("FAIL (double large prime):\n");
+         flint_printf("%ld factors found\n", factors->num);
+         fmpz_print(n); flint_printf("\n");
+         abort();
+      }
+
+      fmpz_factor_clear(factors);
+   }
+
+   flint_set_cutoff(FLINT_CUTOFF_QSIEVE_DLP_BITS,
+                  flint_get_default_cutoff(FLINT_CUTOFF_QSIEVE_DLP_BITS));
+
    for (i = 0; i < 30; i++) /* Test random n, small factors */
    {
       randprime(x, state, 10);
@@ -144,6 +260,8 @@ int main(void)
 
       fmpz_factor_init(factors);
 
+      flint_set_num_threads(n_randint(state, 4) + 1);
+
       qsieve_factor(factors, n);
 
       if (factors->num < 3)
@@ -156,6 +274,8 @@ int main(void)
       fmpz_factor_clear(factors);
    }
 
+   flint_set_num_threads(1);
+
    fmpz_clear(n);
    fmpz_clear(x);
    fmpz_clear(y);
@@ -0,0 +1,141 @@
+/*
+    Copyright (C) 2019 William Hart
+
+    This file is part of FLINT.
+
+    FLINT is free software: you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.  See <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <gmp.h>
+#include "flint.h"
+#include "ulong_extras.h"
+#include "fmpz.h"
+#include "qsieve.h"
+
+#define CHECKPOINT "qsieve_checkpoint_test.dat"
+
+void randprime(fmpz_t p, flint_rand_t state, slong bits)
+{
+    fmpz_randbits(p, state, bits);
+
+    if (fmpz_sgn(p) < 0)
+       fmpz_neg(p, p);
+
+    if (fmpz_is_even(p))
+       fmpz_add_ui(p, p, 1);
+
+    while (!fmpz_is_probabprime(p))
+       fmpz_add_ui(p, p, 2);
+}
+
+int main(void)
+{
+    slong i;
+    fmpz_t n, x, y, z;
+    fmpz_factor_t factors;
+    FLINT_TEST_INIT(state);
+
+    fmpz_init(x);
+    fmpz_init(y);
+    fmpz_init(z);
+    fmpz_init(n);
+
+    flint_printf("factor_checkpoint....");
+    fflush(stdout);
+
+    remove(CHECKPOINT);
+
+    fmpz_factor_init(factors);
+
+    if (qsieve_factor_resume(factors, CHECKPOINT, 0) != -1)
+    {
+        flint_printf("FAIL:\n");
+        flint_printf("resumed without a checkpoint\n");
+        abort();
+    }
+
+    fmpz_factor_clear(factors);
+
+    for (i = 0; i < 5; i++)
+    {
+        slong j, bits = 55 + n_randint(state, 10);
+        int done;
+        FILE * f;
+
+        randprime(x, state, bits);
+        do {
+            randprime(y, state, bits);
+        } while (fmpz_equal(x, y));
+
+        fmpz_mul(n, x, y);
+
+        fmpz_factor_init(factors);
+
+        flint_set_num_threads(n_randint(state, 3) + 1);
+
+        /* stop after each A0, resuming from the checkpoint every time */
+        done = qsieve_factor_checkpoint(factors, n, CHECKPOINT, 1);
+
+        for (j = 0; !done; j++)
+        {
+            if (j == 1000)
+            {
+                flint_printf("FAIL:\n");
+                flint_printf("no progress from checkpoint\n");
+                abort();
+            }
+
+            done = qsieve_factor_resume(factors, CHECKPOINT, 1);
+
+            if (done == -1)
+            {
+                flint_printf("FAIL:\n");
+                flint_printf("checkpoint not written\n");
+                abort();
+            }
+        }
+
+        fmpz_one(z);
+        for (j = 0; j < factors->num; j++)
+        {
+            fmpz_pow_ui(x, factors->p + j, factors->exp[j]);
+            fmpz_mul(z, z, x);
+        }
+
+        if (factors->num < 2 || !fmpz_equal(z, n))
+        {
+            flint_printf("FAIL:\n");
+            flint_printf("n = "); fmpz_print(n);
+            flint_printf(", %wd factors found\n", factors->num);
+            abort();
+        }
+
+        f = fopen(CHECKPOINT, "rb");
+        if (f != NULL)
+        {
+            fclose(f);
+            flint_printf("FAIL:\n");
+            flint_printf("checkpoint not removed\n");
+            abort();
+        }
+
+        fmpz_factor_clear(factors);
+    }
+
+    flint_set_num_threads(1);
+
+    fmpz_clear(n);
+    fmpz_clear(x);
+    fmpz_clear(y);
+    fmpz_clear(z);
+
+    FLINT_TEST_CLEANUP(state);
+
+    flint_printf("PASS\n");
+    return 0;
+}
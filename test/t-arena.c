@@ -0,0 +1,254 @@
+/*
+    Copyright (C) 2019 William Hart
+
+    This file is part of FLINT.
+
+    FLINT is free software: you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.  See <http://www.gnu.org/licenses/>.
+*/
+
+#include <string.h>
+#include "flint.h"
+#include "ulong_extras.h"
+#include "nmod_poly.h"
+#include "threadpool.h"
+
+#define NUM_BLOCKS 200
+
+typedef struct
+{
+    unsigned char * ptr;
+    size_t size;
+    ulong seed;
+} block_struct;
+
+void fill_block(block_struct * b)
+{
+    size_t i;
+
+    for (i = 0; i < b->size; i++)
+        b->ptr[i] = (unsigned char) ((b->seed + i) & 0xff);
+}
+
+int check_block(block_struct * b)
+{
+    size_t i;
+
+    for (i = 0; i < b->size; i++)
+    {
+        if (b->ptr[i] != (unsigned char) ((b->seed + i) & 0xff))
+            return 0;
+    }
+
+    return 1;
+}
+
+size_t random_size(flint_rand_t state)
+{
+    if (n_randint(state, 50) == 0)
+        return n_randint(state, 1000000);
+    else
+        return n_randint(state, 2000);
+}
+
+/* free the blocks handed to another thread */
+void free_worker(void * arg)
+{
+    block_struct * b = (block_struct *) arg;
+
+    if (!check_block(b))
+    {
+        flint_printf("FAIL:\n");
+        flint_printf("block corrupted before remote free\n");
+        abort();
+    }
+
+    flint_free(b->ptr);
+}
+
+int main(void)
+{
+    slong i, j, k;
+    block_struct blocks[NUM_BLOCKS];
+    flint_arena_stats_t s0, s1;
+    FLINT_TEST_INIT(state);
+
+    __flint_set_memory_functions(flint_arena_malloc, flint_arena_calloc,
+                                 flint_arena_realloc, flint_arena_free);
+
+    flint_printf("arena....");
+    fflush(stdout);
+
+    /* random allocations, reallocations and frees keep their contents */
+    for (i = 0; i < 50 * flint_test_multiplier(); i++)
+    {
+        flint_arena_get_stats(s0);
+
+        for (j = 0; j < NUM_BLOCKS; j++)
+        {
+            blocks[j].size = random_size(state);
+            blocks[j].ptr = flint_malloc(blocks[j].size);
+            blocks[j].seed = n_randlimb(state);
+            fill_block(blocks + j);
+        }
+
+        for (k = 0; k < NUM_BLOCKS; k++)
+        {
+            block_struct * b = blocks + n_randint(state, NUM_BLOCKS);
+            size_t size = random_size(state);
+
+            if (!check_block(b))
+            {
+                flint_printf("FAIL:\n");
+                flint_printf("block corrupted, i = %wd\n", i);
+                abort();
+            }
+
+            b->ptr = flint_realloc(b->ptr, size);
+            b->size = FLINT_MIN(b->size, size);
+
+            if (!check_block(b))
+            {
+                flint_printf("FAIL:\n");
+                flint_printf("realloc lost data, i = %wd\n", i);
+                abort();
+            }
+
+            b->size = size;
+            b->seed = n_randlimb(state);
+            fill_block(b);
+        }
+
+        /* free in stack order or at random */
+        if (n_randint(state, 2))
+        {
+            for (j = NUM_BLOCKS - 1; j >= 0; j--)
+                flint_free(blocks[j].ptr);
+        }
+        else
+        {
+            for (j = 0; j < NUM_BLOCKS; j++)
+            {
+                k = j + n_randint(state, NUM_BLOCKS - j);
+                if (!check_block(blocks + k))
+                {
+                    flint_printf("FAIL:\n");
+                    flint_printf("block corrupted, i = %wd\n", i);
+                    abort();
+                }
+                flint_free(blocks[k].ptr);
+                blocks[k] = blocks[j];
+            }
+        }
+
+        flint_arena_get_stats(s1);
+
+        if (s1->in_use != s0->in_use || s1->high_water < s1->in_use)
+        {
+            flint_printf("FAIL:\n");
+            flint_printf("in_use = %wu, %wu, high_water = %wu\n",
+                     (ulong) s0->in_use, (ulong) s1->in_use,
+                     (ulong) s1->high_water);
+            abort();
+        }
+    }
+
+    /* blocks freed by other threads */
+    for (i = 0; i < 10 * flint_test_multiplier(); i++)
+    {
+        flint_set_num_threads(n_randint(state, 4) + 2);
+
+        flint_arena_reset();
+        flint_arena_get_stats(s0);
+
+        for (j = 0; j < NUM_BLOCKS; j++)
+        {
+            blocks[j].size = 1000 + random_size(state);
+            blocks[j].ptr = flint_calloc(blocks[j].size, 1);
+            for (k = 0; k < blocks[j].size; k++)
+            {
+                if (blocks[j].ptr[k] != 0)
+                {
+                    flint_printf("FAIL:\n");
+                    flint_printf("calloc did not clear memory\n");
+                    abort();
+                }
+            }
+            blocks[j].seed = n_randlimb(state);
+            fill_block(blocks + j);
+        }
+
+        threadpool_parallel_do(free_worker, blocks, NUM_BLOCKS,
+                                                        sizeof(block_struct));
+
+        flint_arena_reset();
+        flint_arena_get_stats(s1);
+
+        /* allow for the memory used by the thread pool itself */
+        if (s1->in_use > s0->in_use + 1000*NUM_BLOCKS/2 ||
+            s1->num_chunks > s0->num_chunks + 1)
+        {
+            flint_printf("FAIL:\n");
+            flint_printf("in_use = %wu, %wu, num_chunks = %wu, %wu\n",
+                         (ulong) s0->in_use, (ulong) s1->in_use,
+                         s0->num_chunks, s1->num_chunks);
+            abort();
+        }
+    }
+
+    /* something which makes heavy use of temporary allocation */
+    for (i = 0; i < 10 * flint_test_multiplier(); i++)
+    {
+        nmod_poly_t a, b, c, d;
+        mp_limb_t n = n_randtest_not_zero(state);
+        slong len = n_randint(state, 2000);
+
+        nmod_poly_init(a, n);
+        nmod_poly_init(b, n);
+        nmod_poly_init(c, n);
+        nmod_poly_init(d, n);
+
+        nmod_poly_randtest(a, state, len);
+        nmod_poly_randtest(b, state, len);
+
+        nmod_poly_mul(c, a, b);
+        nmod_poly_mul_classical(d, a, b);
+
+        if (!nmod_poly_equal(c, d))
+        {
+            flint_printf("FAIL:\n");
+            flint_printf("nmod_poly_mul gave the wrong result\n");
+            abort();
+        }
+
+        nmod_poly_clear(a);
+        nmod_poly_clear(b);
+        nmod_poly_clear(c);
+        nmod_poly_clear(d);
+    }
+
+    flint_arena_get_stats(s0);
+    if (s0->num_allocs == 0 || s0->high_water == 0)
+    {
+        flint_printf("FAIL:\n");
+        flint_printf("arena was not used\n");
+        abort();
+    }
+
+    threadpool_global_clear();
+
+    FLINT_TEST_CLEANUP(state);
+
+    flint_arena_get_stats(s0);
+    if (s0->num_chunks != 0)
+    {
+        flint_printf("FAIL:\n");
+        flint_printf("%wu chunks left after cleanup\n", s0->num_chunks);
+        abort();
+    }
+
+    flint_printf("PASS\n");
+    return 0;
+}
@@ -0,0 +1,212 @@
+/*
+    Copyright (C) 2019 William Hart
+
+    This file is part of FLINT.
+
+    FLINT is free software: you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.  See <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdio.h>
+#include "flint.h"
+#include "ulong_extras.h"
+#include "nmod_poly.h"
+#include "nmod_mat.h"
+#include "fmpz_mat.h"
+
+#define TMP_FILE "t-cutoffs.tmp"
+
+int main(void)
+{
+    slong i, j, vals[FLINT_NUM_CUTOFFS];
+    FILE * file;
+    FLINT_TEST_INIT(state);
+
+    flint_printf("cutoffs....");
+    fflush(stdout);
+
+    /* save and load random tables */
+    for (i = 0; i < 20; i++)
+    {
+        for (j = 0; j < FLINT_NUM_CUTOFFS; j++)
+        {
+            vals[j] = n_randint(state, 100000);
+            flint_set_cutoff((flint_cutoff_t) j, vals[j]);
+        }
+
+        if (!flint_save_cutoffs(TMP_FILE))
+        {
+            flint_printf("FAIL:\n");
+            flint_printf("cannot write %s\n", TMP_FILE);
+            abort();
+        }
+
+        flint_reset_cutoffs();
+
+        for (j = 0; j < FLINT_NUM_CUTOFFS; j++)
+        {
+            if (flint_get_cutoff((flint_cutoff_t) j)
+                             != flint_get_default_cutoff((flint_cutoff_t) j))
+            {
+                flint_printf("FAIL:\n");
+                flint_printf("reset failed for %s\n",
+                                         flint_cutoff_name((flint_cutoff_t) j));
+                abort();
+            }
+        }
+
+        if (!flint_load_cutoffs(TMP_FILE))
+        {
+            flint_printf("FAIL:\n");
+            flint_printf("cannot read %s\n", TMP_FILE);
+            abort();
+        }
+
+        for (j = 0; j < FLINT_NUM_CUTOFFS; j++)
+        {
+            if (flint_get_cutoff((flint_cutoff_t) j) != vals[j])
+            {
+                flint_printf("FAIL:\n");
+                flint_printf("%s = %wd, expected %wd\n",
+                    flint_cutoff_name((flint_cutoff_t) j),
+                    flint_get_cutoff((flint_cutoff_t) j), vals[j]);
+                abort();
+            }
+        }
+    }
+
+    /* unknown names are skipped, a malformed file changes nothing */
+    file = fopen(TMP_FILE, "w");
+    fprintf(file, "# comment\n\nno_such_cutoff 5\n  %s 7\n",
+                             flint_cutoff_name(FLINT_CUTOFF_NMOD_POLY_MUL_KS2));
+    fclose(file);
+
+    flint_reset_cutoffs();
+    if (!flint_load_cutoffs(TMP_FILE) ||
+        FLINT_CUTOFF(NMOD_POLY_MUL_KS2) != 7 ||
+        FLINT_CUTOFF(NMOD_POLY_MUL_KS4)
+                   != flint_get_default_cutoff(FLINT_CUTOFF_NMOD_POLY_MUL_KS4))
+    {
+        flint_printf("FAIL:\n");
+        flint_printf("loading a partial file failed\n");
+        abort();
+    }
+
+    file = fopen(TMP_FILE, "w");
+    fprintf(file, "%s 9\n%s x\n",
+                     flint_cutoff_name(FLINT_CUTOFF_NMOD_POLY_MUL_KS2),
+                     flint_cutoff_name(FLINT_CUTOFF_NMOD_POLY_MUL_KS4));
+    fclose(file);
+
+    if (flint_load_cutoffs(TMP_FILE) || FLINT_CUTOFF(NMOD_POLY_MUL_KS2) != 7)
+    {
+        flint_printf("FAIL:\n");
+        flint_printf("a malformed file was accepted\n");
+        abort();
+    }
+
+    remove(TMP_FILE);
+
+    /* the dispatchers give the same results whatever the cutoffs */
+    for (i = 0; i < 100 * flint_test_multiplier(); i++)
+    {
+        nmod_poly_t a, b, c, d;
+        nmod_mat_t A, B, C, D;
+        fmpz_mat_t E, F, G, H;
+        mp_limb_t n = n_randtest_not_zero(state);
+        slong m, k, l;
+
+        for (j = 0; j < FLINT_NUM_CUTOFFS; j++)
+            flint_set_cutoff((flint_cutoff_t) j, n_randint(state, 300));
+
+        /* the FFT is not valid for tiny sizes */
+        flint_set_cutoff(FLINT_CUTOFF_FFT_MULMOD_2EXPP1,
+                    flint_get_default_cutoff(FLINT_CUTOFF_FFT_MULMOD_2EXPP1));
+
+        nmod_poly_init(a, n);
+        nmod_poly_init(b, n);
+        nmod_poly_init(c, n);
+        nmod_poly_init(d, n);
+        nmod_poly_randtest(a, state, n_randint(state, 100));
+        nmod_poly_randtest(b, state, n_randint(state, 100));
+
+        nmod_poly_mul(c, a, b);
+        nmod_poly_mul_classical(d, a, b);
+
+        if (!nmod_poly_equal(c, d))
+        {
+            flint_printf("FAIL:\n");
+            flint_printf("nmod_poly_mul, i = %wd\n", i);
+            abort();
+        }
+
+        nmod_poly_clear(a);
+        nmod_poly_clear(b);
+        nmod_poly_clear(c);
+        nmod_poly_clear(d);
+
+        flint_set_cutoff(FLINT_CUTOFF_NMOD_MAT_MUL_STRASSEN,
+                                                    n_randint(state, 20) + 1);
+
+        m = n_randint(state, 50);
+        k = n_randint(state, 50);
+        l = n_randint(state, 50);
+
+        nmod_mat_init(A, m, k, n);
+        nmod_mat_init(B, k, l, n);
+        nmod_mat_init(C, m, l, n);
+        nmod_mat_init(D, m, l, n);
+        nmod_mat_randtest(A, state);
+        nmod_mat_randtest(B, state);
+
+        nmod_mat_mul(C, A, B);
+        nmod_mat_mul_classical(D, A, B);
+
+        if (!nmod_mat_equal(C, D))
+        {
+            flint_printf("FAIL:\n");
+            flint_printf("nmod_mat_mul, i = %wd\n", i);
+            abort();
+        }
+
+        nmod_mat_clear(A);
+        nmod_mat_clear(B);
+        nmod_mat_clear(C);
+        nmod_mat_clear(D);
+
+        m = n_randint(state, 30);
+        k = n_randint(state, 30);
+        l = n_randint(state, 30);
+
+        fmpz_mat_init(E, m, k);
+        fmpz_mat_init(F, k, l);
+        fmpz_mat_init(G, m, l);
+        fmpz_mat_init(H, m, l);
+        fmpz_mat_randtest(E, state, n_randint(state, 200) + 1);
+        fmpz_mat_randtest(F, state, n_randint(state, 200) + 1);
+
+        fmpz_mat_mul(G, E, F);
+        fmpz_mat_mul_classical(H, E, F);
+
+        if (!fmpz_mat_equal(G, H))
+        {
+            flint_printf("FAIL:\n");
+            flint_printf("fmpz_mat_mul, i = %wd\n", i);
+            abort();
+        }
+
+        fmpz_mat_clear(E);
+        fmpz_mat_clear(F);
+        fmpz_mat_clear(G);
+        fmpz_mat_clear(H);
+    }
+
+    flint_reset_cutoffs();
+
+    FLINT_TEST_CLEANUP(state);
+
+    flint_printf("PASS\n");
+    return 0;
+}
@@ -0,0 +1,152 @@
+/*
+    Copyright (C) 2019 William Hart
+
+    This file is part of FLINT.
+
+    FLINT is free software: you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.  See <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include "flint.h"
+#include "ulong_extras.h"
+#include "nmod_poly.h"
+#include "fmpz_mat.h"
+
+typedef struct
+{
+    ulong calls;
+    slong last_size;
+    ulong last_cycles;
+} callback_struct;
+
+void callback(flint_trace_t d, const char * alg, slong size,
+                                                 ulong cycles, void * data)
+{
+    callback_struct * c = (callback_struct *) data;
+
+    if (d == FLINT_TRACE_NMOD_POLY_MUL && strcmp(alg, "test") == 0)
+    {
+        c->calls++;
+        c->last_size = size;
+        c->last_cycles = cycles;
+    }
+}
+
+int main(void)
+{
+    slong i, size;
+    ulong calls, cycles, total, c;
+    callback_struct cb[1];
+    FLINT_TEST_INIT(state);
+
+    flint_printf("trace....");
+    fflush(stdout);
+
+    flint_trace_reset();
+
+    cb->calls = 0;
+    flint_trace_set_callback(callback, cb);
+
+    /* record directly */
+    total = 0;
+    for (i = 0; i < 1000; i++)
+    {
+        size = n_randint(state, 100000);
+        c = n_randint(state, 1000);
+        total += c;
+
+        flint_trace_record(FLINT_TRACE_NMOD_POLY_MUL, "test", size, c);
+
+        if (cb->calls != i + 1 || cb->last_size != size
+                               || cb->last_cycles != c)
+        {
+            flint_printf("FAIL:\n");
+            flint_printf("callback not called, i = %wd\n", i);
+            abort();
+        }
+    }
+
+    flint_trace_set_callback(NULL, NULL);
+    flint_trace_record(FLINT_TRACE_NMOD_POLY_MUL, "test", 1, 1);
+
+    calls = flint_trace_calls(FLINT_TRACE_NMOD_POLY_MUL, "test", &cycles);
+
+    if (calls != 1001 || cycles != total + 1 || cb->calls != 1000)
+    {
+        flint_printf("FAIL:\n");
+        flint_printf("calls = %wu, cycles = %wu, total = %wu\n",
+                                                       calls, cycles, total);
+        abort();
+    }
+
+    if (flint_trace_calls(FLINT_TRACE_NMOD_MAT_MUL, "test", NULL) != 0)
+    {
+        flint_printf("FAIL:\n");
+        flint_printf("dispatchers not separate\n");
+        abort();
+    }
+
+    flint_trace_reset();
+
+    if (flint_trace_calls(FLINT_TRACE_NMOD_POLY_MUL, "test", NULL) != 0)
+    {
+        flint_printf("FAIL:\n");
+        flint_printf("reset failed\n");
+        abort();
+    }
+
+#if FLINT_TRACE
+    /* the dispatchers record the algorithms they choose */
+    {
+        nmod_poly_t a, b, r;
+        fmpz_mat_t A, B, C;
+
+        nmod_poly_init(a, 17);
+        nmod_poly_init(b, 17);
+        nmod_poly_init(r, 17);
+        fmpz_mat_init(A, 3, 3);
+        fmpz_mat_init(B, 3, 3);
+        fmpz_mat_init(C, 3, 3);
+
+        nmod_poly_set_coeff_ui(a, 1, 3);
+        nmod_poly_set_coeff_ui(b, 1, 5);
+        fmpz_mat_randtest(A, state, 10);
+        fmpz_mat_randtest(B, state, 10);
+
+        for (i = 0; i < 10; i++)
+        {
+            nmod_poly_mul(r, a, b);
+            fmpz_mat_mul(C, A, B);
+        }
+
+        if (flint_trace_calls(FLINT_TRACE_NMOD_POLY_MUL, "classical",
+                                                                  NULL) != 10 ||
+            flint_trace_calls(FLINT_TRACE_FMPZ_MAT_MUL, "classical_inline",
+                                                                  NULL) != 10)
+        {
+            flint_printf("FAIL:\n");
+            flint_printf("dispatchers not traced\n");
+            flint_trace_dump(stdout);
+            abort();
+        }
+
+        nmod_poly_clear(a);
+        nmod_poly_clear(b);
+        nmod_poly_clear(r);
+        fmpz_mat_clear(A);
+        fmpz_mat_clear(B);
+        fmpz_mat_clear(C);
+
+        flint_trace_reset();
+    }
+#endif
+
+    FLINT_TEST_CLEANUP(state);
+
+    flint_printf("PASS\n");
+    return 0;
+}
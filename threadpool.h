@@ -9,9 +9,16 @@
     (at your option) any later version.  See <http://www.gnu.org/licenses/>.
 */
 
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
 #include <pthread.h>
 #include "flint.h"
 
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
 typedef struct
 {
     pthread_t pth;
@@ -55,3 +62,77 @@ FLINT_DLL void threadpool_wait(threadpool_t T, threadpool_threadhandle i);
 FLINT_DLL void threadpool_giveback(threadpool_t T, threadpool_threadhandle i);
 
 FLINT_DLL void threadpool_clear(threadpool_t T);
+
+/*
+    Process-wide work-stealing scheduler.
+
+    The global pool is started lazily by the first task spawned from a thread
+    with flint_get_num_threads() > 1 and grows to the largest such thread
+    count seen. Each worker owns a deque of tasks: the owner pushes and pops
+    at the bottom and idle threads steal from the top. Tasks spawned from
+    threads outside the pool go to a shared injection queue. A thread waiting
+    on a group executes queued tasks until the group is finished, so that
+    tasks may themselves spawn and wait on nested groups.
+*/
+
+#define THREADPOOL_MAX_WORKERS 1024
+
+struct threadpool_group_struct;
+
+typedef struct
+{
+    void (* fxn)(void *);
+    void * fxnarg;
+    struct threadpool_group_struct * group;
+    int num_threads;
+} threadpool_task_struct;
+
+typedef struct
+{
+    pthread_mutex_t mutex;
+    threadpool_task_struct ** tasks;
+    slong top;      /* index of oldest task, thieves take from here */
+    slong bottom;   /* one past the newest task, owner works here */
+    slong alloc;
+} threadpool_deque_struct;
+
+typedef struct threadpool_group_struct
+{
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    slong pending;
+} threadpool_group_struct;
+
+typedef threadpool_group_struct threadpool_group_t[1];
+
+FLINT_DLL void threadpool_group_init(threadpool_group_t G);
+
+FLINT_DLL void threadpool_group_spawn(threadpool_group_t G,
+                                                   void (*f)(void*), void * a);
+
+FLINT_DLL void threadpool_group_wait(threadpool_group_t G);
+
+FLINT_DLL void threadpool_group_clear(threadpool_group_t G);
+
+FLINT_DLL void threadpool_parallel_do(void (*f)(void*), void * args,
+                                                      slong n, size_t size);
+
+FLINT_DLL slong threadpool_global_size(void);
+
+FLINT_DLL void threadpool_global_clear(void);
+
+/* internal */
+
+FLINT_DLL slong _threadpool_global_start(slong l);
+
+FLINT_DLL void _threadpool_global_push(threadpool_task_struct * t);
+
+FLINT_DLL threadpool_task_struct * _threadpool_global_pop(void);
+
+FLINT_DLL void _threadpool_task_run(threadpool_task_struct * t);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,277 @@
+/*
+    Copyright (C) 2019 William Hart
+
+    This file is part of FLINT.
+
+    FLINT is free software: you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.  See <http://www.gnu.org/licenses/>.
+*/
+
+#include <string.h>
+#include "threadpool.h"
+
+typedef struct
+{
+    pthread_t pth;
+    threadpool_deque_struct deque;
+    slong idx;
+} _threadpool_worker_struct;
+
+/*
+    The queues are guarded by their own mutexes. The global mutex only
+    protects the count of queued tasks, which is what sleeping workers wait
+    on, and the list of workers.
+*/
+static struct
+{
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    _threadpool_worker_struct * workers[THREADPOOL_MAX_WORKERS];
+    volatile slong length;
+    threadpool_deque_struct inject;
+    slong queued;
+    slong sleeping;
+    int exit;
+} _threadpool_global = {PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER,
+                        {NULL}, 0,
+                        {PTHREAD_MUTEX_INITIALIZER, NULL, 0, 0, 0},
+                        0, 0, 0};
+
+/* the worker owning the calling thread, or NULL outside the pool */
+FLINT_TLS_PREFIX _threadpool_worker_struct * _threadpool_self = NULL;
+
+static void _deque_push(threadpool_deque_struct * D, threadpool_task_struct * t)
+{
+    pthread_mutex_lock(&D->mutex);
+
+    if (D->bottom >= D->alloc)
+    {
+        if (D->top > 0)
+        {
+            memmove(D->tasks, D->tasks + D->top,
+                          (D->bottom - D->top)*sizeof(threadpool_task_struct *));
+            D->bottom -= D->top;
+            D->top = 0;
+        }
+        else
+        {
+            D->alloc = FLINT_MAX(WORD(16), 2*D->alloc);
+            D->tasks = (threadpool_task_struct **) flint_realloc(D->tasks,
+                                   D->alloc*sizeof(threadpool_task_struct *));
+        }
+    }
+
+    D->tasks[D->bottom++] = t;
+
+    pthread_mutex_unlock(&D->mutex);
+}
+
+static threadpool_task_struct * _deque_pop(threadpool_deque_struct * D)
+{
+    threadpool_task_struct * t = NULL;
+
+    pthread_mutex_lock(&D->mutex);
+    if (D->bottom > D->top)
+    {
+        t = D->tasks[--D->bottom];
+        if (D->bottom == D->top)
+            D->bottom = D->top = 0;
+    }
+    pthread_mutex_unlock(&D->mutex);
+
+    return t;
+}
+
+static threadpool_task_struct * _deque_steal(threadpool_deque_struct * D)
+{
+    threadpool_task_struct * t = NULL;
+
+    /* don't bother locking a deque that looks empty */
+    if (D->bottom <= D->top)
+        return NULL;
+
+    pthread_mutex_lock(&D->mutex);
+    if (D->bottom > D->top)
+    {
+        t = D->tasks[D->top++];
+        if (D->bottom == D->top)
+            D->bottom = D->top = 0;
+    }
+    pthread_mutex_unlock(&D->mutex);
+
+    return t;
+}
+
+void _threadpool_global_push(threadpool_task_struct * t)
+{
+    if (_threadpool_self != NULL)
+        _deque_push(&_threadpool_self->deque, t);
+    else
+        _deque_push(&_threadpool_global.inject, t);
+
+    pthread_mutex_lock(&_threadpool_global.mutex);
+    _threadpool_global.queued++;
+    if (_threadpool_global.sleeping > 0)
+        pthread_cond_signal(&_threadpool_global.cond);
+    pthread_mutex_unlock(&_threadpool_global.mutex);
+}
+
+/*
+    Take the newest task of our own deque, otherwise the oldest task of the
+    injection queue or of some other worker. Return NULL if nothing is queued.
+*/
+threadpool_task_struct * _threadpool_global_pop(void)
+{
+    _threadpool_worker_struct * self = _threadpool_self;
+    threadpool_task_struct * t = NULL;
+    slong i, start, length = _threadpool_global.length;
+
+    if (self != NULL)
+        t = _deque_pop(&self->deque);
+
+    if (t == NULL)
+        t = _deque_steal(&_threadpool_global.inject);
+
+    if (t == NULL && length > 0)
+    {
+        /* start with our neighbour so that thieves spread out */
+        start = (self != NULL) ? self->idx + 1 : 0;
+        for (i = 0; i < length && t == NULL; i++)
+        {
+            _threadpool_worker_struct * w;
+            w = _threadpool_global.workers[(start + i) % length];
+            if (w != NULL && w != self)
+                t = _deque_steal(&w->deque);
+        }
+    }
+
+    if (t != NULL)
+    {
+        pthread_mutex_lock(&_threadpool_global.mutex);
+        _threadpool_global.queued--;
+        pthread_mutex_unlock(&_threadpool_global.mutex);
+    }
+
+    return t;
+}
+
+static void * _threadpool_worker_loop(void * varg)
+{
+    _threadpool_worker_struct * w = (_threadpool_worker_struct *) varg;
+    threadpool_task_struct * t;
+    int exit = 0;
+
+    _threadpool_self = w;
+
+    while (!exit)
+    {
+        t = _threadpool_global_pop();
+        if (t != NULL)
+        {
+            _threadpool_task_run(t);
+            continue;
+        }
+
+        pthread_mutex_lock(&_threadpool_global.mutex);
+        while (_threadpool_global.queued == 0 && !_threadpool_global.exit)
+        {
+            _threadpool_global.sleeping++;
+            pthread_cond_wait(&_threadpool_global.cond,
+                              &_threadpool_global.mutex);
+            _threadpool_global.sleeping--;
+        }
+        exit = _threadpool_global.exit && _threadpool_global.queued == 0;
+        pthread_mutex_unlock(&_threadpool_global.mutex);
+    }
+
+    _threadpool_self = NULL;
+
+    flint_cleanup();
+
+    return NULL;
+}
+
+slong _threadpool_global_start(slong l)
+{
+    slong i, length;
+
+    l = FLINT_MIN(l, THREADPOOL_MAX_WORKERS);
+
+    if (_threadpool_global.length >= l)
+        return _threadpool_global.length;
+
+    pthread_mutex_lock(&_threadpool_global.mutex);
+
+    for (i = _threadpool_global.length; i < l; i++)
+    {
+        _threadpool_worker_struct * w;
+
+        w = (_threadpool_worker_struct *)
+                               flint_malloc(sizeof(_threadpool_worker_struct));
+        pthread_mutex_init(&w->deque.mutex, NULL);
+        w->deque.tasks = NULL;
+        w->deque.top = 0;
+        w->deque.bottom = 0;
+        w->deque.alloc = 0;
+        w->idx = i;
+
+        if (pthread_create(&w->pth, NULL, _threadpool_worker_loop, w) != 0)
+        {
+            pthread_mutex_destroy(&w->deque.mutex);
+            flint_free(w);
+            break;
+        }
+
+        /* publish the worker before the new length */
+        _threadpool_global.workers[i] = w;
+        _threadpool_global.length = i + 1;
+    }
+
+    length = _threadpool_global.length;
+
+    pthread_mutex_unlock(&_threadpool_global.mutex);
+
+    return length;
+}
+
+slong threadpool_global_size(void)
+{
+    return _threadpool_global.length;
+}
+
+void threadpool_global_clear(void)
+{
+    slong i, length;
+
+    pthread_mutex_lock(&_threadpool_global.mutex);
+    length = _threadpool_global.length;
+    _threadpool_global.exit = 1;
+    pthread_cond_broadcast(&_threadpool_global.cond);
+    pthread_mutex_unlock(&_threadpool_global.mutex);
+
+    for (i = 0; i < length; i++)
+        pthread_join(_threadpool_global.workers[i]->pth, NULL);
+
+    pthread_mutex_lock(&_threadpool_global.mutex);
+    for (i = 0; i < length; i++)
+    {
+        _threadpool_worker_struct * w = _threadpool_global.workers[i];
+        FLINT_ASSERT(w->deque.bottom == w->deque.top);
+        pthread_mutex_destroy(&w->deque.mutex);
+        flint_free(w->deque.tasks);
+        flint_free(w);
+        _threadpool_global.workers[i] = NULL;
+    }
+    _threadpool_global.length = 0;
+    _threadpool_global.exit = 0;
+
+    FLINT_ASSERT(_threadpool_global.queued == 0);
+    flint_free(_threadpool_global.inject.tasks);
+    _threadpool_global.inject.tasks = NULL;
+    _threadpool_global.inject.top = 0;
+    _threadpool_global.inject.bottom = 0;
+    _threadpool_global.inject.alloc = 0;
+    pthread_mutex_unlock(&_threadpool_global.mutex);
+}
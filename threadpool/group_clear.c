@@ -0,0 +1,20 @@
+/*
+    Copyright (C) 2019 William Hart
+
+    This file is part of FLINT.
+
+    FLINT is free software: you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.  See <http://www.gnu.org/licenses/>.
+*/
+
+#include "threadpool.h"
+
+
+void threadpool_group_clear(threadpool_group_t G)
+{
+    FLINT_ASSERT(G->pending == 0); /* all tasks should have been waited on */
+    pthread_cond_destroy(&G->cond);
+    pthread_mutex_destroy(&G->mutex);
+}
@@ -0,0 +1,20 @@
+/*
+    Copyright (C) 2019 William Hart
+
+    This file is part of FLINT.
+
+    FLINT is free software: you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.  See <http://www.gnu.org/licenses/>.
+*/
+
+#include "threadpool.h"
+
+
+void threadpool_group_init(threadpool_group_t G)
+{
+    pthread_mutex_init(&G->mutex, NULL);
+    pthread_cond_init(&G->cond, NULL);
+    G->pending = 0;
+}
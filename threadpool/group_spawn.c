@@ -0,0 +1,38 @@
+/*
+    Copyright (C) 2019 William Hart
+
+    This file is part of FLINT.
+
+    FLINT is free software: you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.  See <http://www.gnu.org/licenses/>.
+*/
+
+#include "threadpool.h"
+
+
+void threadpool_group_spawn(threadpool_group_t G, void (*f)(void*), void * a)
+{
+    threadpool_task_struct * t;
+    int num_threads = flint_get_num_threads();
+
+    /* nothing to gain from queueing the task */
+    if (num_threads <= 1 || _threadpool_global_start(num_threads - 1) <= 0)
+    {
+        f(a);
+        return;
+    }
+
+    t = (threadpool_task_struct *) flint_malloc(sizeof(threadpool_task_struct));
+    t->fxn = f;
+    t->fxnarg = a;
+    t->group = G;
+    t->num_threads = num_threads;
+
+    pthread_mutex_lock(&G->mutex);
+    G->pending++;
+    pthread_mutex_unlock(&G->mutex);
+
+    _threadpool_global_push(t);
+}
@@ -0,0 +1,46 @@
+/*
+    Copyright (C) 2019 William Hart
+
+    This file is part of FLINT.
+
+    FLINT is free software: you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.  See <http://www.gnu.org/licenses/>.
+*/
+
+#include "threadpool.h"
+
+
+void threadpool_group_wait(threadpool_group_t G)
+{
+    threadpool_task_struct * t;
+
+    while (1)
+    {
+        pthread_mutex_lock(&G->mutex);
+        if (G->pending == 0)
+        {
+            pthread_mutex_unlock(&G->mutex);
+            return;
+        }
+        pthread_mutex_unlock(&G->mutex);
+
+        /* help out with queued work, which may well be our own */
+        t = _threadpool_global_pop();
+        if (t != NULL)
+        {
+            _threadpool_task_run(t);
+            continue;
+        }
+
+        /*
+            Nothing is queued, so the remaining tasks of G are running
+            elsewhere. Sleep until one of them finishes the group.
+        */
+        pthread_mutex_lock(&G->mutex);
+        if (G->pending > 0)
+            pthread_cond_wait(&G->cond, &G->mutex);
+        pthread_mutex_unlock(&G->mutex);
+    }
+}
@@ -0,0 +1,33 @@
+/*
+    Copyright (C) 2019 William Hart
+
+    This file is part of FLINT.
+
+    FLINT is free software: you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.  See <http://www.gnu.org/licenses/>.
+*/
+
+#include "threadpool.h"
+
+
+void threadpool_parallel_do(void (*f)(void*), void * args,
+                                                       slong n, size_t size)
+{
+    slong i;
+    threadpool_group_t G;
+
+    if (n <= 0)
+        return;
+
+    threadpool_group_init(G);
+
+    for (i = n - 1; i > 0; i--)
+        threadpool_group_spawn(G, f, (char *) args + i*size);
+
+    f(args);
+
+    threadpool_group_wait(G);
+    threadpool_group_clear(G);
+}
@@ -0,0 +1,31 @@
+/*
+    Copyright (C) 2019 William Hart
+
+    This file is part of FLINT.
+
+    FLINT is free software: you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.  See <http://www.gnu.org/licenses/>.
+*/
+
+#include "threadpool.h"
+
+
+void _threadpool_task_run(threadpool_task_struct * t)
+{
+    threadpool_group_struct * G = t->group;
+    int num_threads = flint_get_num_threads();
+
+    /* the task may itself spawn, with the thread count of its parent */
+    flint_set_num_threads(t->num_threads);
+    t->fxn(t->fxnarg);
+    flint_set_num_threads(num_threads);
+
+    flint_free(t);
+
+    pthread_mutex_lock(&G->mutex);
+    if (--G->pending == 0)
+        pthread_cond_broadcast(&G->cond);
+    pthread_mutex_unlock(&G->mutex);
+}
@@ -0,0 +1,197 @@
+/*
+    Copyright (C) 2019 William Hart
+
+    This file is part of FLINT.
+
+    FLINT is free software: you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.  See <http://www.gnu.org/licenses/>.
+*/
+
+#include "threadpool.h"
+#include "fmpz.h"
+
+/******************************************************************************
+    test1:
+        calculate x = n! by splitting (min, max] into residue classes
+        which are handled by threadpool_parallel_do
+*******************************************************************************/
+
+typedef struct
+{
+    ulong modulus;
+    ulong residue;
+    ulong n;
+    fmpz_t ans;
+}
+worker1_arg_struct;
+
+void worker1(void * varg)
+{
+    worker1_arg_struct * arg = (worker1_arg_struct *) varg;
+    ulong i;
+
+    fmpz_one(arg->ans);
+    for (i = arg->residue; i <= arg->n; i += arg->modulus)
+        fmpz_mul_ui(arg->ans, arg->ans, i);
+}
+
+void test1(fmpz_t x, ulong n, slong num)
+{
+    slong k;
+    worker1_arg_struct * args;
+
+    args = (worker1_arg_struct *) flint_malloc(num*sizeof(worker1_arg_struct));
+
+    for (k = 0; k < num; k++)
+    {
+        args[k].residue = k + 1;
+        args[k].modulus = num;
+        args[k].n = n;
+        fmpz_init(args[k].ans);
+    }
+
+    threadpool_parallel_do(worker1, args, num, sizeof(worker1_arg_struct));
+
+    fmpz_one(x);
+    for (k = 0; k < num; k++)
+    {
+        fmpz_mul(x, x, args[k].ans);
+        fmpz_clear(args[k].ans);
+    }
+
+    flint_free(args);
+}
+
+/******************************************************************************
+    test2 - calculate x = n! by recursively spawning nested groups
+*******************************************************************************/
+
+typedef struct
+{
+    ulong min;
+    ulong max;
+    fmpz_t ans;
+}
+worker2_arg_struct;
+
+void test2_helper(fmpz_t x, ulong min, ulong max);
+
+void worker2(void * varg)
+{
+    worker2_arg_struct * arg = (worker2_arg_struct *) varg;
+
+    test2_helper(arg->ans, arg->min, arg->max);
+}
+
+/* set x = product of numbers in (min, max] */
+void test2_helper(fmpz_t x, ulong min, ulong max)
+{
+    ulong i, mid;
+    threadpool_group_t G;
+    worker2_arg_struct args[2];
+
+    FLINT_ASSERT(max >= min);
+
+    if (max - min > UWORD(20))
+    {
+        mid = min + ((max - min)/UWORD(2));
+
+        args[0].min = min;
+        args[0].max = mid;
+        args[1].min = mid;
+        args[1].max = max;
+        fmpz_init(args[0].ans);
+        fmpz_init(args[1].ans);
+
+        threadpool_group_init(G);
+        threadpool_group_spawn(G, worker2, &args[0]);
+        threadpool_group_spawn(G, worker2, &args[1]);
+        threadpool_group_wait(G);
+        threadpool_group_clear(G);
+
+        fmpz_mul(x, args[0].ans, args[1].ans);
+        fmpz_clear(args[0].ans);
+        fmpz_clear(args[1].ans);
+    }
+    else
+    {
+        fmpz_one(x);
+        for (i = max; i > min; i--)
+            fmpz_mul_ui(x, x, i);
+    }
+}
+
+void test2(fmpz_t x, ulong n)
+{
+    test2_helper(x, 0, n);
+}
+
+
+int
+main(void)
+{
+    slong i, j;
+    FLINT_TEST_INIT(state);
+
+    flint_printf("group....");
+    fflush(stdout);
+
+    for (i = 0; i < 10*flint_test_multiplier(); i++)
+    {
+        fmpz_t x, y;
+
+        fmpz_init(x);
+        fmpz_init(y);
+        flint_set_num_threads(n_randint(state, 10) + 1);
+
+        for (j = 0; j < 10; j++)
+        {
+            ulong n = n_randint(state, 1000);
+
+            fmpz_fac_ui(y, n);
+
+            test1(x, n, n_randint(state, 20) + 1);
+            if (!fmpz_equal(x, y))
+            {
+                flint_printf("n: %wu\n", n);
+                printf("x: "); fmpz_print(x); printf("\n");
+                printf("y: "); fmpz_print(y); printf("\n");
+                printf("test1 failed\n");
+                flint_abort();
+            }
+
+            test2(x, n);
+            if (!fmpz_equal(x, y))
+            {
+                flint_printf("n: %wu\n", n);
+                printf("x: "); fmpz_print(x); printf("\n");
+                printf("y: "); fmpz_print(y); printf("\n");
+                printf("test2 failed\n");
+                flint_abort();
+            }
+        }
+
+        if (threadpool_global_size() > 9)
+        {
+            flint_printf("FAIL:\n");
+            flint_printf("pool has %wd workers\n", threadpool_global_size());
+            flint_abort();
+        }
+
+        /* exercise restarting the pool */
+        if (n_randint(state, 4) == 0)
+            threadpool_global_clear();
+
+        fmpz_clear(y);
+        fmpz_clear(x);
+    }
+
+    threadpool_global_clear();
+
+    FLINT_TEST_CLEANUP(state);
+
+    flint_printf("PASS\n");
+    return 0;
+}
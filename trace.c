@@ -0,0 +1,203 @@
+/*
+    Copyright (C) 2019 William Hart
+
+    This file is part of FLINT.
+
+    FLINT is free software: you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.  See <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "flint.h"
+
+/*
+    For each dispatcher, the table has a row for each algorithm it has
+    chosen, in the order they were first seen, and each row has a counter
+    and the total time for each operand size bucket. Bucket b holds the
+    calls with 2^(b-1) <= size < 2^b, i.e. FLINT_BIT_COUNT(size) = b.
+
+    The algorithm names are string literals given by the dispatchers and
+    are compared by content, so the same name may be used in several
+    places.
+*/
+
+#define FLINT_TRACE_MAX_ALGS 16
+
+#define FLINT_TRACE_BUCKETS FLINT_BITS
+
+typedef struct
+{
+    ulong calls;
+    ulong cycles;
+} _flint_trace_entry_struct;
+
+static const char * _flint_trace_names[FLINT_TRACE_NUM_DISPATCHERS] =
+{
+    "fmpz_mat_mul",
+    "fmpz_poly_mul",
+    "nmod_mat_mul",
+    "nmod_poly_mul"
+};
+
+static const char *
+_flint_trace_algs[FLINT_TRACE_NUM_DISPATCHERS][FLINT_TRACE_MAX_ALGS];
+
+static _flint_trace_entry_struct _flint_trace_tab
+    [FLINT_TRACE_NUM_DISPATCHERS][FLINT_TRACE_MAX_ALGS][FLINT_TRACE_BUCKETS];
+
+static flint_trace_func_t _flint_trace_func = NULL;
+static void * _flint_trace_data = NULL;
+
+static pthread_mutex_t _flint_trace_lock = PTHREAD_MUTEX_INITIALIZER;
+
+ulong flint_trace_clock(void)
+{
+#if defined(__GNUC__) && defined(__x86_64__)
+    unsigned int hi, lo;
+
+    __asm__ __volatile__ ("rdtsc" : "=a" (lo), "=d" (hi));
+
+    return ((ulong) hi << 32) | lo;
+#else
+    return clock();
+#endif
+}
+
+/* index of alg in the row for d, -1 if not present; the lock must be held */
+static slong _flint_trace_find(flint_trace_t d, const char * alg)
+{
+    slong i;
+
+    for (i = 0; i < FLINT_TRACE_MAX_ALGS && _flint_trace_algs[d][i] != NULL;
+                                                                          i++)
+    {
+        if (strcmp(_flint_trace_algs[d][i], alg) == 0)
+            return i;
+    }
+
+    return -1;
+}
+
+void flint_trace_record(flint_trace_t d, const char * alg,
+                                                      slong size, ulong cycles)
+{
+    flint_trace_func_t func;
+    void * data;
+    slong i, b = FLINT_BIT_COUNT(FLINT_MAX(size, 0));
+
+    pthread_mutex_lock(&_flint_trace_lock);
+
+    i = _flint_trace_find(d, alg);
+
+    if (i < 0)
+    {
+        for (i = 0; i < FLINT_TRACE_MAX_ALGS; i++)
+            if (_flint_trace_algs[d][i] == NULL)
+                break;
+
+        if (i == FLINT_TRACE_MAX_ALGS)
+        {
+            pthread_mutex_unlock(&_flint_trace_lock);
+            flint_printf("Exception (flint_trace_record). Too many "
+                         "algorithms for %s.\n", _flint_trace_names[d]);
+            flint_abort();
+        }
+
+        _flint_trace_algs[d][i] = alg;
+    }
+
+    _flint_trace_tab[d][i][b].calls++;
+    _flint_trace_tab[d][i][b].cycles += cycles;
+
+    func = _flint_trace_func;
+    data = _flint_trace_data;
+
+    pthread_mutex_unlock(&_flint_trace_lock);
+
+    if (func != NULL)
+        func(d, alg, size, cycles, data);
+}
+
+ulong flint_trace_calls(flint_trace_t d, const char * alg, ulong * cycles)
+{
+    ulong calls = 0, total = 0;
+    slong i, b;
+
+    pthread_mutex_lock(&_flint_trace_lock);
+
+    i = _flint_trace_find(d, alg);
+
+    if (i >= 0)
+    {
+        for (b = 0; b < FLINT_TRACE_BUCKETS; b++)
+        {
+            calls += _flint_trace_tab[d][i][b].calls;
+            total += _flint_trace_tab[d][i][b].cycles;
+        }
+    }
+
+    pthread_mutex_unlock(&_flint_trace_lock);
+
+    if (cycles != NULL)
+        *cycles = total;
+
+    return calls;
+}
+
+const char * flint_trace_name(flint_trace_t d)
+{
+    return _flint_trace_names[d];
+}
+
+void flint_trace_set_callback(flint_trace_func_t func, void * data)
+{
+    pthread_mutex_lock(&_flint_trace_lock);
+    _flint_trace_func = func;
+    _flint_trace_data = data;
+    pthread_mutex_unlock(&_flint_trace_lock);
+}
+
+void flint_trace_reset(void)
+{
+    pthread_mutex_lock(&_flint_trace_lock);
+    memset(_flint_trace_algs, 0, sizeof(_flint_trace_algs));
+    memset(_flint_trace_tab, 0, sizeof(_flint_trace_tab));
+    pthread_mutex_unlock(&_flint_trace_lock);
+}
+
+void flint_trace_dump(FILE * file)
+{
+    slong d, i, b;
+    _flint_trace_entry_struct * e;
+
+    pthread_mutex_lock(&_flint_trace_lock);
+
+    fprintf(file, "# dispatcher algorithm min_size max_size calls cycles\n");
+
+    for (d = 0; d < FLINT_TRACE_NUM_DISPATCHERS; d++)
+    {
+        for (i = 0; i < FLINT_TRACE_MAX_ALGS &&
+                                          _flint_trace_algs[d][i] != NULL; i++)
+        {
+            for (b = 0; b < FLINT_TRACE_BUCKETS; b++)
+            {
+                e = &_flint_trace_tab[d][i][b];
+
+                if (e->calls == 0)
+                    continue;
+
+                flint_fprintf(file, "%s %s %wu %wu %wu %wu\n",
+                    _flint_trace_names[d], _flint_trace_algs[d][i],
+                    b == 0 ? UWORD(0) : UWORD(1) << (b - 1),
+                    (UWORD(1) << b) - 1, e->calls, e->cycles);
+            }
+        }
+    }
+
+    pthread_mutex_unlock(&_flint_trace_lock);
+}
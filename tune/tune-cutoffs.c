@@ -0,0 +1,467 @@
+/*
+    Copyright (C) 2019 William Hart
+
+    This file is part of FLINT.
+
+    FLINT is free software: you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.  See <http://www.gnu.org/licenses/>.
+*/
+
+/*
+   Measures the crossover points of the runtime algorithm cutoffs on this
+   machine and writes them to a tuning file, by default flint_tuning.txt,
+   which can be loaded with flint_load_cutoffs or by setting the environment
+   variable FLINT_TUNING_FILE.
+
+   Usage: tune-cutoffs [filename]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <gmp.h>
+#include "flint.h"
+#include "ulong_extras.h"
+#include "nmod_vec.h"
+#include "nmod_poly.h"
+#include "nmod_mat.h"
+#include "fmpz_mat.h"
+#include "fft.h"
+
+#define MIN_TIME 0.05
+
+typedef void (* tune_fn)(void * arg, slong size, int alg);
+
+/* seconds per call of fn(arg, size, alg), best of three */
+double time_call(tune_fn fn, void * arg, slong size, int alg)
+{
+    double best = 0.0, t;
+    slong i, reps = 1, j;
+    clock_t start;
+
+    for (j = 0; j < 3; j++)
+    {
+        while (1)
+        {
+            start = clock();
+            for (i = 0; i < reps; i++)
+                fn(arg, size, alg);
+            t = (double) (clock() - start) / CLOCKS_PER_SEC;
+
+            if (t >= MIN_TIME)
+                break;
+
+            reps = t < MIN_TIME / 16 ? 8 * reps : 2 * reps;
+        }
+
+        t /= reps;
+        if (j == 0 || t < best)
+            best = t;
+    }
+
+    return best;
+}
+
+/*
+   Returns the index of the first of the increasing sizes from which
+   alg 1 is faster than alg 0 at two consecutive sizes, or num if it never
+   is.
+*/
+slong find_crossover(tune_fn fn, void * arg, const slong * sizes, slong num)
+{
+    slong i, wins = 0;
+    double t0, t1;
+
+    for (i = 0; i < num; i++)
+    {
+        t0 = time_call(fn, arg, sizes[i], 0);
+        t1 = time_call(fn, arg, sizes[i], 1);
+
+        flint_printf("      %wd: %.3g / %.3g us\n", sizes[i], 1e6*t0, 1e6*t1);
+
+        if (t1 < t0)
+        {
+            if (++wins == 2)
+                return i - 1;
+        }
+        else
+            wins = 0;
+    }
+
+    return wins == 1 ? num - 1 : num;
+}
+
+/******************************************************************************
+
+    nmod_poly_mul: KS against KS2, and KS2 against KS4
+
+******************************************************************************/
+
+typedef struct
+{
+    nmod_t mod;
+    mp_ptr a, b, r;
+    int algs;
+} poly_arg_struct;
+
+void poly_mul(void * arg, slong len, int alg)
+{
+    poly_arg_struct * p = (poly_arg_struct *) arg;
+    int which = alg + p->algs;
+
+    if (which == 0)
+        _nmod_poly_mul_KS(p->r, p->a, len, p->b, len, 0, p->mod);
+    else if (which == 1)
+        _nmod_poly_mul_KS2(p->r, p->a, len, p->b, len, p->mod);
+    else
+        _nmod_poly_mul_KS4(p->r, p->a, len, p->b, len, p->mod);
+}
+
+/* the KS2/KS4 cutoffs are in units of bits*len */
+slong tune_nmod_poly_mul(flint_rand_t state, int algs)
+{
+    static const slong lens[] = { 2, 3, 4, 6, 8, 11, 16, 23, 32, 45, 64,
+                                  90, 128, 181, 256, 362, 512, 724, 1024 };
+    const slong num = sizeof(lens) / sizeof(slong), max_len = lens[num - 1];
+    const mp_bitcnt_t test_bits[3] = { FLINT_BITS/4, FLINT_BITS/2,
+                                                              FLINT_BITS - 1 };
+    slong res[3], i, j, t;
+    poly_arg_struct p[1];
+
+    p->a = _nmod_vec_init(max_len);
+    p->b = _nmod_vec_init(max_len);
+    p->r = _nmod_vec_init(2*max_len - 1);
+    p->algs = algs;
+
+    for (i = 0; i < 3; i++)
+    {
+        nmod_init(&p->mod, n_randbits(state, test_bits[i]) | 1);
+        _nmod_vec_randtest(p->a, state, max_len, p->mod);
+        _nmod_vec_randtest(p->b, state, max_len, p->mod);
+
+        flint_printf("   %wu bits:\n", FLINT_BITS - p->mod.norm);
+
+        j = find_crossover(poly_mul, p, lens, num);
+        res[i] = (FLINT_BITS - p->mod.norm)*(j < num ? lens[j] : 2*max_len);
+    }
+
+    _nmod_vec_clear(p->a);
+    _nmod_vec_clear(p->b);
+    _nmod_vec_clear(p->r);
+
+    /* median of the three */
+    if (res[0] > res[1]) t = res[0], res[0] = res[1], res[1] = t;
+    if (res[1] > res[2]) t = res[1], res[1] = res[2], res[2] = t;
+    if (res[0] > res[1]) t = res[0], res[0] = res[1], res[1] = t;
+
+    return res[1];
+}
+
+/******************************************************************************
+
+    nmod_mat_mul: classical against one level of Strassen
+
+******************************************************************************/
+
+typedef struct
+{
+    nmod_mat_t A, B, C;
+} nmod_mat_arg_struct;
+
+void nmod_mat_mul_dim(void * arg, slong dim, int alg)
+{
+    nmod_mat_arg_struct * p = (nmod_mat_arg_struct *) arg;
+    nmod_mat_t A, B, C;
+
+    nmod_mat_window_init(A, p->A, 0, 0, dim, dim);
+    nmod_mat_window_init(B, p->B, 0, 0, dim, dim);
+    nmod_mat_window_init(C, p->C, 0, 0, dim, dim);
+
+    /* the recursive calls are always below the cutoff */
+    flint_set_cutoff(FLINT_CUTOFF_NMOD_MAT_MUL_STRASSEN, alg ? dim : dim + 1);
+    nmod_mat_mul(C, A, B);
+
+    nmod_mat_window_clear(A);
+    nmod_mat_window_clear(B);
+    nmod_mat_window_clear(C);
+}
+
+slong tune_nmod_mat_mul(flint_rand_t state)
+{
+    static const slong dims[] = { 32, 48, 64, 96, 128, 160, 192, 256, 320,
+                                  384, 448, 512, 640, 768 };
+    const slong num = sizeof(dims) / sizeof(slong), max_dim = dims[num - 1];
+    nmod_mat_arg_struct p[1];
+    mp_limb_t n = n_randbits(state, FLINT_BITS - 1) | 1;
+    slong j;
+
+    nmod_mat_init(p->A, max_dim, max_dim, n);
+    nmod_mat_init(p->B, max_dim, max_dim, n);
+    nmod_mat_init(p->C, max_dim, max_dim, n);
+    nmod_mat_randfull(p->A, state);
+    nmod_mat_randfull(p->B, state);
+
+    j = find_crossover(nmod_mat_mul_dim, p, dims, num);
+
+    nmod_mat_clear(p->A);
+    nmod_mat_clear(p->B);
+    nmod_mat_clear(p->C);
+
+    return j < num ? dims[j] : 2*max_dim;
+}
+
+/******************************************************************************
+
+    fmpz_mat_mul
+
+******************************************************************************/
+
+typedef struct
+{
+    fmpz_mat_t A, B, C;
+    slong dim;
+    mp_bitcnt_t bits;
+    flint_rand_s * state;
+} fmpz_mat_arg_struct;
+
+void fmpz_mat_arg_set(fmpz_mat_arg_struct * p, slong dim, mp_bitcnt_t bits)
+{
+    if (p->dim != dim)
+    {
+        fmpz_mat_clear(p->A);
+        fmpz_mat_clear(p->B);
+        fmpz_mat_clear(p->C);
+        fmpz_mat_init(p->A, dim, dim);
+        fmpz_mat_init(p->B, dim, dim);
+        fmpz_mat_init(p->C, dim, dim);
+        p->bits = 0;
+    }
+
+    if (p->bits != bits)
+    {
+        fmpz_mat_randbits(p->A, p->state, bits);
+        fmpz_mat_randbits(p->B, p->state, bits);
+    }
+
+    p->dim = dim;
+    p->bits = bits;
+}
+
+/* bits of the output, as computed by fmpz_mat_mul */
+mp_bitcnt_t fmpz_mat_arg_out_bits(fmpz_mat_arg_struct * p)
+{
+    return 2*p->bits + FLINT_BIT_COUNT(p->dim) + 1;
+}
+
+/* small entries: classical against multimodular, by dimension */
+void fmpz_mat_mul_small_dim(void * arg, slong dim, int alg)
+{
+    fmpz_mat_arg_struct * p = (fmpz_mat_arg_struct *) arg;
+
+    fmpz_mat_arg_set(p, dim, 16);
+
+    if (alg == 0)
+        fmpz_mat_mul_classical_inline(p->C, p->A, p->B);
+    else
+        _fmpz_mat_mul_multi_mod(p->C, p->A, p->B, fmpz_mat_arg_out_bits(p));
+}
+
+/* large entries: classical against one level of Strassen, by bits */
+void fmpz_mat_mul_classical_bits(void * arg, slong bits, int alg)
+{
+    fmpz_mat_arg_struct * p = (fmpz_mat_arg_struct *) arg;
+
+    fmpz_mat_arg_set(p, 32, bits);
+
+    if (alg == 0)
+        fmpz_mat_mul_classical_inline(p->C, p->A, p->B);
+    else
+    {
+        flint_set_cutoff(FLINT_CUTOFF_FMPZ_MAT_MUL_CLASSICAL,
+                                                         2*bits*p->dim);
+        fmpz_mat_mul_strassen(p->C, p->A, p->B);
+    }
+}
+
+/* Strassen against multimodular, by dimension at fixed bits */
+void fmpz_mat_mul_multi_mod_dim(void * arg, slong dim, int alg)
+{
+    fmpz_mat_arg_struct * p = (fmpz_mat_arg_struct *) arg;
+
+    fmpz_mat_arg_set(p, dim, 500);
+
+    if (alg == 0)
+        fmpz_mat_mul_strassen(p->C, p->A, p->B);
+    else
+        _fmpz_mat_mul_multi_mod(p->C, p->A, p->B, fmpz_mat_arg_out_bits(p));
+}
+
+/* Strassen against multimodular, by bits at fixed dimension */
+void fmpz_mat_mul_multi_mod_bits(void * arg, slong bits, int alg)
+{
+    fmpz_mat_arg_struct * p = (fmpz_mat_arg_struct *) arg;
+
+    fmpz_mat_arg_set(p, p->dim, bits);
+
+    if (alg == 0)
+        fmpz_mat_mul_strassen(p->C, p->A, p->B);
+    else
+        _fmpz_mat_mul_multi_mod(p->C, p->A, p->B, fmpz_mat_arg_out_bits(p));
+}
+
+void tune_fmpz_mat_mul(flint_rand_t state)
+{
+    static const slong small_dims[] = { 4, 6, 8, 10, 12, 14, 16, 20, 24,
+                                        28, 32, 40, 48 };
+    static const slong classical_bits[] = { 128, 192, 256, 384, 512, 768,
+                                            1024, 1536, 2048, 3072, 4096 };
+    static const slong multi_mod_dims[] = { 16, 24, 32, 48, 64, 80, 96,
+                                            112, 128, 160, 192 };
+    static const slong multi_mod_bits[] = { 32, 64, 96, 128, 192, 256, 384,
+                                            512, 768, 1024 };
+    fmpz_mat_arg_struct p[1];
+    slong j, num, dim;
+
+    fmpz_mat_init(p->A, 0, 0);
+    fmpz_mat_init(p->B, 0, 0);
+    fmpz_mat_init(p->C, 0, 0);
+    p->dim = 0;
+    p->bits = 0;
+    p->state = state;
+
+    /* keep the multimodular algorithm out of the Strassen recursion */
+    flint_set_cutoff(FLINT_CUTOFF_FMPZ_MAT_MUL_MULTI_MOD_DIM, WORD_MAX);
+
+    flint_printf("fmpz_mat_mul small dimension\n");
+    num = sizeof(small_dims) / sizeof(slong);
+    j = find_crossover(fmpz_mat_mul_small_dim, p, small_dims, num);
+    flint_set_cutoff(FLINT_CUTOFF_FMPZ_MAT_MUL_SMALL,
+                                 j < num ? small_dims[j] : small_dims[num - 1]);
+
+    flint_printf("fmpz_mat_mul classical (dimension 32)\n");
+    num = sizeof(classical_bits) / sizeof(slong);
+    j = find_crossover(fmpz_mat_mul_classical_bits, p, classical_bits, num);
+    flint_set_cutoff(FLINT_CUTOFF_FMPZ_MAT_MUL_CLASSICAL, 2*32*
+                    (j < num ? classical_bits[j] : 2*classical_bits[num - 1]));
+
+    flint_printf("fmpz_mat_mul multimodular dimension (500 bits)\n");
+    num = sizeof(multi_mod_dims) / sizeof(slong);
+    j = find_crossover(fmpz_mat_mul_multi_mod_dim, p, multi_mod_dims, num);
+    dim = j < num ? multi_mod_dims[j] : 2*multi_mod_dims[num - 1];
+
+    flint_printf("fmpz_mat_mul multimodular bits (dimension %wd)\n", dim + 1);
+    fmpz_mat_arg_set(p, dim + 1, multi_mod_bits[0]);
+    num = sizeof(multi_mod_bits) / sizeof(slong);
+    j = find_crossover(fmpz_mat_mul_multi_mod_bits, p, multi_mod_bits, num);
+
+    /* the cutoffs are strict inequalities on dim and bits(A) + bits(B) */
+    flint_set_cutoff(FLINT_CUTOFF_FMPZ_MAT_MUL_MULTI_MOD_DIM, dim - 1);
+    flint_set_cutoff(FLINT_CUTOFF_FMPZ_MAT_MUL_MULTI_MOD_BITS,
+              2*(j < num ? multi_mod_bits[j] : 2*multi_mod_bits[num - 1]) - 1);
+
+    fmpz_mat_clear(p->A);
+    fmpz_mat_clear(p->B);
+    fmpz_mat_clear(p->C);
+}
+
+/******************************************************************************
+
+    fft_mulmod_2expp1: basecase against one level of FFT
+
+******************************************************************************/
+
+typedef struct
+{
+    mp_limb_t * i1, * i2, * r, * tt;
+} fft_arg_struct;
+
+/* size is the number of limbs, which is a power of 2 */
+void fft_mulmod_limbs(void * arg, slong limbs, int alg)
+{
+    fft_arg_struct * p = (fft_arg_struct *) arg;
+
+    /* reduce the inputs mod 2^(limbs*FLINT_BITS) + 1 */
+    p->i1[limbs] = 0;
+    p->i2[limbs] = 0;
+
+    /* the pointwise products are much smaller than the cutoff */
+    flint_set_cutoff(FLINT_CUTOFF_FFT_MULMOD_2EXPP1, alg ? limbs - 1 : limbs);
+    fft_mulmod_2expp1(p->r, p->i1, p->i2, limbs*FLINT_BITS, 1, p->tt);
+}
+
+slong tune_fft_mulmod_2expp1(flint_rand_t state)
+{
+    static const slong limbs[] = { 16, 32, 64, 128, 256, 512, 1024, 2048 };
+    const slong num = sizeof(limbs) / sizeof(slong), max = limbs[num - 1];
+    fft_arg_struct p[1];
+    slong j;
+
+    p->i1 = flint_malloc(5*(max + 1)*sizeof(mp_limb_t));
+    p->i2 = p->i1 + max + 1;
+    p->r = p->i2 + max + 1;
+    p->tt = p->r + max + 1;
+
+    for (j = 0; j <= max; j++)
+    {
+        p->i1[j] = n_randlimb(state);
+        p->i2[j] = n_randlimb(state);
+    }
+
+    j = find_crossover(fft_mulmod_limbs, p, limbs, num);
+
+    flint_free(p->i1);
+
+    /* the cutoff is the largest size using the basecase */
+    return j == 0 ? limbs[0] : (j < num ? limbs[j - 1] : max);
+}
+
+int
+main(int argc, char * argv[])
+{
+    const char * filename = argc > 1 ? argv[1] : "flint_tuning.txt";
+    slong ks2, ks4, strassen, fft;
+    FLINT_TEST_INIT(state);
+
+    if (argc > 2)
+    {
+        flint_printf("usage: %s [filename]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    _flint_rand_init_gmp(state);
+
+    /* start from the defaults, not from any FLINT_TUNING_FILE */
+    flint_reset_cutoffs();
+
+    flint_printf("fft_mulmod_2expp1\n");
+    fft = tune_fft_mulmod_2expp1(state);
+    flint_set_cutoff(FLINT_CUTOFF_FFT_MULMOD_2EXPP1, fft);
+
+    flint_printf("nmod_poly_mul KS2\n");
+    ks2 = tune_nmod_poly_mul(state, 0);
+    flint_printf("nmod_poly_mul KS4\n");
+    ks4 = tune_nmod_poly_mul(state, 1);
+    flint_set_cutoff(FLINT_CUTOFF_NMOD_POLY_MUL_KS2, ks2);
+    flint_set_cutoff(FLINT_CUTOFF_NMOD_POLY_MUL_KS4, FLINT_MAX(ks2, ks4));
+
+    flint_printf("nmod_mat_mul Strassen\n");
+    strassen = tune_nmod_mat_mul(state);
+    flint_set_cutoff(FLINT_CUTOFF_NMOD_MAT_MUL_STRASSEN, strassen);
+
+    tune_fmpz_mat_mul(state);
+
+    if (!flint_save_cutoffs(filename))
+    {
+        flint_printf("Cannot write %s\n", filename);
+        flint_randclear(state);
+        return EXIT_FAILURE;
+    }
+
+    flint_printf("Cutoffs written to %s\n", filename);
+
+    flint_randclear(state);
+    flint_cleanup();
+    return EXIT_SUCCESS;
+}
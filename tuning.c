@@ -0,0 +1,203 @@
+/*
+    Copyright (C) 2019 William Hart
+
+    This file is part of FLINT.
+
+    FLINT is free software: you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.  See <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "flint.h"
+#include "fft_tuning.h"
+
+/*
+    The table starts out with the defaults below. The first time a cutoff
+    is read, the file named by the environment variable FLINT_TUNING_FILE,
+    if set, is loaded over them. A tuning file, as written by
+    flint_save_cutoffs or build/tune/tune-cutoffs, has one cutoff per line,
+    given by name and value; blank lines and lines starting with # are
+    ignored.
+*/
+
+typedef struct
+{
+    const char * name;
+    slong value;
+} _flint_cutoff_default_struct;
+
+static const _flint_cutoff_default_struct
+_flint_cutoff_defaults[FLINT_NUM_CUTOFFS] =
+{
+    /* bits*len2 above which _nmod_poly_mul uses KS2 */
+    { "nmod_poly_mul_ks2", 200 },
+    /* bits*len2 above which _nmod_poly_mul uses KS4 */
+    { "nmod_poly_mul_ks4", 2000 },
+    /* dimension from which nmod_mat_mul uses Strassen */
+    { "nmod_mat_mul_strassen", 256 },
+    /* dimension below which fmpz_mat_mul is always classical */
+    { "fmpz_mat_mul_small", 12 },
+    /* (bits(A) + bits(B))*dim below which fmpz_mat_mul is classical */
+    { "fmpz_mat_mul_classical", 17000 },
+    /* dimension and bits(A) + bits(B) above which multimodular beats
+       Strassen for large entries */
+    { "fmpz_mat_mul_multi_mod_dim", 75 },
+    { "fmpz_mat_mul_multi_mod_bits", 650 },
+    /* limbs above which fft_mulmod_2expp1 uses an FFT */
+    { "fft_mulmod_2expp1", FFT_MULMOD_2EXPP1_CUTOFF },
+    /* bits of n from which qsieve_factor allows two large primes */
+    { "qsieve_dlp_bits", 300 },
+    /* columns from which the qsieve block Lanczos uses several threads */
+    { "qsieve_lanczos_cols", 5000 },
+    /* words of relations qsieve_factor_spill keeps in memory */
+    { "qsieve_store_words", WORD(1) << 24 },
+    /* B2 from which fmpz_factor_ecm uses the polynomial stage II */
+    { "ecm_stage_II_fft", 700000 },
+    /* number of primes the shared table of n_primes_arr_readonly is
+       first computed with */
+    { "primes_table_min", 0 }
+};
+
+slong flint_cutoff_tab[FLINT_NUM_CUTOFFS];
+
+int flint_cutoffs_initialised = 0;
+
+static pthread_once_t _flint_cutoffs_once = PTHREAD_ONCE_INIT;
+
+static int _flint_load_cutoffs(const char * filename);
+
+static void _flint_cutoffs_load_env(void)
+{
+    const char * filename = getenv("FLINT_TUNING_FILE");
+    slong i;
+
+    for (i = 0; i < FLINT_NUM_CUTOFFS; i++)
+        flint_cutoff_tab[i] = _flint_cutoff_defaults[i].value;
+
+    if (filename != NULL && filename[0] != '\0')
+    {
+        if (!_flint_load_cutoffs(filename))
+        {
+            flint_printf("Exception (FLINT tuning). Cannot read tuning file "
+                         "%s.\n", filename);
+            flint_abort();
+        }
+    }
+
+    flint_cutoffs_initialised = 1;
+}
+
+void _flint_cutoffs_init(void)
+{
+    pthread_once(&_flint_cutoffs_once, _flint_cutoffs_load_env);
+}
+
+void flint_set_cutoff(flint_cutoff_t c, slong value)
+{
+    if (!flint_cutoffs_initialised)
+        _flint_cutoffs_init();
+
+    flint_cutoff_tab[c] = value;
+}
+
+slong flint_get_default_cutoff(flint_cutoff_t c)
+{
+    return _flint_cutoff_defaults[c].value;
+}
+
+const char * flint_cutoff_name(flint_cutoff_t c)
+{
+    return _flint_cutoff_defaults[c].name;
+}
+
+void flint_reset_cutoffs(void)
+{
+    slong i;
+
+    if (!flint_cutoffs_initialised)
+        _flint_cutoffs_init();
+
+    for (i = 0; i < FLINT_NUM_CUTOFFS; i++)
+        flint_cutoff_tab[i] = _flint_cutoff_defaults[i].value;
+}
+
+static int _flint_load_cutoffs(const char * filename)
+{
+    FILE * file;
+    char line[256], name[128];
+    slong i, value, vals[FLINT_NUM_CUTOFFS];
+    int set[FLINT_NUM_CUTOFFS];
+
+    file = fopen(filename, "r");
+    if (file == NULL)
+        return 0;
+
+    for (i = 0; i < FLINT_NUM_CUTOFFS; i++)
+        set[i] = 0;
+
+    /* only change the table if the whole file is good */
+    while (fgets(line, sizeof(line), file) != NULL)
+    {
+        char * p = line + strspn(line, " \t");
+
+        if (*p == '#' || *p == '\n' || *p == '\r' || *p == '\0')
+            continue;
+
+        if (sscanf(p, "%127s", name) != 1 ||
+            flint_sscanf(p + strlen(name), "%wd", &value) != 1 || value < 0)
+        {
+            fclose(file);
+            return 0;
+        }
+
+        for (i = 0; i < FLINT_NUM_CUTOFFS; i++)
+            if (strcmp(name, _flint_cutoff_defaults[i].name) == 0)
+                break;
+
+        /* ignore cutoffs we do not know, e.g. from a newer version */
+        if (i < FLINT_NUM_CUTOFFS)
+        {
+            vals[i] = value;
+            set[i] = 1;
+        }
+    }
+
+    fclose(file);
+
+    for (i = 0; i < FLINT_NUM_CUTOFFS; i++)
+        if (set[i])
+            flint_cutoff_tab[i] = vals[i];
+
+    return 1;
+}
+
+int flint_load_cutoffs(const char * filename)
+{
+    if (!flint_cutoffs_initialised)
+        _flint_cutoffs_init();
+
+    return _flint_load_cutoffs(filename);
+}
+
+int flint_save_cutoffs(const char * filename)
+{
+    FILE * file;
+    slong i;
+
+    file = fopen(filename, "w");
+    if (file == NULL)
+        return 0;
+
+    fprintf(file, "# FLINT %s algorithm cutoffs\n", FLINT_VERSION);
+
+    for (i = 0; i < FLINT_NUM_CUTOFFS; i++)
+        flint_fprintf(file, "%s %wd\n", _flint_cutoff_defaults[i].name,
+                                         flint_get_cutoff((flint_cutoff_t) i));
+
+    return fclose(file) == 0;
+}
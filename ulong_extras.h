@@ -59,6 +59,8 @@ typedef struct {
 
 #define FLINT_PRIME_PI_ODD_LOOKUP_CUTOFF 311
 
+#define FLINT_PRIME_PI_MEISSEL_LEHMER_CUTOFF 10000000
+
 #define FLINT_SIEVE_SIZE 65536
 
 #if FLINT64
@@ -114,14 +116,44 @@ n_primes_next(n_primes_t iter)
     }
 }
 
+typedef void (*n_primes_callback_t)(const ulong * primes, slong len,
+                                                                void * arg);
+
+FLINT_DLL ulong _n_primes_range(ulong a, ulong b, n_primes_callback_t f,
+                                                      void * arg, int ordered);
+
+FLINT_DLL void n_primes_range(ulong a, ulong b, n_primes_callback_t f,
+                                                      void * arg, int ordered);
+
+FLINT_DLL ulong n_primes_count_range(ulong a, ulong b);
+
 FLINT_DLL extern const unsigned int flint_primes_small[];
 
-extern FLINT_TLS_PREFIX ulong * _flint_primes[FLINT_BITS];
-extern FLINT_TLS_PREFIX double * _flint_prime_inverses[FLINT_BITS];
-extern FLINT_TLS_PREFIX int _flint_primes_used;
-#if defined(_OPENMP) && !defined(HAVE_TLS)
-#pragma omp threadprivate(_flint_primes, _flint_prime_inverses, _flint_primes_used)
+/* shared by all threads, see compute_primes.c */
+FLINT_DLL extern ulong * _flint_primes[FLINT_BITS];
+FLINT_DLL extern double * _flint_prime_inverses[FLINT_BITS];
+FLINT_DLL extern int _flint_primes_used;
+
+/* the slots below the returned value may be read without locking */
+ULONG_EXTRAS_INLINE
+int _n_primes_used(void)
+{
+#if defined(__GNUC__)
+    return __atomic_load_n(&_flint_primes_used, __ATOMIC_ACQUIRE);
+#else
+    return *(volatile int *) &_flint_primes_used;
 #endif
+}
+
+ULONG_EXTRAS_INLINE
+void _n_primes_set_used(int used)
+{
+#if defined(__GNUC__)
+    __atomic_store_n(&_flint_primes_used, used, __ATOMIC_RELEASE);
+#else
+    *(volatile int *) &_flint_primes_used = used;
+#endif
+}
 
 FLINT_DLL void n_compute_primes(ulong num_primes);
 
@@ -368,12 +400,18 @@ FLINT_DLL int n_is_prime_pocklington(ulong n, ulong iterations);
 
 FLINT_DLL int n_is_prime(ulong n);
 
+FLINT_DLL slong _n_is_prime_vec(ulong * res, const ulong * n, slong len);
+
+FLINT_DLL slong n_is_prime_vec(ulong * res, const ulong * n, slong len);
+
 FLINT_DLL ulong n_nth_prime(ulong n);
 
 FLINT_DLL void n_nth_prime_bounds(ulong *lo, ulong *hi, ulong n);
 
 FLINT_DLL ulong n_prime_pi(ulong n);
 
+FLINT_DLL ulong n_prime_pi_meissel_lehmer(ulong n);
+
 FLINT_DLL void n_prime_pi_bounds(ulong *lo, ulong *hi, ulong n);
 
 FLINT_DLL int n_remove(ulong * n, ulong p);
@@ -410,6 +448,12 @@ FLINT_DLL ulong n_factor_SQUFOF(ulong n, ulong iters);
 
 FLINT_DLL void n_factor(n_factor_t * factors, ulong n, int proved);
 
+typedef void (*n_factor_callback_t)(ulong n, const n_factor_t * factors,
+                                                      slong len, void * arg);
+
+FLINT_DLL void n_factor_range(ulong a, ulong b, n_factor_callback_t f,
+                                                      void * arg, int ordered);
+
 FLINT_DLL ulong n_factor_pp1(ulong n, ulong B1, ulong c);
 
 FLINT_DLL int n_factor_pollard_brent_single(ulong *factor, ulong n, 
@@ -494,6 +538,19 @@ FLINT_DLL int n_factor_ecm_stage_II(ulong *f, ulong B1, ulong B2,
 FLINT_DLL int n_factor_ecm(ulong *f, ulong curves, ulong B1,
                            ulong B2, flint_rand_t state, ulong n);
 
+FLINT_DLL slong n_factor_ecm_vec(ulong *f, ulong curves, ulong B1,
+             ulong B2, flint_rand_t state, const ulong * n, slong len);
+
+FLINT_DLL ulong _n_factor_ecm_tables_init(n_ecm_t n_ecm_inf,
+                                                      ulong B1, ulong B2);
+
+FLINT_DLL void _n_factor_ecm_tables_clear(n_ecm_t n_ecm_inf,
+                                                      ulong B1, ulong B2);
+
+FLINT_DLL int _n_factor_ecm_curves(ulong *f, ulong curves, ulong B1,
+                       ulong B2, ulong P, flint_rand_t state, ulong n,
+                                                      n_ecm_t n_ecm_inf);
+
 FLINT_DLL mp_limb_t n_mulmod_precomp_shoup(mp_limb_t w, mp_limb_t p);
 
 static __inline__
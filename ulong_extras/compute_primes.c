@@ -23,12 +23,6 @@
 #include "ulong_extras.h"
 #include <pthread.h>
 
-#if FLINT_REENTRANT && !HAVE_TLS
-
-static pthread_once_t primes_initialised = PTHREAD_ONCE_INIT;
-pthread_mutex_t primes_lock;
-#endif
-
 const unsigned int flint_primes_small[] =
 {
     2,3,5,7,11,13,17,19,23,29,31,37,41,43,47,53,59,61,67,71,73,79,83,89,97,
@@ -44,62 +38,85 @@ const unsigned int flint_primes_small[] =
 };
 
 
-/* _flint_primes[i] holds an array of 2^i primes */
-FLINT_TLS_PREFIX mp_limb_t * _flint_primes[FLINT_BITS];
-FLINT_TLS_PREFIX double * _flint_prime_inverses[FLINT_BITS];
-FLINT_TLS_PREFIX int _flint_primes_used = 0;
-#pragma omp threadprivate(_flint_primes, _flint_prime_inverses, _flint_primes_used)
+/*
+   _flint_primes[i] holds an array of at least 2^i primes, the largest
+   table being at _flint_primes[_flint_primes_used - 1]. The tables are
+   shared by all threads. They are only replaced under the lock, by a
+   table twice as large or more which starts with a copy of the largest
+   one, and only published slots are read without it. Older tables stay
+   valid until n_cleanup_primes.
+*/
+mp_limb_t * _flint_primes[FLINT_BITS];
+double * _flint_prime_inverses[FLINT_BITS];
+int _flint_primes_used = 0;
 
-#if FLINT_REENTRANT && !HAVE_TLS
-void n_compute_primes_init()
-{
-   pthread_mutex_init(&primes_lock, NULL);
-}
-#endif
+pthread_mutex_t _flint_primes_lock = PTHREAD_MUTEX_INITIALIZER;
 
 void
 n_compute_primes(ulong num_primes)
 {
-    int i, m;
-    ulong num_computed;
-
-#if FLINT_REENTRANT && !HAVE_TLS
-    pthread_once(&primes_initialised, n_compute_primes_init);
-    pthread_mutex_lock(&primes_lock);
-#endif
+    slong i;
+    int m, used;
+    ulong num_old, num_computed;
+    mp_limb_t * primes;
+    double * inverses;
+    n_primes_t iter;
 
     m = FLINT_CLOG2(num_primes);
 
-    if (_flint_primes_used == 0)
-        flint_register_cleanup_function(n_cleanup_primes);
+    if (m < _n_primes_used())
+        return;
 
-    if (m >= _flint_primes_used)
+    pthread_mutex_lock(&_flint_primes_lock);
+
+    used = _flint_primes_used;
+
+    if (m >= used)
     {
-        n_primes_t iter;
+        /* the first table has at least the configured number of primes */
+        if (used == 0)
+            m = FLINT_MAX(m, FLINT_CLOG2(FLINT_MAX(
+                                         FLINT_CUTOFF(PRIMES_TABLE_MIN), 1)));
 
+        num_old = (used == 0) ? 0 : UWORD(1) << (used - 1);
         num_computed = UWORD(1) << m;
-        _flint_primes[m] = flint_malloc(sizeof(mp_limb_t) * num_computed);
-        _flint_prime_inverses[m] = flint_malloc(sizeof(double) * num_computed);
+        primes = flint_malloc(sizeof(mp_limb_t) * num_computed);
+        inverses = flint_malloc(sizeof(double) * num_computed);
 
+        if (num_old != 0)
+        {
+            memcpy(primes, _flint_primes[used - 1],
+                                                sizeof(mp_limb_t) * num_old);
+            memcpy(inverses, _flint_prime_inverses[used - 1],
+                                                   sizeof(double) * num_old);
+        }
+
+        /*
+           jumping into the small primes calls n_prime_pi, which needs the
+           lock we hold, so there we step over the primes we already have
+        */
         n_primes_init(iter);
-        for (i = 0; i < num_computed; i++)
+        if (num_old != 0 &&
+                primes[num_old - 1] >= iter->small_primes[iter->small_num - 1])
+            n_primes_jump_after(iter, primes[num_old - 1]);
+        else
+            iter->small_i = num_old;
+        for (i = num_old; i < (slong) num_computed; i++)
         {
-            _flint_primes[m][i] = n_primes_next(iter);
-            _flint_prime_inverses[m][i] = n_precompute_inverse(_flint_primes[m][i]);
+            primes[i] = n_primes_next(iter);
+            inverses[i] = n_precompute_inverse(primes[i]);
         }
         n_primes_clear(iter);
 
-        /* copy to lower power-of-two slots */
-        for (i = m - 1; i >= _flint_primes_used; i--)
+        /* fill the new power-of-two slots before publishing them */
+        for (i = used; i <= m; i++)
         {
-            _flint_primes[i] = _flint_primes[m];
-            _flint_prime_inverses[i] = _flint_prime_inverses[m];
+            _flint_primes[i] = primes;
+            _flint_prime_inverses[i] = inverses;
         }
-        _flint_primes_used = m + 1;
+
+        _n_primes_set_used(m + 1);
     }
 
-#if FLINT_REENTRANT && !HAVE_TLS
-    pthread_mutex_unlock(&primes_lock);
-#endif
+    pthread_mutex_unlock(&_flint_primes_lock);
 }
-
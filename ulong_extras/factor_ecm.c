@@ -13,37 +13,13 @@
 #include "flint.h"
 #include "ulong_extras.h"
 
-static
-ulong n_ecm_primorial[] =
-{
-#ifdef FLINT64
-
-    UWORD(2), UWORD(6), UWORD(30), UWORD(210), UWORD(2310), UWORD(30030),
-    UWORD(510510), UWORD(9699690), UWORD(223092870), UWORD(6469693230), 
-    UWORD(200560490130), UWORD(7420738134810), UWORD(304250263527210), 
-    UWORD(13082761331670030), UWORD(614889782588491410)
-
-#else
-
-    UWORD(2), UWORD(6), UWORD(30), UWORD(210), UWORD(2310), UWORD(30030),
-    UWORD(510510), UWORD(9699690)
-
-#endif
-};
-
-#ifdef FLINT64
-#define num_n_ecm_primorials 15
-#else
-#define num_n_ecm_primorials 9
-#endif
-
 int
-n_factor_ecm(mp_limb_t *f, mp_limb_t curves, mp_limb_t B1, mp_limb_t B2,
-             flint_rand_t state, mp_limb_t n)
+_n_factor_ecm_curves(mp_limb_t *f, mp_limb_t curves, mp_limb_t B1,
+                mp_limb_t B2, mp_limb_t P, flint_rand_t state, mp_limb_t n,
+                n_ecm_t n_ecm_inf)
 {
-    mp_limb_t P, num, maxD, mmin, mmax, mdiff, prod, maxj, sig;
-    int i, j, ret;
-    n_ecm_t n_ecm_inf;
+    mp_limb_t num, sig, j;
+    int ret;
 
     const mp_limb_t *prime_array;
 
@@ -52,74 +28,11 @@ n_factor_ecm(mp_limb_t *f, mp_limb_t curves, mp_limb_t B1, mp_limb_t B2,
     n_ecm_inf->ninv = n_preinvert_limb(n);
     n_ecm_inf->one = UWORD(1) << n_ecm_inf->normbits;
 
-    ret = 0;
-
-    /************************ STAGE I PRECOMPUTATIONS ************************/
-
     num = n_prime_pi(B1);   /* number of primes under B1 */
 
     /* compute list of primes under B1 for stage I */
     prime_array = n_primes_arr_readonly(num);   
 
-    /************************ STAGE II PRECOMPUTATIONS ***********************/
-
-    maxD = n_sqrt(B2);
-
-    /* Selecting primorial */
-
-    j = 1;
-    while ((j < num_n_ecm_primorials) && (n_ecm_primorial[j] < maxD))
-        j += 1;
-
-    P = n_ecm_primorial[j - 1]; 
-    
-    mmin = (B1 + (P/2)) / P;
-    mmax = ((B2 - P/2) + P - 1)/P;      /* ceil */
-    maxj = (P + 1)/2; 
-    mdiff = mmax - mmin + 1;
-
-    /* compute GCD_table */
-
-    n_ecm_inf->GCD_table = flint_malloc(maxj + 1);
-
-    for (j = 1; j <= maxj; j += 2)
-    {
-        if ((j%2) && n_gcd(j, P) == 1)
-            n_ecm_inf->GCD_table[j] = 1;  
-        else
-            n_ecm_inf->GCD_table[j] = 0;
-    }  
-
-    /* compute prime table */
-
-    n_ecm_inf->prime_table = flint_malloc(mdiff * sizeof(unsigned char*));
-
-    for (i = 0; i < mdiff; i++)
-        n_ecm_inf->prime_table[i] = flint_malloc((maxj + 1) * sizeof(unsigned char));
-
-    for (i = 0; i < mdiff; i++)
-    {
-        for (j = 1; j <= maxj; j += 2)
-        {
-            n_ecm_inf->prime_table[i][j] = 0;
-
-            /* if (i + mmin)*D + j
-               is prime, mark 1. Can be possibly prime
-               only if gcd(j, D) = 1 */
-
-            if (n_ecm_inf->GCD_table[j] == 1)
-            {
-                prod = (i + mmin)*P + j;
-                if (n_is_prime(prod))
-                    n_ecm_inf->prime_table[i][j] = 1;
-
-                prod = (i + mmin)*P - j;
-                if (n_is_prime(prod))
-                    n_ecm_inf->prime_table[i][j] = 1;
-            }
-        }
-    }
-
     /****************************** TRY "CURVES" *****************************/
 
     for (j = 0; j < curves; j++)
@@ -135,8 +48,7 @@ n_factor_ecm(mp_limb_t *f, mp_limb_t curves, mp_limb_t B1, mp_limb_t B2,
             /* Found factor while selecting curve,
                very very lucky :) */
             (*f) >>= n_ecm_inf->normbits;
-            ret = -1;
-            goto cleanup;
+            return -1;
         }
 
         /************************** STAGE I ***************************/
@@ -147,8 +59,7 @@ n_factor_ecm(mp_limb_t *f, mp_limb_t curves, mp_limb_t B1, mp_limb_t B2,
         {
             /* Found factor after stage I */
             (*f) >>= n_ecm_inf->normbits;
-            ret = 1;
-            goto cleanup;
+            return 1;
         }  
 
         /************************** STAGE II ***************************/
@@ -159,19 +70,26 @@ n_factor_ecm(mp_limb_t *f, mp_limb_t curves, mp_limb_t B1, mp_limb_t B2,
         {
             /* Found factor after stage II */
             (*f) >>= n_ecm_inf->normbits;
-            ret = 2;
-            goto cleanup;
+            return 2;
         }   
     }
 
-    cleanup:
+    return 0;
+}
+
+int
+n_factor_ecm(mp_limb_t *f, mp_limb_t curves, mp_limb_t B1, mp_limb_t B2,
+             flint_rand_t state, mp_limb_t n)
+{
+    mp_limb_t P;
+    int ret;
+    n_ecm_t n_ecm_inf;
 
-    flint_free(n_ecm_inf->GCD_table);
+    P = _n_factor_ecm_tables_init(n_ecm_inf, B1, B2);
 
-    for (i = 0; i < mdiff; i++)
-        flint_free(n_ecm_inf->prime_table[i]);
+    ret = _n_factor_ecm_curves(f, curves, B1, B2, P, state, n, n_ecm_inf);
 
-    flint_free(n_ecm_inf->prime_table);
+    _n_factor_ecm_tables_clear(n_ecm_inf, B1, B2);
 
     return ret;
 }
@@ -0,0 +1,126 @@
+/*
+    Copyright (C) 2015 Kushagra Singh
+    Copyright (C) 2019 William Hart
+
+    This file is part of FLINT.
+
+    FLINT is free software: you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.  See <http://www.gnu.org/licenses/>.
+*/
+
+#include <gmp.h>
+#include "flint.h"
+#include "ulong_extras.h"
+
+static
+ulong n_ecm_primorial[] =
+{
+#ifdef FLINT64
+
+    UWORD(2), UWORD(6), UWORD(30), UWORD(210), UWORD(2310), UWORD(30030),
+    UWORD(510510), UWORD(9699690), UWORD(223092870), UWORD(6469693230), 
+    UWORD(200560490130), UWORD(7420738134810), UWORD(304250263527210), 
+    UWORD(13082761331670030), UWORD(614889782588491410)
+
+#else
+
+    UWORD(2), UWORD(6), UWORD(30), UWORD(210), UWORD(2310), UWORD(30030),
+    UWORD(510510), UWORD(9699690)
+
+#endif
+};
+
+#ifdef FLINT64
+#define num_n_ecm_primorials 15
+#else
+#define num_n_ecm_primorials 9
+#endif
+
+/* the primorial used as giant step in stage II */
+static mp_limb_t
+_n_factor_ecm_primorial(mp_limb_t B2)
+{
+    mp_limb_t maxD = n_sqrt(B2);
+    int j = 1;
+
+    while ((j < num_n_ecm_primorials) && (n_ecm_primorial[j] < maxD))
+        j += 1;
+
+    return n_ecm_primorial[j - 1];
+}
+
+mp_limb_t
+_n_factor_ecm_tables_init(n_ecm_t n_ecm_inf, mp_limb_t B1, mp_limb_t B2)
+{
+    mp_limb_t P, mmin, mmax, mdiff, prod, maxj;
+    mp_limb_t i, j;
+
+    P = _n_factor_ecm_primorial(B2);
+    
+    mmin = (B1 + (P/2)) / P;
+    mmax = ((B2 - P/2) + P - 1)/P;      /* ceil */
+    maxj = (P + 1)/2; 
+    mdiff = mmax - mmin + 1;
+
+    /* compute GCD_table */
+
+    n_ecm_inf->GCD_table = flint_malloc(maxj + 1);
+
+    for (j = 1; j <= maxj; j += 2)
+    {
+        if ((j%2) && n_gcd(j, P) == 1)
+            n_ecm_inf->GCD_table[j] = 1;  
+        else
+            n_ecm_inf->GCD_table[j] = 0;
+    }  
+
+    /* compute prime table */
+
+    n_ecm_inf->prime_table = flint_malloc(mdiff * sizeof(unsigned char*));
+
+    for (i = 0; i < mdiff; i++)
+        n_ecm_inf->prime_table[i] = flint_malloc((maxj + 1) * sizeof(unsigned char));
+
+    for (i = 0; i < mdiff; i++)
+    {
+        for (j = 1; j <= maxj; j += 2)
+        {
+            n_ecm_inf->prime_table[i][j] = 0;
+
+            /* if (i + mmin)*D + j
+               is prime, mark 1. Can be possibly prime
+               only if gcd(j, D) = 1 */
+
+            if (n_ecm_inf->GCD_table[j] == 1)
+            {
+                prod = (i + mmin)*P + j;
+                if (n_is_prime(prod))
+                    n_ecm_inf->prime_table[i][j] = 1;
+
+                prod = (i + mmin)*P - j;
+                if (n_is_prime(prod))
+                    n_ecm_inf->prime_table[i][j] = 1;
+            }
+        }
+    }
+
+    return P;
+}
+
+void
+_n_factor_ecm_tables_clear(n_ecm_t n_ecm_inf, mp_limb_t B1, mp_limb_t B2)
+{
+    mp_limb_t i, P, mdiff;
+
+    P = _n_factor_ecm_primorial(B2);
+    mdiff = ((B2 - P/2) + P - 1)/P - (B1 + (P/2)) / P + 1;
+
+    flint_free(n_ecm_inf->GCD_table);
+
+    for (i = 0; i < mdiff; i++)
+        flint_free(n_ecm_inf->prime_table[i]);
+
+    flint_free(n_ecm_inf->prime_table);
+}
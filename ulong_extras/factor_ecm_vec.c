@@ -0,0 +1,105 @@
+/*
+    Copyright (C) 2019 William Hart
+
+    This file is part of FLINT.
+
+    FLINT is free software: you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.  See <http://www.gnu.org/licenses/>.
+*/
+
+#include <gmp.h>
+#include "flint.h"
+#include "ulong_extras.h"
+#include "threadpool.h"
+
+typedef struct
+{
+    mp_limb_t * f;
+    const mp_limb_t * n;
+    slong len;
+    mp_limb_t curves, B1, B2, P;
+    const n_ecm_s * tables;
+    ulong seed1, seed2;
+    slong found;
+} _n_ecm_vec_arg_t;
+
+static void
+_n_factor_ecm_vec_worker(void * arg_ptr)
+{
+    _n_ecm_vec_arg_t * arg = (_n_ecm_vec_arg_t *) arg_ptr;
+    n_ecm_t n_ecm_inf;
+    flint_rand_t state;
+    slong i;
+
+    /* the stage II tables are only read */
+    n_ecm_inf->GCD_table = arg->tables->GCD_table;
+    n_ecm_inf->prime_table = arg->tables->prime_table;
+
+    flint_randinit(state);
+    flint_randseed(state, arg->seed1, arg->seed2);
+
+    arg->found = 0;
+
+    for (i = 0; i < arg->len; i++)
+    {
+        if (_n_factor_ecm_curves(arg->f + i, arg->curves, arg->B1, arg->B2,
+                                       arg->P, state, arg->n[i], n_ecm_inf))
+            arg->found++;
+        else
+            arg->f[i] = 0;
+    }
+
+    flint_randclear(state);
+}
+
+slong
+n_factor_ecm_vec(mp_limb_t * f, mp_limb_t curves, mp_limb_t B1,
+           mp_limb_t B2, flint_rand_t state, const mp_limb_t * n, slong len)
+{
+    _n_ecm_vec_arg_t * args;
+    n_ecm_t n_ecm_inf;
+    mp_limb_t P;
+    slong i, start, num_threads, found;
+
+    if (len <= 0)
+        return 0;
+
+    num_threads = FLINT_MIN(flint_get_num_threads(), len);
+
+    args = flint_malloc(num_threads*sizeof(_n_ecm_vec_arg_t));
+
+    P = _n_factor_ecm_tables_init(n_ecm_inf, B1, B2);
+
+    /* make sure the primes for stage I are computed before any worker */
+    n_primes_arr_readonly(n_prime_pi(B1));
+
+    for (i = 0, start = 0; i < num_threads; i++)
+    {
+        args[i].len = len/num_threads + (i < len % num_threads);
+        args[i].f = f + start;
+        args[i].n = n + start;
+        args[i].curves = curves;
+        args[i].B1 = B1;
+        args[i].B2 = B2;
+        args[i].P = P;
+        args[i].tables = n_ecm_inf;
+        args[i].seed1 = n_randlimb(state);
+        args[i].seed2 = n_randlimb(state);
+
+        start += args[i].len;
+    }
+
+    threadpool_parallel_do(_n_factor_ecm_vec_worker, args,
+                                      num_threads, sizeof(_n_ecm_vec_arg_t));
+
+    found = 0;
+    for (i = 0; i < num_threads; i++)
+        found += args[i].found;
+
+    _n_factor_ecm_tables_clear(n_ecm_inf, B1, B2);
+    flint_free(args);
+
+    return found;
+}
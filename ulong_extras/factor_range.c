@@ -0,0 +1,439 @@
+/*
+    Copyright (C) 2019 William Hart
+
+    This file is part of FLINT.
+
+    FLINT is free software: you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.  See <http://www.gnu.org/licenses/>.
+*/
+
+#include <pthread.h>
+#include <gmp.h>
+#include "flint.h"
+#include "ulong_extras.h"
+#include "threadpool.h"
+
+/*
+   The range is cut into chunks of FACTOR_CHUNK integers, which are
+   grouped into blocks of consecutive chunks that the threads take in
+   turn. A chunk holds the unfactored part of each integer, which every
+   sieving prime p hitting it divides out, the exact quotients being
+   multiplications by p^-1 modulo 2^FLINT_BITS. Primes up to the chunk
+   length find their first multiple in each chunk. Larger primes hit a
+   chunk at most once. Each finds its first multiple in the block once
+   and then waits in the bucket of the next chunk of the block it hits.
+   What is left of an integer after the sieve is 1 or a prime.
+
+   Blocks are handed out in increasing order from a counter, so that the
+   thread delivering block k in order only waits for blocks which are
+   being worked on already. For ordered delivery a whole block is kept.
+
+   When b - a is much smaller than sqrt(b) we only sieve by the primes up
+   to a lower limit, and what is left above its square is tested with
+   n_is_prime and, if composite, factored with n_factor.
+*/
+
+#define FACTOR_CHUNK 4096
+#define FACTOR_BLOCK_MAX 16  /* chunks */
+
+typedef struct
+{
+    ulong m;                 /* the multiple of p hit */
+    ulong p;
+} _n_factor_bucket_entry_struct;
+
+typedef struct
+{
+    _n_factor_bucket_entry_struct * entries;
+    slong num;
+    slong alloc;
+} _n_factor_bucket_struct;
+
+typedef struct
+{
+    ulong a;
+    ulong b;
+    ulong num_chunks;
+    ulong block_chunks;
+    ulong num_blocks;
+    const unsigned int * primes; /* the primes up to the limit */
+    slong num_primes;
+    slong num_small;         /* those up to FACTOR_CHUNK */
+    int test;                /* whether the limit is below sqrt(b) */
+    ulong limit_sq;
+    n_factor_callback_t f;
+    void * arg;
+    int ordered;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    ulong next_block;        /* protected by the mutex */
+    ulong next_deliver;
+} _n_factor_range_struct;
+
+typedef struct
+{
+    unsigned int * primes;
+    slong num;
+    slong alloc;
+} _n_factor_primes_struct;
+
+static void
+_n_factor_primes_callback(const ulong * primes, slong len, void * arg)
+{
+    _n_factor_primes_struct * P = (_n_factor_primes_struct *) arg;
+    slong i;
+
+    if (P->num + len > P->alloc)
+    {
+        P->alloc = FLINT_MAX(2*P->alloc, P->num + len);
+        P->primes = flint_realloc(P->primes, P->alloc*sizeof(unsigned int));
+    }
+
+    for (i = 0; i < len; i++)
+        P->primes[P->num + i] = primes[i];
+
+    P->num += len;
+}
+
+/* p^-1 mod 2^FLINT_BITS for odd p, (3p) xor 2 being right to 5 bits */
+static __inline__ ulong
+_n_factor_binvert(ulong p)
+{
+    ulong x = (3*p) ^ 2;
+
+    x *= 2 - p*x;
+    x *= 2 - p*x;
+    x *= 2 - p*x;
+    x *= 2 - p*x;
+
+    return x;
+}
+
+/* divide r by the odd prime p as often as possible, p | r being known */
+static __inline__ int
+_n_factor_remove(ulong * r, ulong p, ulong pinv)
+{
+    ulong q, t, hi, lo;
+    int e = 1;
+
+    q = (*r)*pinv;
+
+    while (1)
+    {
+        t = q*pinv;
+        umul_ppmm(hi, lo, t, p);
+        if (hi != 0)
+            break;
+        q = t;
+        e++;
+    }
+
+    *r = q;
+
+    return e;
+}
+
+/* insert (p, e) into fac, whose primes are increasing and differ from p */
+static void
+_n_factor_insert_sorted(n_factor_t * fac, ulong p, int e)
+{
+    slong i;
+
+    for (i = fac->num; i > 0 && fac->p[i - 1] > p; i--)
+    {
+        fac->p[i] = fac->p[i - 1];
+        fac->exp[i] = fac->exp[i - 1];
+    }
+
+    fac->p[i] = p;
+    fac->exp[i] = e;
+    fac->num++;
+}
+
+static void
+_n_factor_bucket_push(_n_factor_bucket_struct * B, ulong p, ulong m)
+{
+    if (B->num == B->alloc)
+    {
+        B->alloc = FLINT_MAX(2*B->alloc, 64);
+        B->entries = flint_realloc(B->entries,
+                             B->alloc*sizeof(_n_factor_bucket_entry_struct));
+    }
+
+    B->entries[B->num].m = m;
+    B->entries[B->num].p = p;
+    B->num++;
+}
+
+/*
+   factor the len integers from lo, chunk c of a block of c_end chunks,
+   the large primes hitting chunk i of the block being in buckets[i]
+*/
+static void
+_n_factor_range_chunk(n_factor_t * fac, ulong * rem, ulong lo, slong len,
+                      _n_factor_bucket_struct * buckets, ulong c,
+                      ulong c_end, const _n_factor_range_struct * S)
+{
+    _n_factor_bucket_struct * B = buckets + c;
+    ulong p, pinv, m, off, r;
+    n_factor_t t;
+    slong i, j;
+    int e;
+
+    for (i = 0; i < len; i++)
+    {
+        rem[i] = lo + i;
+        fac[i].num = 0;
+    }
+
+    /* 2, and 0 which is left alone */
+    for (i = (lo & 1); i < len; i += 2)
+    {
+        if (rem[i] == 0)
+            continue;
+
+        count_trailing_zeros(e, rem[i]);
+        rem[i] >>= e;
+        fac[i].p[0] = 2;
+        fac[i].exp[0] = e;
+        fac[i].num = 1;
+    }
+
+    /* the odd primes up to the chunk length */
+    for (j = 1; j < S->num_small; j++)
+    {
+        p = S->primes[j];
+        pinv = _n_factor_binvert(p);
+
+        off = lo % p;
+        off = (off == 0) ? (lo == 0 ? p : 0) : p - off;
+
+        for (i = off; i < len; i += p)
+        {
+            e = _n_factor_remove(rem + i, p, pinv);
+            fac[i].p[fac[i].num] = p;
+            fac[i].exp[fac[i].num] = e;
+            fac[i].num++;
+        }
+    }
+
+    /* the larger primes hitting this chunk, passed on to the next hit */
+    for (j = 0; j < B->num; j++)
+    {
+        p = B->entries[j].p;
+        m = B->entries[j].m;
+        off = m - lo;
+
+        e = _n_factor_remove(rem + off, p, _n_factor_binvert(p));
+        _n_factor_insert_sorted(fac + off, p, e);
+
+        if (m > S->b - p)
+            continue;
+        m += p;
+
+        r = c + (m - lo)/FACTOR_CHUNK;
+        if (r < c_end)
+            _n_factor_bucket_push(buckets + r, p, m);
+    }
+
+    B->num = 0;
+
+    /* what is left */
+    for (i = 0; i < len; i++)
+    {
+        r = rem[i];
+
+        if (r <= 1)
+            continue;
+
+        if (!S->test || r <= S->limit_sq || n_is_prime(r))
+        {
+            _n_factor_insert_sorted(fac + i, r, 1);
+            continue;
+        }
+
+        n_factor_init(&t);
+        n_factor(&t, r, 0);
+
+        for (j = 0; j < t.num; j++)
+            _n_factor_insert_sorted(fac + i, t.p[j], t.exp[j]);
+    }
+}
+
+static void
+_n_factor_range_worker(void * arg_ptr)
+{
+    _n_factor_range_struct * S = *(_n_factor_range_struct **) arg_ptr;
+    ulong blk, c, c0, c_end, lo, p, m, r, start, b_len;
+    slong i, len;
+    ulong * rem;
+    n_factor_t * fac;
+    _n_factor_bucket_struct * buckets;
+
+    rem = flint_malloc(FACTOR_CHUNK*sizeof(ulong));
+    fac = flint_malloc((S->ordered ? S->block_chunks : 1)
+                                            *FACTOR_CHUNK*sizeof(n_factor_t));
+
+    /* indexed by the chunk within the block */
+    buckets = flint_calloc(S->block_chunks, sizeof(_n_factor_bucket_struct));
+
+    while (1)
+    {
+        pthread_mutex_lock(&S->mutex);
+        blk = S->next_block++;
+        pthread_mutex_unlock(&S->mutex);
+
+        if (blk >= S->num_blocks)
+            break;
+
+        c0 = blk*S->block_chunks;
+        c_end = FLINT_MIN(c0 + S->block_chunks, S->num_chunks) - c0;
+        start = S->a + c0*FACTOR_CHUNK;
+        b_len = S->b - start; /* the block is [start, start + b_len] at most */
+
+        /* first hit of each large prime in the block */
+        for (i = S->num_small; i < S->num_primes; i++)
+        {
+            p = S->primes[i];
+
+            if (start <= p)
+                m = p;
+            else if ((r = start % p) == 0)
+                m = start;
+            else if (p - r > b_len)
+                continue;
+            else
+                m = start + (p - r);
+
+            if (m > S->b)
+                continue;
+
+            r = (m - start)/FACTOR_CHUNK;
+            if (r < c_end)
+                _n_factor_bucket_push(buckets + r, p, m);
+        }
+
+        for (c = 0; c < c_end; c++)
+        {
+            lo = start + c*FACTOR_CHUNK;
+            len = FLINT_MIN(FACTOR_CHUNK - 1, S->b - lo) + 1;
+
+            if (S->ordered)
+            {
+                _n_factor_range_chunk(fac + c*FACTOR_CHUNK, rem, lo, len,
+                                                     buckets, c, c_end, S);
+            }
+            else
+            {
+                _n_factor_range_chunk(fac, rem, lo, len, buckets, c, c_end, S);
+                S->f(lo, fac, len, S->arg);
+            }
+        }
+
+        if (S->ordered)
+        {
+            pthread_mutex_lock(&S->mutex);
+            while (S->next_deliver != blk)
+                pthread_cond_wait(&S->cond, &S->mutex);
+            pthread_mutex_unlock(&S->mutex);
+
+            for (c = 0; c < c_end; c++)
+            {
+                lo = start + c*FACTOR_CHUNK;
+                len = FLINT_MIN(FACTOR_CHUNK - 1, S->b - lo) + 1;
+                S->f(lo, fac + c*FACTOR_CHUNK, len, S->arg);
+            }
+
+            pthread_mutex_lock(&S->mutex);
+            S->next_deliver++;
+            pthread_cond_broadcast(&S->cond);
+            pthread_mutex_unlock(&S->mutex);
+        }
+    }
+
+    for (c = 0; c < S->block_chunks; c++)
+        flint_free(buckets[c].entries);
+
+    flint_free(buckets);
+    flint_free(fac);
+    flint_free(rem);
+}
+
+void
+n_factor_range(ulong a, ulong b, n_factor_callback_t f, void * arg,
+                                                                 int ordered)
+{
+    _n_factor_range_struct S[1];
+    _n_factor_primes_struct P;
+    _n_factor_range_struct ** args;
+    ulong limit;
+    slong i, num_threads;
+
+    if (a > b)
+        return;
+
+    S->a = a;
+    S->b = b;
+    S->num_chunks = (b - a)/FACTOR_CHUNK + 1;
+    S->f = f;
+    S->arg = arg;
+    S->ordered = ordered;
+    S->next_block = 0;
+    S->next_deliver = 0;
+
+    limit = n_sqrt(b);
+    S->test = (limit/1024 > b - a && limit > (UWORD(1) << 16));
+    if (S->test)
+    {
+        limit = FLINT_MAX(1024*(b - a), UWORD(1) << 16);
+        S->limit_sq = limit*limit;
+    }
+
+    P.primes = NULL;
+    P.num = 0;
+    P.alloc = 0;
+    if (limit >= 2)
+        n_primes_range(2, limit, _n_factor_primes_callback, &P, 1);
+
+    S->primes = P.primes;
+    S->num_primes = P.num;
+
+    for (S->num_small = 0; S->num_small < P.num
+                && P.primes[S->num_small] <= FACTOR_CHUNK; S->num_small++) ;
+
+    /*
+       A block is long enough for finding the first hits of the large
+       primes to cost little next to the sieving, but the range is still
+       shared out between the threads.
+    */
+    num_threads = flint_get_num_threads();
+
+    S->block_chunks = (S->num_primes - S->num_small)/FACTOR_CHUNK + 1;
+    S->block_chunks = FLINT_MIN(S->block_chunks, FACTOR_BLOCK_MAX);
+    S->block_chunks = FLINT_MIN(S->block_chunks,
+                                     (S->num_chunks - 1)/num_threads + 1);
+    S->num_blocks = (S->num_chunks - 1)/S->block_chunks + 1;
+
+    num_threads = FLINT_MIN(num_threads, S->num_blocks);
+
+    args = flint_malloc(num_threads*sizeof(_n_factor_range_struct *));
+    for (i = 0; i < num_threads; i++)
+        args[i] = S;
+
+    pthread_mutex_init(&S->mutex, NULL);
+    pthread_cond_init(&S->cond, NULL);
+
+    if (num_threads > 1)
+        threadpool_parallel_do(_n_factor_range_worker, args, num_threads,
+                                         sizeof(_n_factor_range_struct *));
+    else
+        _n_factor_range_worker(args);
+
+    pthread_cond_destroy(&S->cond);
+    pthread_mutex_destroy(&S->mutex);
+
+    flint_free(args);
+    flint_free(P.primes);
+}
@@ -0,0 +1,341 @@
+/*
+    Copyright (C) 2019 William Hart
+
+    This file is part of FLINT.
+
+    FLINT is free software: you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.  See <http://www.gnu.org/licenses/>.
+*/
+
+#include <string.h>
+#include <gmp.h>
+#include "flint.h"
+#include "ulong_extras.h"
+#include "threadpool.h"
+
+/*
+   Candidates are first checked for divisibility by the odd primes up to
+   TRIAL_LIMIT, p | n being tested as n*p^-1 <= (2^FLINT_BITS - 1)/p with
+   p^-1 the inverse of p modulo 2^FLINT_BITS, which needs no division.
+   The survivors go through the strong base 2 test LANES at a time, the
+   modular multiplications of the different moduli being independent of
+   one another, and those which pass it through the Lucas test with
+   Selfridge's parameters, again LANES at a time. This is the BPSW test,
+   which has no counterexamples below 2^64.
+*/
+
+#define TRIAL_PRIMES 34  /* odd primes 3 to 149 */
+#define TRIAL_LIMIT 149
+#define LANES 4
+
+static const unsigned char _n_trial_primes[TRIAL_PRIMES] =
+{
+    3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37, 41, 43, 47, 53, 59, 61, 67, 71,
+    73, 79, 83, 89, 97, 101, 103, 107, 109, 113, 127, 131, 137, 139, 149
+};
+
+/* a*b mod n for n normalised and a, b shifted left by norm */
+static __inline__ ulong
+_n_mulmod_shifted(ulong a, ulong b, ulong n, ulong ninv, ulong norm)
+{
+    ulong q0, q1, r, p_hi, p_lo;
+
+    umul_ppmm(p_hi, p_lo, a >> norm, b);
+    umul_ppmm(q1, q0, ninv, p_hi);
+    add_ssaaaa(q1, q0, q1, q0, p_hi, p_lo);
+
+    r = (p_lo - (q1 + 1) * n);
+
+    if (r > q0)
+        r += n;
+
+    return (r < n ? r : r - n);
+}
+
+/* strong base 2 test of the odd n[0], ..., n[m - 1] > 2, m <= LANES */
+static void
+_n_is_strong_probabprime2_lanes(int * res, const ulong * n, slong m)
+{
+    ulong nn[LANES], ninv[LANES], norm[LANES], d[LANES], y[LANES];
+    ulong one[LANES], minus_one[LANES];
+    int s[LANES];
+    slong i, j, bits = 0;
+
+    for (j = 0; j < m; j++)
+    {
+        count_leading_zeros(norm[j], n[j]);
+        nn[j] = n[j] << norm[j];
+        ninv[j] = n_preinvert_limb(nn[j]);
+
+        d[j] = n[j] - 1;
+        count_trailing_zeros(s[j], d[j]);
+        d[j] >>= s[j];
+        bits = FLINT_MAX(bits, FLINT_BIT_COUNT(d[j]));
+
+        one[j] = UWORD(1) << norm[j];
+        minus_one[j] = nn[j] - one[j];
+        y[j] = one[j];
+    }
+
+    /* y = 2^d, one bit of all the exponents at a time */
+    for (i = bits - 1; i >= 0; i--)
+    {
+        for (j = 0; j < m; j++)
+        {
+            ulong t, u;
+
+            t = _n_mulmod_shifted(y[j], y[j], nn[j], ninv[j], norm[j]);
+            u = (t >= nn[j] - t) ? t - (nn[j] - t) : t + t;
+            y[j] = ((d[j] >> i) & 1) ? u : t;
+        }
+    }
+
+    for (j = 0; j < m; j++)
+    {
+        res[j] = (y[j] == one[j] || y[j] == minus_one[j]);
+
+        for (i = 1; i < s[j] && !res[j]; i++)
+        {
+            y[j] = _n_mulmod_shifted(y[j], y[j], nn[j], ninv[j], norm[j]);
+            res[j] = (y[j] == minus_one[j]);
+        }
+    }
+}
+
+/*
+   Lucas test of n[0], ..., n[m - 1] with P = 1 and Q = (1 - D)/4, where
+   D is the first of 5, -7, 9, -11, ... with (D/n) = -1, as in
+   n_is_probabprime_lucas. The n[j] must be odd and have no prime factor
+   up to TRIAL_LIMIT.
+*/
+static void
+_n_is_probabprime_lucas_lanes(int * res, const ulong * n, slong m)
+{
+    ulong nn[LANES], ninv[LANES], norm[LANES], e[LANES];
+    ulong A[LANES], x[LANES], y[LANES], two[LANES];
+    slong lane[LANES];
+    slong i, j, k, bits = 0;
+    int D, factor;
+
+    /* choose D, lanes which are settled already are left out */
+    for (j = k = 0; j < m; j++)
+    {
+        ulong Q;
+
+        factor = 0;
+        for (i = 0; i < 100 && !factor; i++)
+        {
+            D = 5 + 2*i;
+            factor = (n_gcd(D, n[j] % D) != 1);
+            if (factor)
+                break;
+            if (i % 2 == 1)
+                D = -D;
+            if (n_jacobi(D, n[j]) == -1)
+                break;
+        }
+
+        if (factor)
+        {
+            res[j] = 0;
+            continue;
+        }
+
+        if (i == 100)
+        {
+            res[j] = (n_is_probabprime_lucas(n[j]) == 1);
+            continue;
+        }
+
+        Q = (D > 0) ? n[j] - (D - 1)/4 : (1 - D)/4;
+
+        count_leading_zeros(norm[k], n[j]);
+        nn[k] = n[j] << norm[k];
+        ninv[k] = n_preinvert_limb(nn[k]);
+        A[k] = n_submod(n_invmod(Q, n[j]), 2, n[j]) << norm[k];
+        two[k] = UWORD(2) << norm[k];
+        e[k] = n[j] + 1;
+        x[k] = two[k];
+        y[k] = A[k];
+        bits = FLINT_MAX(bits, FLINT_BIT_COUNT(e[k]));
+        lane[k++] = j;
+    }
+
+    /*
+       (x, y) = (V_i, V_{i+1}) for i the top bits of e, and leading zero
+       bits leave (V_0, V_1) = (2, A) alone
+    */
+    for (i = bits - 1; i >= 0; i--)
+    {
+        for (j = 0; j < k; j++)
+        {
+            ulong xy, t, sq;
+            int bit = (e[j] >> i) & 1;
+
+            xy = n_submod(_n_mulmod_shifted(x[j], y[j], nn[j], ninv[j],
+                                                       norm[j]), A[j], nn[j]);
+            t = bit ? y[j] : x[j];
+            sq = n_submod(_n_mulmod_shifted(t, t, nn[j], ninv[j], norm[j]),
+                                                              two[j], nn[j]);
+            x[j] = bit ? xy : sq;
+            y[j] = bit ? sq : xy;
+        }
+    }
+
+    for (j = 0; j < k; j++)
+        res[lane[j]] =
+            _n_mulmod_shifted(A[j], x[j], nn[j], ninv[j], norm[j]) ==
+            _n_mulmod_shifted(two[j], y[j], nn[j], ninv[j], norm[j]);
+}
+
+/* set the bits idx[j] of res for which cand[j] is prime, m <= LANES */
+static void
+_n_is_prime_lanes(ulong * res, const slong * idx, const ulong * cand,
+                                                                    slong m)
+{
+    ulong c[LANES];
+    slong i[LANES];
+    int prime[LANES];
+    slong j, k;
+
+    _n_is_strong_probabprime2_lanes(prime, cand, m);
+
+    for (j = k = 0; j < m; j++)
+    {
+        if (prime[j])
+        {
+            c[k] = cand[j];
+            i[k++] = idx[j];
+        }
+    }
+
+    _n_is_probabprime_lucas_lanes(prime, c, k);
+
+    for (j = 0; j < k; j++)
+        if (prime[j])
+            res[i[j]/FLINT_BITS] |= UWORD(1) << (i[j] % FLINT_BITS);
+}
+
+slong
+_n_is_prime_vec(ulong * res, const ulong * n, slong len)
+{
+    ulong inv[TRIAL_PRIMES], lim[TRIAL_PRIMES];
+    ulong cand[LANES], x;
+    slong idx[LANES];
+    slong i, j, k, m, limbs;
+    int composite;
+
+    for (k = 0; k < TRIAL_PRIMES; k++)
+    {
+        ulong p = _n_trial_primes[k];
+
+        /* Newton iteration for p^-1 mod 2^FLINT_BITS */
+        inv[k] = p;
+        for (j = 0; j < 5; j++)
+            inv[k] *= 2 - p*inv[k];
+
+        lim[k] = UWORD_MAX/p;
+    }
+
+    limbs = (len + FLINT_BITS - 1)/FLINT_BITS;
+    flint_mpn_zero(res, limbs);
+
+    m = 0;
+    for (i = 0; i < len; i++)
+    {
+        x = n[i];
+
+        if (x <= TRIAL_LIMIT)
+        {
+            if (n_is_prime(x))
+                res[i/FLINT_BITS] |= UWORD(1) << (i % FLINT_BITS);
+            continue;
+        }
+
+        if ((x & 1) == 0)
+            continue;
+
+        composite = 0;
+        for (k = 0; k < TRIAL_PRIMES; k++)
+            composite |= (x*inv[k] <= lim[k]);
+
+        if (composite)
+            continue;
+
+        if (x < (TRIAL_LIMIT + 2)*(TRIAL_LIMIT + 2))
+        {
+            res[i/FLINT_BITS] |= UWORD(1) << (i % FLINT_BITS);
+            continue;
+        }
+
+        idx[m] = i;
+        cand[m] = x;
+        m++;
+
+        if (m == LANES)
+        {
+            _n_is_prime_lanes(res, idx, cand, m);
+            m = 0;
+        }
+    }
+
+    if (m != 0)
+        _n_is_prime_lanes(res, idx, cand, m);
+
+    return (limbs == 0) ? 0 : mpn_popcount(res, limbs);
+}
+
+typedef struct
+{
+    ulong * res;
+    const ulong * n;
+    slong len;
+    slong num;
+} _n_is_prime_vec_arg_t;
+
+static void
+_n_is_prime_vec_worker(void * arg_ptr)
+{
+    _n_is_prime_vec_arg_t * arg = (_n_is_prime_vec_arg_t *) arg_ptr;
+
+    arg->num = _n_is_prime_vec(arg->res, arg->n, arg->len);
+}
+
+slong
+n_is_prime_vec(ulong * res, const ulong * n, slong len)
+{
+    _n_is_prime_vec_arg_t * args;
+    slong i, num_threads, block, num;
+
+    /* blocks are whole limbs of res, so that threads write disjoint limbs */
+    num_threads = flint_get_num_threads();
+    num_threads = FLINT_MIN(num_threads, len/(16*FLINT_BITS));
+
+    if (num_threads <= 1)
+        return _n_is_prime_vec(res, n, len);
+
+    block = (len + num_threads - 1)/num_threads;
+    block = ((block + FLINT_BITS - 1)/FLINT_BITS)*FLINT_BITS;
+
+    args = flint_malloc(num_threads*sizeof(_n_is_prime_vec_arg_t));
+
+    for (i = 0; i < num_threads; i++)
+    {
+        args[i].res = res + (i*block)/FLINT_BITS;
+        args[i].n = n + i*block;
+        args[i].len = FLINT_MAX(0, FLINT_MIN(block, len - i*block));
+    }
+
+    threadpool_parallel_do(_n_is_prime_vec_worker, args, num_threads,
+                                                sizeof(_n_is_prime_vec_arg_t));
+
+    num = 0;
+    for (i = 0; i < num_threads; i++)
+        num += args[i].num;
+
+    flint_free(args);
+
+    return num;
+}
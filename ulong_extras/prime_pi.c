@@ -37,6 +37,12 @@ ulong n_prime_pi(mp_limb_t n)
     }
 
     n_prime_pi_bounds(&low, &high, n);
+
+    /* count the primes rather than extend the table up to n */
+    if (n >= FLINT_PRIME_PI_MEISSEL_LEHMER_CUTOFF && (_n_primes_used() == 0
+                || high + 1 > (UWORD(1) << (_n_primes_used() - 1))))
+        return n_prime_pi_meissel_lehmer(n);
+
     primes = n_primes_arr_readonly(high + 1);
 
     while (low < high)
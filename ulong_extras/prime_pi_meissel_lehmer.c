@@ -0,0 +1,351 @@
+/*
+    Copyright (C) 2019 William Hart
+
+    This file is part of FLINT.
+
+    FLINT is free software: you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.  See <http://www.gnu.org/licenses/>.
+*/
+
+#include <gmp.h>
+#include "flint.h"
+#include "ulong_extras.h"
+
+/*
+   We use pi(x) = phi(x, a) + a - 1 - P2(x, a) with a = pi(y) for some
+   x^(1/3) <= y <= sqrt(x), where phi(x, a) counts the integers up to x with
+   no prime factor among the first a primes and P2(x, a) counts those with
+   exactly two prime factors, both larger than p_a. Only the primes up to
+   sqrt(x) are stored. The values pi(x/p) needed by P2 which are larger
+   than sqrt(x) are read off a sieve of (sqrt(x), x/p_{a+1}], which is
+   never stored.
+
+   As in the method of Lagarias, Miller and Odlyzko, phi(x, a) is the sum
+   of the ordinary leaves mu(n) phi(x/n, c) for n <= y with no prime factor
+   among the first c = 6 primes, which are read off a table, and of the
+   special leaves -mu(n) phi(x/(n p_b), b - 1) for c < b <= a and
+   n <= y < n p_b with no prime factor up to p_b. The arguments of the
+   latter are less than x/y. They are counted on a segmented sieve of
+   [1, x/y], removing one prime after another and keeping the counts of
+   what is left in a binary indexed tree.
+*/
+
+#define PHI_PRIMORIAL 30030 /* 2*3*5*7*11*13 */
+#define PHI_TOTIENT 5760
+#define PHI_C 6
+
+/* y is PHI_ALPHA times x^(1/3), balancing the leaves against the sieve */
+#define PHI_ALPHA 4
+
+#define PHI_SEGMENT 65536
+
+typedef struct
+{
+    unsigned int * primes;
+    slong num;
+    slong alloc;
+} _n_pi_primes_struct;
+
+typedef struct
+{
+    const ulong * v;         /* increasing arguments larger than sqrt(x) */
+    ulong * pi;
+    slong num;
+    slong next;
+    ulong count;             /* number of primes before the current batch */
+} _n_pi_queries_struct;
+
+static void
+_n_pi_primes_callback(const ulong * primes, slong len, void * arg)
+{
+    _n_pi_primes_struct * P = (_n_pi_primes_struct *) arg;
+    slong i;
+
+    if (P->num + len > P->alloc)
+    {
+        P->alloc = FLINT_MAX(2*P->alloc, P->num + len);
+        P->primes = flint_realloc(P->primes, P->alloc*sizeof(unsigned int));
+    }
+
+    for (i = 0; i < len; i++)
+        P->primes[P->num + i] = primes[i];
+
+    P->num += len;
+}
+
+/* number of entries of the increasing array primes not exceeding x */
+static slong
+_n_pi_search(const unsigned int * primes, slong num, ulong x)
+{
+    slong lo = 0, hi = num, mid;
+
+    while (lo < hi)
+    {
+        mid = (lo + hi)/2;
+        if (primes[mid] <= x)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return lo;
+}
+
+static void
+_n_pi_queries_callback(const ulong * primes, slong len, void * arg)
+{
+    _n_pi_queries_struct * Q = (_n_pi_queries_struct *) arg;
+    slong lo, hi, mid;
+
+    while (Q->next < Q->num && Q->v[Q->next] < primes[len - 1])
+    {
+        lo = 0;
+        hi = len;
+
+        while (lo < hi)
+        {
+            mid = (lo + hi)/2;
+            if (primes[mid] <= Q->v[Q->next])
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+
+        Q->pi[Q->next++] = Q->count + lo;
+    }
+
+    Q->count += len;
+}
+
+/*
+   phi(x, a) for a = pi(y) >= PHI_C, given the primes up to y, the Moebius
+   function mu and the least prime factor lpf of the integers up to y and
+   phi6[r] = phi(r, PHI_C) for 0 <= r < PHI_PRIMORIAL. The sums are taken
+   modulo the word size, as the result fits in a word.
+*/
+static ulong
+_n_phi(ulong x, ulong y, const unsigned int * primes, slong a,
+       const signed char * mu, const unsigned int * lpf,
+       const unsigned short * phi6)
+{
+    ulong z, lo, hi, len, p, xp, m, n, n_lo, n_hi, s, c;
+    unsigned char * sieve;
+    unsigned int * tree;
+    ulong * count;
+    slong i, j, k, q, sqrt_a;
+
+#define PHI6(t) (((t)/PHI_PRIMORIAL)*PHI_TOTIENT + phi6[(t) % PHI_PRIMORIAL])
+
+    /* ordinary leaves */
+    s = PHI6(x);
+
+    for (n = 2; n <= y; n++)
+    {
+        if (mu[n] != 0 && lpf[n] > primes[PHI_C - 1])
+        {
+            if (mu[n] > 0)
+                s += PHI6(x/n);
+            else
+                s -= PHI6(x/n);
+        }
+    }
+
+#undef PHI6
+
+    /* special leaves, whose arguments x/(n p) are at most z */
+    z = x/y;
+
+    /* from p_{sqrt_a} on, the n of the leaves are the primes in (p, y] */
+    sqrt_a = _n_pi_search(primes, a, n_sqrt(y));
+
+    sieve = flint_malloc(PHI_SEGMENT);
+    tree = flint_malloc(PHI_SEGMENT*sizeof(unsigned int));
+    /* count[k] is the number of integers before the segment left once
+       the first k primes have been removed */
+    count = flint_calloc(a, sizeof(ulong));
+
+    for (lo = 1; lo <= z; lo += PHI_SEGMENT)
+    {
+        len = FLINT_MIN(PHI_SEGMENT, z - lo + 1);
+        hi = lo + len;
+
+        /* the integers in [lo, hi) with no prime factor up to p_c */
+        for (i = 0; i < len; i++)
+        {
+            m = (lo + i) % PHI_PRIMORIAL;
+            sieve[i] = (phi6[m] != (m == 0 ? 0 : phi6[m - 1]));
+        }
+
+        /* tree[i] is the sum of sieve[(i & (i + 1)) .. i] */
+        for (i = 0; i < len; i++)
+            tree[i] = sieve[i];
+
+        for (i = 0; i < len; i++)
+        {
+            j = i | (i + 1);
+            if (j < len)
+                tree[j] += tree[i];
+        }
+
+        /* the leaves x/(n p) with n > p are less than x/p^2 */
+        for (k = PHI_C; k < a && primes[k] <= (x/lo)/primes[k]; k++)
+        {
+            p = primes[k];
+            xp = x/p;
+
+            /* leaves with n <= y < n p and lo <= x/(n p) < hi */
+            n_lo = FLINT_MAX(y/p, xp/hi) + 1;
+            n_hi = FLINT_MIN(y, xp/lo);
+
+            if (k < sqrt_a)
+            {
+                for (n = n_lo; n <= n_hi; n++)
+                {
+                    if (mu[n] == 0 || lpf[n] <= p)
+                        continue;
+
+                    c = count[k];
+                    for (i = xp/n - lo; i >= 0; i = (i & (i + 1)) - 1)
+                        c += tree[i];
+
+                    if (mu[n] > 0)
+                        s -= c;
+                    else
+                        s += c;
+                }
+            }
+            else if (n_lo <= n_hi)
+            {
+                /* mu(n) = -1 for the primes n in (p, y] */
+                for (q = _n_pi_search(primes, a, FLINT_MAX(n_lo - 1, p));
+                                          q < a && primes[q] <= n_hi; q++)
+                {
+                    s += count[k];
+                    for (i = xp/primes[q] - lo; i >= 0;
+                                                   i = (i & (i + 1)) - 1)
+                        s += tree[i];
+                }
+            }
+
+            for (i = len - 1; i >= 0; i = (i & (i + 1)) - 1)
+                count[k] += tree[i];
+
+            /* remove the multiples of p */
+            for (j = ((lo + p - 1)/p)*p - lo; j < len; j += p)
+            {
+                if (sieve[j])
+                {
+                    sieve[j] = 0;
+                    for (i = j; i < len; i |= i + 1)
+                        tree[i]--;
+                }
+            }
+        }
+    }
+
+    flint_free(count);
+    flint_free(tree);
+    flint_free(sieve);
+
+    return s;
+}
+
+ulong n_prime_pi_meissel_lehmer(ulong n)
+{
+    _n_pi_primes_struct P;
+    _n_pi_queries_struct Q;
+    ulong y, s, phi, p2, * v, * pi;
+    unsigned short * phi6;
+    unsigned int * lpf;
+    signed char * mu;
+    slong a, b, k, j;
+
+    if (n < 10000)
+        return n_prime_pi(n);
+
+    s = n_sqrt(n);
+    y = FLINT_MIN(PHI_ALPHA*n_cbrt(n), s);
+
+    P.num = 0;
+    P.alloc = 0;
+    P.primes = NULL;
+    n_primes_range(2, s, _n_pi_primes_callback, &P, 1);
+
+    a = _n_pi_search(P.primes, P.num, y);
+    b = P.num;
+
+    /* pi(n/p_k) for a < k <= b, in increasing order of n/p_k */
+    v = flint_malloc((b - a)*sizeof(ulong));
+    pi = flint_malloc((b - a)*sizeof(ulong));
+
+    for (j = 0, k = b - 1; k >= a; j++, k--)
+        v[j] = n/P.primes[k];
+
+    for (j = 0; j < b - a && v[j] <= s; j++)
+        pi[j] = _n_pi_search(P.primes, P.num, v[j]);
+
+    Q.v = v + j;
+    Q.pi = pi + j;
+    Q.num = b - a - j;
+    Q.next = 0;
+    Q.count = P.num;
+
+    if (Q.num != 0)
+        n_primes_range(s + 1, v[b - a - 1], _n_pi_queries_callback, &Q, 1);
+
+    for ( ; Q.next < Q.num; Q.next++)
+        Q.pi[Q.next] = Q.count;
+
+    p2 = 0;
+    for (j = 0, k = b - 1; k >= a; j++, k--)
+        p2 += pi[j] - k;
+
+    /* phi(r, PHI_C) for r < PHI_PRIMORIAL */
+    phi6 = flint_malloc(PHI_PRIMORIAL*sizeof(unsigned short));
+
+    for (j = 0; j < PHI_PRIMORIAL; j++)
+        phi6[j] = 1;
+
+    for (k = 0; k < PHI_C; k++)
+        for (j = 0; j < PHI_PRIMORIAL; j += P.primes[k])
+            phi6[j] = 0;
+
+    for (j = 1; j < PHI_PRIMORIAL; j++)
+        phi6[j] += phi6[j - 1];
+
+    /* Moebius function and least prime factor up to y */
+    mu = flint_malloc((y + 1)*sizeof(signed char));
+    lpf = flint_calloc(y + 1, sizeof(unsigned int));
+
+    for (j = 0; j <= y; j++)
+        mu[j] = 1;
+
+    for (k = 0; k < a; k++)
+    {
+        ulong p = P.primes[k];
+
+        for (j = p; j <= y; j += p)
+        {
+            if (lpf[j] == 0)
+                lpf[j] = p;
+            mu[j] = -mu[j];
+        }
+
+        if (p <= y/p)
+            for (j = p*p; j <= y; j += p*p)
+                mu[j] = 0;
+    }
+
+    phi = _n_phi(n, y, P.primes, a, mu, lpf, phi6);
+
+    flint_free(lpf);
+    flint_free(mu);
+    flint_free(phi6);
+    flint_free(v);
+    flint_free(pi);
+    flint_free(P.primes);
+
+    return phi + a - 1 - p2;
+}
@@ -22,7 +22,7 @@ const mp_limb_t * n_primes_arr_readonly(ulong num_primes)
         return NULL;
 
     m = FLINT_CLOG2(num_primes);
-    if (m >= _flint_primes_used)
+    if (m >= _n_primes_used())
         n_compute_primes(num_primes);
 
     return _flint_primes[m];
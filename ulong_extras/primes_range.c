@@ -0,0 +1,472 @@
+/*
+    Copyright (C) 2019 William Hart
+
+    This file is part of FLINT.
+
+    FLINT is free software: you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.  See <http://www.gnu.org/licenses/>.
+*/
+
+#include <string.h>
+#include <pthread.h>
+#include <gmp.h>
+#include "flint.h"
+#include "ulong_extras.h"
+#include "threadpool.h"
+
+/*
+   The sieve is bit packed modulo 30: byte i holds the numbers 30i + r for
+   the eight residues r coprime to 30, bit j standing for _n_wheel30[j].
+   A range is cut into chunks, which the threads take in turn, and each
+   chunk is sieved one segment at a time, a segment fitting in the L1
+   cache. Primes smaller than a segment remember their next multiple in
+   each residue class. Larger primes hit a segment at most once per
+   class, so each (prime, class) pair waits in the bucket of the next
+   segment it hits and only that segment looks at it.
+
+   All primes up to sqrt(b) are needed to sieve [a, b], which is wasteful
+   when the range is much shorter than sqrt(b). We then only sieve by the
+   primes up to a limit and test the survivors above its square with
+   n_is_prime.
+*/
+
+#define SEGMENT_BYTES 32768
+#define CHUNK_MIN_SEGMENTS 16
+#define CHUNK_MAX_SEGMENTS 512
+
+static const unsigned char _n_wheel30[8] = { 1, 7, 11, 13, 17, 19, 23, 29 };
+
+/* bit of the residue r in a byte, or 8 if r is not coprime to 30 */
+static const unsigned char _n_wheel30_bit[30] =
+{
+    8, 0, 8, 8, 8, 8, 8, 1, 8, 8, 8, 2, 8, 3, 8, 8, 8, 4, 8, 5,
+    8, 8, 8, 6, 8, 8, 8, 8, 8, 7
+};
+
+typedef struct
+{
+    unsigned int p;
+    unsigned int off_bit; /* offset in the segment times 8 plus the bit */
+} _n_bucket_entry_struct;
+
+typedef struct
+{
+    _n_bucket_entry_struct * entries;
+    slong num;
+    slong alloc;
+} _n_bucket_struct;
+
+typedef struct
+{
+    ulong a;
+    ulong b;
+    ulong lo_byte;           /* first and last byte covering [a, b] */
+    ulong hi_byte;
+    ulong chunk_bytes;
+    slong num_chunks;
+    const unsigned int * primes; /* sieving primes 7 <= p <= limit */
+    slong num_primes;
+    slong num_small;         /* those smaller than a segment */
+    int test;                /* whether the limit is below sqrt(b) */
+    ulong limit_sq;
+    n_primes_callback_t f;
+    void * arg;
+    int ordered;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    slong next_chunk;        /* protected by the mutex */
+    slong next_deliver;
+    ulong count;
+} _n_primes_range_struct;
+
+/* smallest q >= p with p*q >= 30*L */
+static ulong
+_n_first_cofactor(ulong p, ulong L)
+{
+    ulong q = (30*L)/p + ((30*L) % p != 0);
+
+    return FLINT_MAX(q, p);
+}
+
+/*
+   byte of the first multiple p*q' with q' >= q and q' = r mod 30, the bit
+   of the multiple being _n_wheel30_bit[(p*r) % 30]
+*/
+static ulong
+_n_first_hit(ulong p, ulong r, ulong q)
+{
+    ulong t, pr = p % 30;
+
+    t = (q <= r) ? 0 : (q - r + 29)/30;
+
+    return p*t + (p/30)*r + (pr*r)/30;
+}
+
+static void
+_n_bucket_push(_n_bucket_struct * B, unsigned int p, unsigned int off_bit)
+{
+    if (B->num == B->alloc)
+    {
+        B->alloc = FLINT_MAX(2*B->alloc, 64);
+        B->entries = flint_realloc(B->entries,
+                                 B->alloc*sizeof(_n_bucket_entry_struct));
+    }
+
+    B->entries[B->num].p = p;
+    B->entries[B->num].off_bit = off_bit;
+    B->num++;
+}
+
+/* clear the bits of 1 and of numbers outside [a, b] in bytes lo to hi */
+static void
+_n_primes_mask_ends(unsigned char * sieve, ulong lo, ulong hi,
+                                               const _n_primes_range_struct * S)
+{
+    slong j;
+
+    if (lo == 0)
+        sieve[0] &= ~1;
+
+    if (lo == S->lo_byte)
+    {
+        for (j = 0; j < 8; j++)
+            if (30*lo + _n_wheel30[j] < S->a)
+                sieve[0] &= ~(1 << j);
+    }
+
+    if (hi == S->hi_byte)
+    {
+        for (j = 0; j < 8; j++)
+            if (_n_wheel30[j] > S->b - 30*hi)
+                sieve[hi - lo] &= ~(1 << j);
+    }
+}
+
+/* write the primes in bytes lo to hi to primes, return how many */
+static slong
+_n_primes_extract(ulong * primes, const unsigned char * sieve, ulong lo,
+                                   ulong hi, const _n_primes_range_struct * S)
+{
+    slong i, j, num = 0;
+    unsigned int w;
+
+    /* 2, 3 and 5 are not on the wheel */
+    if (lo == 0)
+    {
+        for (j = 0; j < 3; j++)
+        {
+            ulong p = (j == 0) ? 2 : 2*j + 1;
+
+            if (p >= S->a && p <= S->b)
+                primes[num++] = p;
+        }
+    }
+
+    for (i = 0; i <= (slong) (hi - lo); i++)
+    {
+        w = sieve[i];
+
+        for (j = 0; w != 0; j++, w >>= 1)
+        {
+            if (w & 1)
+            {
+                ulong n = 30*(lo + i) + _n_wheel30[j];
+
+                if (!S->test || n <= S->limit_sq || n_is_prime(n))
+                    primes[num++] = n;
+            }
+        }
+    }
+
+    return num;
+}
+
+static void
+_n_primes_range_worker(void * arg_ptr)
+{
+    _n_primes_range_struct * S = (_n_primes_range_struct *) arg_ptr;
+    slong num_large = S->num_primes - S->num_small;
+    slong num_segs, c, s, i, j, k, num;
+    ulong count = 0;
+    ulong chunk_lo, chunk_hi, len, seg_lo, seg_hi, off, p, q;
+    ulong * next, * primes = NULL;
+    unsigned char * sieve, mask;
+    mp_ptr sieve_limbs;
+    _n_bucket_struct * buckets;
+
+    sieve_limbs = flint_malloc(((S->chunk_bytes + sizeof(mp_limb_t) - 1)
+                                     / sizeof(mp_limb_t))*sizeof(mp_limb_t));
+    sieve = (unsigned char *) sieve_limbs;
+    next = flint_malloc(8*FLINT_MAX(S->num_small, 1)*sizeof(ulong));
+    buckets = flint_calloc(CHUNK_MAX_SEGMENTS, sizeof(_n_bucket_struct));
+
+    if (S->f != NULL || S->test)
+        primes = flint_malloc((8*SEGMENT_BYTES + 3)*sizeof(ulong));
+
+    while (1)
+    {
+        pthread_mutex_lock(&S->mutex);
+        c = S->next_chunk++;
+        pthread_mutex_unlock(&S->mutex);
+
+        if (c >= S->num_chunks)
+            break;
+
+        chunk_lo = S->lo_byte + c*S->chunk_bytes;
+        chunk_hi = FLINT_MIN(S->hi_byte, chunk_lo + S->chunk_bytes - 1);
+        len = chunk_hi - chunk_lo + 1;
+        num_segs = (len + SEGMENT_BYTES - 1)/SEGMENT_BYTES;
+
+        memset(sieve, 0xff, len);
+
+        /* next multiple of each small prime in each class */
+        for (i = 0; i < S->num_small; i++)
+        {
+            p = S->primes[i];
+            q = _n_first_cofactor(p, chunk_lo);
+            for (j = 0; j < 8; j++)
+                next[8*i + j] = _n_first_hit(p, _n_wheel30[j], q) - chunk_lo;
+        }
+
+        /* first hit of each large prime in each class, if in this chunk */
+        for (i = 0; i < num_large; i++)
+        {
+            p = S->primes[S->num_small + i];
+            q = _n_first_cofactor(p, chunk_lo);
+            for (j = 0; j < 8; j++)
+            {
+                off = _n_first_hit(p, _n_wheel30[j], q) - chunk_lo;
+                if (off < len)
+                    _n_bucket_push(buckets + off/SEGMENT_BYTES, p,
+                            ((off % SEGMENT_BYTES) << 3)
+                              | _n_wheel30_bit[((p % 30)*_n_wheel30[j]) % 30]);
+            }
+        }
+
+        for (s = 0; s < num_segs; s++)
+        {
+            unsigned char * seg = sieve + s*SEGMENT_BYTES;
+            _n_bucket_struct * B = buckets + s;
+
+            seg_lo = s*SEGMENT_BYTES;
+            seg_hi = FLINT_MIN(len, seg_lo + SEGMENT_BYTES);
+
+            for (i = 0; i < S->num_small; i++)
+            {
+                p = S->primes[i];
+                for (j = 0; j < 8; j++)
+                {
+                    mask = ~(1 << _n_wheel30_bit[((p % 30)*_n_wheel30[j]) % 30]);
+
+                    for (off = next[8*i + j]; off < seg_hi; off += p)
+                        sieve[off] &= mask;
+
+                    next[8*i + j] = off;
+                }
+            }
+
+            for (k = 0; k < B->num; k++)
+            {
+                p = B->entries[k].p;
+                off = B->entries[k].off_bit >> 3;
+                j = B->entries[k].off_bit & 7;
+
+                seg[off] &= ~(1 << j);
+
+                off += seg_lo + p;
+                if (off < len)
+                    _n_bucket_push(buckets + off/SEGMENT_BYTES, p,
+                                             ((off % SEGMENT_BYTES) << 3) | j);
+            }
+
+            B->num = 0;
+
+            if (!S->ordered && (S->f != NULL || S->test))
+            {
+                _n_primes_mask_ends(seg, chunk_lo + seg_lo,
+                                             chunk_lo + seg_hi - 1, S);
+                num = _n_primes_extract(primes, seg, chunk_lo + seg_lo,
+                                                 chunk_lo + seg_hi - 1, S);
+                if (S->f == NULL)
+                    count += num;
+                else if (num != 0)
+                    S->f(primes, num, S->arg);
+            }
+        }
+
+        if (S->f == NULL && S->test)
+        {
+            pthread_mutex_lock(&S->mutex);
+            S->count += count;
+            pthread_mutex_unlock(&S->mutex);
+            count = 0;
+        }
+        else if (S->f == NULL)
+        {
+            _n_primes_mask_ends(sieve, chunk_lo, chunk_hi, S);
+
+            /* the bytes past the chunk are cleared to count whole limbs */
+            k = (len + sizeof(mp_limb_t) - 1)/sizeof(mp_limb_t);
+            memset(sieve + len, 0, k*sizeof(mp_limb_t) - len);
+            num = mpn_popcount(sieve_limbs, k);
+
+            if (chunk_lo == 0)
+                num += (S->a <= 2 && S->b >= 2) + (S->a <= 3 && S->b >= 3)
+                                                + (S->a <= 5 && S->b >= 5);
+
+            pthread_mutex_lock(&S->mutex);
+            S->count += num;
+            pthread_mutex_unlock(&S->mutex);
+        }
+        else if (S->ordered)
+        {
+            pthread_mutex_lock(&S->mutex);
+            while (S->next_deliver != c)
+                pthread_cond_wait(&S->cond, &S->mutex);
+            pthread_mutex_unlock(&S->mutex);
+
+            for (s = 0; s < num_segs; s++)
+            {
+                seg_lo = s*SEGMENT_BYTES;
+                seg_hi = FLINT_MIN(len, seg_lo + SEGMENT_BYTES);
+
+                _n_primes_mask_ends(sieve + seg_lo, chunk_lo + seg_lo,
+                                                  chunk_lo + seg_hi - 1, S);
+                num = _n_primes_extract(primes, sieve + seg_lo,
+                              chunk_lo + seg_lo, chunk_lo + seg_hi - 1, S);
+                if (num != 0)
+                    S->f(primes, num, S->arg);
+            }
+
+            pthread_mutex_lock(&S->mutex);
+            S->next_deliver++;
+            pthread_cond_broadcast(&S->cond);
+            pthread_mutex_unlock(&S->mutex);
+        }
+    }
+
+    for (s = 0; s < CHUNK_MAX_SEGMENTS; s++)
+        flint_free(buckets[s].entries);
+
+    flint_free(buckets);
+    flint_free(next);
+    flint_free(sieve_limbs);
+    flint_free(primes);
+}
+
+static void
+_n_primes_range_worker_ptr(void * arg_ptr)
+{
+    _n_primes_range_worker(*(_n_primes_range_struct **) arg_ptr);
+}
+
+ulong
+_n_primes_range(ulong a, ulong b, n_primes_callback_t f, void * arg,
+                                                                 int ordered)
+{
+    _n_primes_range_struct S[1];
+    n_primes_t iter;
+    ulong p, limit, total_bytes, chunk_bytes;
+    unsigned int * sieve_primes;
+    slong i, alloc, num_threads;
+
+    if (a > b)
+        return 0;
+
+    S->a = a;
+    S->b = b;
+    S->lo_byte = a/30;
+    S->hi_byte = b/30;
+    S->f = f;
+    S->arg = arg;
+    S->ordered = ordered && (f != NULL);
+    S->next_chunk = 0;
+    S->next_deliver = 0;
+    S->count = 0;
+
+    /* the primes from 7 up to the limit */
+    limit = n_sqrt(b);
+    S->test = (limit/16 > b - a && limit > (UWORD(1) << 16));
+    if (S->test)
+    {
+        limit = FLINT_MAX(16*(b - a), UWORD(1) << 16);
+        S->limit_sq = limit*limit;
+    }
+
+    alloc = 64;
+    sieve_primes = flint_malloc(alloc*sizeof(unsigned int));
+    S->num_primes = 0;
+    S->num_small = 0;
+
+    n_primes_init(iter);
+    n_primes_jump_after(iter, 5);
+    while ((p = n_primes_next(iter)) <= limit)
+    {
+        if (S->num_primes == alloc)
+        {
+            alloc *= 2;
+            sieve_primes = flint_realloc(sieve_primes,
+                                                alloc*sizeof(unsigned int));
+        }
+
+        sieve_primes[S->num_primes++] = p;
+        S->num_small += (p < SEGMENT_BYTES);
+    }
+    n_primes_clear(iter);
+
+    S->primes = sieve_primes;
+
+    /*
+       A chunk is at least a quarter of limit bytes, so that finding the
+       first multiples costs little next to the sieving, but the range is
+       still shared out between the threads.
+    */
+    num_threads = flint_get_num_threads();
+    total_bytes = S->hi_byte - S->lo_byte + 1;
+
+    chunk_bytes = FLINT_MAX(CHUNK_MIN_SEGMENTS*SEGMENT_BYTES, limit/4);
+    chunk_bytes = FLINT_MIN(chunk_bytes, (total_bytes - 1)/num_threads + 1);
+    chunk_bytes = FLINT_MIN(chunk_bytes, CHUNK_MAX_SEGMENTS*SEGMENT_BYTES);
+    chunk_bytes = FLINT_MAX(chunk_bytes, SEGMENT_BYTES);
+    chunk_bytes = ((chunk_bytes + SEGMENT_BYTES - 1)/SEGMENT_BYTES)*SEGMENT_BYTES;
+
+    S->chunk_bytes = chunk_bytes;
+    S->num_chunks = (total_bytes - 1)/chunk_bytes + 1;
+
+    num_threads = FLINT_MIN(num_threads, S->num_chunks);
+
+    pthread_mutex_init(&S->mutex, NULL);
+    pthread_cond_init(&S->cond, NULL);
+
+    if (num_threads > 1)
+    {
+        _n_primes_range_struct ** args;
+
+        args = flint_malloc(num_threads*sizeof(_n_primes_range_struct *));
+        for (i = 0; i < num_threads; i++)
+            args[i] = S;
+
+        threadpool_parallel_do(_n_primes_range_worker_ptr, args,
+                                num_threads, sizeof(_n_primes_range_struct *));
+
+        flint_free(args);
+    }
+    else
+        _n_primes_range_worker(S);
+
+    pthread_cond_destroy(&S->cond);
+    pthread_mutex_destroy(&S->mutex);
+
+    flint_free(sieve_primes);
+
+    return S->count;
+}
+
+void
+n_primes_range(ulong a, ulong b, n_primes_callback_t f, void * arg,
+                                                                 int ordered)
+{
+    _n_primes_range(a, b, f, arg, ordered);
+}
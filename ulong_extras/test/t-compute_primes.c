@@ -15,6 +15,42 @@
 #include <gmp.h>
 #include "flint.h"
 #include "ulong_extras.h"
+#include "threadpool.h"
+
+typedef struct
+{
+    ulong seed;
+    slong lim;
+    const mp_limb_t * ref_primes;
+    const mp_limb_t * primes; /* table seen for lim primes */
+} worker_arg_struct;
+
+/* look up random primes, all threads sharing one table */
+void worker(void * varg)
+{
+    worker_arg_struct * arg = (worker_arg_struct *) varg;
+    flint_rand_t state;
+    slong i, n;
+
+    flint_randinit(state);
+    flint_randseed(state, arg->seed, arg->seed + 1);
+
+    for (i = 0; i < 100; i++)
+    {
+        n = n_randint(state, arg->lim);
+
+        if (n_primes_arr_readonly(n + 1)[n] != arg->ref_primes[n])
+        {
+            flint_printf("FAIL (threads):\n");
+            flint_printf("n = %wd\n", n);
+            abort();
+        }
+    }
+
+    arg->primes = n_primes_arr_readonly(arg->lim);
+
+    flint_randclear(state);
+}
 
 int main()
 {
@@ -64,6 +100,62 @@ int main()
         }
     }
 
+    /* the table is shared between threads */
+    for (i = 0; i < 10; i++)
+    {
+        worker_arg_struct args[8];
+        slong k, num = n_randint(state, 8) + 1;
+
+        flint_set_num_threads(n_randint(state, 4) + 1);
+
+        if (n_randint(state, 2))
+            n_cleanup_primes();
+
+        for (k = 0; k < num; k++)
+        {
+            args[k].seed = n_randlimb(state);
+            args[k].lim = lim;
+            args[k].ref_primes = ref_primes;
+        }
+
+        threadpool_parallel_do(worker, args, num, sizeof(worker_arg_struct));
+
+        for (k = 0; k < num; k++)
+        {
+            if (args[k].primes != n_primes_arr_readonly(lim))
+            {
+                flint_printf("FAIL (threads):\n");
+                flint_printf("thread %wd has its own table\n", k);
+                abort();
+            }
+        }
+    }
+
+    /* the first table has at least primes_table_min primes */
+    n_cleanup_primes();
+    flint_set_cutoff(FLINT_CUTOFF_PRIMES_TABLE_MIN, 5000);
+    n_primes_arr_readonly(1);
+
+    if ((UWORD(1) << (_n_primes_used() - 1)) < 5000)
+    {
+        flint_printf("FAIL (primes_table_min):\n");
+        flint_printf("%d slots\n", _n_primes_used());
+        abort();
+    }
+
+    flint_reset_cutoffs();
+
+    /* growing a table which ends in the small primes */
+    n_cleanup_primes();
+    n_primes_arr_readonly(64);
+    if (n_primes_arr_readonly(1000)[999] != 7919)
+    {
+        flint_printf("FAIL (small table):\n");
+        abort();
+    }
+
+    threadpool_global_clear();
+
     flint_free(ref_primes);
     flint_free(ref_inverses);
     FLINT_TEST_CLEANUP(state);
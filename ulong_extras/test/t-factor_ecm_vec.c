@@ -0,0 +1,92 @@
+/*
+    Copyright (C) 2019 William Hart
+
+    This file is part of FLINT.
+
+    FLINT is free software: you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.  See <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <gmp.h>
+#include "flint.h"
+#include "ulong_extras.h"
+
+int main(void)
+{
+    slong i, j, len, found, count, fails, total;
+    mp_limb_t * n, * f;
+    FLINT_TEST_INIT(state);
+
+    flint_printf("factor_ecm_vec....");
+    fflush(stdout);
+
+    fails = 0;
+    total = 0;
+
+    for (i = 0; i < 10 * flint_test_multiplier(); i++)
+    {
+        len = n_randint(state, 50) + 1;
+
+        n = flint_malloc(len*sizeof(mp_limb_t));
+        f = flint_malloc(len*sizeof(mp_limb_t));
+
+        for (j = 0; j < len; j++)
+        {
+            slong bits = n_randint(state, FLINT_BITS/2 - 14) + 10;
+
+            n[j] = n_randprime(state, bits, 1)
+                 * n_randprime(state, FLINT_BITS - bits - 2, 1);
+        }
+
+        flint_set_num_threads(n_randint(state, 4) + 1);
+
+        found = n_factor_ecm_vec(f, 100, 1000, 50000, state, n, len);
+
+        count = 0;
+        for (j = 0; j < len; j++)
+        {
+            if (f[j] == 0)
+                continue;
+
+            count++;
+
+            if (f[j] == 1 || f[j] == n[j] || n[j] % f[j] != 0)
+            {
+                flint_printf("FAIL:\n");
+                flint_printf("n = %wu, f = %wu\n", n[j], f[j]);
+                abort();
+            }
+        }
+
+        if (count != found)
+        {
+            flint_printf("FAIL:\n");
+            flint_printf("found = %wd, count = %wd\n", found, count);
+            abort();
+        }
+
+        fails += len - found;
+        total += len;
+
+        flint_free(n);
+        flint_free(f);
+    }
+
+    if (fails > total/20)
+    {
+        flint_printf("FAIL:\n");
+        flint_printf("%wd of %wd not factored\n", fails, total);
+        abort();
+    }
+
+    flint_set_num_threads(1);
+
+    FLINT_TEST_CLEANUP(state);
+
+    flint_printf("PASS\n");
+    return 0;
+}
@@ -0,0 +1,257 @@
+/*
+    Copyright (C) 2019 William Hart
+
+    This file is part of FLINT.
+
+    FLINT is free software: you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.  See <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+#include <gmp.h>
+#include "flint.h"
+#include "ulong_extras.h"
+#include "threadpool.h"
+
+typedef struct
+{
+    ulong a;
+    ulong next;              /* for ordered delivery */
+    char * seen;
+    slong num;
+    int unordered;
+    int check;               /* whether to compare with n_factor */
+    pthread_mutex_t mutex;
+} check_struct;
+
+/* compare with n_factor, whose primes need not be increasing */
+int factor_equal(const n_factor_t * fac, ulong n)
+{
+    n_factor_t t;
+    slong i, j;
+
+    n_factor_init(&t);
+    if (n > 1)
+        n_factor(&t, n, 0);
+
+    if (t.num != fac->num)
+        return 0;
+
+    for (i = 0; i < fac->num; i++)
+    {
+        if (i > 0 && fac->p[i] <= fac->p[i - 1])
+            return 0;
+
+        for (j = 0; j < t.num; j++)
+            if (t.p[j] == fac->p[i] && t.exp[j] == fac->exp[i])
+                break;
+
+        if (j == t.num)
+            return 0;
+    }
+
+    return 1;
+}
+
+void check(ulong n, const n_factor_t * factors, slong len, void * arg)
+{
+    check_struct * C = (check_struct *) arg;
+    slong i;
+
+    if (C->unordered)
+        pthread_mutex_lock(&C->mutex);
+
+    if (!C->unordered && n != C->next)
+    {
+        flint_printf("FAIL (order):\n");
+        flint_printf("n = %wu, expected %wu\n", n, C->next);
+        abort();
+    }
+
+    C->next = n + len;
+
+    for (i = 0; i < len; i++)
+    {
+        if (C->seen[n + i - C->a])
+        {
+            flint_printf("FAIL (twice):\n");
+            flint_printf("n = %wu\n", n + i);
+            abort();
+        }
+
+        C->seen[n + i - C->a] = 1;
+        C->num++;
+
+        if (C->check && !factor_equal(factors + i, n + i))
+        {
+            flint_printf("FAIL (factors):\n");
+            flint_printf("n = %wu\n", n + i);
+            abort();
+        }
+    }
+
+    if (C->unordered)
+        pthread_mutex_unlock(&C->mutex);
+}
+
+void run(check_struct * C, ulong a, ulong b, int ordered, int check_factors)
+{
+    C->a = a;
+    C->next = a;
+    C->num = 0;
+    C->unordered = !ordered;
+    C->check = check_factors;
+    C->seen = flint_calloc(b - a + 1, 1);
+
+    n_factor_range(a, b, check, C, ordered);
+
+    if (C->num != b - a + 1)
+    {
+        flint_printf("FAIL (count):\n");
+        flint_printf("a = %wu, b = %wu, num = %wd\n", a, b, C->num);
+        abort();
+    }
+
+    flint_free(C->seen);
+}
+
+typedef struct
+{
+    ulong a;
+    ulong b;
+    ulong next;
+    slong bad;
+} nested_struct;
+
+void nested_check(ulong n, const n_factor_t * factors, slong len, void * arg)
+{
+    nested_struct * N = (nested_struct *) arg;
+
+    if (n != N->next)
+        N->bad = 1;
+
+    N->next = n + len;
+}
+
+pthread_mutex_t nested_mutex = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t nested_cond = PTHREAD_COND_INITIALIZER;
+slong nested_count;
+
+/*
+    An ordered call from a task of the thread pool. The tasks first wait
+    (for a second at most) until all of them have started, so that no
+    thread of the pool is left free to pick up the tasks queued by the
+    inner calls.
+*/
+void nested_worker(void * arg)
+{
+    nested_struct * N = (nested_struct *) arg;
+    struct timespec ts;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_sec += 1;
+
+    pthread_mutex_lock(&nested_mutex);
+    nested_count++;
+    pthread_cond_broadcast(&nested_cond);
+    while (nested_count < 4 &&
+                pthread_cond_timedwait(&nested_cond, &nested_mutex, &ts) == 0)
+        ;
+    pthread_mutex_unlock(&nested_mutex);
+
+    N->next = N->a;
+    N->bad = 0;
+    n_factor_range(N->a, N->b, nested_check, N, 1);
+
+    if (N->next != N->b + 1)
+        N->bad = 1;
+}
+
+int main(void)
+{
+    slong i;
+    ulong a, b;
+    check_struct C;
+    FLINT_TEST_INIT(state);
+
+    flint_printf("factor_range....");
+    fflush(stdout);
+
+    pthread_mutex_init(&C.mutex, NULL);
+
+    /* ranges around random points, sieved up to the square root or not */
+    for (i = 0; i < 100 * flint_test_multiplier(); i++)
+    {
+        flint_set_num_threads(n_randint(state, 4) + 1);
+
+        if (n_randint(state, 2))
+        {
+            a = n_randint(state, 2) ? n_randint(state, 100) :
+                     n_randbits(state, n_randint(state, FLINT_BITS/2) + 1);
+            b = a + n_randint(state, 10000);
+        }
+        else
+        {
+            a = n_randbits(state, n_randint(state, FLINT_BITS) + 1);
+            b = a + n_randint(state, 30);
+            if (b < a)
+                b = UWORD_MAX;
+        }
+
+        run(&C, a, b, n_randint(state, 2), 1);
+    }
+
+    /* many chunks and threads */
+    flint_set_num_threads(8);
+
+    a = n_randint(state, 1000);
+    b = a + 1000000 + n_randint(state, 1000);
+    run(&C, a, b, 1, 0);
+    run(&C, a, b, 0, 0);
+
+    a = (UWORD(1) << (FLINT_BITS/2 + 4)) + n_randint(state, 1000);
+    b = a + 20000 + n_randint(state, 1000);
+    run(&C, a, b, 1, 1);
+
+    /* ordered calls from inside threadpool_parallel_do */
+    {
+        nested_struct N[4];
+
+        flint_set_num_threads(4);
+
+        nested_count = 0;
+        for (i = 0; i < 4; i++)
+        {
+            N[i].a = 1000000 + i;
+            N[i].b = 1100000 + i;
+        }
+
+        threadpool_parallel_do(nested_worker, N, 4, sizeof(nested_struct));
+
+        for (i = 0; i < 4; i++)
+        {
+            if (N[i].bad)
+            {
+                flint_printf("FAIL (nested):\n");
+                flint_printf("i = %wd\n", i);
+                abort();
+            }
+        }
+    }
+
+    /* the top of the range of a word */
+    run(&C, UWORD_MAX - 200, UWORD_MAX, 1, 1);
+
+    pthread_mutex_destroy(&C.mutex);
+
+    FLINT_TEST_CLEANUP(state);
+    threadpool_global_clear();
+
+    flint_printf("PASS\n");
+    return 0;
+}
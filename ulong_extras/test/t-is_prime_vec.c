@@ -0,0 +1,128 @@
+/*
+    Copyright (C) 2019 William Hart
+
+    This file is part of FLINT.
+
+    FLINT is free software: you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.  See <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <gmp.h>
+#include "flint.h"
+#include "ulong_extras.h"
+#include "threadpool.h"
+
+int main(void)
+{
+    slong i, j, len, num, count;
+    ulong * n, * res;
+    /* squares of Wieferich primes and strong base 2 pseudoprimes */
+    const ulong hard[] = { 1194649, 12327121, 2047, 3277, 4033, 4681, 8321,
+                           15841, 29341, 42799, 49141, 52633, 65281, 74665,
+                           80581, 85489, 88357, 90751, UWORD(3215031751)
+#if FLINT64
+                           , UWORD(3825123056546413051)
+#endif
+                         };
+    FLINT_TEST_INIT(state);
+
+    flint_printf("is_prime_vec....");
+    fflush(stdout);
+
+    for (i = 0; i < 200 * flint_test_multiplier(); i++)
+    {
+        flint_set_num_threads(n_randint(state, 4) + 1);
+
+        len = n_randint(state, 2) ? n_randint(state, 200) :
+                                    n_randint(state, 5000);
+
+        n = flint_malloc((len + 1)*sizeof(ulong));
+        res = flint_malloc(((len + FLINT_BITS - 1)/FLINT_BITS + 1)*sizeof(ulong));
+
+        if (n_randint(state, 4) == 0)
+        {
+            /* consecutive integers */
+            ulong a = n_randtest(state);
+
+            for (j = 0; j < len; j++)
+                n[j] = a + j;
+        }
+        else
+        {
+            for (j = 0; j < len; j++)
+            {
+                switch (n_randint(state, 5))
+                {
+                    case 0:
+                        n[j] = n_randint(state, 1000);
+                        break;
+                    case 1:
+                        n[j] = n_randtest(state);
+                        break;
+                    case 2:
+                        n[j] = n_randtest_prime(state, 0);
+                        break;
+                    case 3:
+                        n[j] = hard[n_randint(state,
+                                                  sizeof(hard)/sizeof(ulong))];
+                        break;
+                    default:
+                        n[j] = n_randtest_bits(state,
+                                          n_randint(state, FLINT_BITS) + 1) | 1;
+                }
+            }
+        }
+
+        /* a guard limb past the mask must be left alone */
+        res[(len + FLINT_BITS - 1)/FLINT_BITS] = UWORD(12345);
+
+        if (n_randint(state, 2))
+            num = n_is_prime_vec(res, n, len);
+        else
+            num = _n_is_prime_vec(res, n, len);
+
+        count = 0;
+        for (j = 0; j < len; j++)
+        {
+            int bit = (res[j/FLINT_BITS] >> (j % FLINT_BITS)) & 1;
+
+            if (bit != n_is_prime(n[j]))
+            {
+                flint_printf("FAIL:\n");
+                flint_printf("n = %wu, bit = %d\n", n[j], bit);
+                abort();
+            }
+
+            count += bit;
+        }
+
+        for (j = len; j % FLINT_BITS != 0; j++)
+        {
+            if ((res[j/FLINT_BITS] >> (j % FLINT_BITS)) & 1)
+            {
+                flint_printf("FAIL (bits past len):\n");
+                abort();
+            }
+        }
+
+        if (count != num || res[(len + FLINT_BITS - 1)/FLINT_BITS] != 12345)
+        {
+            flint_printf("FAIL (count):\n");
+            flint_printf("count = %wd, num = %wd\n", count, num);
+            abort();
+        }
+
+        flint_free(n);
+        flint_free(res);
+    }
+
+    FLINT_TEST_CLEANUP(state);
+    threadpool_global_clear();
+
+    flint_printf("PASS\n");
+    return 0;
+}
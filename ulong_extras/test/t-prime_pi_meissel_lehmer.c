@@ -0,0 +1,89 @@
+/*
+    Copyright (C) 2019 William Hart
+
+    This file is part of FLINT.
+
+    FLINT is free software: you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.  See <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <gmp.h>
+#include "flint.h"
+#include "ulong_extras.h"
+#include "threadpool.h"
+
+int main(void)
+{
+    slong i;
+    ulong n, a, b;
+    /* pi(10^k) for k = 0, 1, ... */
+    const ulong pi10[] = { 0, 4, 25, 168, 1229, 9592, 78498, 664579, 5761455,
+                           50847534
+#if FLINT64
+                           , 455052511, UWORD(4118054813), UWORD(37607912018)
+#endif
+                         };
+    FLINT_TEST_INIT(state);
+
+    flint_printf("prime_pi_meissel_lehmer....");
+    fflush(stdout);
+
+    for (i = 0; i < 100 * flint_test_multiplier(); i++)
+    {
+        n = n_randint(state, n_randint(state, 10) ? 1000000 : 30000000);
+
+        a = n_prime_pi_meissel_lehmer(n);
+        b = n_primes_count_range(0, n);
+
+        if (a != b)
+        {
+            flint_printf("FAIL:\n");
+            flint_printf("n = %wu, pi(n) = %wu, not %wu\n", n, b, a);
+            abort();
+        }
+    }
+
+#if FLINT64
+    /* above a power of ten, counting the primes in between */
+    for (i = 0; i < 2 * flint_test_multiplier(); i++)
+    {
+        flint_set_num_threads(n_randint(state, 4) + 1);
+
+        n = UWORD(10000000000) + n_randint(state, 10000000);
+
+        a = n_prime_pi_meissel_lehmer(n);
+        b = pi10[10] + n_primes_count_range(UWORD(10000000001), n);
+
+        if (a != b)
+        {
+            flint_printf("FAIL:\n");
+            flint_printf("n = %wu, pi(n) = %wu, not %wu\n", n, b, a);
+            abort();
+        }
+    }
+#endif
+
+    for (i = 0; i < sizeof(pi10)/sizeof(ulong); i++)
+    {
+        n = n_pow(10, i);
+
+        a = n_prime_pi_meissel_lehmer(n);
+
+        if (a != pi10[i])
+        {
+            flint_printf("FAIL:\n");
+            flint_printf("pi(10^%wd) = %wu, not %wu\n", i, pi10[i], a);
+            abort();
+        }
+    }
+
+    FLINT_TEST_CLEANUP(state);
+    threadpool_global_clear();
+
+    flint_printf("PASS\n");
+    return 0;
+}
@@ -0,0 +1,263 @@
+/*
+    Copyright (C) 2019 William Hart
+
+    This file is part of FLINT.
+
+    FLINT is free software: you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.  See <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <gmp.h>
+#include "flint.h"
+#include "ulong_extras.h"
+#include "threadpool.h"
+
+typedef struct
+{
+    ulong * primes;
+    slong num;
+    slong alloc;
+    int unordered;
+    pthread_mutex_t mutex;
+} collect_struct;
+
+void collect(const ulong * primes, slong len, void * arg)
+{
+    collect_struct * C = (collect_struct *) arg;
+    slong i;
+
+    if (C->unordered)
+        pthread_mutex_lock(&C->mutex);
+
+    if (C->num + len > C->alloc)
+    {
+        C->alloc = FLINT_MAX(2*C->alloc, C->num + len);
+        C->primes = flint_realloc(C->primes, C->alloc*sizeof(ulong));
+    }
+
+    for (i = 0; i < len; i++)
+        C->primes[C->num + i] = primes[i];
+
+    C->num += len;
+
+    if (C->unordered)
+        pthread_mutex_unlock(&C->mutex);
+}
+
+int ulong_cmp(const void * a, const void * b)
+{
+    ulong x = *(const ulong *) a, y = *(const ulong *) b;
+
+    return (x > y) - (x < y);
+}
+
+/* check the primes collected from [a, b] one by one */
+void check_collected(collect_struct * C, ulong a, ulong b, const char * s)
+{
+    slong i;
+    ulong p = a;
+
+    if (C->unordered)
+        qsort(C->primes, C->num, sizeof(ulong), ulong_cmp);
+
+    for (i = 0; i < C->num; i++)
+    {
+        if (C->primes[i] < p || C->primes[i] > b || !n_is_prime(C->primes[i]))
+        {
+            flint_printf("FAIL (%s):\n", s);
+            flint_printf("a = %wu, b = %wu, p = %wu\n", a, b, C->primes[i]);
+            abort();
+        }
+
+        for ( ; p < C->primes[i]; p++)
+        {
+            if (n_is_prime(p))
+            {
+                flint_printf("FAIL (%s):\n", s);
+                flint_printf("a = %wu, b = %wu, missing %wu\n", a, b, p);
+                abort();
+            }
+        }
+
+        p = C->primes[i] + 1;
+    }
+
+    for ( ; p <= b && p != 0; p++)
+    {
+        if (n_is_prime(p))
+        {
+            flint_printf("FAIL (%s):\n", s);
+            flint_printf("a = %wu, b = %wu, missing %wu\n", a, b, p);
+            abort();
+        }
+    }
+}
+
+int main(void)
+{
+    slong i, j;
+    ulong a, b, count;
+    collect_struct C;
+    n_primes_t iter;
+    FLINT_TEST_INIT(state);
+
+    flint_printf("primes_range....");
+    fflush(stdout);
+
+    C.primes = NULL;
+    C.alloc = 0;
+    pthread_mutex_init(&C.mutex, NULL);
+
+    /* ordered delivery gives the same primes as n_primes_next */
+    for (i = 0; i < 100 * flint_test_multiplier(); i++)
+    {
+        flint_set_num_threads(n_randint(state, 4) + 1);
+
+        a = n_randint(state, 2) ? n_randint(state, 100) :
+                     n_randbits(state, n_randint(state, FLINT_BITS - 25) + 1);
+        b = a + n_randint(state, n_randint(state, 2) ? 1000 : 3000000);
+
+        C.num = 0;
+        C.unordered = 0;
+        n_primes_range(a, b, collect, &C, 1);
+
+        n_primes_init(iter);
+        if (a > 0)
+            n_primes_jump_after(iter, a - 1);
+
+        for (j = 0; j < C.num; j++)
+        {
+            ulong p = n_primes_next(iter);
+
+            if (p != C.primes[j])
+            {
+                flint_printf("FAIL (ordered):\n");
+                flint_printf("a = %wu, b = %wu, j = %wd\n", a, b, j);
+                flint_printf("p = %wu, q = %wu\n", p, C.primes[j]);
+                abort();
+            }
+        }
+
+        if (n_primes_next(iter) <= b)
+        {
+            flint_printf("FAIL (ordered):\n");
+            flint_printf("a = %wu, b = %wu, too few primes\n", a, b);
+            abort();
+        }
+
+        n_primes_clear(iter);
+
+        count = n_primes_count_range(a, b);
+
+        if (count != C.num)
+        {
+            flint_printf("FAIL (count):\n");
+            flint_printf("a = %wu, b = %wu, count = %wu, num = %wd\n",
+                                                         a, b, count, C.num);
+            abort();
+        }
+    }
+
+    /* unordered delivery from several threads */
+    for (i = 0; i < 20 * flint_test_multiplier(); i++)
+    {
+        flint_set_num_threads(n_randint(state, 8) + 1);
+
+        a = n_randint(state, 2) ? n_randint(state, 1000) : n_randtest(state);
+        b = a + n_randint(state, 50000);
+        if (b < a)
+            b = UWORD_MAX;
+
+        C.num = 0;
+        C.unordered = 1;
+        n_primes_range(a, b, collect, &C, 0);
+
+        check_collected(&C, a, b, "unordered");
+
+        count = n_primes_count_range(a, b);
+
+        if (count != C.num)
+        {
+            flint_printf("FAIL (count):\n");
+            flint_printf("a = %wu, b = %wu, count = %wu, num = %wd\n",
+                                                         a, b, count, C.num);
+            abort();
+        }
+    }
+
+    /* a range split into many chunks gives the same primes either way */
+    {
+        ulong * ordered;
+        slong num;
+
+        flint_set_num_threads(8);
+
+        a = n_randint(state, 1000) + 1;
+        b = a + 20000000 + n_randint(state, 1000);
+
+        C.num = 0;
+        C.unordered = 0;
+        n_primes_range(a, b, collect, &C, 1);
+
+        num = C.num;
+        ordered = C.primes;
+        C.primes = NULL;
+        C.alloc = 0;
+
+        C.num = 0;
+        C.unordered = 1;
+        n_primes_range(a, b, collect, &C, 0);
+        qsort(C.primes, C.num, sizeof(ulong), ulong_cmp);
+
+        for (j = 0; j < num && j < C.num; j++)
+            if (ordered[j] != C.primes[j])
+                break;
+
+        if (num != C.num || j != num || num != n_prime_pi(b) - n_prime_pi(a - 1))
+        {
+            flint_printf("FAIL (chunks):\n");
+            flint_printf("a = %wu, b = %wu, %wd, %wd\n", a, b, num, C.num);
+            abort();
+        }
+
+        flint_free(ordered);
+    }
+
+    /* the top of the range of a word */
+    a = UWORD_MAX - 1000;
+    b = UWORD_MAX;
+    C.num = 0;
+    C.unordered = 0;
+    n_primes_range(a, b, collect, &C, 1);
+
+    if (C.num == 0 || C.primes[C.num - 1] != UWORD_MAX_PRIME)
+    {
+        flint_printf("FAIL (top):\n");
+        abort();
+    }
+
+    check_collected(&C, a, b, "top");
+
+    /* known counts */
+    if (n_primes_count_range(0, 0) != 0 || n_primes_count_range(5, 2) != 0
+        || n_primes_count_range(2, 2) != 1 || n_primes_count_range(0, 30) != 10
+        || n_primes_count_range(0, 100000000) != 5761455)
+    {
+        flint_printf("FAIL (known counts):\n");
+        abort();
+    }
+
+    flint_free(C.primes);
+    pthread_mutex_destroy(&C.mutex);
+
+    FLINT_TEST_CLEANUP(state);
+    threadpool_global_clear();
+
+    flint_printf("PASS\n");
+    return 0;
+}